@@ -0,0 +1,539 @@
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+// Small microbenchmark harness with the shape of Google Benchmark, so its tools (and
+// scripts/compare_bench.py) read the output:
+//
+//   static void BM_ViewMatrix(Microbench::State &state){
+//       Camera camera;
+//       for(auto _ : state){
+//           Microbench::doNotOptimize(camera.GetViewMatrix());
+//       }
+//   }
+//   MICROBENCH(BM_ViewMatrix);
+//   MICROBENCH(BM_Cull)->arg(1024)->arg(65536);
+//
+// Each benchmark runs with a growing iteration count until one batch takes at least the
+// minimum time, then repeats that batch; the median of the repetitions is the number to
+// compare. Wall and thread CPU time are both reported. run(argc, argv) understands the
+// usual --benchmark_filter / _min_time / _repetitions / _out flags and writes the JSON
+// report in Google Benchmark's format.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MICROBENCH_UNUSED __attribute__((unused))
+#else
+#define MICROBENCH_UNUSED
+#endif
+
+namespace Microbench {
+
+    typedef std::chrono::steady_clock Clock;
+
+    inline double threadCpuSeconds(){
+#if defined(_WIN32)
+        FILETIME creation, exit, kernel, user;
+        GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+        uint64_t total = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32 | kernel.dwLowDateTime) + (static_cast<uint64_t>(user.dwHighDateTime) << 32 | user.dwLowDateTime);
+        return total * 1e-7;
+#else
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+    }
+
+    // keeps value (and everything it was computed from) alive without storing it anywhere
+    template<typename T>
+    inline void doNotOptimize(const T &value){
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    // forces pending writes to memory, e.g. after filling an output buffer
+    inline void clobberMemory(){
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : : "memory");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+    class State {
+        public:
+            struct Iterator {
+                uint64_t remaining;
+                State* state;
+
+                bool operator!=(const Iterator&) const{
+                    if(remaining != 0){
+                        return true;
+                    }
+                    state->stop();
+                    return false;
+                }
+
+                void operator++(){
+                    remaining--;
+                }
+
+                // the loop variable is never used
+                struct MICROBENCH_UNUSED Value {};
+
+                Value operator*() const{
+                    return Value();
+                }
+            };
+
+            State(uint64_t iterations, const std::vector<int64_t> &args) : iterations_(iterations), args(args){}
+
+            Iterator begin(){
+                startWall = Clock::now();
+                startCpu = threadCpuSeconds();
+                return Iterator{ iterations_, this };
+            }
+
+            Iterator end(){
+                return Iterator{ 0, this };
+            }
+
+            int64_t range(size_t index = 0) const{
+                return index < args.size() ? args[index] : 0;
+            }
+
+            uint64_t iterations() const{
+                return iterations_;
+            }
+
+            // setup inside the loop that shouldn't count
+            void pauseTiming(){
+                pauseWall = Clock::now();
+                pauseCpu = threadCpuSeconds();
+            }
+
+            void resumeTiming(){
+                pausedWall += Clock::now() - pauseWall;
+                pausedCpu += threadCpuSeconds() - pauseCpu;
+            }
+
+            void setItemsProcessed(int64_t items){
+                itemsProcessed = items;
+            }
+
+            void setBytesProcessed(int64_t bytes){
+                bytesProcessed = bytes;
+            }
+
+            void setLabel(const std::string &text){
+                label = text;
+            }
+
+            // e.g. when a test asset is missing; the benchmark is reported as an error
+            void skipWithError(const std::string &message){
+                error = message;
+                iterations_ = 0;
+            }
+
+        private:
+            friend struct Runner;
+
+            uint64_t iterations_;
+            std::vector<int64_t> args;
+            Clock::time_point startWall;
+            double startCpu = 0.0;
+            Clock::time_point pauseWall;
+            double pauseCpu = 0.0;
+            Clock::duration pausedWall = Clock::duration::zero();
+            double pausedCpu = 0.0;
+            double wallSeconds = 0.0;
+            double cpuSeconds = 0.0;
+            int64_t itemsProcessed = 0;
+            int64_t bytesProcessed = 0;
+            std::string label;
+            std::string error;
+
+            void stop(){
+                wallSeconds = std::chrono::duration<double>(Clock::now() - startWall - pausedWall).count();
+                cpuSeconds = threadCpuSeconds() - startCpu - pausedCpu;
+            }
+    };
+
+    typedef void (*Function)(State&);
+
+    struct Benchmark {
+        std::string name;
+        Function function;
+        std::vector<std::vector<int64_t>> argSets;
+        bool realTime = false;
+
+        Benchmark* arg(int64_t value){
+            argSets.push_back({ value });
+            return this;
+        }
+
+        Benchmark* args(const std::vector<int64_t> &values){
+            argSets.push_back(values);
+            return this;
+        }
+
+        // rates against wall time instead of the calling thread's CPU time, for benchmarks
+        // that hand work to other threads
+        Benchmark* useRealTime(){
+            realTime = true;
+            return this;
+        }
+
+        // start, start * multiplier, ... up to and including limit
+        Benchmark* range(int64_t start, int64_t limit, int64_t multiplier = 8){
+            for(int64_t value = start; value < limit; value *= multiplier){
+                argSets.push_back({ value });
+            }
+            argSets.push_back({ limit });
+            return this;
+        }
+    };
+
+    inline std::vector<Benchmark*>& registry(){
+        static std::vector<Benchmark*> benchmarks;
+        return benchmarks;
+    }
+
+    inline Benchmark* registerBenchmark(const char* name, Function function){
+        Benchmark* benchmark = new Benchmark{ name, function, {} };
+        registry().push_back(benchmark);
+        return benchmark;
+    }
+
+    struct Settings {
+        std::string filter = ".";
+        double minTime = 0.5;           // seconds per repetition
+        int repetitions = 3;
+        std::string out;                // JSON report path, empty for none
+        bool list = false;
+    };
+
+    struct Run {
+        std::string name;               // name/arg/arg
+        std::string runName;
+        bool aggregate = false;
+        std::string aggregateName;
+        int repetitionIndex = 0;
+        int repetitions = 0;
+        uint64_t iterations = 0;
+        double realNs = 0.0;            // per iteration
+        double cpuNs = 0.0;
+        double wallSeconds = 0.0;       // whole batch
+        double itemsPerSecond = 0.0;
+        double bytesPerSecond = 0.0;
+        bool realTime = false;          // rates are against wall time
+        std::string label;
+        std::string error;
+    };
+
+    struct Runner {
+        // one timed batch, per iteration times filled in
+        static Run measure(const Benchmark &benchmark, const std::vector<int64_t> &args, uint64_t iterations){
+            State state(iterations, args);
+            benchmark.function(state);
+            Run run;
+            run.iterations = state.iterations_;
+            run.error = state.error;
+            run.label = state.label;
+            if(state.iterations_ == 0){
+                return run;
+            }
+            run.realNs = state.wallSeconds * 1e9 / state.iterations_;
+            run.cpuNs = state.cpuSeconds * 1e9 / state.iterations_;
+            // Google Benchmark takes items/bytes for the whole batch and rates against CPU time
+            // unless the benchmark asked for real time
+            run.realTime = benchmark.realTime;
+            double seconds = run.realTime ? state.wallSeconds : state.cpuSeconds;
+            if(state.itemsProcessed > 0 && seconds > 0.0){
+                run.itemsPerSecond = state.itemsProcessed / seconds;
+            }
+            if(state.bytesProcessed > 0 && seconds > 0.0){
+                run.bytesPerSecond = state.bytesProcessed / seconds;
+            }
+            run.wallSeconds = state.wallSeconds;
+            return run;
+        }
+
+        // grows the batch until it takes minTime, like Google Benchmark's 1.4x overshoot
+        static uint64_t calibrate(const Benchmark &benchmark, const std::vector<int64_t> &args, double minTime, Run &probe){
+            uint64_t iterations = 1;
+            for(;;){
+                probe = measure(benchmark, args, iterations);
+                if(!probe.error.empty() || probe.wallSeconds >= minTime || iterations >= 1000000000ull){
+                    return iterations;
+                }
+                double grow = probe.wallSeconds > 0.0 ? 1.4 * minTime / probe.wallSeconds : 10.0;
+                iterations = static_cast<uint64_t>(std::ceil(iterations * std::min(10.0, std::max(2.0, grow))));
+            }
+        }
+    };
+
+    inline std::string runName(const Benchmark &benchmark, const std::vector<int64_t> &args){
+        std::string name = benchmark.name;
+        for(int64_t value : args){
+            name += "/" + std::to_string(value);
+        }
+        return name;
+    }
+
+    inline Run aggregateOf(const std::vector<Run> &runs, const char* kind){
+        Run result = runs.front();
+        result.aggregate = true;
+        result.aggregateName = kind;
+        result.name = result.runName + "_" + kind;
+        std::vector<double> real, cpu;
+        for(const Run &run : runs){
+            real.push_back(run.realNs);
+            cpu.push_back(run.cpuNs);
+        }
+        auto reduce = [&](std::vector<double> values) -> double{
+            double mean = 0.0;
+            for(double value : values){
+                mean += value / values.size();
+            }
+            if(std::string(kind) == "mean"){
+                return mean;
+            }
+            if(std::string(kind) == "median"){
+                std::sort(values.begin(), values.end());
+                size_t middle = values.size() / 2;
+                return values.size() % 2 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+            }
+            double variance = 0.0;
+            for(double value : values){
+                variance += (value - mean) * (value - mean);
+            }
+            return values.size() > 1 ? std::sqrt(variance / (values.size() - 1)) : 0.0;
+        };
+        result.realNs = reduce(real);
+        result.cpuNs = reduce(cpu);
+        // rates follow the aggregated time they were taken against, a standard deviation has none
+        double first = result.realTime ? runs.front().realNs : runs.front().cpuNs;
+        double aggregated = result.realTime ? result.realNs : result.cpuNs;
+        double scale = result.aggregateName != "stddev" && aggregated > 0.0 ? first / aggregated : 0.0;
+        result.itemsPerSecond *= scale;
+        result.bytesPerSecond *= scale;
+        return result;
+    }
+
+    inline void writeEscaped(FILE* file, const std::string &text){
+        for(char c : text){
+            if(c == '"' || c == '\\'){
+                fputc('\\', file);
+            }
+            fputc(static_cast<unsigned char>(c) < 0x20 ? ' ' : c, file);
+        }
+    }
+
+    inline bool writeJson(const std::string &path, const std::string &executable, const std::vector<Run> &runs){
+        FILE* file = fopen(path.c_str(), "w");
+        if(file == NULL){
+            return false;
+        }
+        char date[64];
+        time_t now = time(NULL);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+        fprintf(file, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"executable\": \"", date);
+        writeEscaped(file, executable);
+        fprintf(file, "\",\n    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+        fprintf(file, "    \"library_build_type\": \"release\"\n  },\n  \"benchmarks\": [\n");
+#else
+        fprintf(file, "    \"library_build_type\": \"debug\"\n  },\n  \"benchmarks\": [\n");
+#endif
+        for(size_t i = 0; i < runs.size(); i++){
+            const Run &run = runs[i];
+            fprintf(file, "    {\"name\": \"");
+            writeEscaped(file, run.name);
+            fprintf(file, "\", \"run_name\": \"");
+            writeEscaped(file, run.runName);
+            fprintf(file, "\", \"run_type\": \"%s\", \"repetitions\": %d, ", run.aggregate ? "aggregate" : "iteration", run.repetitions);
+            if(run.aggregate){
+                fprintf(file, "\"aggregate_name\": \"%s\", ", run.aggregateName.c_str());
+            }
+            else{
+                fprintf(file, "\"repetition_index\": %d, ", run.repetitionIndex);
+            }
+            if(!run.error.empty()){
+                fprintf(file, "\"error_occurred\": true, \"error_message\": \"");
+                writeEscaped(file, run.error);
+                fprintf(file, "\", ");
+            }
+            fprintf(file, "\"iterations\": %llu, \"real_time\": %.4f, \"cpu_time\": %.4f, \"time_unit\": \"ns\"",
+                static_cast<unsigned long long>(run.iterations), run.realNs, run.cpuNs);
+            if(run.itemsPerSecond > 0.0){
+                fprintf(file, ", \"items_per_second\": %.4f", run.itemsPerSecond);
+            }
+            if(run.bytesPerSecond > 0.0){
+                fprintf(file, ", \"bytes_per_second\": %.4f", run.bytesPerSecond);
+            }
+            if(!run.label.empty()){
+                fprintf(file, ", \"label\": \"");
+                writeEscaped(file, run.label);
+                fprintf(file, "\"");
+            }
+            fprintf(file, "}%s\n", i + 1 < runs.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+        return fclose(file) == 0;
+    }
+
+    inline void printRun(const Run &run){
+        if(!run.error.empty()){
+            printf("%-48s ERROR: %s\n", run.name.c_str(), run.error.c_str());
+            return;
+        }
+        printf("%-48s %14.1f ns %14.1f ns %12llu", run.name.c_str(), run.realNs, run.cpuNs, static_cast<unsigned long long>(run.iterations));
+        if(run.itemsPerSecond > 0.0){
+            printf("  %.4g items/s", run.itemsPerSecond);
+        }
+        if(run.bytesPerSecond > 0.0){
+            printf("  %.4g MB/s", run.bytesPerSecond / (1024.0 * 1024.0));
+        }
+        if(!run.label.empty()){
+            printf("  %s", run.label.c_str());
+        }
+        printf("\n");
+    }
+
+    inline bool parseFlag(const std::string &argument, const char* flag, std::string &value){
+        std::string prefix = std::string(flag) + "=";
+        if(argument.compare(0, prefix.size(), prefix) != 0){
+            return false;
+        }
+        value = argument.substr(prefix.size());
+        return true;
+    }
+
+    // runs every registered benchmark matching the filter, returns the number that failed
+    inline int run(const Settings &settings, const std::string &executable){
+        std::regex filter(settings.filter);
+        std::vector<Run> report;
+        int failed = 0;
+        if(!settings.list){
+            printf("%-48s %17s %17s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+        }
+        for(const Benchmark* benchmark : registry()){
+            std::vector<std::vector<int64_t>> argSets = benchmark->argSets;
+            if(argSets.empty()){
+                argSets.push_back({});
+            }
+            for(const std::vector<int64_t> &args : argSets){
+                std::string name = runName(*benchmark, args);
+                if(!std::regex_search(name, filter)){
+                    continue;
+                }
+                if(settings.list){
+                    printf("%s\n", name.c_str());
+                    continue;
+                }
+                Run probe;
+                uint64_t iterations = Runner::calibrate(*benchmark, args, settings.minTime, probe);
+                std::vector<Run> runs;
+                for(int repetition = 0; repetition < settings.repetitions; repetition++){
+                    Run run = probe.error.empty() ? Runner::measure(*benchmark, args, iterations) : probe;
+                    run.name = name;
+                    run.runName = name;
+                    run.repetitionIndex = repetition;
+                    run.repetitions = settings.repetitions;
+                    printRun(run);
+                    runs.push_back(run);
+                    if(!run.error.empty()){
+                        break;
+                    }
+                }
+                report.insert(report.end(), runs.begin(), runs.end());
+                if(!runs.back().error.empty()){
+                    failed++;
+                    continue;
+                }
+                if(runs.size() > 1){
+                    for(const char* kind : { "mean", "median", "stddev" }){
+                        Run aggregate = aggregateOf(runs, kind);
+                        printRun(aggregate);
+                        report.push_back(aggregate);
+                    }
+                }
+            }
+        }
+        if(!settings.out.empty() && !settings.list){
+            if(writeJson(settings.out, executable, report)){
+                printf("wrote %s\n", settings.out.c_str());
+            }
+            else{
+                printf("failed to write %s\n", settings.out.c_str());
+                failed++;
+            }
+        }
+        return failed;
+    }
+
+    inline int run(int argc, char** argv){
+        Settings settings;
+        for(int i = 1; i < argc; i++){
+            std::string argument = argv[i];
+            std::string value;
+            if(parseFlag(argument, "--benchmark_filter", value)){
+                settings.filter = value;
+            }
+            else if(parseFlag(argument, "--benchmark_min_time", value)){
+                // "0.5" or Google Benchmark's newer "0.5s"
+                settings.minTime = std::max(1e-3, atof(value.c_str()));
+            }
+            else if(parseFlag(argument, "--benchmark_repetitions", value)){
+                settings.repetitions = std::max(1, atoi(value.c_str()));
+            }
+            else if(parseFlag(argument, "--benchmark_out", value)){
+                settings.out = value;
+            }
+            else if(parseFlag(argument, "--benchmark_out_format", value)){
+                if(value != "json"){
+                    printf("only the json output format is supported\n");
+                    return -1;
+                }
+            }
+            else if(argument == "--benchmark_list_tests" || argument == "--benchmark_list_tests=true"){
+                settings.list = true;
+            }
+            else{
+                printf("usage: %s [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>] [--benchmark_repetitions=<n>]\n"
+                       "          [--benchmark_out=<file.json>] [--benchmark_list_tests]\n", argv[0]);
+                return -1;
+            }
+        }
+        return run(settings, argv[0]) == 0 ? 0 : 1;
+    }
+}
+
+#define MICROBENCH_CONCAT_INNER(a, b) a##b
+#define MICROBENCH_CONCAT(a, b) MICROBENCH_CONCAT_INNER(a, b)
+#define MICROBENCH(function) static Microbench::Benchmark* MICROBENCH_CONCAT(microbench_, __LINE__) = Microbench::registerBenchmark(#function, function)
+
+#endif
@@ -4,6 +4,12 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <Culling/frustum.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 
 // Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
 enum Camera_Movement {
@@ -29,6 +35,15 @@ const float FAR         =  100.0f;
 
 
 // An abstract camera class that processes input and calculates the corresponding Euler Angles, Vectors and Matrices for use in OpenGL
+//
+// The matrices and the frustum are cached. Every getter first compares Position, the angles,
+// Zoom, AspectRatio, Near and Far with what the cache was built from (they are public and
+// get written directly) and rebuilds only the part that went stale: the view from the pose,
+// the projection from the lens, and the products, frustum and inverses when first asked for
+// after either changed. Each change takes a new Version() from a counter shared by all
+// cameras, so a copy keeps its original's version and two cameras with the same version show
+// the same thing: anything derived from the camera (culling results, uniform blocks) can
+// keep the version it was built for and skip the work while it still matches.
 class Camera
 {
 public:
@@ -49,9 +64,12 @@ public:
     float Near;
     float Far;
     float AspectRatio;
+    // infinite far plane, depth 1 at Near falling to 0 at infinity (for glClipControl's
+    // GL_ZERO_TO_ONE with a GL_GREATER depth test); Far is ignored
+    bool ReverseZ;
 
     // constructor with vectors
-    Camera(Camera_Type type = FREE, float aspectRatio = 1.0f, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Near(NEAR), Far(FAR)
+    Camera(Camera_Type type = FREE, float aspectRatio = 1.0f, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Near(NEAR), Far(FAR), ReverseZ(false)
     {
         Type = type;
         AspectRatio = aspectRatio;
@@ -62,7 +80,7 @@ public:
         updateCameraVectors();
     }
     // constructor with scalar values
-    Camera(Camera_Type type, float aspectRatio, float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Near(NEAR), Far(FAR)
+    Camera(Camera_Type type, float aspectRatio, float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Near(NEAR), Far(FAR), ReverseZ(false)
     {
         Type = type;
         AspectRatio = aspectRatio;
@@ -74,23 +92,59 @@ public:
     }
 
     // returns the view matrix calculated using Euler Angles and the LookAt Matrix
-    glm::mat4 GetViewMatrix()
-    {
-        glm::mat4 transMat = glm::mat4(1.0f);
-        transMat = glm::translate(transMat, Position);
-        transMat = glm::inverse(transMat);
-        glm::mat4 rotMat = glm::mat4(1.0f);
-        rotMat[0][0] = Right.x;
-        rotMat[1][0] = Right.y;
-        rotMat[2][0] = Right.z;
-        rotMat[0][1] = Up.x;
-        rotMat[1][1] = Up.y;
-        rotMat[2][1] = Up.z;
-        rotMat[0][2] = -Front.x;
-        rotMat[1][2] = -Front.y;
-        rotMat[2][2] = -Front.z;
-        return rotMat * transMat;
-        // return glm::lookAt(Position, Position + Front, Up);
+    const glm::mat4 &GetViewMatrix()
+    {
+        Refresh();
+        return view;
+    }
+
+    const glm::mat4 &GetProjectionMatrix()
+    {
+        Refresh();
+        return projection;
+    }
+
+    const glm::mat4 &GetViewProjectionMatrix()
+    {
+        RefreshViewProjection();
+        return viewProjection;
+    }
+
+    // camera to world
+    const glm::mat4 &GetInverseViewMatrix()
+    {
+        Refresh();
+        return inverseView;
+    }
+
+    // clip space to world, for unprojecting
+    const glm::mat4 &GetInverseViewProjectionMatrix()
+    {
+        RefreshViewProjection();
+        if (!inverseValid)
+        {
+            inverseViewProjection = inverseView * glm::inverse(projection);
+            inverseValid = true;
+        }
+        return inverseViewProjection;
+    }
+
+    const Culling::Frustum &GetFrustum()
+    {
+        RefreshViewProjection();
+        return frustum;
+    }
+
+    // changes whenever the matrices do
+    uint64_t Version()
+    {
+        Refresh();
+        return version;
+    }
+
+    void SetAspectRatio(float aspectRatio)
+    {
+        AspectRatio = aspectRatio;
     }
 
     void printMat4(glm::mat4 mat){
@@ -144,6 +198,8 @@ public:
     // processes input received from a mouse input system. Expects the offset value in both the x and y direction.
     void ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true)
     {
+        if (xoffset == 0.0f && yoffset == 0.0f)
+            return;
         xoffset *= MouseSensitivity;
         yoffset *= MouseSensitivity;
 
@@ -163,6 +219,15 @@ public:
         updateCameraVectors();
     }
 
+    // places the camera directly, for scripted paths that don't go through input
+    void SetPose(glm::vec3 position, float yaw, float pitch)
+    {
+        Position = position;
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
     // processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
     void ProcessMouseScroll(float yoffset)
     {
@@ -174,14 +239,109 @@ public:
     }
 
 private:
+    // what the cached matrices were built from
+    struct PoseKey {
+        glm::vec3 position;
+        float yaw, pitch;
+    };
+
+    struct LensKey {
+        float zoom, aspectRatio, nearPlane, farPlane, reverseZ;
+    };
+
+    bool cached = false;
+    PoseKey pose;
+    LensKey lens;
+    bool viewProjectionValid = false;
+    bool inverseValid = false;
+    uint64_t version = 0;
+    glm::mat4 view, projection, viewProjection, inverseView, inverseViewProjection;
+    Culling::Frustum frustum;
+
+    static uint64_t NextVersion()
+    {
+        static std::atomic<uint64_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    void Refresh()
+    {
+        PoseKey currentPose = { Position, Yaw, Pitch };
+        LensKey currentLens = { Zoom, AspectRatio, Near, Far, ReverseZ ? 1.0f : 0.0f };
+        bool poseChanged = !cached || memcmp(&currentPose, &pose, sizeof(PoseKey)) != 0;
+        bool lensChanged = !cached || memcmp(&currentLens, &lens, sizeof(LensKey)) != 0;
+        if (!poseChanged && !lensChanged)
+            return;
+        cached = true;
+        version = NextVersion();
+        viewProjectionValid = false;
+        inverseValid = false;
+        if (poseChanged)
+        {
+            pose = currentPose;
+            RefreshView();
+        }
+        if (lensChanged)
+        {
+            lens = currentLens;
+            projection = ReverseZ ? ReversedInfinitePerspective(glm::radians(Zoom), AspectRatio, Near) : glm::perspective(glm::radians(Zoom), AspectRatio, Near, Far);
+        }
+    }
+
+    // clip z is near and w is -z, so depth is near / distance: 1 at the near plane, 0 at infinity,
+    // and float depth keeps its precision where the distances are large
+    static glm::mat4 ReversedInfinitePerspective(float fovy, float aspect, float nearPlane)
+    {
+        float f = 1.0f / tan(fovy * 0.5f);
+        glm::mat4 result(0.0f);
+        result[0][0] = f / aspect;
+        result[1][1] = f;
+        result[2][3] = -1.0f;
+        result[3][2] = nearPlane;
+        return result;
+    }
+
+    void RefreshViewProjection()
+    {
+        Refresh();
+        if (viewProjectionValid)
+            return;
+        viewProjection = projection * view;
+        frustum = Culling::Frustum::fromMatrix(viewProjection, ReverseZ ? Culling::Frustum::REVERSED_ZERO_TO_ONE : Culling::Frustum::NEGATIVE_ONE_TO_ONE);
+        viewProjectionValid = true;
+    }
+
+    void RefreshView()
+    {
+        // the rotation's rows are the camera axes and the translation is already rotated, so
+        // there is nothing to invert
+        view = glm::mat4(1.0f);
+        view[0][0] = Right.x;
+        view[1][0] = Right.y;
+        view[2][0] = Right.z;
+        view[0][1] = Up.x;
+        view[1][1] = Up.y;
+        view[2][1] = Up.z;
+        view[0][2] = -Front.x;
+        view[1][2] = -Front.y;
+        view[2][2] = -Front.z;
+        view[3][0] = -glm::dot(Right, Position);
+        view[3][1] = -glm::dot(Up, Position);
+        view[3][2] = glm::dot(Front, Position);
+        inverseView = glm::mat4(glm::vec4(Right, 0.0f), glm::vec4(Up, 0.0f), glm::vec4(-Front, 0.0f), glm::vec4(Position, 1.0f));
+    }
+
     // calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors()
     {
-        // calculate the new Front vector
+        // calculate the new Front vector, one sin and cos per angle
+        float yaw = glm::radians(Yaw);
+        float pitch = glm::radians(Pitch);
+        float cosPitch = cos(pitch);
         glm::vec3 front;
-        front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-        front.y = sin(glm::radians(Pitch));
-        front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
+        front.x = cos(yaw) * cosPitch;
+        front.y = sin(pitch);
+        front.z = sin(yaw) * cosPitch;
         Front = glm::normalize(front);
         // also re-calculate the Right and Up vector
         Right = glm::normalize(glm::cross(Front, WorldUp));  // normalize the vectors, because their length gets closer to 0 the more you look up or down which results in slower movement.
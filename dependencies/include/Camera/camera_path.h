@@ -0,0 +1,200 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <Camera/camera.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// A camera pose per frame, for runs that have to be repeatable. Playback is by frame index,
+// not time: frame n of a run always draws pose n (paths shorter than the run loop), so two
+// runs render the same frames however long each frame took.
+//
+// Paths come from recording a live session (record() once per drawn frame, then save()) or
+// from the procedural ones below: orbit, flyThrough and strafe.
+//
+// File (.cpath), little endian:
+//
+//   Header              fixed size
+//   Pose[frameCount]    24 bytes each: position xyz, yaw, pitch, zoom
+
+class CameraPath {
+    public:
+        struct Pose {
+            glm::vec3 position;
+            float yaw;
+            float pitch;
+            float zoom;
+        };
+
+        struct Header {
+            uint8_t identifier[8];
+            uint32_t version;
+            uint32_t frameCount;
+            uint32_t reserved[4];
+        };
+
+        static_assert(sizeof(Pose) == 24, "Pose layout is part of the file format");
+        static_assert(sizeof(Header) == 32, "Header layout is part of the file format");
+
+        static constexpr uint8_t IDENTIFIER[8] = { 0xAB, 'C', 'P', 'A', 'T', 'H', 0xBB, 0x1A };
+        static const uint32_t VERSION = 1;
+
+        size_t frames() const{
+            return this->poses.size();
+        }
+
+        bool empty() const{
+            return this->poses.empty();
+        }
+
+        void clear(){
+            this->poses.clear();
+        }
+
+        void add(const Pose &pose){
+            this->poses.push_back(pose);
+        }
+
+        // the pose the camera is drawn with this frame
+        void record(const Camera &camera){
+            this->poses.push_back(Pose{ camera.Position, camera.Yaw, camera.Pitch, camera.Zoom });
+        }
+
+        // loops past the end; the path must not be empty
+        const Pose &pose(uint64_t frame) const{
+            return this->poses[static_cast<size_t>(frame % this->poses.size())];
+        }
+
+        void apply(uint64_t frame, Camera &camera) const{
+            const Pose &current = pose(frame);
+            camera.SetPose(current.position, current.yaw, current.pitch);
+            camera.Zoom = current.zoom;
+        }
+
+        bool save(const std::string &path) const{
+            Header header = {};
+            memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+            header.version = VERSION;
+            header.frameCount = static_cast<uint32_t>(this->poses.size());
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if(!out){
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(this->poses.data()), static_cast<std::streamsize>(sizeof(Pose) * this->poses.size()));
+            return static_cast<bool>(out);
+        }
+
+        bool load(const std::string &path, std::string &error){
+            std::ifstream in(path, std::ios::binary);
+            if(!in){
+                error = "can't open " + path;
+                return false;
+            }
+            Header header;
+            if(!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0){
+                error = path + " is not a camera path";
+                return false;
+            }
+            if(header.version != VERSION){
+                error = path + " is version " + std::to_string(header.version) + ", expected " + std::to_string(VERSION);
+                return false;
+            }
+            if(header.frameCount == 0){
+                error = path + " has no frames";
+                return false;
+            }
+            // the count comes from the file, check it against the poses actually there before allocating
+            in.seekg(0, std::ios::end);
+            std::streamoff size = in.tellg();
+            in.seekg(sizeof(Header), std::ios::beg);
+            uint64_t expected = sizeof(Header) + static_cast<uint64_t>(sizeof(Pose)) * header.frameCount;
+            if(size < 0 || static_cast<uint64_t>(size) != expected){
+                error = path + (size >= 0 && static_cast<uint64_t>(size) < expected ? " is truncated" : " has data past its " + std::to_string(header.frameCount) + " frames");
+                return false;
+            }
+            std::vector<Pose> loaded(header.frameCount);
+            if(!in.read(reinterpret_cast<char*>(loaded.data()), static_cast<std::streamsize>(sizeof(Pose) * loaded.size()))){
+                error = path + " is truncated";
+                return false;
+            }
+            this->poses.swap(loaded);
+            return true;
+        }
+
+        #pragma region Procedural paths
+        // one turn around center at radius over frames, looking at center and bobbing
+        // bobHeight up and down twice per turn
+        static CameraPath orbit(const glm::vec3 &center, float radius, float bobHeight, uint64_t frames){
+            CameraPath path;
+            for(uint64_t frame = 0; frame < frames; frame++){
+                float angle = turn(frame, frames);
+                glm::vec3 position = center + glm::vec3(radius * std::cos(angle), bobHeight * std::sin(2.0f * angle), radius * std::sin(angle));
+                path.add(looking(position, center - position));
+            }
+            return path;
+        }
+
+        // a closed loop through waypoints (Catmull-Rom, constant time per segment) over
+        // frames, looking where it is going
+        static CameraPath flyThrough(const std::vector<glm::vec3> &waypoints, uint64_t frames){
+            CameraPath path;
+            size_t count = waypoints.size();
+            if(count < 2){
+                return path;
+            }
+            for(uint64_t frame = 0; frame < frames; frame++){
+                float t = static_cast<float>(frame) / static_cast<float>(frames) * count;
+                size_t segment = static_cast<size_t>(t) % count;
+                float local = t - std::floor(t);
+                const glm::vec3 &p0 = waypoints[(segment + count - 1) % count];
+                const glm::vec3 &p1 = waypoints[segment];
+                const glm::vec3 &p2 = waypoints[(segment + 1) % count];
+                const glm::vec3 &p3 = waypoints[(segment + 2) % count];
+                glm::vec3 position = catmullRom(p0, p1, p2, p3, local);
+                glm::vec3 tangent = 0.5f * ((p2 - p0) + 2.0f * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * local + 3.0f * (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * local * local);
+                path.add(looking(position, glm::length(tangent) > 0.0f ? tangent : p2 - p1));
+            }
+            return path;
+        }
+
+        // sideways from center by up to halfWidth and back over frames, facing yaw and pitch
+        // the whole time: everything in view slides across the screen
+        static CameraPath strafe(const glm::vec3 &center, float halfWidth, float yaw, float pitch, uint64_t frames){
+            CameraPath path;
+            glm::vec3 right = glm::vec3(-std::sin(glm::radians(yaw)), 0.0f, std::cos(glm::radians(yaw)));
+            for(uint64_t frame = 0; frame < frames; frame++){
+                path.add(Pose{ center + right * (halfWidth * std::sin(turn(frame, frames))), yaw, pitch, ZOOM });
+            }
+            return path;
+        }
+        #pragma endregion
+
+    private:
+        std::vector<Pose> poses;
+
+        // radians around a full turn at frame
+        static float turn(uint64_t frame, uint64_t frames){
+            return static_cast<float>(frame) / static_cast<float>(frames > 0 ? frames : 1) * 2.0f * glm::pi<float>();
+        }
+
+        static Pose looking(const glm::vec3 &position, const glm::vec3 &direction){
+            glm::vec3 forward = glm::normalize(direction);
+            return Pose{ position, glm::degrees(std::atan2(forward.z, forward.x)), glm::degrees(std::asin(forward.y)), ZOOM };
+        }
+
+        static glm::vec3 catmullRom(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, float t){
+            float t2 = t * t;
+            float t3 = t2 * t;
+            return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+        }
+};
+
+#endif
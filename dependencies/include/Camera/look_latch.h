@@ -0,0 +1,68 @@
+#ifndef LOOK_LATCH_H
+#define LOOK_LATCH_H
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+// Mouse look deltas for late latching. Cursor callbacks add() from the window thread without
+// a lock; readers take a snapshot of the running totals whenever they like. Totals only ever
+// grow, so any number of readers can each keep the snapshot they last applied and use the
+// difference: the simulation tick turns it into the camera's orientation, and the renderer
+// adds what arrived after the tick to that orientation right before submitting the frame,
+// instead of showing it a tick (and a frame) later.
+//
+// Totals are fixed point (1/1024 of a pixel) so adding is one fetch_add per axis. A snapshot
+// taken between the two axes of an add() sees half of it; the other half shows up in the
+// next snapshot, nothing is lost.
+
+class LookLatch {
+    public:
+        struct Totals {
+            int64_t x = 0;
+            int64_t y = 0;
+            uint64_t events = 0;
+        };
+
+        static constexpr float UNITS_PER_PIXEL = 1024.0f;
+
+        // time is the event's timestamp (glfwGetTime), kept for latency measurements
+        void add(float dx, float dy, double time){
+            this->x.fetch_add(static_cast<int64_t>(std::lround(dx * UNITS_PER_PIXEL)), std::memory_order_relaxed);
+            this->y.fetch_add(static_cast<int64_t>(std::lround(dy * UNITS_PER_PIXEL)), std::memory_order_relaxed);
+            double none = 0.0;
+            this->oldest.compare_exchange_strong(none, time, std::memory_order_relaxed);
+            this->count.fetch_add(1, std::memory_order_release);
+        }
+
+        Totals totals() const{
+            Totals result;
+            result.events = this->count.load(std::memory_order_acquire);
+            result.x = this->x.load(std::memory_order_relaxed);
+            result.y = this->y.load(std::memory_order_relaxed);
+            return result;
+        }
+
+        // pixels moved between two snapshots
+        static float deltaX(const Totals &from, const Totals &to){
+            return static_cast<float>(to.x - from.x) / UNITS_PER_PIXEL;
+        }
+
+        static float deltaY(const Totals &from, const Totals &to){
+            return static_cast<float>(to.y - from.y) / UNITS_PER_PIXEL;
+        }
+
+        // timestamp of the oldest event since the last call, 0 when there was none; for the
+        // one consumer that reports input latency
+        double takeOldestEvent(){
+            return this->oldest.exchange(0.0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<int64_t> x{0};
+        std::atomic<int64_t> y{0};
+        std::atomic<uint64_t> count{0};
+        std::atomic<double> oldest{0.0};
+};
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <Simd/cpu_features.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// View frustum culling. The six planes are pulled straight out of the combined
+// projection * view matrix (Gribb & Hartmann) and normalised, so a point's signed distance
+// to a plane is dot(normal, p) + distance and spheres test against their radius. The near
+// and far planes depend on the clip space depth range the projection was built for: GL's
+// default -w..w, 0..w after glClipControl(GL_ZERO_TO_ONE), or 0..w reversed (near at w).
+// An infinite far plane comes out with a zero normal and distance, which nothing is behind.
+//
+// Single objects use testSphere / testAabb. Large batches keep their bounding spheres as
+// separate x, y, z, radius arrays (SphereSoA) and go through cullSpheres, which tests four
+// (SSE2) or eight (AVX2) spheres per plane at a time and writes one visibility byte each.
+
+namespace Culling {
+
+    struct Plane {
+        glm::vec3 normal = glm::vec3(0.0f);
+        float distance = 0.0f;
+
+        float signedDistance(const glm::vec3 &point) const{
+            return glm::dot(normal, point) + distance;
+        }
+    };
+
+    class Frustum {
+        public:
+            enum Side { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+            Plane planes[PLANE_COUNT];
+
+            enum DepthRange {
+                NEGATIVE_ONE_TO_ONE,    // -w <= z <= w, near at -w
+                ZERO_TO_ONE,            // 0 <= z <= w, near at 0
+                REVERSED_ZERO_TO_ONE    // 0 <= z <= w, near at w
+            };
+
+            static Frustum fromMatrix(const glm::mat4 &viewProjection, DepthRange depth = NEGATIVE_ONE_TO_ONE){
+                // rows of the matrix, glm stores columns
+                glm::vec4 rows[4];
+                for(int r = 0; r < 4; r++){
+                    rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+                }
+                glm::vec4 nearSide = depth == NEGATIVE_ONE_TO_ONE ? rows[3] + rows[2] : depth == ZERO_TO_ONE ? rows[2] : rows[3] - rows[2];
+                glm::vec4 farSide = depth == REVERSED_ZERO_TO_ONE ? rows[2] : rows[3] - rows[2];
+                const glm::vec4 sides[PLANE_COUNT] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], nearSide, farSide };
+                Frustum frustum;
+                for(int i = 0; i < PLANE_COUNT; i++){
+                    float length = glm::length(glm::vec3(sides[i]));
+                    float scale = length > 0.0f ? 1.0f / length : 0.0f;
+                    frustum.planes[i].normal = glm::vec3(sides[i]) * scale;
+                    frustum.planes[i].distance = sides[i].w * scale;
+                }
+                return frustum;
+            }
+
+            bool testSphere(const glm::vec3 &center, float radius) const{
+                for(const Plane &plane : planes){
+                    if(plane.signedDistance(center) < -radius){
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // tests the corner furthest along each plane normal, conservative near the edges
+            bool testAabb(const glm::vec3 &min, const glm::vec3 &max) const{
+                for(const Plane &plane : planes){
+                    glm::vec3 positive = glm::vec3(plane.normal.x >= 0.0f ? max.x : min.x,
+                                                   plane.normal.y >= 0.0f ? max.y : min.y,
+                                                   plane.normal.z >= 0.0f ? max.z : min.z);
+                    if(plane.signedDistance(positive) < 0.0f){
+                        return false;
+                    }
+                }
+                return true;
+            }
+    };
+
+    // bounding spheres split into one array per component for the batched kernels
+    struct SphereSoA {
+        std::vector<float> x, y, z, radius;
+
+        void add(const glm::vec3 &center, float r){
+            x.push_back(center.x);
+            y.push_back(center.y);
+            z.push_back(center.z);
+            radius.push_back(r);
+        }
+
+        void clear(){
+            x.clear();
+            y.clear();
+            z.clear();
+            radius.clear();
+        }
+
+        size_t size() const{
+            return x.size();
+        }
+    };
+
+    #pragma region Kernels
+    // visible[i] = 1 when sphere i touches the frustum, returns the visible count
+    inline size_t cullSpheresScalar(const Frustum &frustum, const SphereSoA &spheres, size_t first, size_t count, uint8_t* visible){
+        size_t inside = 0;
+        for(size_t i = first; i < first + count; i++){
+            glm::vec3 center = glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]);
+            visible[i] = frustum.testSphere(center, spheres.radius[i]) ? 1 : 0;
+            inside += visible[i];
+        }
+        return inside;
+    }
+
+#if defined(SIMD_SSE2)
+    inline size_t cullSpheresSse2(const Frustum &frustum, const SphereSoA &spheres, uint8_t* visible){
+        size_t count = spheres.size();
+        size_t inside = 0;
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4){
+            __m128 x = _mm_loadu_ps(&spheres.x[i]);
+            __m128 y = _mm_loadu_ps(&spheres.y[i]);
+            __m128 z = _mm_loadu_ps(&spheres.z[i]);
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+            __m128 outside = _mm_setzero_ps();
+            for(const Plane &plane : frustum.planes){
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.normal.x)), _mm_mul_ps(y, _mm_set1_ps(plane.normal.y))),
+                                             _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.normal.z)), _mm_set1_ps(plane.distance)));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+            }
+            int mask = _mm_movemask_ps(outside);
+            for(int lane = 0; lane < 4; lane++){
+                visible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+                inside += visible[i + lane];
+            }
+        }
+        return inside + cullSpheresScalar(frustum, spheres, i, count - i, visible);
+    }
+#endif
+
+#if defined(SIMD_X86)
+    SIMD_TARGET_AVX2 inline size_t cullSpheresAvx2(const Frustum &frustum, const SphereSoA &spheres, uint8_t* visible){
+        size_t count = spheres.size();
+        size_t inside = 0;
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8){
+            __m256 x = _mm256_loadu_ps(&spheres.x[i]);
+            __m256 y = _mm256_loadu_ps(&spheres.y[i]);
+            __m256 z = _mm256_loadu_ps(&spheres.z[i]);
+            __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[i]));
+            __m256 outside = _mm256_setzero_ps();
+            for(const Plane &plane : frustum.planes){
+                __m256 distance = _mm256_fmadd_ps(x, _mm256_set1_ps(plane.normal.x),
+                                  _mm256_fmadd_ps(y, _mm256_set1_ps(plane.normal.y),
+                                  _mm256_fmadd_ps(z, _mm256_set1_ps(plane.normal.z), _mm256_set1_ps(plane.distance))));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+            }
+            int mask = _mm256_movemask_ps(outside);
+            for(int lane = 0; lane < 8; lane++){
+                visible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+                inside += visible[i + lane];
+            }
+        }
+        return inside + cullSpheresScalar(frustum, spheres, i, count - i, visible);
+    }
+#endif
+    #pragma endregion
+
+    // widest kernel the CPU supports; visible needs spheres.size() bytes
+    inline size_t cullSpheres(const Frustum &frustum, const SphereSoA &spheres, uint8_t* visible, bool allowSimd = true){
+#if defined(SIMD_X86)
+        if(allowSimd && Simd::hasAvx2()){
+            return cullSpheresAvx2(frustum, spheres, visible);
+        }
+#endif
+#if defined(SIMD_SSE2)
+        if(allowSimd){
+            return cullSpheresSse2(frustum, spheres, visible);
+        }
+#endif
+        return cullSpheresScalar(frustum, spheres, 0, spheres.size(), visible);
+    }
+
+    inline size_t cullAabbs(const Frustum &frustum, const glm::vec3* mins, const glm::vec3* maxs, size_t count, uint8_t* visible){
+        size_t inside = 0;
+        for(size_t i = 0; i < count; i++){
+            visible[i] = frustum.testAabb(mins[i], maxs[i]) ? 1 : 0;
+            inside += visible[i];
+        }
+        return inside;
+    }
+}
+
+#endif
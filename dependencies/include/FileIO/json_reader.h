@@ -0,0 +1,326 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Small JSON reader for asset metadata (the glTF importer). Builds the whole document as a
+// tree of Values; lookups of missing keys or indices return a shared null Value instead of
+// failing, so optional fields read as value["key"].numberOr(default). Numbers are doubles,
+// strings are unescaped to UTF-8. The input doesn't have to be NUL terminated.
+
+namespace Json {
+
+    struct Value {
+        enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+        Type type = NUL;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<Value> array;
+        std::vector<std::pair<std::string, Value>> object;
+
+        static const Value &null(){
+            static const Value none;
+            return none;
+        }
+
+        bool isNull() const{
+            return type == NUL;
+        }
+
+        bool has(const char* key) const{
+            return !(*this)[key].isNull();
+        }
+
+        size_t size() const{
+            return type == ARRAY ? array.size() : type == OBJECT ? object.size() : 0;
+        }
+
+        const Value &operator[](const char* key) const{
+            if(type == OBJECT){
+                for(const std::pair<std::string, Value> &member : object){
+                    if(member.first == key){
+                        return member.second;
+                    }
+                }
+            }
+            return null();
+        }
+
+        const Value &operator[](size_t index) const{
+            return type == ARRAY && index < array.size() ? array[index] : null();
+        }
+
+        // literal indices (value[0]) would be ambiguous with the key lookup otherwise
+        const Value &operator[](int index) const{
+            return index >= 0 ? (*this)[static_cast<size_t>(index)] : null();
+        }
+
+        double numberOr(double fallback) const{
+            return type == NUMBER ? number : fallback;
+        }
+
+        // a non negative integer, fallback for anything else
+        int64_t indexOr(int64_t fallback) const{
+            return type == NUMBER && number >= 0.0 && number < 9.0e15 && number == static_cast<double>(static_cast<int64_t>(number)) ? static_cast<int64_t>(number) : fallback;
+        }
+
+        std::string stringOr(const std::string &fallback) const{
+            return type == STRING ? string : fallback;
+        }
+    };
+
+    class Reader {
+        public:
+            Reader(const char* text, size_t size) : p(text), end(text + size){}
+
+            bool read(Value &value, std::string &error){
+                this->depth = 0;
+                if(!this->value(value)){
+                    error = this->message;
+                    return false;
+                }
+                skip();
+                if(this->p != this->end){
+                    error = "trailing characters after the document";
+                    return false;
+                }
+                return true;
+            }
+
+        private:
+            static const int MAX_DEPTH = 256;
+
+            const char* p;
+            const char* end;
+            int depth = 0;
+            std::string message;
+
+            bool fail(const char* what){
+                this->message = what;
+                return false;
+            }
+
+            void skip(){
+                while(this->p < this->end && (*this->p == ' ' || *this->p == '\t' || *this->p == '\n' || *this->p == '\r')){
+                    this->p++;
+                }
+            }
+
+            bool literal(const char* word){
+                size_t length = strlen(word);
+                if(static_cast<size_t>(this->end - this->p) < length || memcmp(this->p, word, length) != 0){
+                    return fail("unexpected characters");
+                }
+                this->p += length;
+                return true;
+            }
+
+            bool value(Value &out){
+                skip();
+                if(this->p >= this->end){
+                    return fail("unexpected end of document");
+                }
+                switch(*this->p){
+                    case '{': return object(out);
+                    case '[': return array(out);
+                    case '"': out.type = Value::STRING; return string(out.string);
+                    case 't': out.type = Value::BOOLEAN; out.boolean = true; return literal("true");
+                    case 'f': out.type = Value::BOOLEAN; out.boolean = false; return literal("false");
+                    case 'n': out.type = Value::NUL; return literal("null");
+                    default: return number(out);
+                }
+            }
+
+            bool object(Value &out){
+                if(++this->depth > MAX_DEPTH){
+                    return fail("nested too deep");
+                }
+                out.type = Value::OBJECT;
+                this->p++;
+                skip();
+                if(this->p < this->end && *this->p == '}'){
+                    this->p++;
+                    this->depth--;
+                    return true;
+                }
+                for(;;){
+                    skip();
+                    if(this->p >= this->end || *this->p != '"'){
+                        return fail("expected a member name");
+                    }
+                    out.object.emplace_back();
+                    if(!string(out.object.back().first)){
+                        return false;
+                    }
+                    skip();
+                    if(this->p >= this->end || *this->p != ':'){
+                        return fail("expected ':'");
+                    }
+                    this->p++;
+                    if(!value(out.object.back().second)){
+                        return false;
+                    }
+                    skip();
+                    if(this->p < this->end && *this->p == ','){
+                        this->p++;
+                        continue;
+                    }
+                    if(this->p < this->end && *this->p == '}'){
+                        this->p++;
+                        this->depth--;
+                        return true;
+                    }
+                    return fail("expected ',' or '}'");
+                }
+            }
+
+            bool array(Value &out){
+                if(++this->depth > MAX_DEPTH){
+                    return fail("nested too deep");
+                }
+                out.type = Value::ARRAY;
+                this->p++;
+                skip();
+                if(this->p < this->end && *this->p == ']'){
+                    this->p++;
+                    this->depth--;
+                    return true;
+                }
+                for(;;){
+                    out.array.emplace_back();
+                    if(!value(out.array.back())){
+                        return false;
+                    }
+                    skip();
+                    if(this->p < this->end && *this->p == ','){
+                        this->p++;
+                        continue;
+                    }
+                    if(this->p < this->end && *this->p == ']'){
+                        this->p++;
+                        this->depth--;
+                        return true;
+                    }
+                    return fail("expected ',' or ']'");
+                }
+            }
+
+            static void appendUtf8(std::string &out, uint32_t code){
+                if(code < 0x80){
+                    out += static_cast<char>(code);
+                }
+                else if(code < 0x800){
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else if(code < 0x10000){
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else{
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+            }
+
+            bool hex4(uint32_t &code){
+                if(this->end - this->p < 4){
+                    return fail("truncated \\u escape");
+                }
+                code = 0;
+                for(int i = 0; i < 4; i++){
+                    char c = *this->p++;
+                    code <<= 4;
+                    if(c >= '0' && c <= '9') code |= static_cast<uint32_t>(c - '0');
+                    else if(c >= 'a' && c <= 'f') code |= static_cast<uint32_t>(c - 'a' + 10);
+                    else if(c >= 'A' && c <= 'F') code |= static_cast<uint32_t>(c - 'A' + 10);
+                    else return fail("bad \\u escape");
+                }
+                return true;
+            }
+
+            bool string(std::string &out){
+                this->p++;
+                for(;;){
+                    const char* run = this->p;
+                    while(this->p < this->end && *this->p != '"' && *this->p != '\\'){
+                        this->p++;
+                    }
+                    out.append(run, this->p);
+                    if(this->p >= this->end){
+                        return fail("unterminated string");
+                    }
+                    if(*this->p++ == '"'){
+                        return true;
+                    }
+                    if(this->p >= this->end){
+                        return fail("unterminated string");
+                    }
+                    char escape = *this->p++;
+                    switch(escape){
+                        case '"': out += '"'; break;
+                        case '\\': out += '\\'; break;
+                        case '/': out += '/'; break;
+                        case 'b': out += '\b'; break;
+                        case 'f': out += '\f'; break;
+                        case 'n': out += '\n'; break;
+                        case 'r': out += '\r'; break;
+                        case 't': out += '\t'; break;
+                        case 'u': {
+                            uint32_t code;
+                            if(!hex4(code)){
+                                return false;
+                            }
+                            // a surrogate pair is two escapes
+                            if(code >= 0xD800 && code < 0xDC00 && this->end - this->p >= 6 && this->p[0] == '\\' && this->p[1] == 'u'){
+                                this->p += 2;
+                                uint32_t low;
+                                if(!hex4(low)){
+                                    return false;
+                                }
+                                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                            }
+                            appendUtf8(out, code);
+                            break;
+                        }
+                        default: return fail("bad escape");
+                    }
+                }
+            }
+
+            bool number(Value &out){
+                // copied out so strtod stops inside the document
+                char buffer[64];
+                size_t length = 0;
+                while(this->p + length < this->end && length < sizeof(buffer) - 1 && strchr("+-0123456789.eE", this->p[length]) != NULL){
+                    buffer[length] = this->p[length];
+                    length++;
+                }
+                buffer[length] = '\0';
+                char* stop = NULL;
+                out.type = Value::NUMBER;
+                out.number = strtod(buffer, &stop);
+                if(length == 0 || stop != buffer + length){
+                    return fail("bad number");
+                }
+                this->p += length;
+                return true;
+            }
+    };
+
+    inline bool parse(const char* text, size_t size, Value &value, std::string &error){
+        return Reader(text, size).read(value, error);
+    }
+}
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file. Pages are faulted in by the OS on first
+// touch, so data can be handed straight to GL without an intermediate copy.
+class MappedFile {
+    public:
+        MappedFile(){}
+
+        explicit MappedFile(const std::string &path){
+            open(path);
+        }
+
+        ~MappedFile(){
+            close();
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile &&other) noexcept {
+            *this = static_cast<MappedFile&&>(other);
+        }
+
+        MappedFile& operator=(MappedFile &&other) noexcept {
+            if(this != &other){
+                close();
+                bytes = other.bytes;
+                length = other.length;
+#if defined(_WIN32)
+                fileHandle = other.fileHandle;
+                mapHandle = other.mapHandle;
+                other.fileHandle = INVALID_HANDLE_VALUE;
+                other.mapHandle = NULL;
+#endif
+                other.bytes = nullptr;
+                other.length = 0;
+            }
+            return *this;
+        }
+
+        bool open(const std::string &path){
+            close();
+#if defined(_WIN32)
+            fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if(fileHandle == INVALID_HANDLE_VALUE){
+                return false;
+            }
+            LARGE_INTEGER size;
+            if(!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0){
+                close();
+                return false;
+            }
+            mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+            if(mapHandle == NULL){
+                close();
+                return false;
+            }
+            bytes = static_cast<const uint8_t*>(MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0));
+            length = static_cast<size_t>(size.QuadPart);
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if(fd < 0){
+                return false;
+            }
+            struct stat info;
+            if(fstat(fd, &info) != 0 || info.st_size == 0){
+                ::close(fd);
+                return false;
+            }
+            void* mapping = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            // the mapping keeps its own reference to the file
+            ::close(fd);
+            if(mapping == MAP_FAILED){
+                return false;
+            }
+            bytes = static_cast<const uint8_t*>(mapping);
+            length = static_cast<size_t>(info.st_size);
+#endif
+            if(bytes == nullptr){
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close(){
+#if defined(_WIN32)
+            if(bytes != nullptr) UnmapViewOfFile(bytes);
+            if(mapHandle != NULL) CloseHandle(mapHandle);
+            if(fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+            mapHandle = NULL;
+            fileHandle = INVALID_HANDLE_VALUE;
+#else
+            if(bytes != nullptr) munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+            bytes = nullptr;
+            length = 0;
+        }
+
+        // hint that the whole range will be read front to back soon
+        void willNeed() const{
+#if !defined(_WIN32)
+            if(bytes != nullptr){
+                madvise(const_cast<uint8_t*>(bytes), length, MADV_WILLNEED);
+            }
+#endif
+        }
+
+        bool isOpen() const{
+            return bytes != nullptr;
+        }
+
+        const uint8_t* data() const{
+            return bytes;
+        }
+
+        size_t size() const{
+            return length;
+        }
+
+    private:
+        const uint8_t* bytes = nullptr;
+        size_t length = 0;
+#if defined(_WIN32)
+        HANDLE fileHandle = INVALID_HANDLE_VALUE;
+        HANDLE mapHandle = NULL;
+#endif
+};
+
+#endif
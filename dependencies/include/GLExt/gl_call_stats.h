@@ -0,0 +1,439 @@
+#ifndef GL_CALL_STATS_H
+#define GL_CALL_STATS_H
+
+#include <glad/glad.h>
+#include <GLExt/gl_entry_points.h>
+#include <GLExt/gl_hooks.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Per frame GL call accounting. install() hooks every glad entry point (see gl_hooks.h) with
+// an observer that counts the call by entry point before it goes to the driver, so nothing
+// outside this file changes; uninstall() removes the observers again. Until install() is
+// called there is no cost at all.
+//
+// Besides raw call counts it tracks draws with their vertices, instances and primitives,
+// binds (glBind*), uniform uploads (glUniform*, in bytes), buffer bytes handed to
+// glBufferData/glBufferSubData or mapped for writing with glMapBufferRange, and texture bytes
+// of the glTex(Sub)Image / glCompressedTex(Sub)Image calls. Texture bytes assume tightly packed
+// rows and include uploads sourced from a pixel unpack buffer, so a staged texture upload counts
+// once as buffer bytes (written into the mapping) and once as texture bytes (copied from it).
+//
+// Counting isn't synchronised, call GL from one thread (as GL requires per context anyway).
+//
+//   GLCallStats::install();            // after gladLoadGLLoader
+//   ... frame ...
+//   GLCallStats::endFrame();
+//   GLCallStats::lastFrame().drawCalls
+
+namespace GLCallStats {
+
+    struct Counters {
+        uint64_t calls = 0;
+        uint64_t drawCalls = 0;
+        uint64_t vertices = 0;          // vertices or indices submitted, times instances
+        uint64_t instances = 0;
+        uint64_t primitives = 0;
+        uint64_t binds = 0;
+        uint64_t uniformCalls = 0;
+        uint64_t uniformBytes = 0;
+        uint64_t bufferBytes = 0;
+        uint64_t textureBytes = 0;
+
+        Counters& operator+=(const Counters &other){
+            calls += other.calls;
+            drawCalls += other.drawCalls;
+            vertices += other.vertices;
+            instances += other.instances;
+            primitives += other.primitives;
+            binds += other.binds;
+            uniformCalls += other.uniformCalls;
+            uniformBytes += other.uniformBytes;
+            bufferBytes += other.bufferBytes;
+            textureBytes += other.textureBytes;
+            return *this;
+        }
+    };
+
+    struct EntryPoint {
+        const char* name;
+        uint64_t frameCalls = 0;
+        uint64_t totalCalls = 0;
+        bool bind = false;
+        bool uniformArray = false;      // glUniform*v, bytes scale with the count argument
+        uint32_t uniformBytes = 0;      // bytes per value, 0 for anything but glUniform*
+    };
+
+    struct State {
+        bool installed = false;
+        std::vector<EntryPoint> entries;
+        Counters frame;
+        Counters last;
+        Counters total;
+        uint64_t frames = 0;
+    };
+
+    inline State& state(){
+        static State instance;
+        return instance;
+    }
+
+    // glUniform{1,2,3,4}{f,i,ui}[v] and glUniformMatrix{2,3,4,2x3,...}fv, GL 3.3 has no doubles
+    inline void describeUniform(EntryPoint &entry){
+        const char* name = entry.name;
+        if(strncmp(name, "glUniformMatrix", 15) == 0){
+            int columns = name[15] - '0';
+            int rows = name[16] == 'x' ? name[17] - '0' : columns;
+            entry.uniformBytes = columns * rows * 4;
+            entry.uniformArray = true;
+        }
+        else if(strncmp(name, "glUniform", 9) == 0 && name[9] >= '1' && name[9] <= '4'){
+            entry.uniformBytes = (name[9] - '0') * 4;
+            entry.uniformArray = name[strlen(name) - 1] == 'v';
+        }
+    }
+
+    inline uint32_t registerEntry(const char* name){
+        EntryPoint entry;
+        entry.name = name;
+        entry.bind = strncmp(name, "glBind", 6) == 0;
+        describeUniform(entry);
+        state().entries.push_back(entry);
+        return static_cast<uint32_t>(state().entries.size() - 1);
+    }
+
+    // the count argument of glUniform*v / glUniformMatrix*fv
+    template<typename First, typename Second, typename... Rest>
+    inline uint64_t secondArgument(First, Second second, Rest...){
+        if constexpr(std::is_integral<Second>::value){
+            return second > 0 ? static_cast<uint64_t>(second) : 0;
+        }
+        else{
+            return 1;
+        }
+    }
+
+    inline uint64_t secondArgument(...){
+        return 1;
+    }
+
+    template<typename... A>
+    inline void record(uint32_t index, A... args){
+        State &s = state();
+        EntryPoint &entry = s.entries[index];
+        entry.frameCalls++;
+        s.frame.calls++;
+        s.frame.binds += entry.bind ? 1 : 0;
+        if(entry.uniformBytes != 0){
+            s.frame.uniformCalls++;
+            s.frame.uniformBytes += entry.uniformBytes * (entry.uniformArray ? secondArgument(args...) : 1);
+        }
+    }
+
+    inline uint64_t primitivesFor(GLenum mode, uint64_t vertices){
+        switch(mode){
+            case GL_POINTS: return vertices;
+            case GL_LINES: return vertices / 2;
+            case GL_LINE_LOOP: return vertices >= 2 ? vertices : 0;
+            case GL_LINE_STRIP: return vertices >= 2 ? vertices - 1 : 0;
+            case GL_TRIANGLES: return vertices / 3;
+            case GL_TRIANGLE_STRIP:
+            case GL_TRIANGLE_FAN: return vertices >= 3 ? vertices - 2 : 0;
+            case GL_LINES_ADJACENCY: return vertices / 4;
+            case GL_LINE_STRIP_ADJACENCY: return vertices >= 4 ? vertices - 3 : 0;
+            case GL_TRIANGLES_ADJACENCY: return vertices / 6;
+            case GL_TRIANGLE_STRIP_ADJACENCY: return vertices >= 6 ? (vertices - 4) / 2 : 0;
+            default: return 0;
+        }
+    }
+
+    inline void addDraw(GLenum mode, GLsizei count, GLsizei instances){
+        Counters &frame = state().frame;
+        uint64_t vertices = static_cast<uint64_t>(std::max(count, 0));
+        uint64_t copies = static_cast<uint64_t>(std::max(instances, 0));
+        frame.drawCalls++;
+        frame.instances += copies;
+        frame.vertices += vertices * copies;
+        frame.primitives += primitivesFor(mode, vertices) * copies;
+    }
+
+    // bytes per pixel of an uncompressed upload, 0 when the combination isn't known
+    inline uint64_t pixelBytes(GLenum format, GLenum type){
+        switch(type){
+            case GL_UNSIGNED_BYTE_3_3_2: case GL_UNSIGNED_BYTE_2_3_3_REV:
+                return 1;
+            case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_5_6_5_REV:
+            case GL_UNSIGNED_SHORT_4_4_4_4: case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+            case GL_UNSIGNED_SHORT_5_5_5_1: case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+                return 2;
+            case GL_UNSIGNED_INT_8_8_8_8: case GL_UNSIGNED_INT_8_8_8_8_REV:
+            case GL_UNSIGNED_INT_10_10_10_2: case GL_UNSIGNED_INT_2_10_10_10_REV:
+            case GL_UNSIGNED_INT_24_8: case GL_UNSIGNED_INT_10F_11F_11F_REV: case GL_UNSIGNED_INT_5_9_9_9_REV:
+                return 4;
+            case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+                return 8;
+        }
+        uint64_t component = 0;
+        switch(type){
+            case GL_UNSIGNED_BYTE: case GL_BYTE: component = 1; break;
+            case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: component = 2; break;
+            case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: component = 4; break;
+            default: return 0;
+        }
+        switch(format){
+            case GL_RED: case GL_RED_INTEGER: case GL_GREEN: case GL_BLUE: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX:
+                return component;
+            case GL_RG: case GL_RG_INTEGER:
+                return component * 2;
+            case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: case GL_BGR_INTEGER:
+                return component * 3;
+            case GL_RGBA: case GL_BGRA: case GL_RGBA_INTEGER: case GL_BGRA_INTEGER:
+                return component * 4;
+            default:
+                return 0;
+        }
+    }
+
+    inline bool unpackBufferBound(){
+        // through the driver's pointer so the query doesn't show up in the counts
+        GLint buffer = 0;
+        GLHooks::Hook<&glad_glGetIntegerv>::real()(GL_PIXEL_UNPACK_BUFFER_BINDING, &buffer);
+        return buffer != 0;
+    }
+
+    // with an unpack buffer bound pixels is an offset into it, and 0 is a valid one
+    inline void addTextureUpload(const void* pixels, uint64_t width, uint64_t height, uint64_t depth, GLenum format, GLenum type){
+        if(pixels != NULL || unpackBufferBound()){
+            state().frame.textureBytes += width * height * depth * pixelBytes(format, type);
+        }
+    }
+
+    inline void addCompressedUpload(const void* data, GLsizei bytes){
+        if(data != NULL || unpackBufferBound()){
+            state().frame.textureBytes += static_cast<uint64_t>(std::max(bytes, 0));
+        }
+    }
+
+    // counts calls to the entry point whose glad pointer lives at Slot
+    template<auto* Slot>
+    struct Counter {
+        static inline uint32_t index = UINT32_MAX;
+
+        template<typename... A>
+        static void count(A... args){
+            record(index, args...);
+        }
+    };
+
+    #pragma region Observers
+    inline void onDrawArrays(GLenum mode, GLint, GLsizei count){
+        addDraw(mode, count, 1);
+    }
+
+    inline void onDrawArraysInstanced(GLenum mode, GLint, GLsizei count, GLsizei instances){
+        addDraw(mode, count, instances);
+    }
+
+    inline void onDrawElements(GLenum mode, GLsizei count, GLenum, const void*){
+        addDraw(mode, count, 1);
+    }
+
+    inline void onDrawElementsInstanced(GLenum mode, GLsizei count, GLenum, const void*, GLsizei instances){
+        addDraw(mode, count, instances);
+    }
+
+    inline void onDrawRangeElements(GLenum mode, GLuint, GLuint, GLsizei count, GLenum, const void*){
+        addDraw(mode, count, 1);
+    }
+
+    inline void onDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum, const void*, GLint){
+        addDraw(mode, count, 1);
+    }
+
+    inline void onDrawRangeElementsBaseVertex(GLenum mode, GLuint, GLuint, GLsizei count, GLenum, const void*, GLint){
+        addDraw(mode, count, 1);
+    }
+
+    inline void onDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum, const void*, GLsizei instances, GLint){
+        addDraw(mode, count, instances);
+    }
+
+    inline void onMultiDrawArrays(GLenum mode, const GLint*, const GLsizei* count, GLsizei drawcount){
+        for(GLsizei i = 0; i < drawcount; i++){
+            addDraw(mode, count[i], 1);
+        }
+    }
+
+    inline void onMultiDrawElements(GLenum mode, const GLsizei* count, GLenum, const void* const*, GLsizei drawcount){
+        for(GLsizei i = 0; i < drawcount; i++){
+            addDraw(mode, count[i], 1);
+        }
+    }
+
+    inline void onBufferData(GLenum, GLsizeiptr size, const void* data, GLenum){
+        state().frame.bufferBytes += data != NULL && size > 0 ? static_cast<uint64_t>(size) : 0;
+    }
+
+    inline void onBufferSubData(GLenum, GLintptr, GLsizeiptr size, const void* data){
+        state().frame.bufferBytes += data != NULL && size > 0 ? static_cast<uint64_t>(size) : 0;
+    }
+
+    // after the call, a mapping that failed uploads nothing
+    inline void onMapBufferRange(void* result, GLenum, GLintptr, GLsizeiptr length, GLbitfield access){
+        if(result != NULL && (access & GL_MAP_WRITE_BIT) != 0 && length > 0){
+            state().frame.bufferBytes += static_cast<uint64_t>(length);
+        }
+    }
+
+    inline void onTexImage2D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void* pixels){
+        addTextureUpload(pixels, width, height, 1, format, type);
+    }
+
+    inline void onTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels){
+        addTextureUpload(pixels, width, height, 1, format, type);
+    }
+
+    inline void onTexImage3D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLint, GLenum format, GLenum type, const void* pixels){
+        addTextureUpload(pixels, width, height, depth, format, type);
+    }
+
+    inline void onTexSubImage3D(GLenum, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels){
+        addTextureUpload(pixels, width, height, depth, format, type);
+    }
+
+    inline void onCompressedTexImage2D(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei bytes, const void* data){
+        addCompressedUpload(data, bytes);
+    }
+
+    inline void onCompressedTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei bytes, const void* data){
+        addCompressedUpload(data, bytes);
+    }
+
+    inline void onCompressedTexImage3D(GLenum, GLint, GLenum, GLsizei, GLsizei, GLsizei, GLint, GLsizei bytes, const void* data){
+        addCompressedUpload(data, bytes);
+    }
+
+    inline void onCompressedTexSubImage3D(GLenum, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLsizei, GLenum, GLsizei bytes, const void* data){
+        addCompressedUpload(data, bytes);
+    }
+    #pragma endregion
+
+#define GL_CALL_STATS_OBSERVERS \
+    GL_CALL_STATS_OBSERVER(glDrawArrays, onDrawArrays) \
+    GL_CALL_STATS_OBSERVER(glDrawArraysInstanced, onDrawArraysInstanced) \
+    GL_CALL_STATS_OBSERVER(glDrawElements, onDrawElements) \
+    GL_CALL_STATS_OBSERVER(glDrawElementsInstanced, onDrawElementsInstanced) \
+    GL_CALL_STATS_OBSERVER(glDrawRangeElements, onDrawRangeElements) \
+    GL_CALL_STATS_OBSERVER(glDrawElementsBaseVertex, onDrawElementsBaseVertex) \
+    GL_CALL_STATS_OBSERVER(glDrawRangeElementsBaseVertex, onDrawRangeElementsBaseVertex) \
+    GL_CALL_STATS_OBSERVER(glDrawElementsInstancedBaseVertex, onDrawElementsInstancedBaseVertex) \
+    GL_CALL_STATS_OBSERVER(glMultiDrawArrays, onMultiDrawArrays) \
+    GL_CALL_STATS_OBSERVER(glMultiDrawElements, onMultiDrawElements) \
+    GL_CALL_STATS_OBSERVER(glBufferData, onBufferData) \
+    GL_CALL_STATS_OBSERVER(glBufferSubData, onBufferSubData) \
+    GL_CALL_STATS_OBSERVER(glTexImage2D, onTexImage2D) \
+    GL_CALL_STATS_OBSERVER(glTexSubImage2D, onTexSubImage2D) \
+    GL_CALL_STATS_OBSERVER(glTexImage3D, onTexImage3D) \
+    GL_CALL_STATS_OBSERVER(glTexSubImage3D, onTexSubImage3D) \
+    GL_CALL_STATS_OBSERVER(glCompressedTexImage2D, onCompressedTexImage2D) \
+    GL_CALL_STATS_OBSERVER(glCompressedTexSubImage2D, onCompressedTexSubImage2D) \
+    GL_CALL_STATS_OBSERVER(glCompressedTexImage3D, onCompressedTexImage3D) \
+    GL_CALL_STATS_OBSERVER(glCompressedTexSubImage3D, onCompressedTexSubImage3D)
+
+    // call after gladLoadGLLoader, on the thread that owns the context
+    inline void install(){
+        State &s = state();
+        if(s.installed){
+            return;
+        }
+        s.entries.reserve(512);
+#define GL_ENTRY_POINT(name) \
+        if(glad_##name != NULL){ \
+            if(Counter<&glad_##name>::index == UINT32_MAX){ \
+                Counter<&glad_##name>::index = registerEntry(#name); \
+            } \
+            GLHooks::Hook<&glad_##name>::addBefore(&Counter<&glad_##name>::count); \
+        }
+        GL_ENTRY_POINTS
+#undef GL_ENTRY_POINT
+#define GL_CALL_STATS_OBSERVER(name, observer) GLHooks::Hook<&glad_##name>::addBefore(observer);
+        GL_CALL_STATS_OBSERVERS
+#undef GL_CALL_STATS_OBSERVER
+        GLHooks::Hook<&glad_glMapBufferRange>::addAfter(onMapBufferRange);
+        s.installed = true;
+    }
+
+    inline void uninstall(){
+#define GL_ENTRY_POINT(name) GLHooks::Hook<&glad_##name>::removeBefore(&Counter<&glad_##name>::count);
+        GL_ENTRY_POINTS
+#undef GL_ENTRY_POINT
+#define GL_CALL_STATS_OBSERVER(name, observer) GLHooks::Hook<&glad_##name>::removeBefore(observer);
+        GL_CALL_STATS_OBSERVERS
+#undef GL_CALL_STATS_OBSERVER
+        GLHooks::Hook<&glad_glMapBufferRange>::removeAfter(onMapBufferRange);
+        state().installed = false;
+    }
+
+    inline bool installed(){
+        return state().installed;
+    }
+
+    // closes the current frame, its counters become lastFrame()
+    inline void endFrame(){
+        State &s = state();
+        s.last = s.frame;
+        s.total += s.frame;
+        s.frame = Counters();
+        for(EntryPoint &entry : s.entries){
+            entry.totalCalls += entry.frameCalls;
+            entry.frameCalls = 0;
+        }
+        s.frames++;
+    }
+
+    inline const Counters& lastFrame(){
+        return state().last;
+    }
+
+    inline const Counters& totals(){
+        return state().total;
+    }
+
+    inline uint64_t frames(){
+        return state().frames;
+    }
+
+    // drops the totals (e.g. after warm up), the open frame keeps counting
+    inline void resetTotals(){
+        State &s = state();
+        s.total = Counters();
+        s.frames = 0;
+        for(EntryPoint &entry : s.entries){
+            entry.totalCalls = 0;
+        }
+    }
+
+    // entry points by total calls since the last reset, most called first
+    inline std::vector<std::pair<const char*, uint64_t>> topEntryPoints(size_t count){
+        std::vector<std::pair<const char*, uint64_t>> result;
+        for(const EntryPoint &entry : state().entries){
+            if(entry.totalCalls > 0){
+                result.push_back({ entry.name, entry.totalCalls });
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const std::pair<const char*, uint64_t> &a, const std::pair<const char*, uint64_t> &b){
+            return a.second > b.second;
+        });
+        if(result.size() > count){
+            result.resize(count);
+        }
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,836 @@
+#ifndef GL_CAPTURE_H
+#define GL_CAPTURE_H
+
+#include <glad/glad.h>
+#include <GLExt/gl_ext.h>
+#include <GLExt/gl_entry_points.h>
+#include <GLExt/gl_hooks.h>
+#include <GLExt/gl_call_stats.h>
+#include <Profiling/gpu_resources.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// GL command stream capture. Every glad entry point (plus the GLExt ones) gets an after
+// observer (see gl_hooks.h) that serializes the call into a compact binary file for a number
+// of frames; GL_Replay (src/gl_replay.cpp) re-executes the file headlessly and times each call.
+//
+// Capture has to start before anything is created (install() right after glad is loaded) so
+// the replay can rebuild every object. Getters (glGet*, glIs*) are left out since they don't
+// change state, except the ones whose results later calls depend on (uniform locations and
+// friends), which are recorded with their result so the replayer can remap them.
+//
+// File layout, little endian: a Header, then records that each start with a uint16:
+//
+//   entry id           a call: its arguments in order, then the result if there is one
+//   RECORD_ENTRY       id, name length, name; precedes the first call of an entry point
+//   RECORD_PAYLOAD     hash, size, padding to 8 bytes, bytes
+//   RECORD_MAPPED      target, offset, payload hash; bytes written into a mapped buffer
+//   RECORD_FRAME       end of a frame
+//   RECORD_END
+//
+// Scalars are stored raw at their C size, GLsync as a uint64 id. Pointers start with a Tag.
+// Pointed-to data (buffer and texture uploads, uniform arrays, shader sources, object names)
+// is stored once per distinct content as a payload and referenced by its 64 bit hash, so
+// uniforms that don't change and textures uploaded twice cost a few bytes per call. How much
+// a pointer refers to comes from the per entry point ArgSpec table below; pointers without a
+// spec are recorded as TAG_UNKNOWN and counted (the replayer hands them scratch memory).
+//
+//   GLCapture::begin("frames.glcs", 60);       // before the window exists
+//   GLCapture::install();                      // right after gladLoadGLLoader / GLExt::load
+//   ... GLCapture::endFrame() once per frame, the file is closed after 60 frames
+
+namespace GLCapture {
+
+    static const uint32_t MAGIC = 0x53434C47;          // "GLCS"
+    static const uint32_t VERSION = 1;
+
+    struct Header {
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        uint32_t width = 0;             // default framebuffer at capture start
+        uint32_t height = 0;
+        uint64_t frames = 0;
+        uint64_t calls = 0;
+    };
+
+    enum Record : uint16_t {
+        RECORD_END = 0xFFFB,
+        RECORD_MAPPED = 0xFFFC,
+        RECORD_ENTRY = 0xFFFD,
+        RECORD_PAYLOAD = 0xFFFE,
+        RECORD_FRAME = 0xFFFF
+    };
+
+    enum Tag : uint8_t {
+        TAG_NULL,
+        TAG_OFFSET,         // uint64, into the bound buffer (vertex attributes, indices, PBOs)
+        TAG_PAYLOAD,        // uint64 hash of a payload recorded earlier
+        TAG_OUTPUT,         // uint64 size, written by GL
+        TAG_UNKNOWN
+    };
+
+    #pragma region Argument specs
+    enum ArgKind : uint8_t {
+        ARG_VALUE,          // scalar, or a pointer nothing is known about
+        ARG_NULL,           // pointer recorded as NULL (glShaderSource lengths, the sources are NUL separated)
+        ARG_OFFSET,         // pointer that is an offset into a bound buffer
+        ARG_NAME,           // object name of kind object
+        ARG_NAMES,          // array of args[a] names of kind object
+        ARG_NAMES_OUT,      // array of args[a] names written by glGen*
+        ARG_LOCATION,       // uniform location in the current program
+        ARG_LABEL_NAME,     // glObjectLabel name, kind from the identifier in args[a]
+        ARG_BYTES,          // args[a] bytes
+        ARG_ELEMENTS,       // args[a] * size bytes
+        ARG_IMAGE,          // pixels of args[a] x args[b] x args[c] (c < 0: 1) in format args[d] and type args[e]
+        ARG_COMPRESSED,     // args[a] bytes, or an offset when a pixel unpack buffer is bound
+        ARG_STRING,         // NUL terminated, or args[a] bytes when a >= 0 and the length isn't negative
+        ARG_STRINGS,        // args[a] strings, lengths in args[b] (b < 0: NUL terminated)
+        ARG_PARAMS,         // 4 values of size bytes for vector pnames (args[a]), 1 otherwise
+        ARG_CLEAR,          // 4 values of size bytes when clearing GL_COLOR (args[a]), 1 otherwise
+        ARG_OUTPUT,         // args[a] * size bytes written by GL (a < 0: size bytes)
+        ARG_READ_PIXELS     // like ARG_IMAGE but written by GL, or an offset into a pixel pack buffer
+    };
+
+    enum ResultKind : uint8_t {
+        RESULT_VALUE,
+        RESULT_NAME,        // glCreateProgram / glCreateShader
+        RESULT_LOCATION,    // glGetUniformLocation, remapped per program
+        RESULT_MAPPED       // glMapBuffer(Range), the replayer keeps the pointer for RECORD_MAPPED
+    };
+
+    struct ArgSpec {
+        ArgKind kind = ARG_VALUE;
+        int8_t a = -1, b = -1, c = -1, d = -1, e = -1;
+        uint16_t size = 0;
+        GpuResources::Kind object = GpuResources::BUFFER;
+    };
+
+    struct EntrySpec {
+        std::vector<ArgSpec> args;
+        ResultKind result = RESULT_VALUE;
+        GpuResources::Kind object = GpuResources::BUFFER;
+
+        // arguments past the end of the spec are plain values
+        ArgSpec arg(size_t index) const{
+            return index < args.size() ? args[index] : ArgSpec();
+        }
+    };
+
+    inline ArgSpec spec(ArgKind kind, int a = -1, int b = -1, int c = -1, int d = -1, int e = -1){
+        ArgSpec arg;
+        arg.kind = kind;
+        arg.a = static_cast<int8_t>(a);
+        arg.b = static_cast<int8_t>(b);
+        arg.c = static_cast<int8_t>(c);
+        arg.d = static_cast<int8_t>(d);
+        arg.e = static_cast<int8_t>(e);
+        return arg;
+    }
+
+    inline ArgSpec sized(ArgKind kind, int a, uint16_t size){
+        ArgSpec arg = spec(kind, a);
+        arg.size = size;
+        return arg;
+    }
+
+    inline ArgSpec object(ArgKind kind, GpuResources::Kind type, int a = -1){
+        ArgSpec arg = spec(kind, a);
+        arg.object = type;
+        return arg;
+    }
+
+    inline EntrySpec returning(ResultKind result, GpuResources::Kind type = GpuResources::BUFFER, std::vector<ArgSpec> args = {}){
+        EntrySpec entry;
+        entry.args = args;
+        entry.result = result;
+        entry.object = type;
+        return entry;
+    }
+
+    inline std::unordered_map<std::string, EntrySpec> buildSpecs(){
+        using namespace GpuResources;
+        const ArgSpec V;
+        const ArgSpec OFFSET = spec(ARG_OFFSET);
+        auto name = [](Kind kind){ return object(ARG_NAME, kind); };
+
+        std::unordered_map<std::string, EntrySpec> specs = {
+            { "glBindBuffer", { { V, name(BUFFER) } } },
+            { "glBindBufferBase", { { V, V, name(BUFFER) } } },
+            { "glBindBufferRange", { { V, V, name(BUFFER) } } },
+            { "glBindTexture", { { V, name(TEXTURE) } } },
+            { "glBindRenderbuffer", { { V, name(RENDERBUFFER) } } },
+            { "glBindFramebuffer", { { V, name(FRAMEBUFFER) } } },
+            { "glBindVertexArray", { { name(VERTEX_ARRAY) } } },
+            { "glBindSampler", { { V, name(SAMPLER) } } },
+            { "glUseProgram", { { name(PROGRAM) } } },
+            { "glCreateProgram", returning(RESULT_NAME, PROGRAM) },
+            { "glCreateShader", returning(RESULT_NAME, SHADER) },
+            { "glDeleteProgram", { { name(PROGRAM) } } },
+            { "glDeleteShader", { { name(SHADER) } } },
+            { "glAttachShader", { { name(PROGRAM), name(SHADER) } } },
+            { "glDetachShader", { { name(PROGRAM), name(SHADER) } } },
+            { "glShaderSource", { { name(SHADER), V, spec(ARG_STRINGS, 1, 3), spec(ARG_NULL) } } },
+            { "glCompileShader", { { name(SHADER) } } },
+            { "glLinkProgram", { { name(PROGRAM) } } },
+            { "glValidateProgram", { { name(PROGRAM) } } },
+            { "glGetUniformLocation", returning(RESULT_LOCATION, PROGRAM, { name(PROGRAM), spec(ARG_STRING) }) },
+            { "glGetAttribLocation", { { name(PROGRAM), spec(ARG_STRING) } } },
+            { "glGetFragDataLocation", { { name(PROGRAM), spec(ARG_STRING) } } },
+            { "glGetFragDataIndex", { { name(PROGRAM), spec(ARG_STRING) } } },
+            { "glGetUniformBlockIndex", { { name(PROGRAM), spec(ARG_STRING) } } },
+            { "glUniformBlockBinding", { { name(PROGRAM) } } },
+            { "glBindAttribLocation", { { name(PROGRAM), V, spec(ARG_STRING) } } },
+            { "glBindFragDataLocation", { { name(PROGRAM), V, spec(ARG_STRING) } } },
+            { "glBindFragDataLocationIndexed", { { name(PROGRAM), V, V, spec(ARG_STRING) } } },
+            { "glTransformFeedbackVaryings", { { name(PROGRAM), V, spec(ARG_STRINGS, 1) } } },
+            { "glBufferData", { { V, V, spec(ARG_BYTES, 1) } } },
+            { "glBufferSubData", { { V, V, V, spec(ARG_BYTES, 2) } } },
+            { "glBufferStorage", { { V, V, spec(ARG_BYTES, 1), V } } },
+            { "glMapBuffer", returning(RESULT_MAPPED) },
+            { "glMapBufferRange", returning(RESULT_MAPPED) },
+            { "glTexImage1D", { { V, V, V, V, V, spec(ARG_IMAGE, 3, -1, -1, 5, 6) } } },
+            { "glTexImage2D", { { V, V, V, V, V, V, V, V, spec(ARG_IMAGE, 3, 4, -1, 6, 7) } } },
+            { "glTexImage3D", { { V, V, V, V, V, V, V, V, V, spec(ARG_IMAGE, 3, 4, 5, 7, 8) } } },
+            { "glTexSubImage1D", { { V, V, V, V, V, V, spec(ARG_IMAGE, 3, -1, -1, 4, 5) } } },
+            { "glTexSubImage2D", { { V, V, V, V, V, V, V, V, spec(ARG_IMAGE, 4, 5, -1, 6, 7) } } },
+            { "glTexSubImage3D", { { V, V, V, V, V, V, V, V, V, V, spec(ARG_IMAGE, 5, 6, 7, 8, 9) } } },
+            { "glCompressedTexImage1D", { { V, V, V, V, V, V, spec(ARG_COMPRESSED, 5) } } },
+            { "glCompressedTexImage2D", { { V, V, V, V, V, V, V, spec(ARG_COMPRESSED, 6) } } },
+            { "glCompressedTexImage3D", { { V, V, V, V, V, V, V, V, spec(ARG_COMPRESSED, 7) } } },
+            { "glCompressedTexSubImage1D", { { V, V, V, V, V, V, spec(ARG_COMPRESSED, 5) } } },
+            { "glCompressedTexSubImage2D", { { V, V, V, V, V, V, V, V, spec(ARG_COMPRESSED, 7) } } },
+            { "glCompressedTexSubImage3D", { { V, V, V, V, V, V, V, V, V, V, spec(ARG_COMPRESSED, 9) } } },
+            { "glTexParameteriv", { { V, V, sized(ARG_PARAMS, 1, 4) } } },
+            { "glTexParameterfv", { { V, V, sized(ARG_PARAMS, 1, 4) } } },
+            { "glTexParameterIiv", { { V, V, sized(ARG_PARAMS, 1, 4) } } },
+            { "glTexParameterIuiv", { { V, V, sized(ARG_PARAMS, 1, 4) } } },
+            { "glSamplerParameteri", { { name(SAMPLER) } } },
+            { "glSamplerParameterf", { { name(SAMPLER) } } },
+            { "glSamplerParameteriv", { { name(SAMPLER), V, sized(ARG_PARAMS, 1, 4) } } },
+            { "glSamplerParameterfv", { { name(SAMPLER), V, sized(ARG_PARAMS, 1, 4) } } },
+            { "glSamplerParameterIiv", { { name(SAMPLER), V, sized(ARG_PARAMS, 1, 4) } } },
+            { "glSamplerParameterIuiv", { { name(SAMPLER), V, sized(ARG_PARAMS, 1, 4) } } },
+            { "glVertexAttribPointer", { { V, V, V, V, V, OFFSET } } },
+            { "glVertexAttribIPointer", { { V, V, V, V, OFFSET } } },
+            { "glDrawElements", { { V, V, V, OFFSET } } },
+            { "glDrawElementsInstanced", { { V, V, V, OFFSET } } },
+            { "glDrawRangeElements", { { V, V, V, V, V, OFFSET } } },
+            { "glDrawElementsBaseVertex", { { V, V, V, OFFSET } } },
+            { "glDrawElementsInstancedBaseVertex", { { V, V, V, OFFSET } } },
+            { "glDrawRangeElementsBaseVertex", { { V, V, V, V, V, OFFSET } } },
+            { "glFramebufferRenderbuffer", { { V, V, V, name(RENDERBUFFER) } } },
+            { "glFramebufferTexture", { { V, V, name(TEXTURE) } } },
+            { "glFramebufferTexture1D", { { V, V, V, name(TEXTURE) } } },
+            { "glFramebufferTexture2D", { { V, V, V, name(TEXTURE) } } },
+            { "glFramebufferTexture3D", { { V, V, V, name(TEXTURE) } } },
+            { "glFramebufferTextureLayer", { { V, V, name(TEXTURE) } } },
+            { "glDrawBuffers", { { V, sized(ARG_ELEMENTS, 0, 4) } } },
+            { "glClearBufferiv", { { V, V, sized(ARG_CLEAR, 0, 4) } } },
+            { "glClearBufferuiv", { { V, V, sized(ARG_CLEAR, 0, 4) } } },
+            { "glClearBufferfv", { { V, V, sized(ARG_CLEAR, 0, 4) } } },
+            { "glBeginQuery", { { V, name(QUERY) } } },
+            { "glQueryCounter", { { name(QUERY) } } },
+            { "glBeginConditionalRender", { { name(QUERY) } } },
+            { "glReadPixels", { { V, V, V, V, V, V, spec(ARG_READ_PIXELS, 2, 3, -1, 4, 5) } } },
+            { "glObjectLabel", { { V, spec(ARG_LABEL_NAME, 0), V, spec(ARG_STRING, 2) } } },
+        };
+
+        // glGen* / glDelete* for every kind GpuResources knows
+        const struct { const char* type; Kind kind; } kinds[] = {
+            { "Buffers", BUFFER }, { "Textures", TEXTURE }, { "Renderbuffers", RENDERBUFFER }, { "Framebuffers", FRAMEBUFFER },
+            { "VertexArrays", VERTEX_ARRAY }, { "Queries", QUERY }, { "Samplers", SAMPLER }
+        };
+        for(const auto &type : kinds){
+            specs[std::string("glGen") + type.type] = { { V, object(ARG_NAMES_OUT, type.kind, 0) } };
+            specs[std::string("glDelete") + type.type] = { { V, object(ARG_NAMES, type.kind, 0) } };
+        }
+        return specs;
+    }
+
+    // glUniform{1,2,3,4}{f,i,ui}[v] and glUniformMatrix*fv, values come from GLCallStats::describeUniform
+    inline EntrySpec uniformSpec(const char* name){
+        GLCallStats::EntryPoint entry;
+        entry.name = name;
+        GLCallStats::describeUniform(entry);
+        EntrySpec uniform;
+        uniform.args.push_back(spec(ARG_LOCATION));
+        if(entry.uniformArray){
+            bool matrix = strncmp(name, "glUniformMatrix", 15) == 0;
+            uniform.args.push_back(ArgSpec());
+            if(matrix){
+                uniform.args.push_back(ArgSpec());
+            }
+            uniform.args.push_back(sized(ARG_ELEMENTS, 1, static_cast<uint16_t>(entry.uniformBytes)));
+        }
+        return uniform;
+    }
+
+    inline const EntrySpec& findSpec(const char* name){
+        static const std::unordered_map<std::string, EntrySpec> specs = buildSpecs();
+        static std::unordered_map<std::string, EntrySpec> uniforms;
+        static const EntrySpec plain;
+        auto found = specs.find(name);
+        if(found != specs.end()){
+            return found->second;
+        }
+        if(strncmp(name, "glUniform", 9) == 0 && name[9] != 'B'){
+            auto uniform = uniforms.find(name);
+            if(uniform == uniforms.end()){
+                uniform = uniforms.emplace(name, uniformSpec(name)).first;
+            }
+            return uniform->second;
+        }
+        return plain;
+    }
+
+    // getters don't change state, apart from the lookups later calls use the results of
+    inline bool recorded(const char* name){
+        static const char* lookups[] = { "glGetUniformLocation", "glGetAttribLocation", "glGetFragDataLocation", "glGetFragDataIndex", "glGetUniformBlockIndex" };
+        for(const char* lookup : lookups){
+            if(strcmp(name, lookup) == 0){
+                return true;
+            }
+        }
+        return strncmp(name, "glGet", 5) != 0 && strncmp(name, "glIs", 4) != 0;
+    }
+
+    // pnames whose glTexParameter*v / glSamplerParameter*v take four values
+    inline bool vectorParam(GLenum pname){
+        return pname == GL_TEXTURE_BORDER_COLOR || pname == GL_TEXTURE_SWIZZLE_RGBA;
+    }
+    #pragma endregion
+
+    inline uint64_t mix64(uint64_t value){
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    // content hash of a payload, size is mixed in so a prefix never collides with the whole
+    inline uint64_t hash64(const void* data, size_t size){
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = mix64(size ^ 0x9E3779B97F4A7C15ull);
+        size_t i = 0;
+        for(; i + 8 <= size; i += 8){
+            uint64_t word;
+            memcpy(&word, bytes + i, 8);
+            hash = (hash ^ mix64(word)) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, bytes + i, size - i);
+        return mix64(hash ^ tail ^ (static_cast<uint64_t>(size - i) << 56));
+    }
+
+    // bytes a pixel transfer reads or writes, following the pixel store state; 0 when the
+    // format / type combination isn't known
+    inline uint64_t imageBytes(uint64_t width, uint64_t height, uint64_t depth, GLenum format, GLenum type, bool pack){
+        GLint alignment = 4, rowLength = 0, imageHeight = 0, skipPixels = 0, skipRows = 0, skipImages = 0;
+        auto getIntegerv = GLHooks::Hook<&glad_glGetIntegerv>::real();
+        getIntegerv(pack ? GL_PACK_ALIGNMENT : GL_UNPACK_ALIGNMENT, &alignment);
+        getIntegerv(pack ? GL_PACK_ROW_LENGTH : GL_UNPACK_ROW_LENGTH, &rowLength);
+        getIntegerv(pack ? GL_PACK_IMAGE_HEIGHT : GL_UNPACK_IMAGE_HEIGHT, &imageHeight);
+        getIntegerv(pack ? GL_PACK_SKIP_PIXELS : GL_UNPACK_SKIP_PIXELS, &skipPixels);
+        getIntegerv(pack ? GL_PACK_SKIP_ROWS : GL_UNPACK_SKIP_ROWS, &skipRows);
+        getIntegerv(pack ? GL_PACK_SKIP_IMAGES : GL_UNPACK_SKIP_IMAGES, &skipImages);
+        uint64_t pixel = GLCallStats::pixelBytes(format, type);
+        if(pixel == 0 || width == 0 || height == 0 || depth == 0){
+            return 0;
+        }
+        uint64_t align = static_cast<uint64_t>(std::max(alignment, 1));
+        uint64_t rowBytes = (static_cast<uint64_t>(rowLength > 0 ? rowLength : width) * pixel + align - 1) / align * align;
+        uint64_t rows = static_cast<uint64_t>(imageHeight > 0 ? imageHeight : height);
+        uint64_t skip = skipPixels * pixel + skipRows * rowBytes + skipImages * rowBytes * rows;
+        return skip + rowBytes * rows * (depth - 1) + rowBytes * (height - 1) + width * pixel;
+    }
+
+    inline bool bufferBound(GLenum binding){
+        GLint buffer = 0;
+        GLHooks::Hook<&glad_glGetIntegerv>::real()(binding, &buffer);
+        return buffer != 0;
+    }
+
+    #pragma region Capture
+    struct Entry {
+        const char* name;
+        const EntrySpec* spec;
+        bool written = false;           // RECORD_ENTRY is in the file
+        uint64_t calls = 0;
+    };
+
+    struct Mapping {
+        uint8_t* pointer = NULL;
+        uint64_t length = 0;
+        GLbitfield access = 0;
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t calls = 0;
+        uint64_t payloads = 0;
+        uint64_t payloadBytes = 0;          // stored
+        uint64_t referencedBytes = 0;       // before deduplication
+        uint64_t unknownPointers = 0;
+        uint64_t fileBytes = 0;
+    };
+
+    struct State {
+        std::string path;
+        uint64_t frameLimit = 0;
+        bool requested = false;
+        bool active = false;
+        FILE* file = NULL;
+        Header header;
+        std::vector<uint8_t> buffer;        // pending file bytes
+        std::vector<uint8_t> call;          // record being assembled, payloads go out first
+        uint64_t flushed = 0;
+        std::vector<Entry> entries;
+        std::unordered_set<uint64_t> payloads;
+        std::unordered_map<GLenum, Mapping> mappings;
+        std::unordered_map<std::string, uint64_t> unknown;     // entry point -> pointers without a spec
+        Stats stats;
+    };
+
+    inline State& state(){
+        static State instance;
+        return instance;
+    }
+
+    inline void put(std::vector<uint8_t> &out, const void* data, size_t size){
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    template<typename T>
+    inline void put(std::vector<uint8_t> &out, T value){
+        put(out, &value, sizeof(T));
+    }
+
+    inline void flush(){
+        State &s = state();
+        if(!s.buffer.empty()){
+            fwrite(s.buffer.data(), 1, s.buffer.size(), s.file);
+            s.flushed += s.buffer.size();
+            s.buffer.clear();
+        }
+    }
+
+    // stores the payload the first time its content is seen, returns the hash to reference it
+    inline uint64_t payload(const void* data, uint64_t size){
+        State &s = state();
+        uint64_t hash = hash64(data, size);
+        s.stats.referencedBytes += size;
+        if(!s.payloads.insert(hash).second){
+            return hash;
+        }
+        put(s.buffer, static_cast<uint16_t>(RECORD_PAYLOAD));
+        put(s.buffer, hash);
+        put(s.buffer, size);
+        // payload bytes start 8 byte aligned in the file, so the replayer can use them in place
+        while((s.flushed + s.buffer.size()) % 8 != 0){
+            s.buffer.push_back(0);
+        }
+        if(size > (1u << 20)){
+            flush();
+            fwrite(data, 1, size, s.file);
+            s.flushed += size;
+        }
+        else{
+            put(s.buffer, data, size);
+        }
+        s.stats.payloads++;
+        s.stats.payloadBytes += size;
+        return hash;
+    }
+
+    inline void pointerTag(Tag tag, uint64_t value = 0){
+        State &s = state();
+        s.call.push_back(tag);
+        if(tag != TAG_NULL && tag != TAG_UNKNOWN){
+            put(s.call, value);
+        }
+    }
+
+    inline void pointerPayload(const void* data, uint64_t size){
+        if(data == NULL){
+            pointerTag(TAG_NULL);
+        }
+        else{
+            pointerTag(TAG_PAYLOAD, payload(data, size));
+        }
+    }
+
+    inline void pointerStrings(const uint64_t* values, const ArgSpec &arg, const void* pointer){
+        const GLchar* const* strings = static_cast<const GLchar* const*>(pointer);
+        const GLint* lengths = arg.b >= 0 ? reinterpret_cast<const GLint*>(values[arg.b]) : NULL;
+        std::vector<uint8_t> joined;
+        for(uint64_t i = 0; strings != NULL && i < values[arg.a]; i++){
+            size_t length = lengths != NULL && lengths[i] >= 0 ? static_cast<size_t>(lengths[i]) : strlen(strings[i]);
+            put(joined, strings[i], length);
+            joined.push_back(0);
+        }
+        pointerPayload(strings != NULL ? joined.data() : NULL, joined.size());
+    }
+
+    inline void writePointer(const char* name, const ArgSpec &arg, const uint64_t* values, const void* pointer){
+        switch(arg.kind){
+            case ARG_NULL:
+                pointerTag(TAG_NULL);
+                return;
+            case ARG_OFFSET:
+                pointerTag(TAG_OFFSET, reinterpret_cast<uintptr_t>(pointer));
+                return;
+            case ARG_NAMES:
+            case ARG_NAMES_OUT:
+                pointerPayload(pointer, values[arg.a] * sizeof(GLuint));
+                return;
+            case ARG_BYTES:
+                pointerPayload(pointer, values[arg.a]);
+                return;
+            case ARG_ELEMENTS:
+                pointerPayload(pointer, values[arg.a] * arg.size);
+                return;
+            case ARG_PARAMS:
+                pointerPayload(pointer, (vectorParam(static_cast<GLenum>(values[arg.a])) ? 4 : 1) * arg.size);
+                return;
+            case ARG_CLEAR:
+                pointerPayload(pointer, (values[arg.a] == GL_COLOR ? 4 : 1) * arg.size);
+                return;
+            case ARG_STRINGS:
+                pointerStrings(values, arg, pointer);
+                return;
+            case ARG_STRING: {
+                GLsizei length = arg.a >= 0 ? static_cast<GLsizei>(values[arg.a]) : -1;
+                const char* text = static_cast<const char*>(pointer);
+                pointerPayload(text, text == NULL ? 0 : length >= 0 ? length : strlen(text) + 1);
+                return;
+            }
+            case ARG_COMPRESSED:
+            case ARG_IMAGE:
+                if(bufferBound(GL_PIXEL_UNPACK_BUFFER_BINDING)){
+                    pointerTag(TAG_OFFSET, reinterpret_cast<uintptr_t>(pointer));
+                    return;
+                }
+                if(arg.kind == ARG_COMPRESSED){
+                    pointerPayload(pointer, values[arg.a]);
+                    return;
+                }
+                if(pointer != NULL){
+                    uint64_t bytes = imageBytes(values[arg.a], arg.b >= 0 ? values[arg.b] : 1, arg.c >= 0 ? values[arg.c] : 1,
+                                                static_cast<GLenum>(values[arg.d]), static_cast<GLenum>(values[arg.e]), false);
+                    if(bytes != 0){
+                        pointerPayload(pointer, bytes);
+                        return;
+                    }
+                }
+                break;
+            case ARG_READ_PIXELS:
+                if(bufferBound(GL_PIXEL_PACK_BUFFER_BINDING)){
+                    pointerTag(TAG_OFFSET, reinterpret_cast<uintptr_t>(pointer));
+                }
+                else{
+                    pointerTag(TAG_OUTPUT, imageBytes(values[arg.a], values[arg.b], 1, static_cast<GLenum>(values[arg.d]), static_cast<GLenum>(values[arg.e]), true));
+                }
+                return;
+            case ARG_OUTPUT:
+                pointerTag(TAG_OUTPUT, arg.a >= 0 ? values[arg.a] * arg.size : arg.size);
+                return;
+            default:
+                break;
+        }
+        if(pointer == NULL){
+            pointerTag(TAG_NULL);
+            return;
+        }
+        pointerTag(TAG_UNKNOWN);
+        state().stats.unknownPointers++;
+        state().unknown[name]++;
+    }
+
+    template<typename T>
+    inline uint64_t toValue(T value){
+        if constexpr(std::is_pointer<T>::value){
+            return reinterpret_cast<uintptr_t>(value);
+        }
+        else if constexpr(std::is_integral<T>::value){
+            return static_cast<uint64_t>(value);
+        }
+        else{
+            return 0;
+        }
+    }
+
+    template<typename T>
+    inline void writeArg(const Entry &entry, size_t index, const uint64_t* values, T value){
+        State &s = state();
+        if constexpr(std::is_same<T, GLsync>::value){
+            put(s.call, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+        }
+        else if constexpr(std::is_pointer<T>::value){
+            writePointer(entry.name, entry.spec->arg(index), values, reinterpret_cast<const void*>(value));
+        }
+        else{
+            put(s.call, value);
+        }
+    }
+
+    template<typename R>
+    inline void writeResult(R result){
+        if constexpr(std::is_pointer<R>::value){
+            put(state().call, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(result)));
+        }
+        else{
+            put(state().call, result);
+        }
+    }
+
+    inline void beginCall(uint32_t index){
+        State &s = state();
+        Entry &entry = s.entries[index];
+        if(!entry.written){
+            put(s.buffer, static_cast<uint16_t>(RECORD_ENTRY));
+            put(s.buffer, static_cast<uint16_t>(index));
+            put(s.buffer, static_cast<uint8_t>(strlen(entry.name)));
+            put(s.buffer, entry.name, strlen(entry.name));
+            entry.written = true;
+        }
+        entry.calls++;
+        s.stats.calls++;
+        s.call.clear();
+        put(s.call, static_cast<uint16_t>(index));
+    }
+
+    inline void endCall(){
+        State &s = state();
+        put(s.buffer, s.call.data(), s.call.size());
+        if(s.buffer.size() > (1u << 20)){
+            flush();
+        }
+    }
+
+    template<typename... A, size_t... I>
+    inline void writeArgs(const Entry &entry, std::index_sequence<I...>, A... args){
+        const uint64_t values[sizeof...(A) + 1] = { toValue(args)... };
+        (void)values;
+        (writeArg(entry, I, values, args), ...);
+    }
+
+    // serializes calls to the entry point whose pointer lives at Slot
+    template<auto* Slot, typename Function = std::remove_pointer_t<decltype(Slot)>>
+    struct Recorder;
+
+    template<auto* Slot, typename R, typename... A>
+    struct Recorder<Slot, R (APIENTRYP)(A...)> {
+        static inline uint32_t index = UINT32_MAX;
+
+        static void after(R result, A... args){
+            beginCall(index);
+            writeArgs(state().entries[index], std::index_sequence_for<A...>{}, args...);
+            writeResult(result);
+            endCall();
+        }
+    };
+
+    template<auto* Slot, typename... A>
+    struct Recorder<Slot, void (APIENTRYP)(A...)> {
+        static inline uint32_t index = UINT32_MAX;
+
+        static void after(A... args){
+            beginCall(index);
+            writeArgs(state().entries[index], std::index_sequence_for<A...>{}, args...);
+            endCall();
+        }
+    };
+
+    #pragma region Mapped buffers
+    inline void writeMapped(GLenum target, uint64_t offset, const void* data, uint64_t size){
+        State &s = state();
+        uint64_t hash = payload(data, size);
+        put(s.buffer, static_cast<uint16_t>(RECORD_MAPPED));
+        put(s.buffer, static_cast<uint32_t>(target));
+        put(s.buffer, offset);
+        put(s.buffer, hash);
+    }
+
+    inline void onMapBufferRange(void* result, GLenum target, GLintptr, GLsizeiptr length, GLbitfield access){
+        if(result != NULL){
+            state().mappings[target] = Mapping{ static_cast<uint8_t*>(result), static_cast<uint64_t>(length), access };
+        }
+    }
+
+    inline void onMapBuffer(void* result, GLenum target, GLenum access){
+        if(result != NULL){
+            GLint size = 0;
+            GLHooks::Hook<&glad_glGetBufferParameteriv>::real()(target, GL_BUFFER_SIZE, &size);
+            state().mappings[target] = Mapping{ static_cast<uint8_t*>(result), static_cast<uint64_t>(size), static_cast<GLbitfield>(access == GL_READ_ONLY ? GL_MAP_READ_BIT : GL_MAP_WRITE_BIT) };
+        }
+    }
+
+    // whatever was written through the mapping goes into the file right before the call that publishes it
+    inline void onFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length){
+        auto found = state().mappings.find(target);
+        if(found != state().mappings.end() && offset >= 0 && static_cast<uint64_t>(offset + length) <= found->second.length){
+            writeMapped(target, offset, found->second.pointer + offset, length);
+        }
+    }
+
+    inline void onUnmapBuffer(GLenum target){
+        auto found = state().mappings.find(target);
+        if(found == state().mappings.end()){
+            return;
+        }
+        const Mapping &mapping = found->second;
+        if((mapping.access & GL_MAP_WRITE_BIT) != 0 && (mapping.access & GL_MAP_FLUSH_EXPLICIT_BIT) == 0){
+            writeMapped(target, 0, mapping.pointer, mapping.length);
+        }
+        state().mappings.erase(found);
+    }
+    #pragma endregion
+    #pragma endregion
+
+    template<auto* Slot>
+    inline void addRecorder(const char* name){
+        if(!recorded(name)){
+            return;
+        }
+        State &s = state();
+        if(Recorder<Slot>::index == UINT32_MAX){
+            Recorder<Slot>::index = static_cast<uint32_t>(s.entries.size());
+            s.entries.push_back(Entry{ name, &findSpec(name) });
+        }
+        GLHooks::Hook<Slot>::addAfter(&Recorder<Slot>::after);
+    }
+
+    template<auto* Slot>
+    inline void removeRecorder(){
+        GLHooks::Hook<Slot>::removeAfter(&Recorder<Slot>::after);
+    }
+
+#define GL_CAPTURE_EXT_ENTRY_POINTS \
+    GL_CAPTURE_EXT_ENTRY_POINT(TexStorage2D) \
+    GL_CAPTURE_EXT_ENTRY_POINT(TexStorage3D) \
+    GL_CAPTURE_EXT_ENTRY_POINT(ObjectLabel) \
+    GL_CAPTURE_EXT_ENTRY_POINT(ClipControl) \
+    GL_CAPTURE_EXT_ENTRY_POINT(BufferStorage)
+
+    // capture the first frames into path, call before the window is created
+    inline void begin(const std::string &path, uint64_t frames){
+        State &s = state();
+        s.path = path;
+        s.frameLimit = frames;
+        s.requested = true;
+    }
+
+    inline bool capturing(){
+        return state().active;
+    }
+
+    inline const Stats& stats(){
+        return state().stats;
+    }
+
+    // starts a capture requested with begin(); call after gladLoadGLLoader and GLExt::load,
+    // before any GL object is created
+    inline bool install(){
+        State &s = state();
+        if(!s.requested || s.active){
+            return false;
+        }
+        s.requested = false;
+        s.file = fopen(s.path.c_str(), "wb");
+        if(s.file == NULL){
+            std::cout << "can't write GL capture " << s.path << std::endl;
+            return false;
+        }
+        GLint viewport[4] = {};
+        GLHooks::Hook<&glad_glGetIntegerv>::real()(GL_VIEWPORT, viewport);
+        s.header = Header();
+        s.header.width = static_cast<uint32_t>(viewport[2]);
+        s.header.height = static_cast<uint32_t>(viewport[3]);
+        put(s.buffer, &s.header, sizeof(Header));
+        s.active = true;
+
+#define GL_ENTRY_POINT(name) addRecorder<&glad_##name>(#name);
+        GL_ENTRY_POINTS
+#undef GL_ENTRY_POINT
+#define GL_CAPTURE_EXT_ENTRY_POINT(name) addRecorder<&GLExt::name>("gl" #name);
+        GL_CAPTURE_EXT_ENTRY_POINTS
+#undef GL_CAPTURE_EXT_ENTRY_POINT
+        GLHooks::Hook<&glad_glMapBufferRange>::addAfter(onMapBufferRange);
+        GLHooks::Hook<&glad_glMapBuffer>::addAfter(onMapBuffer);
+        GLHooks::Hook<&glad_glFlushMappedBufferRange>::addBefore(onFlushMappedBufferRange);
+        GLHooks::Hook<&glad_glUnmapBuffer>::addBefore(onUnmapBuffer);
+        std::cout << "capturing GL commands of " << s.frameLimit << " frames to " << s.path << std::endl;
+        return true;
+    }
+
+    inline void printSummary(std::ostream &out){
+        State &s = state();
+        const Stats &stats = s.stats;
+        out << "GL capture " << s.path << ": " << stats.frames << " frames, " << stats.calls << " calls, "
+            << stats.payloads << " payloads (" << stats.payloadBytes / 1024 << " KB stored of " << stats.referencedBytes / 1024
+            << " KB referenced), " << stats.fileBytes / 1024 << " KB file" << std::endl;
+        for(const std::pair<const std::string, uint64_t> &unknown : s.unknown){
+            out << "  " << unknown.first << ": " << unknown.second << " pointer arguments without a spec, replayed with scratch memory" << std::endl;
+        }
+    }
+
+    // closes the file and removes the hooks, endFrame() does this after the last frame
+    inline void end(){
+        State &s = state();
+        if(!s.active){
+            return;
+        }
+#define GL_ENTRY_POINT(name) removeRecorder<&glad_##name>();
+        GL_ENTRY_POINTS
+#undef GL_ENTRY_POINT
+#define GL_CAPTURE_EXT_ENTRY_POINT(name) removeRecorder<&GLExt::name>();
+        GL_CAPTURE_EXT_ENTRY_POINTS
+#undef GL_CAPTURE_EXT_ENTRY_POINT
+        GLHooks::Hook<&glad_glMapBufferRange>::removeAfter(onMapBufferRange);
+        GLHooks::Hook<&glad_glMapBuffer>::removeAfter(onMapBuffer);
+        GLHooks::Hook<&glad_glFlushMappedBufferRange>::removeBefore(onFlushMappedBufferRange);
+        GLHooks::Hook<&glad_glUnmapBuffer>::removeBefore(onUnmapBuffer);
+
+        put(s.buffer, static_cast<uint16_t>(RECORD_END));
+        flush();
+        s.header.frames = s.stats.frames;
+        s.header.calls = s.stats.calls;
+        s.stats.fileBytes = s.flushed;
+        fseek(s.file, 0, SEEK_SET);
+        fwrite(&s.header, sizeof(Header), 1, s.file);
+        fclose(s.file);
+        s.file = NULL;
+        s.active = false;
+        s.payloads.clear();
+        s.mappings.clear();
+        printSummary(std::cout);
+    }
+
+    // once per frame, after the frame's last GL call
+    inline void endFrame(){
+        State &s = state();
+        if(!s.active){
+            return;
+        }
+        put(s.buffer, static_cast<uint16_t>(RECORD_FRAME));
+        s.stats.frames++;
+        if(s.stats.frames >= s.frameLimit){
+            end();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include <glad/glad.h>
+#include <cstring>
+
+// glad is generated for the GL 3.3 core profile only. Anything newer (texture storage,
+// clip control, debug labels, ...) is loaded here at runtime and stays NULL when the
+// driver doesn't expose it, so always check the pointer (or the has* flag) before use.
+
+#ifndef GL_TEXTURE_IMMUTABLE_FORMAT
+#define GL_TEXTURE_IMMUTABLE_FORMAT 0x912F
+#endif
+
+// block compression formats (EXT_texture_compression_s3tc, EXT_texture_sRGB, ARB_texture_compression_bptc)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
+// clip control (ARB_clip_control, core in 4.5)
+#ifndef GL_LOWER_LEFT
+#define GL_LOWER_LEFT 0x8CA1
+#endif
+#ifndef GL_NEGATIVE_ONE_TO_ONE
+#define GL_NEGATIVE_ONE_TO_ONE 0x935E
+#endif
+#ifndef GL_ZERO_TO_ONE
+#define GL_ZERO_TO_ONE 0x935F
+#endif
+
+// object label namespaces (KHR_debug), the rest reuse the object's binding target enum
+#ifndef GL_BUFFER
+#define GL_BUFFER 0x82E0
+#endif
+#ifndef GL_SHADER
+#define GL_SHADER 0x82E1
+#endif
+#ifndef GL_PROGRAM
+#define GL_PROGRAM 0x82E2
+#endif
+#ifndef GL_VERTEX_ARRAY
+#define GL_VERTEX_ARRAY 0x8074
+#endif
+#ifndef GL_QUERY
+#define GL_QUERY 0x82E3
+#endif
+#ifndef GL_SAMPLER
+#define GL_SAMPLER 0x82E6
+#endif
+
+typedef void (APIENTRYP PFNGLEXTTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLEXTTEXSTORAGE3DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+typedef void (APIENTRYP PFNGLEXTOBJECTLABELPROC)(GLenum identifier, GLuint name, GLsizei length, const GLchar* label);
+typedef void (APIENTRYP PFNGLEXTCLIPCONTROLPROC)(GLenum origin, GLenum depth);
+typedef void (APIENTRYP PFNGLEXTBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+namespace GLExt {
+
+    inline bool hasTextureStorage = false;
+    inline PFNGLEXTTEXSTORAGE2DPROC TexStorage2D = NULL;
+    inline PFNGLEXTTEXSTORAGE3DPROC TexStorage3D = NULL;
+    inline PFNGLEXTOBJECTLABELPROC ObjectLabel = NULL;
+    inline PFNGLEXTCLIPCONTROLPROC ClipControl = NULL;
+    inline PFNGLEXTBUFFERSTORAGEPROC BufferStorage = NULL;
+
+    // true if the current context is at least major.minor
+    inline bool versionAtLeast(int major, int minor){
+        return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+    }
+
+    inline bool hasExtension(const char* name){
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for(GLint i = 0; i < count; i++){
+            const char* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if(ext != NULL && strcmp(ext, name) == 0){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // call once after gladLoadGLLoader with the same loader
+    inline void load(GLADloadproc loader){
+        if(versionAtLeast(4, 2) || hasExtension("GL_ARB_texture_storage")){
+            TexStorage2D = (PFNGLEXTTEXSTORAGE2DPROC)loader("glTexStorage2D");
+            TexStorage3D = (PFNGLEXTTEXSTORAGE3DPROC)loader("glTexStorage3D");
+        }
+        hasTextureStorage = TexStorage2D != NULL && TexStorage3D != NULL;
+        if(versionAtLeast(4, 3) || hasExtension("GL_KHR_debug")){
+            ObjectLabel = (PFNGLEXTOBJECTLABELPROC)loader("glObjectLabel");
+        }
+        if(versionAtLeast(4, 5) || hasExtension("GL_ARB_clip_control")){
+            ClipControl = (PFNGLEXTCLIPCONTROLPROC)loader("glClipControl");
+        }
+        if(versionAtLeast(4, 4) || hasExtension("GL_ARB_buffer_storage")){
+            BufferStorage = (PFNGLEXTBUFFERSTORAGEPROC)loader("glBufferStorage");
+        }
+    }
+}
+
+#endif
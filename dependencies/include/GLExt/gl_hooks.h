@@ -0,0 +1,144 @@
+#ifndef GL_HOOKS_H
+#define GL_HOOKS_H
+
+#include <glad/glad.h>
+
+#include <type_traits>
+
+// Observers on GL entry points. glad (and GLExt) call through plain function pointer
+// variables, so a hook swaps the variable for a wrapper that runs the observers and forwards
+// to the driver. Slot is the address of that variable:
+//
+//   GLHooks::Hook<&glad_glDeleteBuffers>::addBefore(onDeleteBuffers);
+//   GLHooks::Hook<&glad_glGenBuffers>::addAfter(onGenBuffers);
+//
+// Before observers see the arguments, after observers see the result (if any) followed by
+// the arguments once the driver returned. The pointer is swapped while any observer is
+// registered and restored when the last one is removed, so unhooked entry points cost
+// nothing. Several subsystems (GLCallStats, GpuResources) can observe the same entry point.
+//
+// Install hooks after gladLoadGLLoader / GLExt::load and only from the GL thread.
+
+namespace GLHooks {
+
+    static const int MAX_OBSERVERS = 4;
+
+    template<typename R, typename... A>
+    struct AfterObserver {
+        typedef void (*Type)(R, A...);
+    };
+
+    template<typename... A>
+    struct AfterObserver<void, A...> {
+        typedef void (*Type)(A...);
+    };
+
+    template<auto* Slot, typename Function = std::remove_pointer_t<decltype(Slot)>>
+    struct Hook;
+
+    template<auto* Slot, typename R, typename... A>
+    struct Hook<Slot, R (APIENTRYP)(A...)> {
+        typedef R (APIENTRYP Function)(A...);
+        typedef void (*Before)(A...);
+        typedef typename AfterObserver<R, A...>::Type After;
+
+        static inline Function original = NULL;
+        static inline Before before[MAX_OBSERVERS] = {};
+        static inline After after[MAX_OBSERVERS] = {};
+
+        static R APIENTRY call(A... args){
+            for(int i = 0; i < MAX_OBSERVERS; i++){
+                if(before[i] != NULL){
+                    before[i](args...);
+                }
+            }
+            if constexpr(std::is_void<R>::value){
+                original(args...);
+                for(int i = 0; i < MAX_OBSERVERS; i++){
+                    if(after[i] != NULL){
+                        after[i](args...);
+                    }
+                }
+            }
+            else{
+                R result = original(args...);
+                for(int i = 0; i < MAX_OBSERVERS; i++){
+                    if(after[i] != NULL){
+                        after[i](result, args...);
+                    }
+                }
+                return result;
+            }
+        }
+
+        // the driver's entry point, for observers that need to call GL without being observed
+        static Function real(){
+            return original != NULL ? original : *Slot;
+        }
+
+        static bool hooked(){
+            return *Slot == call;
+        }
+
+        // false when the entry point isn't loaded or every observer slot is taken
+        static bool addBefore(Before observer){
+            return add(before, observer);
+        }
+
+        static bool addAfter(After observer){
+            return add(after, observer);
+        }
+
+        static void removeBefore(Before observer){
+            remove(before, observer);
+        }
+
+        static void removeAfter(After observer){
+            remove(after, observer);
+        }
+
+    private:
+        template<typename Observer>
+        static bool add(Observer (&observers)[MAX_OBSERVERS], Observer observer){
+            if(*Slot == NULL){
+                return false;
+            }
+            for(int i = 0; i < MAX_OBSERVERS; i++){
+                if(observers[i] == observer){
+                    return true;
+                }
+            }
+            for(int i = 0; i < MAX_OBSERVERS; i++){
+                if(observers[i] == NULL){
+                    observers[i] = observer;
+                    if(*Slot != call){
+                        original = *Slot;
+                        *Slot = call;
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template<typename Observer>
+        static void remove(Observer (&observers)[MAX_OBSERVERS], Observer observer){
+            for(int i = 0; i < MAX_OBSERVERS; i++){
+                if(observers[i] == observer){
+                    observers[i] = NULL;
+                }
+            }
+            for(int i = 0; i < MAX_OBSERVERS; i++){
+                if(before[i] != NULL || after[i] != NULL){
+                    return;
+                }
+            }
+            if(*Slot == call){
+                *Slot = original;
+            }
+            original = NULL;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,574 @@
+#ifndef GLTF_IMPORTER_H
+#define GLTF_IMPORTER_H
+
+#include <FileIO/json_reader.h>
+#include <FileIO/mapped_file.h>
+#include <Meshes/mesh_container.h>
+#include <Threading/parallel_for.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// glTF 2.0 into the interleaved layout of MeshContainer, from a .glb (JSON and binary chunk
+// in one file) or a .gltf whose buffers are data: URIs or files next to it. The default
+// scene is flattened: every triangle primitive of every node is transformed into model
+// space and appended, so the result is one mesh with one submesh per material in order of
+// first use, like ObjImport. POSITION is required; missing NORMALs are generated per
+// primitive from its faces and missing TEXCOORD_0 reads as 0, 0. Points, lines, sparse
+// accessors, morph targets and skins are ignored.
+//
+// glTF vertices are already unique, so there is nothing to deduplicate: each primitive's
+// vertices and indices go to offsets known up front and are converted in parallel.
+
+namespace GltfImport {
+
+    const uint32_t GLB_MAGIC = 0x46546C67;          // "glTF"
+    const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;     // "JSON"
+    const uint32_t GLB_CHUNK_BIN = 0x004E4942;      // "BIN\0"
+
+    const uint32_t COMPONENT_BYTE = 5120;
+    const uint32_t COMPONENT_UNSIGNED_BYTE = 5121;
+    const uint32_t COMPONENT_SHORT = 5122;
+    const uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+    const uint32_t COMPONENT_UNSIGNED_INT = 5125;
+    const uint32_t COMPONENT_FLOAT = 5126;
+
+    const int64_t MODE_TRIANGLES = 4;
+
+    // the parsed JSON and the bytes of every buffer, which stay valid while it lives
+    struct Document {
+        Json::Value json;
+        std::vector<std::pair<const uint8_t*, size_t>> buffers;
+        std::vector<std::vector<uint8_t>> decoded;      // data: URIs
+        std::vector<MappedFile> files;                  // external buffers
+    };
+
+    // typed view of one accessor, bounds checked against its buffer
+    struct Accessor {
+        const uint8_t* data = NULL;
+        size_t count = 0;
+        size_t stride = 0;
+        uint32_t componentType = 0;
+        int components = 0;
+        bool normalized = false;
+    };
+
+    inline size_t componentSize(uint32_t componentType){
+        switch(componentType){
+            case COMPONENT_BYTE: case COMPONENT_UNSIGNED_BYTE: return 1;
+            case COMPONENT_SHORT: case COMPONENT_UNSIGNED_SHORT: return 2;
+            case COMPONENT_UNSIGNED_INT: case COMPONENT_FLOAT: return 4;
+            default: return 0;
+        }
+    }
+
+    inline int componentCount(const std::string &type){
+        return type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+    }
+
+    inline bool decodeBase64(const char* text, size_t size, std::vector<uint8_t> &out){
+        out.clear();
+        out.reserve(size / 4 * 3);
+        uint32_t bits = 0;
+        int pending = 0;
+        for(size_t i = 0; i < size && text[i] != '='; i++){
+            char c = text[i];
+            uint32_t value;
+            if(c >= 'A' && c <= 'Z') value = static_cast<uint32_t>(c - 'A');
+            else if(c >= 'a' && c <= 'z') value = static_cast<uint32_t>(c - 'a' + 26);
+            else if(c >= '0' && c <= '9') value = static_cast<uint32_t>(c - '0' + 52);
+            else if(c == '+' || c == '-') value = 62;
+            else if(c == '/' || c == '_') value = 63;
+            else return false;
+            bits = bits << 6 | value;
+            pending += 6;
+            if(pending >= 8){
+                pending -= 8;
+                out.push_back(static_cast<uint8_t>(bits >> pending));
+            }
+        }
+        return true;
+    }
+
+    // resolves the buffers of document.json; binary is the GLB chunk, if any
+    inline bool loadBuffers(Document &document, const std::string &directory, const uint8_t* binary, size_t binarySize, std::string &error){
+        const Json::Value &buffers = document.json["buffers"];
+        document.decoded.reserve(buffers.size());
+        for(size_t i = 0; i < buffers.size(); i++){
+            const Json::Value &buffer = buffers[i];
+            int64_t length = buffer["byteLength"].indexOr(-1);
+            const std::string &uri = buffer["uri"].stringOr("");
+            const uint8_t* data = NULL;
+            size_t size = 0;
+            if(!buffer.has("uri")){
+                if(i != 0 || binary == NULL){
+                    error = "buffer " + std::to_string(i) + " has no data";
+                    return false;
+                }
+                data = binary;
+                size = binarySize;
+            }
+            else if(uri.compare(0, 5, "data:") == 0){
+                size_t comma = uri.find(";base64,");
+                if(comma == std::string::npos){
+                    error = "buffer " + std::to_string(i) + " isn't base64";
+                    return false;
+                }
+                document.decoded.emplace_back();
+                if(!decodeBase64(uri.data() + comma + 8, uri.size() - comma - 8, document.decoded.back())){
+                    error = "buffer " + std::to_string(i) + " has bad base64";
+                    return false;
+                }
+                data = document.decoded.back().data();
+                size = document.decoded.back().size();
+            }
+            else{
+                MappedFile file;
+                if(!file.open(directory + uri)){
+                    error = "can't open buffer " + directory + uri;
+                    return false;
+                }
+                file.willNeed();
+                data = file.data();
+                size = file.size();
+                document.files.push_back(std::move(file));
+            }
+            if(length < 0 || static_cast<uint64_t>(length) > size){
+                error = "buffer " + std::to_string(i) + " is shorter than its byteLength";
+                return false;
+            }
+            document.buffers.emplace_back(data, static_cast<size_t>(length));
+        }
+        return true;
+    }
+
+    inline bool accessor(const Document &document, int64_t index, Accessor &out, std::string &error){
+        const Json::Value &json = document.json["accessors"][static_cast<size_t>(std::max<int64_t>(index, 0))];
+        const Json::Value &view = document.json["bufferViews"][static_cast<size_t>(std::max<int64_t>(json["bufferView"].indexOr(-1), 0))];
+        std::string name = "accessor " + std::to_string(index);
+        if(index < 0 || json.isNull() || !json.has("bufferView") || view.isNull()){
+            error = name + " is missing or has no bufferView";
+            return false;
+        }
+        int64_t buffer = view["buffer"].indexOr(-1);
+        if(buffer < 0 || static_cast<size_t>(buffer) >= document.buffers.size()){
+            error = name + " refers to a missing buffer";
+            return false;
+        }
+        out.componentType = static_cast<uint32_t>(json["componentType"].indexOr(0));
+        out.components = componentCount(json["type"].stringOr(""));
+        out.count = static_cast<size_t>(json["count"].indexOr(0));
+        out.normalized = json["normalized"].type == Json::Value::BOOLEAN && json["normalized"].boolean;
+        size_t element = componentSize(out.componentType) * static_cast<size_t>(out.components);
+        if(element == 0){
+            error = name + " has an unknown type";
+            return false;
+        }
+        uint64_t viewOffset = static_cast<uint64_t>(view["byteOffset"].indexOr(0));
+        uint64_t viewLength = static_cast<uint64_t>(view["byteLength"].indexOr(0));
+        uint64_t offset = static_cast<uint64_t>(json["byteOffset"].indexOr(0));
+        out.stride = static_cast<size_t>(view["byteStride"].indexOr(static_cast<int64_t>(element)));
+        if(viewOffset + viewLength > document.buffers[buffer].second || out.stride < element ||
+           (out.count > 0 && offset + static_cast<uint64_t>(out.stride) * (out.count - 1) + element > viewLength)){
+            error = name + " runs past its bufferView";
+            return false;
+        }
+        out.data = document.buffers[buffer].first + viewOffset + offset;
+        return true;
+    }
+
+    // component c of element i as a float, normalized integers mapped to [0, 1] or [-1, 1]
+    inline float component(const Accessor &accessor, size_t i, int c){
+        const uint8_t* p = accessor.data + i * accessor.stride + static_cast<size_t>(c) * componentSize(accessor.componentType);
+        switch(accessor.componentType){
+            case COMPONENT_FLOAT: { float v; memcpy(&v, p, 4); return v; }
+            case COMPONENT_UNSIGNED_BYTE: return accessor.normalized ? *p / 255.0f : *p;
+            case COMPONENT_BYTE: { int8_t v = static_cast<int8_t>(*p); return accessor.normalized ? std::max(v / 127.0f, -1.0f) : v; }
+            case COMPONENT_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, p, 2); return accessor.normalized ? v / 65535.0f : v; }
+            case COMPONENT_SHORT: { int16_t v; memcpy(&v, p, 2); return accessor.normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+            case COMPONENT_UNSIGNED_INT: { uint32_t v; memcpy(&v, p, 4); return static_cast<float>(v); }
+            default: return 0.0f;
+        }
+    }
+
+    inline uint32_t indexAt(const Accessor &accessor, size_t i){
+        const uint8_t* p = accessor.data + i * accessor.stride;
+        switch(accessor.componentType){
+            case COMPONENT_UNSIGNED_BYTE: return *p;
+            case COMPONENT_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, p, 2); return v; }
+            default: { uint32_t v; memcpy(&v, p, 4); return v; }
+        }
+    }
+
+    inline glm::mat4 nodeTransform(const Json::Value &node){
+        const Json::Value &matrix = node["matrix"];
+        if(matrix.size() == 16){
+            float values[16];
+            for(size_t i = 0; i < 16; i++){
+                values[i] = static_cast<float>(matrix[i].numberOr(0.0));
+            }
+            return glm::make_mat4(values);
+        }
+        const Json::Value &t = node["translation"];
+        const Json::Value &r = node["rotation"];
+        const Json::Value &s = node["scale"];
+        glm::mat4 transform(1.0f);
+        if(t.size() == 3){
+            transform = glm::translate(transform, glm::vec3(t[0].numberOr(0.0), t[1].numberOr(0.0), t[2].numberOr(0.0)));
+        }
+        if(r.size() == 4){
+            transform *= glm::mat4_cast(glm::quat(static_cast<float>(r[3].numberOr(1.0)), static_cast<float>(r[0].numberOr(0.0)), static_cast<float>(r[1].numberOr(0.0)), static_cast<float>(r[2].numberOr(0.0))));
+        }
+        if(s.size() == 3){
+            transform = glm::scale(transform, glm::vec3(s[0].numberOr(1.0), s[1].numberOr(1.0), s[2].numberOr(1.0)));
+        }
+        return transform;
+    }
+
+    // one triangle primitive placed in the scene, with where its data goes in the mesh
+    struct Draw {
+        const Json::Value* primitive;
+        glm::mat4 transform;
+        uint32_t material;              // index into the material names
+        Accessor positions, normals, texcoords, indices;
+        bool hasNormals, hasTexcoords, hasIndices;
+        int64_t attributeIds[3];        // POSITION, NORMAL, TEXCOORD_0 accessors
+        size_t sharedWith;              // an earlier draw whose vertices these are, or SIZE_MAX
+        uint32_t firstVertex;
+        size_t indexCount;
+        size_t output;                  // first index in the material sorted indices
+    };
+
+    inline bool collectDraws(const Document &document, int64_t nodeIndex, const glm::mat4 &parent, size_t depth, std::vector<Draw> &draws, std::vector<int64_t> &materialIds, std::string &error){
+        const Json::Value &node = document.json["nodes"][static_cast<size_t>(std::max<int64_t>(nodeIndex, 0))];
+        if(nodeIndex < 0 || node.isNull() || depth > document.json["nodes"].size()){
+            error = "bad node " + std::to_string(nodeIndex);
+            return false;
+        }
+        glm::mat4 transform = parent * nodeTransform(node);
+        if(node.has("mesh")){
+            const Json::Value &primitives = document.json["meshes"][static_cast<size_t>(std::max<int64_t>(node["mesh"].indexOr(-1), 0))]["primitives"];
+            if(node["mesh"].indexOr(-1) < 0 || primitives.isNull()){
+                error = "node " + std::to_string(nodeIndex) + " has a bad mesh";
+                return false;
+            }
+            size_t firstDraw = draws.size();
+            for(size_t i = 0; i < primitives.size(); i++){
+                const Json::Value &primitive = primitives[i];
+                if(primitive["mode"].indexOr(MODE_TRIANGLES) != MODE_TRIANGLES){
+                    continue;
+                }
+                Draw draw = {};
+                draw.primitive = &primitive;
+                draw.transform = transform;
+                const Json::Value &attributes = primitive["attributes"];
+                if(!accessor(document, attributes["POSITION"].indexOr(-1), draw.positions, error)){
+                    return false;
+                }
+                draw.hasNormals = attributes.has("NORMAL");
+                draw.hasTexcoords = attributes.has("TEXCOORD_0");
+                draw.hasIndices = primitive.has("indices");
+                if((draw.hasNormals && !accessor(document, attributes["NORMAL"].indexOr(-1), draw.normals, error)) ||
+                   (draw.hasTexcoords && !accessor(document, attributes["TEXCOORD_0"].indexOr(-1), draw.texcoords, error)) ||
+                   (draw.hasIndices && !accessor(document, primitive["indices"].indexOr(-1), draw.indices, error))){
+                    return false;
+                }
+                if(draw.positions.components != 3 || (draw.hasNormals && (draw.normals.components != 3 || draw.normals.count != draw.positions.count)) ||
+                   (draw.hasTexcoords && (draw.texcoords.components != 2 || draw.texcoords.count != draw.positions.count)) ||
+                   (draw.hasIndices && (draw.indices.components != 1 || draw.indices.componentType == COMPONENT_FLOAT || componentSize(draw.indices.componentType) == 0 ||
+                                        draw.indices.componentType == COMPONENT_BYTE || draw.indices.componentType == COMPONENT_SHORT))){
+                    error = "primitive of node " + std::to_string(nodeIndex) + " has mismatched attributes";
+                    return false;
+                }
+                draw.indexCount = (draw.hasIndices ? draw.indices.count : draw.positions.count) / 3 * 3;
+                if(draw.indexCount == 0){
+                    continue;
+                }
+                // primitives splitting one vertex buffer by material share its vertices, unless
+                // normals have to be generated from each one's own faces
+                draw.attributeIds[0] = attributes["POSITION"].indexOr(-1);
+                draw.attributeIds[1] = attributes["NORMAL"].indexOr(-1);
+                draw.attributeIds[2] = attributes["TEXCOORD_0"].indexOr(-1);
+                draw.sharedWith = SIZE_MAX;
+                for(size_t d = firstDraw; d < draws.size() && draw.hasNormals; d++){
+                    if(draws[d].sharedWith == SIZE_MAX && memcmp(draws[d].attributeIds, draw.attributeIds, sizeof(draw.attributeIds)) == 0){
+                        draw.sharedWith = d;
+                        break;
+                    }
+                }
+                int64_t material = primitive["material"].indexOr(-1);
+                draw.material = static_cast<uint32_t>(std::find(materialIds.begin(), materialIds.end(), material) - materialIds.begin());
+                if(draw.material == materialIds.size()){
+                    materialIds.push_back(material);
+                }
+                draws.push_back(draw);
+            }
+        }
+        const Json::Value &children = node["children"];
+        for(size_t i = 0; i < children.size(); i++){
+            if(!collectDraws(document, children[i].indexOr(-1), transform, depth + 1, draws, materialIds, error)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // position, normal and texcoord of the draw's vertices [begin, end) into the interleaved stream
+    inline void writeVertices(const Draw &draw, float* vertices, size_t begin, size_t end){
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(draw.transform)));
+        for(size_t i = begin; i < end; i++){
+            float* out = vertices + (static_cast<size_t>(draw.firstVertex) + i) * 8;
+            glm::vec4 p = draw.transform * glm::vec4(component(draw.positions, i, 0), component(draw.positions, i, 1), component(draw.positions, i, 2), 1.0f);
+            out[0] = p.x;
+            out[1] = p.y;
+            out[2] = p.z;
+            if(draw.hasNormals){
+                glm::vec3 n = normalMatrix * glm::vec3(component(draw.normals, i, 0), component(draw.normals, i, 1), component(draw.normals, i, 2));
+                float length = glm::length(n);
+                n = length > 0.0f ? n / length : glm::vec3(0.0f, 1.0f, 0.0f);
+                out[3] = n.x;
+                out[4] = n.y;
+                out[5] = n.z;
+            }
+            out[6] = draw.hasTexcoords ? component(draw.texcoords, i, 0) : 0.0f;
+            out[7] = draw.hasTexcoords ? component(draw.texcoords, i, 1) : 0.0f;
+        }
+    }
+
+    // area weighted face normals for a draw without NORMAL, from its written positions and indices
+    inline void generateNormals(const Draw &draw, float* vertices, const uint32_t* indices){
+        std::vector<glm::vec3> sums(draw.positions.count, glm::vec3(0.0f));
+        for(size_t i = 0; i + 2 < draw.indexCount; i += 3){
+            uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            glm::vec3 pa = glm::make_vec3(vertices + static_cast<size_t>(a) * 8);
+            glm::vec3 n = glm::cross(glm::make_vec3(vertices + static_cast<size_t>(b) * 8) - pa, glm::make_vec3(vertices + static_cast<size_t>(c) * 8) - pa);
+            sums[a - draw.firstVertex] += n;
+            sums[b - draw.firstVertex] += n;
+            sums[c - draw.firstVertex] += n;
+        }
+        for(size_t i = 0; i < sums.size(); i++){
+            float length = glm::length(sums[i]);
+            glm::vec3 n = length > 0.0f ? sums[i] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+            memcpy(vertices + (static_cast<size_t>(draw.firstVertex) + i) * 8 + 3, &n[0], 3 * sizeof(float));
+        }
+    }
+
+    inline bool convert(const Document &document, MeshContainer::Mesh &mesh, std::vector<std::string> &materials, std::string &error, bool parallel){
+        const Json::Value &json = document.json;
+        std::vector<Draw> draws;
+        std::vector<int64_t> materialIds;
+        const Json::Value &scene = json["scenes"][static_cast<size_t>(json["scene"].indexOr(0))];
+        if(!scene.isNull()){
+            const Json::Value &roots = scene["nodes"];
+            for(size_t i = 0; i < roots.size(); i++){
+                if(!collectDraws(document, roots[i].indexOr(-1), glm::mat4(1.0f), 0, draws, materialIds, error)){
+                    return false;
+                }
+            }
+        }
+        else{
+            // no scene: every node that isn't somebody's child is a root
+            std::vector<bool> child(json["nodes"].size(), false);
+            for(size_t i = 0; i < json["nodes"].size(); i++){
+                const Json::Value &children = json["nodes"][i]["children"];
+                for(size_t c = 0; c < children.size(); c++){
+                    size_t index = static_cast<size_t>(std::max<int64_t>(children[c].indexOr(0), 0));
+                    if(index < child.size()){
+                        child[index] = true;
+                    }
+                }
+            }
+            for(size_t i = 0; i < child.size(); i++){
+                if(!child[i] && !collectDraws(document, static_cast<int64_t>(i), glm::mat4(1.0f), 0, draws, materialIds, error)){
+                    return false;
+                }
+            }
+        }
+        if(draws.empty()){
+            error = "no triangles";
+            return false;
+        }
+
+        // vertex offsets in draw order, indices grouped by material keeping draw order inside
+        uint64_t vertexCount = 0;
+        std::vector<size_t> materialIndices(materialIds.size(), 0);
+        for(Draw &draw : draws){
+            if(draw.sharedWith != SIZE_MAX){
+                draw.firstVertex = draws[draw.sharedWith].firstVertex;
+            }
+            else{
+                draw.firstVertex = static_cast<uint32_t>(vertexCount);
+                vertexCount += draw.positions.count;
+            }
+            materialIndices[draw.material] += draw.indexCount;
+        }
+        if(vertexCount > 0xFFFFFFFFull){
+            error = "too many vertices";
+            return false;
+        }
+        std::vector<size_t> cursor(materialIds.size(), 0);
+        for(size_t m = 1; m < materialIds.size(); m++){
+            cursor[m] = cursor[m - 1] + materialIndices[m - 1];
+        }
+        std::vector<size_t> materialStart = cursor;
+        for(Draw &draw : draws){
+            draw.output = cursor[draw.material];
+            cursor[draw.material] += draw.indexCount;
+        }
+
+        mesh = MeshContainer::Mesh();
+        mesh.vertexCount = static_cast<uint32_t>(vertexCount);
+        mesh.attributes = MeshContainer::interleavedLayout();
+        mesh.streams.resize(1);
+        mesh.streams[0].stride = MeshContainer::INTERLEAVED_STRIDE;
+        mesh.streams[0].bytes.resize(static_cast<size_t>(MeshContainer::INTERLEAVED_STRIDE) * vertexCount);
+        mesh.indices.resize(cursor.back());
+        float* vertices = reinterpret_cast<float*>(mesh.streams[0].bytes.data());
+
+        // big primitives are split across threads, small ones run where they are
+        const size_t GRAIN = 16 * 1024;
+        bool outOfRange = false;
+        for(const Draw &draw : draws){
+            // shared vertices were written with the draw that owns them
+            if(draw.sharedWith == SIZE_MAX && parallel){
+                parallelFor(draw.positions.count, [&](size_t begin, size_t end){ writeVertices(draw, vertices, begin, end); }, GRAIN);
+            }
+            else if(draw.sharedWith == SIZE_MAX){
+                writeVertices(draw, vertices, 0, draw.positions.count);
+            }
+            uint32_t* out = &mesh.indices[draw.output];
+            // a mirroring transform turns the winding around
+            bool flip = glm::determinant(glm::mat3(draw.transform)) < 0.0f;
+            std::atomic<bool> bad(false);
+            auto writeIndices = [&](size_t begin, size_t end){
+                for(size_t i = begin; i < end; i++){
+                    size_t source = flip && i % 3 != 0 ? i + (i % 3 == 1 ? 1 : -1) : i;
+                    uint32_t index = draw.hasIndices ? indexAt(draw.indices, source) : static_cast<uint32_t>(source);
+                    if(index >= draw.positions.count){
+                        bad.store(true, std::memory_order_relaxed);
+                        index = 0;
+                    }
+                    out[i] = draw.firstVertex + index;
+                }
+            };
+            if(parallel){
+                parallelFor(draw.indexCount, writeIndices, GRAIN);
+            }
+            else{
+                writeIndices(0, draw.indexCount);
+            }
+            outOfRange = outOfRange || bad.load();
+            if(!draw.hasNormals){
+                generateNormals(draw, vertices, out);
+            }
+        }
+        if(outOfRange){
+            error = "index out of range";
+            return false;
+        }
+
+        MeshContainer::Lod lod = {};
+        materials.clear();
+        for(size_t m = 0; m < materialIds.size(); m++){
+            MeshContainer::Submesh submesh = {};
+            submesh.firstIndex = static_cast<uint32_t>(materialStart[m]);
+            submesh.indexCount = static_cast<uint32_t>(materialIndices[m]);
+            submesh.material = static_cast<uint32_t>(materials.size());
+            materials.push_back(materialIds[m] < 0 ? "" : json["materials"][static_cast<size_t>(materialIds[m])]["name"].stringOr("material" + std::to_string(materialIds[m])));
+            MeshContainer::indexBounds(mesh, submesh.firstIndex, submesh.indexCount, submesh.boundsMin, submesh.boundsMax);
+            mesh.submeshes.push_back(submesh);
+            lod.submeshCount++;
+        }
+        mesh.lods.push_back(lod);
+        return true;
+    }
+
+    // a .glb or .gltf already in memory; directory is where external buffers are looked up
+    inline bool parse(const uint8_t* data, size_t size, const std::string &directory, MeshContainer::Mesh &mesh, std::vector<std::string> &materials, std::string &error, bool parallel = true){
+        Document document;
+        const uint8_t* binary = NULL;
+        size_t binarySize = 0;
+        uint32_t magic = 0;
+        if(size >= 4){
+            memcpy(&magic, data, 4);
+        }
+        if(magic == GLB_MAGIC){
+            uint32_t header[3];
+            if(size < 20){
+                error = "truncated GLB header";
+                return false;
+            }
+            memcpy(header, data, sizeof(header));
+            if(header[1] != 2 || header[2] > size){
+                error = "unsupported GLB version or bad length";
+                return false;
+            }
+            const uint8_t* json = NULL;
+            size_t jsonSize = 0;
+            for(size_t offset = 12; offset + 8 <= header[2];){
+                uint32_t chunk[2];
+                memcpy(chunk, data + offset, sizeof(chunk));
+                if(chunk[0] > header[2] - offset - 8){
+                    error = "GLB chunk runs past the file";
+                    return false;
+                }
+                if(chunk[1] == GLB_CHUNK_JSON && json == NULL){
+                    json = data + offset + 8;
+                    jsonSize = chunk[0];
+                }
+                else if(chunk[1] == GLB_CHUNK_BIN && binary == NULL){
+                    binary = data + offset + 8;
+                    binarySize = chunk[0];
+                }
+                offset += 8 + MeshContainer::alignUp(chunk[0], 4);
+            }
+            if(json == NULL){
+                error = "GLB without a JSON chunk";
+                return false;
+            }
+            // the JSON chunk is padded with spaces, which the reader skips
+            if(!Json::parse(reinterpret_cast<const char*>(json), jsonSize, document.json, error)){
+                error = "bad JSON: " + error;
+                return false;
+            }
+        }
+        else if(!Json::parse(reinterpret_cast<const char*>(data), size, document.json, error)){
+            error = "bad JSON: " + error;
+            return false;
+        }
+        if(document.json["asset"]["version"].stringOr("").compare(0, 2, "2.") != 0){
+            error = "not a glTF 2 asset";
+            return false;
+        }
+        return loadBuffers(document, directory, binary, binarySize, error) && convert(document, mesh, materials, error, parallel);
+    }
+
+    // materials gets the material names of the submeshes, "" for primitives without one
+    inline bool load(const std::string &path, MeshContainer::Mesh &mesh, std::vector<std::string> &materials, std::string &error, bool parallel = true){
+        MappedFile file;
+        if(!file.open(path)){
+            error = "can't open " + path;
+            return false;
+        }
+        file.willNeed();
+        size_t slash = path.find_last_of("/\\");
+        std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+        if(!parse(file.data(), file.size(), directory, mesh, materials, error, parallel)){
+            error = path + ": " + error;
+            return false;
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,396 @@
+#ifndef MESH_CONTAINER_H
+#define MESH_CONTAINER_H
+
+#include <glad/glad.h>
+#include <FileIO/mapped_file.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Cooked mesh container (.gmesh), the geometry counterpart of the .gtex texture container:
+//
+//   Header                        fixed size, little endian
+//   Attribute[attributeCount]     vertex attribute layout, one entry per shader location
+//   Stream[streamCount]           vertex streams (one buffer binding each) inside the vertex data
+//   Lod[lodCount]                 detail levels, most detailed first, each a run of submeshes
+//   Submesh[submeshCount]         index ranges with their material and bounds
+//   vertex data                   every stream back to back, each aligned to DATA_ALIGNMENT
+//   index data                    every LOD's indices, GL_UNSIGNED_SHORT when they fit
+//
+// Vertex and index data are already in the layout glVertexAttribPointer / glDrawElements
+// expect, so a loader can hand pointers into the mapped file straight to glBufferData (or
+// glBufferStorage) with no copy of its own. All LODs share the vertex data, the smaller ones
+// only index fewer of the vertices.
+
+namespace MeshContainer {
+
+    const uint8_t IDENTIFIER[12] = { 0xAB, 'G', 'M', 'S', 'H', ' ', '1', '0', 0xBB, '\r', '\n', 0x1A };
+    const uint32_t VERSION = 1;
+    const uint32_t DATA_ALIGNMENT = 16;
+    const uint32_t MAX_ATTRIBUTES = 16;
+    const uint32_t MAX_STREAMS = 8;
+    const uint32_t MAX_LODS = 8;
+
+    // shader locations of the attributes the cooker writes, match shader.vert
+    enum Location : uint32_t {
+        LOCATION_POSITION = 0,
+        LOCATION_NORMAL = 1,
+        LOCATION_TEXCOORD = 2
+    };
+
+    struct Header {
+        uint8_t identifier[12];
+        uint32_t version;
+        uint32_t vertexCount;
+        uint32_t indexType;          // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+        uint32_t indexCount;         // of every LOD together
+        uint32_t attributeCount;
+        uint32_t streamCount;
+        uint32_t lodCount;
+        uint32_t submeshCount;
+        uint32_t reserved0;
+        uint64_t vertexDataOffset;
+        uint64_t vertexDataLength;
+        uint64_t indexDataOffset;
+        uint64_t indexDataLength;
+        float boundsMin[3];          // of the positions, object space
+        float boundsMax[3];
+        float sphereCenter[3];
+        float sphereRadius;
+        uint32_t reserved[2];
+    };
+
+    struct Attribute {
+        uint32_t location;
+        uint32_t stream;
+        uint32_t offset;             // within a vertex of the stream
+        uint32_t components;         // 1-4
+        uint32_t glType;             // e.g. GL_FLOAT
+        uint32_t normalized;         // integer types read as 0..1 / -1..1
+    };
+
+    struct Stream {
+        uint64_t byteOffset;         // from vertexDataOffset
+        uint64_t byteLength;
+        uint32_t stride;
+        uint32_t reserved;
+    };
+
+    struct Lod {
+        uint32_t firstSubmesh;
+        uint32_t submeshCount;
+        float error;                 // object space distance the surface may be off by, 0 for the original
+        uint32_t reserved;
+    };
+
+    struct Submesh {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t material;           // index into the source file's materials, in order of first use
+        uint32_t reserved;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    static_assert(sizeof(Header) == 128, "Header layout is part of the file format");
+    static_assert(sizeof(Attribute) == 24, "Attribute layout is part of the file format");
+    static_assert(sizeof(Stream) == 24, "Stream layout is part of the file format");
+    static_assert(sizeof(Lod) == 16, "Lod layout is part of the file format");
+    static_assert(sizeof(Submesh) == 40, "Submesh layout is part of the file format");
+
+    struct VertexStream {
+        uint32_t stride = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    // a mesh in memory, as the importers and the cooker build it
+    struct Mesh {
+        uint32_t vertexCount = 0;
+        std::vector<Attribute> attributes;
+        std::vector<VertexStream> streams;
+        std::vector<uint32_t> indices;
+        std::vector<Lod> lods;
+        std::vector<Submesh> submeshes;
+    };
+
+    // position, normal and texture coordinate floats interleaved in stream 0, the layout of
+    // the app's own cube vertices
+    const uint32_t INTERLEAVED_STRIDE = 8 * sizeof(float);
+
+    inline std::vector<Attribute> interleavedLayout(){
+        return {
+            { LOCATION_POSITION, 0, 0, 3, GL_FLOAT, 0 },
+            { LOCATION_NORMAL, 0, 3 * sizeof(float), 3, GL_FLOAT, 0 },
+            { LOCATION_TEXCOORD, 0, 6 * sizeof(float), 2, GL_FLOAT, 0 }
+        };
+    }
+
+    inline uint64_t alignUp(uint64_t value, uint64_t alignment){
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    inline const Attribute* findAttribute(const Mesh &mesh, uint32_t location){
+        for(const Attribute &attribute : mesh.attributes){
+            if(attribute.location == location){
+                return &attribute;
+            }
+        }
+        return NULL;
+    }
+
+    // object space position of a vertex, from the float3 LOCATION_POSITION attribute
+    inline void position(const Mesh &mesh, const Attribute &attribute, uint32_t vertex, float out[3]){
+        const VertexStream &stream = mesh.streams[attribute.stream];
+        memcpy(out, stream.bytes.data() + static_cast<size_t>(vertex) * stream.stride + attribute.offset, 3 * sizeof(float));
+    }
+
+    // bounds of the indices [first, first + count)
+    inline void indexBounds(const Mesh &mesh, uint32_t first, uint32_t count, float boundsMin[3], float boundsMax[3]){
+        const Attribute* attribute = findAttribute(mesh, LOCATION_POSITION);
+        for(int axis = 0; axis < 3; axis++){
+            boundsMin[axis] = count > 0 && attribute != NULL ? INFINITY : 0.0f;
+            boundsMax[axis] = count > 0 && attribute != NULL ? -INFINITY : 0.0f;
+        }
+        if(attribute == NULL){
+            return;
+        }
+        for(uint32_t i = first; i < first + count; i++){
+            float p[3];
+            position(mesh, *attribute, mesh.indices[i], p);
+            for(int axis = 0; axis < 3; axis++){
+                boundsMin[axis] = std::min(boundsMin[axis], p[axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], p[axis]);
+            }
+        }
+    }
+
+    // the mesh needs at least one LOD and submesh, with submesh bounds filled (indexBounds)
+    inline bool write(const std::string &path, const Mesh &mesh){
+        if(mesh.vertexCount == 0 || mesh.streams.empty() || mesh.lods.empty() || mesh.submeshes.empty() ||
+           mesh.attributes.size() > MAX_ATTRIBUTES || mesh.streams.size() > MAX_STREAMS || mesh.lods.size() > MAX_LODS){
+            return false;
+        }
+
+        Header header = {};
+        memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+        header.version = VERSION;
+        header.vertexCount = mesh.vertexCount;
+        header.indexType = mesh.vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        header.attributeCount = static_cast<uint32_t>(mesh.attributes.size());
+        header.streamCount = static_cast<uint32_t>(mesh.streams.size());
+        header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+        header.submeshCount = static_cast<uint32_t>(mesh.submeshes.size());
+
+        // the whole mesh's bounds are the most detailed LOD's
+        const Lod &top = mesh.lods[0];
+        for(int axis = 0; axis < 3; axis++){
+            header.boundsMin[axis] = INFINITY;
+            header.boundsMax[axis] = -INFINITY;
+        }
+        for(uint32_t i = top.firstSubmesh; i < top.firstSubmesh + top.submeshCount; i++){
+            for(int axis = 0; axis < 3; axis++){
+                header.boundsMin[axis] = std::min(header.boundsMin[axis], mesh.submeshes[i].boundsMin[axis]);
+                header.boundsMax[axis] = std::max(header.boundsMax[axis], mesh.submeshes[i].boundsMax[axis]);
+            }
+        }
+        const Attribute* attribute = findAttribute(mesh, LOCATION_POSITION);
+        float radiusSquared = 0.0f;
+        for(int axis = 0; axis < 3; axis++){
+            header.sphereCenter[axis] = (header.boundsMin[axis] + header.boundsMax[axis]) * 0.5f;
+        }
+        for(uint32_t vertex = 0; attribute != NULL && vertex < mesh.vertexCount; vertex++){
+            float p[3];
+            position(mesh, *attribute, vertex, p);
+            float dx = p[0] - header.sphereCenter[0], dy = p[1] - header.sphereCenter[1], dz = p[2] - header.sphereCenter[2];
+            radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+        }
+        header.sphereRadius = std::sqrt(radiusSquared);
+
+        std::vector<Stream> streams(mesh.streams.size());
+        uint64_t streamOffset = 0;
+        for(size_t i = 0; i < mesh.streams.size(); i++){
+            streams[i].byteOffset = streamOffset;
+            streams[i].byteLength = mesh.streams[i].bytes.size();
+            streams[i].stride = mesh.streams[i].stride;
+            streamOffset = alignUp(streamOffset + mesh.streams[i].bytes.size(), DATA_ALIGNMENT);
+        }
+        size_t indexSize = header.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        uint64_t tables = sizeof(Header) + sizeof(Attribute) * mesh.attributes.size() + sizeof(Stream) * streams.size() +
+                          sizeof(Lod) * mesh.lods.size() + sizeof(Submesh) * mesh.submeshes.size();
+        header.vertexDataOffset = alignUp(tables, DATA_ALIGNMENT);
+        header.vertexDataLength = streams.back().byteOffset + streams.back().byteLength;
+        header.indexDataOffset = alignUp(header.vertexDataOffset + header.vertexDataLength, DATA_ALIGNMENT);
+        header.indexDataLength = indexSize * mesh.indices.size();
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if(!out){
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(mesh.attributes.data()), static_cast<std::streamsize>(sizeof(Attribute) * mesh.attributes.size()));
+        out.write(reinterpret_cast<const char*>(streams.data()), static_cast<std::streamsize>(sizeof(Stream) * streams.size()));
+        out.write(reinterpret_cast<const char*>(mesh.lods.data()), static_cast<std::streamsize>(sizeof(Lod) * mesh.lods.size()));
+        out.write(reinterpret_cast<const char*>(mesh.submeshes.data()), static_cast<std::streamsize>(sizeof(Submesh) * mesh.submeshes.size()));
+
+        const char padding[DATA_ALIGNMENT] = {};
+        uint64_t written = tables;
+        for(size_t i = 0; i < streams.size(); i++){
+            out.write(padding, static_cast<std::streamsize>(header.vertexDataOffset + streams[i].byteOffset - written));
+            out.write(reinterpret_cast<const char*>(mesh.streams[i].bytes.data()), static_cast<std::streamsize>(streams[i].byteLength));
+            written = header.vertexDataOffset + streams[i].byteOffset + streams[i].byteLength;
+        }
+        out.write(padding, static_cast<std::streamsize>(header.indexDataOffset - written));
+        if(header.indexType == GL_UNSIGNED_SHORT){
+            std::vector<uint16_t> narrow(mesh.indices.begin(), mesh.indices.end());
+            out.write(reinterpret_cast<const char*>(narrow.data()), static_cast<std::streamsize>(header.indexDataLength));
+        }
+        else{
+            out.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(header.indexDataLength));
+        }
+        return static_cast<bool>(out);
+    }
+}
+
+// Read side of the container. The file stays mapped for the lifetime of the object and
+// vertexData() / indexData() point straight into the mapping.
+class MeshFile {
+    public:
+        bool open(const std::string &path){
+            if(!file.open(path)){
+                return false;
+            }
+            if(!validate()){
+                file.close();
+                return false;
+            }
+            return true;
+        }
+
+        void close(){
+            file.close();
+        }
+
+        bool isOpen() const{
+            return file.isOpen();
+        }
+
+        const MeshContainer::Header& header() const{
+            return *reinterpret_cast<const MeshContainer::Header*>(file.data());
+        }
+
+        const MeshContainer::Attribute& attribute(uint32_t i) const{
+            return attributes()[i];
+        }
+
+        const MeshContainer::Stream& stream(uint32_t i) const{
+            return streams()[i];
+        }
+
+        const MeshContainer::Lod& lod(uint32_t i) const{
+            return lods()[i];
+        }
+
+        const MeshContainer::Submesh& submesh(uint32_t i) const{
+            return submeshes()[i];
+        }
+
+        const uint8_t* vertexData() const{
+            return file.data() + header().vertexDataOffset;
+        }
+
+        size_t vertexDataSize() const{
+            return static_cast<size_t>(header().vertexDataLength);
+        }
+
+        const uint8_t* indexData() const{
+            return file.data() + header().indexDataOffset;
+        }
+
+        size_t indexDataSize() const{
+            return static_cast<size_t>(header().indexDataLength);
+        }
+
+        size_t indexSize() const{
+            return header().indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        }
+
+        const MappedFile& mapping() const{
+            return file;
+        }
+
+    private:
+        MappedFile file;
+
+        const MeshContainer::Attribute* attributes() const{
+            return reinterpret_cast<const MeshContainer::Attribute*>(file.data() + sizeof(MeshContainer::Header));
+        }
+
+        const MeshContainer::Stream* streams() const{
+            return reinterpret_cast<const MeshContainer::Stream*>(attributes() + header().attributeCount);
+        }
+
+        const MeshContainer::Lod* lods() const{
+            return reinterpret_cast<const MeshContainer::Lod*>(streams() + header().streamCount);
+        }
+
+        const MeshContainer::Submesh* submeshes() const{
+            return reinterpret_cast<const MeshContainer::Submesh*>(lods() + header().lodCount);
+        }
+
+        static bool inside(uint64_t offset, uint64_t length, uint64_t size){
+            return offset <= size && length <= size - offset;
+        }
+
+        bool validate() const{
+            using namespace MeshContainer;
+            if(file.size() < sizeof(Header)){
+                return false;
+            }
+            const Header &h = header();
+            if(memcmp(h.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0 || h.version != VERSION || h.vertexCount == 0 ||
+               (h.indexType != GL_UNSIGNED_SHORT && h.indexType != GL_UNSIGNED_INT) ||
+               h.attributeCount > MAX_ATTRIBUTES || h.streamCount == 0 || h.streamCount > MAX_STREAMS ||
+               h.lodCount == 0 || h.lodCount > MAX_LODS || h.submeshCount == 0){
+                return false;
+            }
+            uint64_t tables = sizeof(Header) + sizeof(Attribute) * h.attributeCount + sizeof(Stream) * h.streamCount +
+                              sizeof(Lod) * h.lodCount + sizeof(Submesh) * static_cast<uint64_t>(h.submeshCount);
+            if(tables > file.size() || !inside(h.vertexDataOffset, h.vertexDataLength, file.size()) ||
+               !inside(h.indexDataOffset, h.indexDataLength, file.size()) || h.indexDataLength != static_cast<uint64_t>(h.indexCount) * indexSize()){
+                return false;
+            }
+            for(uint32_t i = 0; i < h.streamCount; i++){
+                const Stream &s = streams()[i];
+                if(s.stride == 0 || !inside(s.byteOffset, s.byteLength, h.vertexDataLength) || s.byteLength < static_cast<uint64_t>(s.stride) * h.vertexCount){
+                    return false;
+                }
+            }
+            for(uint32_t i = 0; i < h.attributeCount; i++){
+                const Attribute &a = attributes()[i];
+                if(a.stream >= h.streamCount || a.components == 0 || a.components > 4 || a.offset >= streams()[a.stream].stride){
+                    return false;
+                }
+            }
+            for(uint32_t i = 0; i < h.lodCount; i++){
+                const Lod &l = lods()[i];
+                if(!inside(l.firstSubmesh, l.submeshCount, h.submeshCount)){
+                    return false;
+                }
+            }
+            for(uint32_t i = 0; i < h.submeshCount; i++){
+                const Submesh &s = submeshes()[i];
+                if(!inside(s.firstIndex, s.indexCount, h.indexCount)){
+                    return false;
+                }
+            }
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef MESH_IMPORT_H
+#define MESH_IMPORT_H
+
+#include <Meshes/gltf_importer.h>
+#include <Meshes/mesh_container.h>
+#include <Meshes/obj_importer.h>
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+// One entry point for the source mesh formats, picked by file extension: Wavefront OBJ
+// (Meshes/obj_importer.h) and glTF 2.0 as .gltf or .glb (Meshes/gltf_importer.h). Both produce
+// the interleaved MeshContainer layout with a single LOD, ready for MeshLod::generate and
+// MeshContainer::write.
+
+namespace MeshImport {
+
+    struct Options {
+        bool parallel = true;           // split one file across the job system
+    };
+
+    inline std::string extension(const std::string &path){
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of("/\\");
+        std::string result = dot == std::string::npos || (slash != std::string::npos && dot < slash) ? "" : path.substr(dot);
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+        return result;
+    }
+
+    inline bool supported(const std::string &path){
+        std::string type = extension(path);
+        return type == ".obj" || type == ".gltf" || type == ".glb";
+    }
+
+    // materials gets the material name of each submesh
+    inline bool load(const std::string &path, MeshContainer::Mesh &mesh, std::vector<std::string> &materials, std::string &error, const Options &options = Options()){
+        std::string type = extension(path);
+        if(type == ".obj"){
+            return ObjImport::load(path, mesh, materials, error, options.parallel);
+        }
+        if(type == ".gltf" || type == ".glb"){
+            return GltfImport::load(path, mesh, materials, error, options.parallel);
+        }
+        error = path + ": unsupported mesh format";
+        return false;
+    }
+}
+
+#endif
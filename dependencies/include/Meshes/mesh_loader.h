@@ -0,0 +1,97 @@
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#include <glad/glad.h>
+#include <GLExt/gl_ext.h>
+#include <Meshes/mesh_container.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Uploads a cooked mesh into vertexBuffer and indexBuffer, reading straight out of the file
+// mapping: one call for all vertex streams and one for every LOD's indices, no staging copy
+// on our side. Uses immutable storage (glBufferStorage) when the context has it, otherwise
+// glBufferData with GL_STATIC_DRAW. The attributes of the vertex array currently bound are
+// pointed at the streams and indexBuffer becomes its element buffer; attributes are read as
+// floats (glVertexAttribPointer), integer ones normalized or converted.
+inline bool uploadMeshFile(const MeshFile &file, GLuint vertexBuffer, GLuint indexBuffer){
+    if(!file.isOpen()){
+        return false;
+    }
+    const MeshContainer::Header &header = file.header();
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    if(GLExt::BufferStorage != NULL){
+        GLExt::BufferStorage(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(file.vertexDataSize()), file.vertexData(), 0);
+    }
+    else{
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(file.vertexDataSize()), file.vertexData(), GL_STATIC_DRAW);
+    }
+    for(uint32_t i = 0; i < header.attributeCount; i++){
+        const MeshContainer::Attribute &attribute = file.attribute(i);
+        const MeshContainer::Stream &stream = file.stream(attribute.stream);
+        glVertexAttribPointer(attribute.location, static_cast<GLint>(attribute.components), attribute.glType, attribute.normalized ? GL_TRUE : GL_FALSE,
+            static_cast<GLsizei>(stream.stride), reinterpret_cast<const void*>(static_cast<uintptr_t>(stream.byteOffset + attribute.offset)));
+        glEnableVertexAttribArray(attribute.location);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    if(GLExt::BufferStorage != NULL){
+        GLExt::BufferStorage(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(file.indexDataSize()), file.indexData(), 0);
+    }
+    else{
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(file.indexDataSize()), file.indexData(), GL_STATIC_DRAW);
+    }
+    return true;
+}
+
+// The same for a mesh still in memory (MeshImport::load, not cooked): its streams back to back
+// as a cooked file lays them out, and 32 bit indices.
+inline bool uploadMesh(const MeshContainer::Mesh &mesh, GLuint vertexBuffer, GLuint indexBuffer){
+    if(mesh.vertexCount == 0 || mesh.streams.empty()){
+        return false;
+    }
+    std::vector<uint64_t> offsets(mesh.streams.size());
+    uint64_t vertexBytes = 0;
+    for(size_t i = 0; i < mesh.streams.size(); i++){
+        offsets[i] = MeshContainer::alignUp(vertexBytes, MeshContainer::DATA_ALIGNMENT);
+        vertexBytes = offsets[i] + mesh.streams[i].bytes.size();
+    }
+
+    // a single stream (the importers' interleaved layout) goes up without a copy
+    std::vector<uint8_t> packed;
+    const uint8_t* vertexData = mesh.streams[0].bytes.data();
+    if(mesh.streams.size() > 1){
+        packed.resize(static_cast<size_t>(vertexBytes));
+        for(size_t i = 0; i < mesh.streams.size(); i++){
+            memcpy(packed.data() + offsets[i], mesh.streams[i].bytes.data(), mesh.streams[i].bytes.size());
+        }
+        vertexData = packed.data();
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    if(GLExt::BufferStorage != NULL){
+        GLExt::BufferStorage(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexBytes), vertexData, 0);
+    }
+    else{
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexBytes), vertexData, GL_STATIC_DRAW);
+    }
+    for(const MeshContainer::Attribute &attribute : mesh.attributes){
+        glVertexAttribPointer(attribute.location, static_cast<GLint>(attribute.components), attribute.glType, attribute.normalized ? GL_TRUE : GL_FALSE,
+            static_cast<GLsizei>(mesh.streams[attribute.stream].stride), reinterpret_cast<const void*>(static_cast<uintptr_t>(offsets[attribute.stream] + attribute.offset)));
+        glEnableVertexAttribArray(attribute.location);
+    }
+
+    GLsizeiptr indexBytes = static_cast<GLsizeiptr>(mesh.indices.size() * sizeof(uint32_t));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    if(GLExt::BufferStorage != NULL){
+        GLExt::BufferStorage(GL_ELEMENT_ARRAY_BUFFER, indexBytes, mesh.indices.data(), 0);
+    }
+    else{
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, mesh.indices.data(), GL_STATIC_DRAW);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <Meshes/mesh_container.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Coarser detail levels for a cooked mesh by vertex clustering: the bounds are cut into a grid
+// of cubic cells, every vertex snaps to the first vertex that fell into its cell, and
+// triangles whose corners end up in fewer than three cells disappear. The snapped vertices
+// already exist, so a LOD is only a new index range over the shared vertex data.
+//
+// Each pass halves the grid, starting at FINEST_CELLS along the longest axis. Passes that
+// don't remove at least a tenth of the previous LOD's triangles are skipped, so small or
+// already coarse meshes (the cube) keep their single LOD.
+
+namespace MeshLod {
+
+    const uint32_t FINEST_CELLS = 64;
+
+    // triangles of the submesh left after snapping every index through representative
+    inline std::vector<uint32_t> clusterTriangles(const MeshContainer::Mesh &mesh, const MeshContainer::Submesh &submesh, const std::vector<uint32_t> &representative){
+        std::vector<uint32_t> kept;
+        for(uint32_t i = submesh.firstIndex; i + 2 < submesh.firstIndex + submesh.indexCount; i += 3){
+            uint32_t a = representative[mesh.indices[i]];
+            uint32_t b = representative[mesh.indices[i + 1]];
+            uint32_t c = representative[mesh.indices[i + 2]];
+            if(a != b && b != c && a != c){
+                kept.push_back(a);
+                kept.push_back(b);
+                kept.push_back(c);
+            }
+        }
+        return kept;
+    }
+
+    // appends LODs to a mesh holding only its original (LOD 0) until it has lodCount of them
+    // or the grid runs out of cells
+    inline void generate(MeshContainer::Mesh &mesh, uint32_t lodCount){
+        using namespace MeshContainer;
+        const Attribute* attribute = findAttribute(mesh, LOCATION_POSITION);
+        if(attribute == NULL || mesh.lods.size() != 1 || lodCount <= 1){
+            return;
+        }
+        lodCount = std::min(lodCount, MAX_LODS);
+        const Lod original = mesh.lods[0];
+
+        float boundsMin[3], boundsMax[3];
+        indexBounds(mesh, 0, static_cast<uint32_t>(mesh.indices.size()), boundsMin, boundsMax);
+        float extent = std::max(boundsMax[0] - boundsMin[0], std::max(boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2]));
+        if(!(extent > 0.0f)){
+            return;
+        }
+
+        uint64_t previousIndices = mesh.indices.size();
+        std::vector<uint32_t> representative(mesh.vertexCount);
+        for(uint32_t cells = FINEST_CELLS; cells >= 1 && mesh.lods.size() < lodCount; cells /= 2){
+            float cellSize = extent / cells;
+            std::unordered_map<uint64_t, uint32_t> occupant;
+            occupant.reserve(mesh.vertexCount);
+            for(uint32_t vertex = 0; vertex < mesh.vertexCount; vertex++){
+                float p[3];
+                position(mesh, *attribute, vertex, p);
+                uint64_t key = 0;
+                for(int axis = 0; axis < 3; axis++){
+                    uint32_t cell = static_cast<uint32_t>(std::min(std::max((p[axis] - boundsMin[axis]) / cellSize, 0.0f), static_cast<float>(cells - 1)));
+                    key = key << 21 | cell;
+                }
+                representative[vertex] = occupant.emplace(key, vertex).first->second;
+            }
+
+            std::vector<std::vector<uint32_t>> triangles;
+            uint64_t total = 0;
+            for(uint32_t i = original.firstSubmesh; i < original.firstSubmesh + original.submeshCount; i++){
+                triangles.push_back(clusterTriangles(mesh, mesh.submeshes[i], representative));
+                total += triangles.back().size();
+            }
+            if(total == 0){
+                break;
+            }
+            if(total > previousIndices * 9 / 10){
+                continue;
+            }
+            previousIndices = total;
+
+            Lod lod = {};
+            lod.firstSubmesh = static_cast<uint32_t>(mesh.submeshes.size());
+            lod.error = cellSize * std::sqrt(3.0f);
+            for(size_t i = 0; i < triangles.size(); i++){
+                if(triangles[i].empty()){
+                    continue;
+                }
+                Submesh submesh = mesh.submeshes[original.firstSubmesh + i];
+                submesh.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+                submesh.indexCount = static_cast<uint32_t>(triangles[i].size());
+                mesh.indices.insert(mesh.indices.end(), triangles[i].begin(), triangles[i].end());
+                indexBounds(mesh, submesh.firstIndex, submesh.indexCount, submesh.boundsMin, submesh.boundsMax);
+                mesh.submeshes.push_back(submesh);
+                lod.submeshCount++;
+            }
+            mesh.lods.push_back(lod);
+        }
+    }
+}
+
+#endif
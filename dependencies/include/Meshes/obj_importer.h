@@ -0,0 +1,766 @@
+#ifndef OBJ_IMPORTER_H
+#define OBJ_IMPORTER_H
+
+#include <FileIO/mapped_file.h>
+#include <Meshes/mesh_container.h>
+#include <Threading/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Wavefront OBJ into the interleaved layout of MeshContainer (position, normal, texture
+// coordinate). Reads v / vt / vn / f / usemtl and ignores the rest (groups, smoothing groups,
+// material libraries). Polygons are fanned into triangles (faces of one or two corners add
+// nothing, not even vertices), negative indices count back from the last element. Each distinct v/vt/vn triple becomes one vertex; corners without a
+// normal get the area weighted average of their faces' normals, corners without a texture
+// coordinate get 0, 0. Faces are grouped into one submesh per usemtl material, in order of
+// first use, as the single LOD of the result.
+//
+// Large files are parsed in parallel: the text is cut at line ends into chunks that are read
+// on the job system, each collecting its own elements and faces, and the corners are then
+// deduplicated through a shared lock free table (CornerTable). Vertex ids still follow the
+// order corners first appear in the file, so both paths give the same mesh.
+
+namespace ObjImport {
+
+    struct Corner {
+        int32_t position;
+        int32_t texcoord;            // -1 when missing
+        int32_t normal;              // -1 when missing
+
+        bool operator==(const Corner &other) const{
+            return position == other.position && texcoord == other.texcoord && normal == other.normal;
+        }
+    };
+
+    struct CornerHash {
+        size_t operator()(const Corner &corner) const{
+            uint64_t key = static_cast<uint32_t>(corner.position) * 0x9E3779B97F4A7C15ull;
+            key ^= (static_cast<uint32_t>(corner.texcoord) + 0x632BE59BD9B4E019ull + (key << 6) + (key >> 2));
+            key ^= (static_cast<uint32_t>(corner.normal) + 0x8CB92BA72F3D8DD7ull + (key << 6) + (key >> 2));
+            return static_cast<size_t>(key);
+        }
+    };
+
+    inline const char* skipSpaces(const char* p, const char* end){
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')){
+            p++;
+        }
+        return p;
+    }
+
+    inline const char* lineEnd(const char* p, const char* end){
+        const char* found = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        return found != NULL ? found : end;
+    }
+
+    // a decimal number with optional sign, fraction and exponent; returns where it ended or
+    // NULL when there are no digits. Never reads at or past end (the mapping isn't terminated).
+    inline const char* parseFloat(const char* p, const char* end, float &value){
+        static const double POWERS[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        bool negative = p < end && *p == '-';
+        p += p < end && (*p == '-' || *p == '+') ? 1 : 0;
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        int digits = 0;
+        for(; p < end && *p >= '0' && *p <= '9'; p++, digits++){
+            if(mantissa < 100000000000000000ull){
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            }
+            else{
+                exponent++;
+            }
+        }
+        if(p < end && *p == '.'){
+            for(p++; p < end && *p >= '0' && *p <= '9'; p++, digits++){
+                if(mantissa < 100000000000000000ull){
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    exponent--;
+                }
+            }
+        }
+        if(digits == 0){
+            return NULL;
+        }
+        if(p < end && (*p == 'e' || *p == 'E')){
+            const char* q = p + 1;
+            bool negativeExponent = q < end && *q == '-';
+            q += q < end && (*q == '-' || *q == '+') ? 1 : 0;
+            int written = 0;
+            for(; q < end && *q >= '0' && *q <= '9'; q++){
+                written = written < 10000 ? written * 10 + (*q - '0') : written;
+            }
+            if(q > p + 1 && q[-1] >= '0' && q[-1] <= '9'){
+                exponent += negativeExponent ? -written : written;
+                p = q;
+            }
+        }
+        double result = static_cast<double>(mantissa);
+        if(exponent >= 0){
+            result *= exponent <= 22 ? POWERS[exponent] : std::pow(10.0, exponent);
+        }
+        else{
+            result /= -exponent <= 22 ? POWERS[-exponent] : std::pow(10.0, -exponent);
+        }
+        value = static_cast<float>(negative ? -result : result);
+        return p;
+    }
+
+    // count floats from p into out, false when the line has fewer
+    inline bool parseFloats(const char* p, const char* end, float* out, int count){
+        for(int i = 0; i < count; i++){
+            p = parseFloat(skipSpaces(p, end), end, out[i]);
+            if(p == NULL){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // one index of a face corner as written (1 based, negative counts back); 0 when absent
+    inline bool parseRawIndex(const char* &p, const char* end, long &value){
+        value = 0;
+        if(p >= end || *p == '/' || *p == ' ' || *p == '\t' || *p == '\r'){
+            return true;
+        }
+        bool negative = *p == '-';
+        p += negative ? 1 : 0;
+        const char* digits = p;
+        for(; p < end && *p >= '0' && *p <= '9'; p++){
+            value = value < 1000000000L ? value * 10 + (*p - '0') : value;
+        }
+        if(p == digits || value == 0){
+            return false;
+        }
+        value = negative ? -value : value;
+        return true;
+    }
+
+    // one index of a face corner, resolved against count elements read so far; -1 when absent
+    inline bool parseIndex(const char* &p, const char* end, size_t count, int32_t &index){
+        long value;
+        if(!parseRawIndex(p, end, value)){
+            return false;
+        }
+        if(value == 0){
+            index = -1;
+            return true;
+        }
+        long resolved = value > 0 ? value - 1 : static_cast<long>(count) + value;
+        if(resolved < 0 || resolved >= static_cast<long>(count)){
+            return false;
+        }
+        index = static_cast<int32_t>(resolved);
+        return true;
+    }
+
+    // the reference parser, one pass on the calling thread
+    inline bool parseSerial(const char* text, size_t size, MeshContainer::Mesh &mesh, std::vector<std::string> &materials, std::string &error){
+        std::vector<float> positions, texcoords, normals;
+        std::unordered_map<Corner, uint32_t, CornerHash> vertexOf;
+        std::vector<Corner> vertices;
+        std::vector<std::vector<uint32_t>> trianglesOf(1);
+        std::vector<std::string> names(1);
+        size_t material = 0;
+        std::vector<Corner> face;
+
+        const char* end = text + size;
+        uint64_t lineNumber = 0;
+        for(const char* line = text; line < end;){
+            const char* next = lineEnd(line, end);
+            const char* p = skipSpaces(line, next);
+            lineNumber++;
+            float values[3];
+            if(next - p > 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')){
+                if(!parseFloats(p + 2, next, values, 3)){
+                    error = "bad vertex on line " + std::to_string(lineNumber);
+                    return false;
+                }
+                positions.insert(positions.end(), values, values + 3);
+            }
+            else if(next - p > 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t')){
+                if(!parseFloats(p + 3, next, values, 2)){
+                    error = "bad texture coordinate on line " + std::to_string(lineNumber);
+                    return false;
+                }
+                texcoords.insert(texcoords.end(), values, values + 2);
+            }
+            else if(next - p > 3 && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t')){
+                if(!parseFloats(p + 3, next, values, 3)){
+                    error = "bad normal on line " + std::to_string(lineNumber);
+                    return false;
+                }
+                normals.insert(normals.end(), values, values + 3);
+            }
+            else if(next - p > 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')){
+                face.clear();
+                p = skipSpaces(p + 2, next);
+                while(p < next){
+                    Corner corner;
+                    bool ok = parseIndex(p, next, positions.size() / 3, corner.position) && corner.position >= 0;
+                    corner.texcoord = corner.normal = -1;
+                    if(ok && p < next && *p == '/'){
+                        p++;
+                        ok = parseIndex(p, next, texcoords.size() / 2, corner.texcoord);
+                        if(ok && p < next && *p == '/'){
+                            p++;
+                            ok = parseIndex(p, next, normals.size() / 3, corner.normal);
+                        }
+                    }
+                    if(!ok){
+                        error = "bad face on line " + std::to_string(lineNumber);
+                        return false;
+                    }
+                    face.push_back(corner);
+                    p = skipSpaces(p, next);
+                }
+                // faces with fewer than three corners make no triangle, so their corners make no vertex
+                if(face.size() < 3){
+                    face.clear();
+                }
+                uint32_t first = 0, previous = 0;
+                for(size_t i = 0; i < face.size(); i++){
+                    auto inserted = vertexOf.emplace(face[i], static_cast<uint32_t>(vertices.size()));
+                    if(inserted.second){
+                        vertices.push_back(face[i]);
+                    }
+                    uint32_t vertex = inserted.first->second;
+                    if(i == 0){
+                        first = vertex;
+                    }
+                    else if(i >= 2){
+                        trianglesOf[material].push_back(first);
+                        trianglesOf[material].push_back(previous);
+                        trianglesOf[material].push_back(vertex);
+                    }
+                    previous = vertex;
+                }
+            }
+            else if(next - p > 7 && strncmp(p, "usemtl", 6) == 0 && (p[6] == ' ' || p[6] == '\t')){
+                const char* name = skipSpaces(p + 7, next);
+                const char* nameEnd = next;
+                while(nameEnd > name && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r')){
+                    nameEnd--;
+                }
+                std::string materialName(name, nameEnd);
+                material = 0;
+                while(material < names.size() && (material == 0 || names[material] != materialName)){
+                    material++;
+                }
+                if(material == names.size()){
+                    names.push_back(materialName);
+                    trianglesOf.emplace_back();
+                }
+            }
+            line = next + 1;
+        }
+        if(vertices.empty()){
+            error = "no faces";
+            return false;
+        }
+
+        // corners without a normal share it with every face around their position and texcoord
+        std::vector<float> faceNormals(vertices.size() * 3, 0.0f);
+        for(const std::vector<uint32_t> &triangles : trianglesOf){
+            for(size_t i = 0; i + 2 < triangles.size(); i += 3){
+                const float* a = &positions[vertices[triangles[i]].position * 3];
+                const float* b = &positions[vertices[triangles[i + 1]].position * 3];
+                const float* c = &positions[vertices[triangles[i + 2]].position * 3];
+                float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+                float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+                float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+                for(int corner = 0; corner < 3; corner++){
+                    for(int axis = 0; axis < 3; axis++){
+                        faceNormals[triangles[i + corner] * 3 + axis] += n[axis];
+                    }
+                }
+            }
+        }
+
+        mesh = MeshContainer::Mesh();
+        mesh.vertexCount = static_cast<uint32_t>(vertices.size());
+        mesh.attributes = MeshContainer::interleavedLayout();
+        mesh.streams.resize(1);
+        mesh.streams[0].stride = MeshContainer::INTERLEAVED_STRIDE;
+        mesh.streams[0].bytes.resize(static_cast<size_t>(MeshContainer::INTERLEAVED_STRIDE) * vertices.size());
+        float* out = reinterpret_cast<float*>(mesh.streams[0].bytes.data());
+        for(size_t i = 0; i < vertices.size(); i++, out += 8){
+            const Corner &corner = vertices[i];
+            memcpy(out, &positions[corner.position * 3], 3 * sizeof(float));
+            if(corner.normal >= 0){
+                memcpy(out + 3, &normals[corner.normal * 3], 3 * sizeof(float));
+            }
+            else{
+                const float* n = &faceNormals[i * 3];
+                float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for(int axis = 0; axis < 3; axis++){
+                    out[3 + axis] = length > 0.0f ? n[axis] / length : (axis == 1 ? 1.0f : 0.0f);
+                }
+            }
+            out[6] = corner.texcoord >= 0 ? texcoords[corner.texcoord * 2] : 0.0f;
+            out[7] = corner.texcoord >= 0 ? texcoords[corner.texcoord * 2 + 1] : 0.0f;
+        }
+
+        MeshContainer::Lod lod = {};
+        materials.clear();
+        for(size_t i = 0; i < trianglesOf.size(); i++){
+            if(trianglesOf[i].empty()){
+                continue;
+            }
+            MeshContainer::Submesh submesh = {};
+            submesh.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+            submesh.indexCount = static_cast<uint32_t>(trianglesOf[i].size());
+            submesh.material = static_cast<uint32_t>(materials.size());
+            materials.push_back(names[i]);
+            mesh.indices.insert(mesh.indices.end(), trianglesOf[i].begin(), trianglesOf[i].end());
+            MeshContainer::indexBounds(mesh, submesh.firstIndex, submesh.indexCount, submesh.boundsMin, submesh.boundsMax);
+            mesh.submeshes.push_back(submesh);
+            lod.submeshCount++;
+        }
+        if(lod.submeshCount == 0){
+            error = "no triangles";
+            return false;
+        }
+        mesh.lods.push_back(lod);
+        return true;
+    }
+
+    // a face corner as a chunk reads it: positive indices are already absolute, negative ones
+    // (bit k of relative set) count back from the chunk's own elements until its bases are known
+    struct PendingCorner {
+        int32_t index[3];               // position, texcoord, normal; -1 when missing
+        uint32_t relative;
+    };
+
+    // one line aligned piece of the file and what was read from it
+    struct Chunk {
+        const char* begin = NULL;
+        const char* end = NULL;
+        std::vector<float> positions, texcoords, normals;
+        std::vector<PendingCorner> corners;                         // three per triangle
+        std::vector<std::pair<size_t, std::string>> materials;      // usemtl, from this triangle on
+        bool failed = false;
+    };
+
+    // chunks smaller than this aren't worth a job
+    const size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+    inline void parseChunk(Chunk &chunk){
+        std::vector<PendingCorner> face;
+        for(const char* line = chunk.begin; line < chunk.end;){
+            const char* next = lineEnd(line, chunk.end);
+            const char* p = skipSpaces(line, next);
+            float values[3];
+            if(next - p > 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')){
+                if(!parseFloats(p + 2, next, values, 3)){
+                    chunk.failed = true;
+                    return;
+                }
+                chunk.positions.insert(chunk.positions.end(), values, values + 3);
+            }
+            else if(next - p > 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t')){
+                if(!parseFloats(p + 3, next, values, 2)){
+                    chunk.failed = true;
+                    return;
+                }
+                chunk.texcoords.insert(chunk.texcoords.end(), values, values + 2);
+            }
+            else if(next - p > 3 && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t')){
+                if(!parseFloats(p + 3, next, values, 3)){
+                    chunk.failed = true;
+                    return;
+                }
+                chunk.normals.insert(chunk.normals.end(), values, values + 3);
+            }
+            else if(next - p > 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')){
+                face.clear();
+                const int64_t counts[3] = { static_cast<int64_t>(chunk.positions.size() / 3), static_cast<int64_t>(chunk.texcoords.size() / 2), static_cast<int64_t>(chunk.normals.size() / 3) };
+                p = skipSpaces(p + 2, next);
+                while(p < next){
+                    PendingCorner corner = { { -1, -1, -1 }, 0 };
+                    for(int k = 0; k < 3; k++){
+                        long value;
+                        if(!parseRawIndex(p, next, value) || (k == 0 && value == 0)){
+                            chunk.failed = true;
+                            return;
+                        }
+                        if(value > 0){
+                            corner.index[k] = static_cast<int32_t>(value - 1);
+                        }
+                        else if(value < 0){
+                            corner.index[k] = static_cast<int32_t>(counts[k] + value);
+                            corner.relative |= 1u << k;
+                        }
+                        if(k == 2 || p >= next || *p != '/'){
+                            break;
+                        }
+                        p++;
+                    }
+                    face.push_back(corner);
+                    p = skipSpaces(p, next);
+                }
+                for(size_t i = 2; i < face.size(); i++){
+                    chunk.corners.push_back(face[0]);
+                    chunk.corners.push_back(face[i - 1]);
+                    chunk.corners.push_back(face[i]);
+                }
+            }
+            else if(next - p > 7 && strncmp(p, "usemtl", 6) == 0 && (p[6] == ' ' || p[6] == '\t')){
+                const char* name = skipSpaces(p + 7, next);
+                const char* nameEnd = next;
+                while(nameEnd > name && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r')){
+                    nameEnd--;
+                }
+                chunk.materials.emplace_back(chunk.corners.size() / 3, std::string(name, nameEnd));
+            }
+            line = next + 1;
+        }
+    }
+
+    // Open addressing set of corners, filled from many threads at once. A slot holds the
+    // ordinal of the earliest corner with its key: inserting claims an empty slot with a
+    // compare and swap, and finding an equal corner lowers the slot to the smaller ordinal, so
+    // once every corner is in, table.at(slot) == ordinal says a corner is the first of its key
+    // no matter which thread got there first. Keys live in the corner array, not the table.
+    class CornerTable {
+        public:
+            static const uint32_t EMPTY = 0xFFFFFFFFu;
+
+            CornerTable(const std::vector<Corner> &corners) : corners(corners){
+                uint64_t capacity = 1;
+                while(capacity < corners.size() * 2){
+                    capacity *= 2;
+                }
+                this->mask = static_cast<uint32_t>(capacity - 1);
+                this->slots.reset(new std::atomic<uint32_t>[capacity]);
+                std::atomic<uint32_t>* slots = this->slots.get();
+                parallelFor(static_cast<size_t>(capacity), [slots](size_t begin, size_t end){
+                    for(size_t i = begin; i < end; i++){
+                        slots[i].store(EMPTY, std::memory_order_relaxed);
+                    }
+                }, 64 * 1024);
+            }
+
+            // the slot the corner's key lives in
+            uint32_t insert(uint32_t ordinal){
+                const Corner &corner = this->corners[ordinal];
+                uint64_t hash = CornerHash()(corner);
+                for(uint32_t slot = static_cast<uint32_t>(hash ^ (hash >> 32)) & this->mask;; slot = (slot + 1) & this->mask){
+                    uint32_t held = this->slots[slot].load(std::memory_order_acquire);
+                    if(held == EMPTY && this->slots[slot].compare_exchange_strong(held, ordinal, std::memory_order_acq_rel)){
+                        return slot;
+                    }
+                    // held is the corner that took the slot, ours or another key's
+                    if(this->corners[held] == corner){
+                        while(ordinal < held && !this->slots[slot].compare_exchange_weak(held, ordinal, std::memory_order_acq_rel)){}
+                        return slot;
+                    }
+                }
+            }
+
+            uint32_t at(uint32_t slot) const{
+                return this->slots[slot].load(std::memory_order_relaxed);
+            }
+
+            void set(uint32_t slot, uint32_t value){
+                this->slots[slot].store(value, std::memory_order_relaxed);
+            }
+
+        private:
+            const std::vector<Corner> &corners;
+            std::unique_ptr<std::atomic<uint32_t>[]> slots;
+            uint32_t mask = 0;
+    };
+
+    // Same result as parseSerial, except that faces may refer to elements defined further down.
+    // Malformed files are handed to parseSerial, which finds the line to report.
+    inline bool parseParallel(const char* text, size_t size, MeshContainer::Mesh &mesh, std::vector<std::string> &materials, std::string &error){
+        size_t chunkCount = std::min<size_t>((JobSystem::instance().workerCount() + 1) * 4, size / MIN_CHUNK_BYTES);
+        if(chunkCount <= 1){
+            return parseSerial(text, size, mesh, materials, error);
+        }
+        const char* end = text + size;
+        std::vector<Chunk> chunks(chunkCount);
+        const char* begin = text;
+        for(size_t i = 0; i < chunkCount; i++){
+            const char* split = end;
+            if(i + 1 < chunkCount){
+                split = lineEnd(std::max(begin, text + size / chunkCount * (i + 1)), end);
+                split = split < end ? split + 1 : end;
+            }
+            chunks[i].begin = begin;
+            chunks[i].end = split;
+            begin = split;
+        }
+        parallelFor(chunkCount, [&](size_t first, size_t last){
+            for(size_t i = first; i < last; i++){
+                parseChunk(chunks[i]);
+            }
+        });
+
+        // where each chunk's elements and triangles start in the whole file
+        std::vector<int64_t> bases(chunkCount * 3);
+        std::vector<size_t> triangleBases(chunkCount + 1, 0);
+        int64_t totals[3] = { 0, 0, 0 };
+        for(size_t i = 0; i < chunkCount; i++){
+            if(chunks[i].failed){
+                return parseSerial(text, size, mesh, materials, error);
+            }
+            const int64_t counts[3] = { static_cast<int64_t>(chunks[i].positions.size() / 3), static_cast<int64_t>(chunks[i].texcoords.size() / 2), static_cast<int64_t>(chunks[i].normals.size() / 3) };
+            for(int k = 0; k < 3; k++){
+                bases[i * 3 + k] = totals[k];
+                totals[k] += counts[k];
+            }
+            triangleBases[i + 1] = triangleBases[i] + chunks[i].corners.size() / 3;
+        }
+        size_t triangleCount = triangleBases[chunkCount];
+        // ordinals and table slots (with a flag bit) have to fit in 32 bits
+        if(triangleCount == 0 || triangleCount * 3 > 0x40000000u || totals[0] > 0x7FFFFFFF || totals[1] > 0x7FFFFFFF || totals[2] > 0x7FFFFFFF){
+            return parseSerial(text, size, mesh, materials, error);
+        }
+
+        // elements into one array each and corners resolved to absolute indices, the chunks'
+        // copies are released as they go
+        std::vector<float> positions(static_cast<size_t>(totals[0]) * 3), texcoords(static_cast<size_t>(totals[1]) * 2), normals(static_cast<size_t>(totals[2]) * 3);
+        std::vector<Corner> corners(triangleCount * 3);
+        std::atomic<bool> outOfRange(false);
+        parallelFor(chunkCount, [&](size_t first, size_t last){
+            for(size_t i = first; i < last; i++){
+                Chunk &chunk = chunks[i];
+                std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + bases[i * 3] * 3);
+                std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + bases[i * 3 + 1] * 2);
+                std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + bases[i * 3 + 2] * 3);
+                std::vector<float>().swap(chunk.positions);
+                std::vector<float>().swap(chunk.texcoords);
+                std::vector<float>().swap(chunk.normals);
+                Corner* out = &corners[triangleBases[i] * 3];
+                for(const PendingCorner &pending : chunk.corners){
+                    int32_t* index = &out->position;
+                    for(int k = 0; k < 3; k++){
+                        int64_t value = pending.index[k];
+                        if((pending.relative >> k) & 1u){
+                            value += bases[i * 3 + k];
+                        }
+                        else if(value < 0 && k > 0){
+                            index[k] = -1;
+                            continue;
+                        }
+                        if(value < 0 || value >= totals[k]){
+                            outOfRange.store(true, std::memory_order_relaxed);
+                            value = 0;
+                        }
+                        index[k] = static_cast<int32_t>(value);
+                    }
+                    out++;
+                }
+                std::vector<PendingCorner>().swap(chunk.corners);
+            }
+        });
+        if(outOfRange.load()){
+            return parseSerial(text, size, mesh, materials, error);
+        }
+
+        // usemtl switches as runs of triangles, materials numbered in order of first use
+        struct Run {
+            size_t firstTriangle;
+            uint32_t material;
+            size_t output;              // where its triangles go in the material sorted indices
+        };
+        std::vector<std::string> names(1);
+        std::vector<Run> runs(1, Run{ 0, 0, 0 });
+        for(size_t i = 0; i < chunkCount; i++){
+            for(const std::pair<size_t, std::string> &use : chunks[i].materials){
+                uint32_t material = 1;
+                while(material < names.size() && names[material] != use.second){
+                    material++;
+                }
+                if(material == names.size()){
+                    names.push_back(use.second);
+                }
+                size_t firstTriangle = triangleBases[i] + use.first;
+                if(runs.back().firstTriangle == firstTriangle){
+                    runs.back().material = material;
+                }
+                else if(runs.back().material != material){
+                    runs.push_back(Run{ firstTriangle, material, 0 });
+                }
+            }
+        }
+        std::vector<size_t> materialTriangles(names.size(), 0);
+        for(size_t r = 0; r < runs.size(); r++){
+            size_t runEnd = r + 1 < runs.size() ? runs[r + 1].firstTriangle : triangleCount;
+            materialTriangles[runs[r].material] += runEnd - runs[r].firstTriangle;
+        }
+        std::vector<size_t> cursor(names.size(), 0);
+        for(size_t m = 1; m < names.size(); m++){
+            cursor[m] = cursor[m - 1] + materialTriangles[m - 1];
+        }
+        std::vector<size_t> materialStart = cursor;
+        for(size_t r = 0; r < runs.size(); r++){
+            size_t runEnd = r + 1 < runs.size() ? runs[r + 1].firstTriangle : triangleCount;
+            runs[r].output = cursor[runs[r].material];
+            cursor[runs[r].material] += runEnd - runs[r].firstTriangle;
+        }
+        chunks.clear();
+
+        // every corner into the table, then the first corner of each key counted per block,
+        // numbered and written out as a vertex
+        const uint32_t FIRST = 0x80000000u;
+        size_t cornerCount = corners.size();
+        CornerTable table(corners);
+        std::vector<uint32_t> slotOf(cornerCount);
+        parallelFor(cornerCount, [&](size_t first, size_t last){
+            for(size_t o = first; o < last; o++){
+                slotOf[o] = table.insert(static_cast<uint32_t>(o));
+            }
+        }, 16 * 1024);
+
+        size_t blockCount = std::min<size_t>((JobSystem::instance().workerCount() + 1) * 8, cornerCount);
+        size_t blockSize = (cornerCount + blockCount - 1) / blockCount;
+        std::vector<uint32_t> blockVertices(blockCount + 1, 0);
+        parallelFor(blockCount, [&](size_t first, size_t last){
+            for(size_t b = first; b < last; b++){
+                uint32_t count = 0;
+                for(size_t o = b * blockSize; o < std::min(cornerCount, (b + 1) * blockSize); o++){
+                    if(table.at(slotOf[o]) == o){
+                        slotOf[o] |= FIRST;
+                        count++;
+                    }
+                }
+                blockVertices[b + 1] = count;
+            }
+        });
+        for(size_t b = 0; b < blockCount; b++){
+            blockVertices[b + 1] += blockVertices[b];
+        }
+        uint32_t vertexCount = blockVertices[blockCount];
+
+        mesh = MeshContainer::Mesh();
+        mesh.vertexCount = vertexCount;
+        mesh.attributes = MeshContainer::interleavedLayout();
+        mesh.streams.resize(1);
+        mesh.streams[0].stride = MeshContainer::INTERLEAVED_STRIDE;
+        mesh.streams[0].bytes.resize(static_cast<size_t>(MeshContainer::INTERLEAVED_STRIDE) * vertexCount);
+        float* vertices = reinterpret_cast<float*>(mesh.streams[0].bytes.data());
+        std::vector<uint8_t> generated(vertexCount, 0);
+        std::atomic<bool> needsNormals(false);
+        parallelFor(blockCount, [&](size_t first, size_t last){
+            for(size_t b = first; b < last; b++){
+                uint32_t id = blockVertices[b];
+                for(size_t o = b * blockSize; o < std::min(cornerCount, (b + 1) * blockSize); o++){
+                    if((slotOf[o] & FIRST) == 0){
+                        continue;
+                    }
+                    const Corner &corner = corners[o];
+                    float* out = vertices + static_cast<size_t>(id) * 8;
+                    memcpy(out, &positions[static_cast<size_t>(corner.position) * 3], 3 * sizeof(float));
+                    if(corner.normal >= 0){
+                        memcpy(out + 3, &normals[static_cast<size_t>(corner.normal) * 3], 3 * sizeof(float));
+                    }
+                    else{
+                        generated[id] = 1;
+                        needsNormals.store(true, std::memory_order_relaxed);
+                    }
+                    out[6] = corner.texcoord >= 0 ? texcoords[static_cast<size_t>(corner.texcoord) * 2] : 0.0f;
+                    out[7] = corner.texcoord >= 0 ? texcoords[static_cast<size_t>(corner.texcoord) * 2 + 1] : 0.0f;
+                    table.set(slotOf[o] & ~FIRST, id++);
+                }
+            }
+        });
+
+        // the table now maps each key to its vertex; indices go out grouped by material
+        mesh.indices.resize(cornerCount);
+        parallelFor(triangleCount, [&](size_t first, size_t last){
+            size_t r = static_cast<size_t>(std::upper_bound(runs.begin(), runs.end(), first, [](size_t triangle, const Run &run){ return triangle < run.firstTriangle; }) - runs.begin()) - 1;
+            for(size_t t = first; t < last; t++){
+                while(r + 1 < runs.size() && runs[r + 1].firstTriangle <= t){
+                    r++;
+                }
+                uint32_t* out = &mesh.indices[(runs[r].output + t - runs[r].firstTriangle) * 3];
+                for(int k = 0; k < 3; k++){
+                    out[k] = table.at(slotOf[t * 3 + k] & ~FIRST);
+                }
+            }
+        }, 16 * 1024);
+        std::vector<uint32_t>().swap(slotOf);
+        std::vector<Corner>().swap(corners);
+
+        // the same accumulation order as parseSerial, so generated normals match bit for bit
+        if(needsNormals.load()){
+            std::vector<float> faceNormals(static_cast<size_t>(vertexCount) * 3, 0.0f);
+            for(size_t i = 0; i + 2 < mesh.indices.size(); i += 3){
+                const float* a = vertices + static_cast<size_t>(mesh.indices[i]) * 8;
+                const float* b = vertices + static_cast<size_t>(mesh.indices[i + 1]) * 8;
+                const float* c = vertices + static_cast<size_t>(mesh.indices[i + 2]) * 8;
+                float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+                float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+                float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+                for(int corner = 0; corner < 3; corner++){
+                    for(int axis = 0; axis < 3; axis++){
+                        faceNormals[mesh.indices[i + corner] * 3 + axis] += n[axis];
+                    }
+                }
+            }
+            for(uint32_t i = 0; i < vertexCount; i++){
+                if(!generated[i]){
+                    continue;
+                }
+                const float* n = &faceNormals[static_cast<size_t>(i) * 3];
+                float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for(int axis = 0; axis < 3; axis++){
+                    vertices[static_cast<size_t>(i) * 8 + 3 + axis] = length > 0.0f ? n[axis] / length : (axis == 1 ? 1.0f : 0.0f);
+                }
+            }
+        }
+
+        MeshContainer::Lod lod = {};
+        materials.clear();
+        for(size_t m = 0; m < names.size(); m++){
+            if(materialTriangles[m] == 0){
+                continue;
+            }
+            MeshContainer::Submesh submesh = {};
+            submesh.firstIndex = static_cast<uint32_t>(materialStart[m] * 3);
+            submesh.indexCount = static_cast<uint32_t>(materialTriangles[m] * 3);
+            submesh.material = static_cast<uint32_t>(materials.size());
+            materials.push_back(names[m]);
+            MeshContainer::indexBounds(mesh, submesh.firstIndex, submesh.indexCount, submesh.boundsMin, submesh.boundsMax);
+            mesh.submeshes.push_back(submesh);
+            lod.submeshCount++;
+        }
+        mesh.lods.push_back(lod);
+        return true;
+    }
+
+    inline bool parse(const char* text, size_t size, MeshContainer::Mesh &mesh, std::vector<std::string> &materials, std::string &error, bool parallel = true){
+        if(parallel){
+            return parseParallel(text, size, mesh, materials, error);
+        }
+        return parseSerial(text, size, mesh, materials, error);
+    }
+
+    // materials gets the usemtl names of the submeshes, "" for faces before any usemtl
+    inline bool load(const std::string &path, MeshContainer::Mesh &mesh, std::vector<std::string> &materials, std::string &error, bool parallel = true){
+        MappedFile file;
+        if(!file.open(path)){
+            error = "can't open " + path;
+            return false;
+        }
+        file.willNeed();
+        if(!parse(reinterpret_cast<const char*>(file.data()), file.size(), mesh, materials, error, parallel)){
+            error = path + ": " + error;
+            return false;
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Frame time statistics for comparing runs.
+//
+// Every frame the caller adds the CPU frame interval (tick() measures it on the steady
+// clock) and, whenever the GPU timer has a result, a GPU frame time. Percentiles are
+// available over the rolling window of the last windowSize frames (for on-screen readouts)
+// and over the whole run (for the report). Every sample of the run is kept, 4 bytes per
+// frame per series, so the report percentiles are exact rather than read off the histogram.
+//
+// Hitches are counted twice: against fixed thresholds (a frame over 33.3 ms missed two 60 Hz
+// vsyncs whatever the average is) and against the rolling median (stutterFactor times the
+// median of the frames before it), which catches spikes in runs that are fast overall.
+
+class FrameStats {
+    public:
+        struct Summary {
+            uint64_t frames = 0;
+            double mean = 0.0;
+            double p50 = 0.0;
+            double p95 = 0.0;
+            double p99 = 0.0;
+            double max = 0.0;
+        };
+
+        struct Config {
+            size_t windowSize = 240;
+            std::vector<double> hitchThresholds = { 16.7, 33.3, 50.0, 100.0 };   // milliseconds
+            double stutterFactor = 2.0;
+            double histogramMin = 0.25;         // first bucket edge in milliseconds
+            uint32_t bucketsPerOctave = 4;
+            uint32_t octaves = 12;              // up to histogramMin * 2^octaves (~1 s)
+        };
+
+        typedef std::chrono::steady_clock Clock;
+
+        FrameStats() : FrameStats(Config()){}
+
+        explicit FrameStats(const Config &config) : config(config){
+            hitches.assign(config.hitchThresholds.size(), 0);
+            histogram.assign(config.bucketsPerOctave * config.octaves + 2, 0);
+        }
+
+        // seconds since the previous tick (0 on the first call), recorded as a CPU frame
+        double tick(){
+            Clock::time_point now = Clock::now();
+            double seconds = started ? std::chrono::duration<double>(now - last).count() : 0.0;
+            if(started){
+                addFrame(seconds * 1000.0);
+            }
+            else{
+                start = now;
+            }
+            started = true;
+            last = now;
+            return seconds;
+        }
+
+        void addFrame(double milliseconds){
+            if(cpu.size() >= 8){
+                std::vector<float> window = recent(cpu, config.windowSize);
+                std::nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+                if(milliseconds > config.stutterFactor * window[window.size() / 2]){
+                    stutters++;
+                }
+            }
+            cpu.push_back(static_cast<float>(milliseconds));
+            histogram[bucket(milliseconds)]++;
+            for(size_t i = 0; i < config.hitchThresholds.size(); i++){
+                hitches[i] += milliseconds > config.hitchThresholds[i] ? 1 : 0;
+            }
+        }
+
+        // drops every sample, e.g. after warm up frames; the next tick starts a new interval
+        void reset(){
+            cpu.clear();
+            gpu.clear();
+            std::fill(histogram.begin(), histogram.end(), 0);
+            std::fill(hitches.begin(), hitches.end(), 0);
+            stutters = 0;
+            started = false;
+        }
+
+        void addGpuFrame(double milliseconds){
+            gpu.push_back(static_cast<float>(milliseconds));
+        }
+
+        Summary cpuWindow() const{
+            return summarize(recent(cpu, config.windowSize));
+        }
+
+        Summary gpuWindow() const{
+            return summarize(recent(gpu, config.windowSize));
+        }
+
+        Summary cpuRun() const{
+            return summarize(cpu);
+        }
+
+        Summary gpuRun() const{
+            return summarize(gpu);
+        }
+
+        uint64_t hitchCount(size_t threshold) const{
+            return hitches[threshold];
+        }
+
+        uint64_t stutterCount() const{
+            return stutters;
+        }
+
+        const Config& settings() const{
+            return config;
+        }
+
+        // upper edge in milliseconds of a histogram bucket, the last bucket is unbounded
+        double bucketUpper(size_t index) const{
+            if(index + 1 >= histogram.size()){
+                return INFINITY;
+            }
+            return config.histogramMin * std::pow(2.0, static_cast<double>(index) / config.bucketsPerOctave);
+        }
+
+        const std::vector<uint64_t>& histogramCounts() const{
+            return histogram;
+        }
+
+        double elapsedSeconds() const{
+            return started ? std::chrono::duration<double>(last - start).count() : 0.0;
+        }
+
+        // one row per frame: frame, cpu_ms, gpu_ms (GPU results lag a few frames, so the
+        // column is the n-th GPU result rather than the GPU time of the same frame)
+        bool writeCsv(const std::string &path) const{
+            FILE* file = fopen(path.c_str(), "w");
+            if(file == NULL){
+                return false;
+            }
+            fprintf(file, "frame,cpu_ms,gpu_ms\n");
+            for(size_t i = 0; i < std::max(cpu.size(), gpu.size()); i++){
+                fprintf(file, "%zu,", i);
+                if(i < cpu.size()){
+                    fprintf(file, "%.4f", cpu[i]);
+                }
+                fprintf(file, ",");
+                if(i < gpu.size()){
+                    fprintf(file, "%.4f", gpu[i]);
+                }
+                fprintf(file, "\n");
+            }
+            return fclose(file) == 0;
+        }
+
+        bool writeJson(const std::string &path) const{
+            FILE* file = fopen(path.c_str(), "w");
+            if(file == NULL){
+                return false;
+            }
+            fprintf(file, "{\n  \"seconds\": %.3f,\n", elapsedSeconds());
+            writeSummary(file, "cpu", cpuRun());
+            writeSummary(file, "gpu", gpuRun());
+            fprintf(file, "  \"stutters\": %llu,\n  \"stutter_factor\": %.2f,\n", static_cast<unsigned long long>(stutters), config.stutterFactor);
+            fprintf(file, "  \"hitches\": [");
+            for(size_t i = 0; i < hitches.size(); i++){
+                fprintf(file, "%s{\"over_ms\": %.2f, \"frames\": %llu}", i == 0 ? "" : ", ", config.hitchThresholds[i], static_cast<unsigned long long>(hitches[i]));
+            }
+            fprintf(file, "],\n  \"histogram\": [");
+            bool first = true;
+            for(size_t i = 0; i < histogram.size(); i++){
+                if(histogram[i] == 0){
+                    continue;
+                }
+                double upper = bucketUpper(i);
+                if(std::isinf(upper)){
+                    fprintf(file, "%s{\"upper_ms\": null, \"frames\": %llu}", first ? "" : ", ", static_cast<unsigned long long>(histogram[i]));
+                }
+                else{
+                    fprintf(file, "%s{\"upper_ms\": %.4f, \"frames\": %llu}", first ? "" : ", ", upper, static_cast<unsigned long long>(histogram[i]));
+                }
+                first = false;
+            }
+            fprintf(file, "]\n}\n");
+            return fclose(file) == 0;
+        }
+
+        static Summary summarize(std::vector<float> samples){
+            Summary summary;
+            summary.frames = samples.size();
+            if(samples.empty()){
+                return summary;
+            }
+            double total = 0.0;
+            for(float sample : samples){
+                total += sample;
+            }
+            summary.mean = total / samples.size();
+            std::sort(samples.begin(), samples.end());
+            summary.p50 = percentile(samples, 0.50);
+            summary.p95 = percentile(samples, 0.95);
+            summary.p99 = percentile(samples, 0.99);
+            summary.max = samples.back();
+            return summary;
+        }
+
+        // "name": {...}, line for JSON reports
+        static void writeSummary(FILE* file, const char* name, const Summary &summary){
+            fprintf(file, "  \"%s\": {\"frames\": %llu, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f},\n",
+                name, static_cast<unsigned long long>(summary.frames), summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+        }
+
+    private:
+        Config config;
+        std::vector<float> cpu;
+        std::vector<float> gpu;
+        std::vector<uint64_t> histogram;     // bucket 0 is under histogramMin, the last is everything above the range
+        std::vector<uint64_t> hitches;
+        uint64_t stutters = 0;
+        Clock::time_point start;
+        Clock::time_point last;
+        bool started = false;
+
+        // nearest rank on sorted samples
+        static double percentile(const std::vector<float> &sorted, double fraction){
+            size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+            return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+        }
+
+        static std::vector<float> recent(const std::vector<float> &samples, size_t count){
+            return std::vector<float>(samples.end() - std::min(count, samples.size()), samples.end());
+        }
+
+        size_t bucket(double milliseconds) const{
+            if(milliseconds < config.histogramMin){
+                return 0;
+            }
+            double index = std::floor(std::log2(milliseconds / config.histogramMin) * config.bucketsPerOctave) + 1.0;
+            return static_cast<size_t>(std::min(index, static_cast<double>(histogram.size() - 1)));
+        }
+
+};
+
+#endif
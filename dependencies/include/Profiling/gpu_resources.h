@@ -0,0 +1,573 @@
+#ifndef GPU_RESOURCES_H
+#define GPU_RESOURCES_H
+
+#include <glad/glad.h>
+#include <GLExt/gl_ext.h>
+#include <GLExt/gl_hooks.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Registry of every GL object the process creates, for memory budgets and leak checks.
+//
+// install() hooks the glGen* / glCreate* / glDelete* entry points and the calls that
+// allocate storage (glBufferData, glTex(Image|Storage), glRenderbufferStorage, ...), so
+// objects are recorded no matter who creates them. Sizes are estimates from the internal
+// format and dimensions, drivers add padding, alignment and mip tails of their own. RGB8
+// style formats are counted as 4 bytes per texel since that's how drivers store them.
+// Programs, shaders, VAOs, framebuffers and queries are counted but have no size.
+//
+// Where an object was created is taken from the innermost GPU_RESOURCE_SITE() scope on the
+// calling thread, and label() names it both here and in GL (glObjectLabel, when the driver
+// has KHR_debug) so captures in RenderDoc or Nsight show the same names.
+//
+//   GPU_RESOURCE_SITE();
+//   glGenBuffers(1, &vbo);
+//   GpuResources::label(GpuResources::BUFFER, vbo, "cube vertices");
+//
+// breakdown() is the live total per category; leakReport() lists whatever is still alive
+// (call it after releasing everything at shutdown). Deleting a name that isn't a live object
+// of that kind (e.g. glDeleteBuffers on a vertex array) is reported as well.
+
+namespace GpuResources {
+
+    enum Kind {
+        BUFFER,
+        TEXTURE,
+        RENDERBUFFER,
+        FRAMEBUFFER,
+        VERTEX_ARRAY,
+        PROGRAM,
+        SHADER,
+        QUERY,
+        SAMPLER,
+        KIND_COUNT
+    };
+
+    inline const char* kindName(Kind kind){
+        static const char* names[KIND_COUNT] = { "buffer", "texture", "renderbuffer", "framebuffer", "vertex array", "program", "shader", "query", "sampler" };
+        return names[kind];
+    }
+
+    // namespace glObjectLabel expects for each kind
+    inline GLenum labelIdentifier(Kind kind){
+        static const GLenum identifiers[KIND_COUNT] = { GL_BUFFER, GL_TEXTURE, GL_RENDERBUFFER, GL_FRAMEBUFFER, GL_VERTEX_ARRAY, GL_PROGRAM, GL_SHADER, GL_QUERY, GL_SAMPLER };
+        return identifiers[kind];
+    }
+
+    struct Site {
+        const char* file = NULL;
+        int line = 0;
+        const char* function = NULL;
+    };
+
+    struct Resource {
+        Kind kind = BUFFER;
+        GLuint name = 0;
+        size_t bytes = 0;
+        std::string label;
+        Site site;
+        uint64_t createdFrame = 0;
+        double createdSeconds = 0.0;
+        std::map<uint32_t, size_t> images;      // texture storage per (level, face), summed into bytes
+    };
+
+    struct KindStats {
+        uint64_t live = 0;
+        uint64_t created = 0;
+        uint64_t destroyed = 0;
+        uint64_t transient = 0;             // destroyed within a frame of being created
+        uint64_t lifetimeFrames = 0;        // summed over destroyed objects
+        size_t bytes = 0;
+        size_t peakBytes = 0;
+    };
+
+    struct State {
+        bool installed = false;
+        std::unordered_map<uint64_t, Resource> live;
+        KindStats kinds[KIND_COUNT];
+        size_t peakBytes = 0;
+        uint64_t frame = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::string> problems;
+    };
+
+    inline State& state(){
+        static State instance;
+        return instance;
+    }
+
+    inline Site& currentSite(){
+        thread_local Site site;
+        return site;
+    }
+
+    // objects created while this is alive are attributed to file:line
+    class SiteScope {
+        public:
+            SiteScope(const char* file, int line, const char* function) : previous(currentSite()){
+                currentSite().file = file;
+                currentSite().line = line;
+                currentSite().function = function;
+            }
+
+            ~SiteScope(){
+                currentSite() = previous;
+            }
+
+            SiteScope(const SiteScope&) = delete;
+            SiteScope& operator=(const SiteScope&) = delete;
+
+        private:
+            Site previous;
+    };
+
+    inline uint64_t key(Kind kind, GLuint name){
+        return (static_cast<uint64_t>(kind) << 32) | name;
+    }
+
+    inline Resource* find(Kind kind, GLuint name){
+        std::unordered_map<uint64_t, Resource>::iterator it = state().live.find(key(kind, name));
+        return it != state().live.end() ? &it->second : NULL;
+    }
+
+    inline size_t totalBytes(){
+        size_t total = 0;
+        for(const KindStats &stats : state().kinds){
+            total += stats.bytes;
+        }
+        return total;
+    }
+
+    inline void setBytes(Resource &resource, size_t bytes){
+        State &s = state();
+        KindStats &stats = s.kinds[resource.kind];
+        stats.bytes = stats.bytes - resource.bytes + bytes;
+        stats.peakBytes = std::max(stats.peakBytes, stats.bytes);
+        resource.bytes = bytes;
+        s.peakBytes = std::max(s.peakBytes, totalBytes());
+    }
+
+    inline void problem(const std::string &text){
+        std::vector<std::string> &problems = state().problems;
+        if(problems.size() < 64){
+            problems.push_back(text);
+        }
+    }
+
+    inline void create(Kind kind, GLuint name){
+        if(name == 0){
+            return;
+        }
+        State &s = state();
+        Resource resource;
+        resource.kind = kind;
+        resource.name = name;
+        resource.site = currentSite();
+        resource.createdFrame = s.frame;
+        resource.createdSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - s.start).count();
+        s.live[key(kind, name)] = resource;
+        s.kinds[kind].live++;
+        s.kinds[kind].created++;
+    }
+
+    inline void destroy(Kind kind, GLuint name, const char* call){
+        if(name == 0){
+            return;
+        }
+        State &s = state();
+        Resource* resource = find(kind, name);
+        if(resource == NULL){
+            std::string text = std::string(call) + "(" + std::to_string(name) + ") on a name that is no live " + kindName(kind);
+            for(int other = 0; other < KIND_COUNT; other++){
+                if(find(static_cast<Kind>(other), name) != NULL){
+                    text += ", but a live " + std::string(kindName(static_cast<Kind>(other))) + " has that name";
+                }
+            }
+            problem(text);
+            return;
+        }
+        KindStats &stats = s.kinds[kind];
+        setBytes(*resource, 0);
+        stats.live--;
+        stats.destroyed++;
+        stats.lifetimeFrames += s.frame - resource->createdFrame;
+        stats.transient += s.frame - resource->createdFrame <= 1 ? 1 : 0;
+        s.live.erase(key(kind, name));
+    }
+
+    // names the object here and, when the driver supports it, in GL debug tools
+    inline void label(Kind kind, GLuint name, const std::string &text){
+        Resource* resource = find(kind, name);
+        if(resource != NULL){
+            resource->label = text;
+        }
+        if(GLExt::ObjectLabel != NULL && name != 0){
+            GLExt::ObjectLabel(labelIdentifier(kind), name, -1, text.c_str());
+        }
+    }
+
+    inline void endFrame(){
+        state().frame++;
+    }
+
+    #pragma region Sizes
+    inline GLuint boundName(GLenum binding){
+        GLint name = 0;
+        GLHooks::Hook<&glad_glGetIntegerv>::real()(binding, &name);
+        return static_cast<GLuint>(name);
+    }
+
+    inline GLuint boundBuffer(GLenum target){
+        switch(target){
+            case GL_ARRAY_BUFFER: return boundName(GL_ARRAY_BUFFER_BINDING);
+            case GL_ELEMENT_ARRAY_BUFFER: return boundName(GL_ELEMENT_ARRAY_BUFFER_BINDING);
+            case GL_UNIFORM_BUFFER: return boundName(GL_UNIFORM_BUFFER_BINDING);
+            case GL_PIXEL_PACK_BUFFER: return boundName(GL_PIXEL_PACK_BUFFER_BINDING);
+            case GL_PIXEL_UNPACK_BUFFER: return boundName(GL_PIXEL_UNPACK_BUFFER_BINDING);
+            case GL_TRANSFORM_FEEDBACK_BUFFER: return boundName(GL_TRANSFORM_FEEDBACK_BUFFER_BINDING);
+            // these targets double as their own binding query
+            case GL_COPY_READ_BUFFER: case GL_COPY_WRITE_BUFFER: case GL_TEXTURE_BUFFER: return boundName(target);
+            default: return 0;
+        }
+    }
+
+    inline GLuint boundTexture(GLenum target){
+        switch(target){
+            case GL_TEXTURE_1D: return boundName(GL_TEXTURE_BINDING_1D);
+            case GL_TEXTURE_2D: return boundName(GL_TEXTURE_BINDING_2D);
+            case GL_TEXTURE_3D: return boundName(GL_TEXTURE_BINDING_3D);
+            case GL_TEXTURE_1D_ARRAY: return boundName(GL_TEXTURE_BINDING_1D_ARRAY);
+            case GL_TEXTURE_2D_ARRAY: return boundName(GL_TEXTURE_BINDING_2D_ARRAY);
+            case GL_TEXTURE_RECTANGLE: return boundName(GL_TEXTURE_BINDING_RECTANGLE);
+            case GL_TEXTURE_2D_MULTISAMPLE: return boundName(GL_TEXTURE_BINDING_2D_MULTISAMPLE);
+            case GL_TEXTURE_2D_MULTISAMPLE_ARRAY: return boundName(GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY);
+            case GL_TEXTURE_CUBE_MAP:
+            case GL_TEXTURE_CUBE_MAP_POSITIVE_X: case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
+            case GL_TEXTURE_CUBE_MAP_POSITIVE_Y: case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
+            case GL_TEXTURE_CUBE_MAP_POSITIVE_Z: case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
+                return boundName(GL_TEXTURE_BINDING_CUBE_MAP);
+            default: return 0;          // proxy targets allocate nothing
+        }
+    }
+
+    inline uint32_t cubeFace(GLenum target){
+        return target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z ? target - GL_TEXTURE_CUBE_MAP_POSITIVE_X : 0;
+    }
+
+    // bytes per 4x4 block of the block compressed formats, 0 for anything else
+    inline size_t blockBytes(GLenum internalFormat){
+        switch(internalFormat){
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RED_RGTC1: case GL_COMPRESSED_SIGNED_RED_RGTC1:
+                return 8;
+            case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            case GL_COMPRESSED_RG_RGTC2: case GL_COMPRESSED_SIGNED_RG_RGTC2:
+            case GL_COMPRESSED_RGBA_BPTC_UNORM: case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    inline size_t texelBytes(GLenum internalFormat){
+        switch(internalFormat){
+            case GL_R8: case GL_R8_SNORM: case GL_R8I: case GL_R8UI: case GL_RED: case GL_STENCIL_INDEX8:
+                return 1;
+            case GL_RG8: case GL_RG8_SNORM: case GL_RG8I: case GL_RG8UI: case GL_RG:
+            case GL_R16: case GL_R16_SNORM: case GL_R16F: case GL_R16I: case GL_R16UI: case GL_DEPTH_COMPONENT16:
+                return 2;
+            case GL_RGB8: case GL_SRGB8: case GL_RGB8_SNORM: case GL_RGB8I: case GL_RGB8UI: case GL_RGB:
+            case GL_RGBA8: case GL_SRGB8_ALPHA8: case GL_RGBA8_SNORM: case GL_RGBA8I: case GL_RGBA8UI: case GL_RGBA:
+            case GL_RG16: case GL_RG16_SNORM: case GL_RG16F: case GL_RG16I: case GL_RG16UI:
+            case GL_R32F: case GL_R32I: case GL_R32UI:
+            case GL_RGB10_A2: case GL_RGB10_A2UI: case GL_R11F_G11F_B10F: case GL_RGB9_E5:
+            case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32: case GL_DEPTH_COMPONENT32F: case GL_DEPTH_COMPONENT:
+            case GL_DEPTH24_STENCIL8: case GL_DEPTH_STENCIL:
+                return 4;
+            case GL_RGB16: case GL_RGB16_SNORM: case GL_RGB16F: case GL_RGB16I: case GL_RGB16UI:
+            case GL_RGBA16: case GL_RGBA16_SNORM: case GL_RGBA16F: case GL_RGBA16I: case GL_RGBA16UI:
+            case GL_RG32F: case GL_RG32I: case GL_RG32UI: case GL_DEPTH32F_STENCIL8:
+                return 8;
+            case GL_RGB32F: case GL_RGB32I: case GL_RGB32UI:
+            case GL_RGBA32F: case GL_RGBA32I: case GL_RGBA32UI:
+                return 16;
+            default:
+                return 4;
+        }
+    }
+
+    inline size_t imageBytes(GLenum internalFormat, uint64_t width, uint64_t height, uint64_t depth){
+        size_t block = blockBytes(internalFormat);
+        if(block != 0){
+            return static_cast<size_t>(((width + 3) / 4) * ((height + 3) / 4) * depth * block);
+        }
+        return static_cast<size_t>(width * height * depth * texelBytes(internalFormat));
+    }
+
+    inline void setImage(GLuint texture, uint32_t level, uint32_t face, size_t bytes){
+        Resource* resource = find(TEXTURE, texture);
+        if(resource == NULL){
+            return;
+        }
+        resource->images[level * 6 + face] = bytes;
+        size_t total = 0;
+        for(const std::pair<const uint32_t, size_t> &image : resource->images){
+            total += image.second;
+        }
+        setBytes(*resource, total);
+    }
+
+    // every level of an immutable texture at once; cube maps get six faces per level, arrays
+    // keep their layer count while 3D textures halve depth too
+    inline void setStorage(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei depth){
+        GLuint texture = boundTexture(target);
+        bool volume = target == GL_TEXTURE_3D;
+        uint32_t faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+        for(GLsizei level = 0; level < levels; level++){
+            uint64_t w = std::max(1, width >> level);
+            uint64_t h = target == GL_TEXTURE_1D_ARRAY ? height : std::max(1, height >> level);
+            uint64_t d = volume ? std::max(1, depth >> level) : depth;
+            for(uint32_t face = 0; face < faces; face++){
+                setImage(texture, level, face, imageBytes(internalFormat, w, h, d));
+            }
+        }
+    }
+    #pragma endregion
+
+    #pragma region Observers
+    template<Kind K>
+    inline void onGen(GLsizei count, GLuint* names){
+        for(GLsizei i = 0; i < count; i++){
+            create(K, names[i]);
+        }
+    }
+
+    template<Kind K>
+    inline void onDelete(GLsizei count, const GLuint* names){
+        static const char* calls[KIND_COUNT] = { "glDeleteBuffers", "glDeleteTextures", "glDeleteRenderbuffers", "glDeleteFramebuffers",
+                                                 "glDeleteVertexArrays", "glDeleteProgram", "glDeleteShader", "glDeleteQueries", "glDeleteSamplers" };
+        for(GLsizei i = 0; i < count; i++){
+            destroy(K, names[i], calls[K]);
+        }
+    }
+
+    inline void onCreateProgram(GLuint program){
+        create(PROGRAM, program);
+    }
+
+    inline void onDeleteProgram(GLuint program){
+        destroy(PROGRAM, program, "glDeleteProgram");
+    }
+
+    inline void onCreateShader(GLuint shader, GLenum){
+        create(SHADER, shader);
+    }
+
+    inline void onDeleteShader(GLuint shader){
+        destroy(SHADER, shader, "glDeleteShader");
+    }
+
+    inline void onBufferData(GLenum target, GLsizeiptr size, const void*, GLenum){
+        Resource* resource = find(BUFFER, boundBuffer(target));
+        if(resource != NULL){
+            setBytes(*resource, size > 0 ? static_cast<size_t>(size) : 0);
+        }
+    }
+
+    inline void onBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield){
+        onBufferData(target, size, data, 0);
+    }
+
+    inline void onTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint, GLenum, GLenum, const void*){
+        setImage(boundTexture(target), level, cubeFace(target), imageBytes(internalFormat, width, height, 1));
+    }
+
+    inline void onTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint, GLenum, GLenum, const void*){
+        setImage(boundTexture(target), level, 0, imageBytes(internalFormat, width, height, depth));
+    }
+
+    inline void onCompressedTexImage2D(GLenum target, GLint level, GLenum, GLsizei, GLsizei, GLint, GLsizei bytes, const void*){
+        setImage(boundTexture(target), level, cubeFace(target), bytes > 0 ? bytes : 0);
+    }
+
+    inline void onCompressedTexImage3D(GLenum target, GLint level, GLenum, GLsizei, GLsizei, GLsizei, GLint, GLsizei bytes, const void*){
+        setImage(boundTexture(target), level, 0, bytes > 0 ? bytes : 0);
+    }
+
+    inline void onTexImage2DMultisample(GLenum target, GLsizei samples, GLenum internalFormat, GLsizei width, GLsizei height, GLboolean){
+        setImage(boundTexture(target), 0, 0, imageBytes(internalFormat, width, height, 1) * std::max(samples, 1));
+    }
+
+    inline void onTexImage3DMultisample(GLenum target, GLsizei samples, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLboolean){
+        setImage(boundTexture(target), 0, 0, imageBytes(internalFormat, width, height, depth) * std::max(samples, 1));
+    }
+
+    inline void onTexStorage2D(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height){
+        setStorage(target, levels, internalFormat, width, height, 1);
+    }
+
+    inline void onTexStorage3D(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei depth){
+        setStorage(target, levels, internalFormat, width, height, depth);
+    }
+
+    inline void onRenderbufferStorage(GLenum, GLenum internalFormat, GLsizei width, GLsizei height){
+        Resource* resource = find(RENDERBUFFER, boundName(GL_RENDERBUFFER_BINDING));
+        if(resource != NULL){
+            setBytes(*resource, imageBytes(internalFormat, width, height, 1));
+        }
+    }
+
+    inline void onRenderbufferStorageMultisample(GLenum, GLsizei samples, GLenum internalFormat, GLsizei width, GLsizei height){
+        Resource* resource = find(RENDERBUFFER, boundName(GL_RENDERBUFFER_BINDING));
+        if(resource != NULL){
+            setBytes(*resource, imageBytes(internalFormat, width, height, 1) * std::max(samples, 1));
+        }
+    }
+    #pragma endregion
+
+#define GPU_RESOURCES_GEN_DELETE \
+    GPU_RESOURCES_KIND(BUFFER, glGenBuffers, glDeleteBuffers) \
+    GPU_RESOURCES_KIND(TEXTURE, glGenTextures, glDeleteTextures) \
+    GPU_RESOURCES_KIND(RENDERBUFFER, glGenRenderbuffers, glDeleteRenderbuffers) \
+    GPU_RESOURCES_KIND(FRAMEBUFFER, glGenFramebuffers, glDeleteFramebuffers) \
+    GPU_RESOURCES_KIND(VERTEX_ARRAY, glGenVertexArrays, glDeleteVertexArrays) \
+    GPU_RESOURCES_KIND(QUERY, glGenQueries, glDeleteQueries) \
+    GPU_RESOURCES_KIND(SAMPLER, glGenSamplers, glDeleteSamplers)
+
+#define GPU_RESOURCES_SIZE_OBSERVERS \
+    GPU_RESOURCES_OBSERVER(glad_glBufferData, onBufferData) \
+    GPU_RESOURCES_OBSERVER(glad_glTexImage2D, onTexImage2D) \
+    GPU_RESOURCES_OBSERVER(glad_glTexImage3D, onTexImage3D) \
+    GPU_RESOURCES_OBSERVER(glad_glCompressedTexImage2D, onCompressedTexImage2D) \
+    GPU_RESOURCES_OBSERVER(glad_glCompressedTexImage3D, onCompressedTexImage3D) \
+    GPU_RESOURCES_OBSERVER(glad_glTexImage2DMultisample, onTexImage2DMultisample) \
+    GPU_RESOURCES_OBSERVER(glad_glTexImage3DMultisample, onTexImage3DMultisample) \
+    GPU_RESOURCES_OBSERVER(glad_glRenderbufferStorage, onRenderbufferStorage) \
+    GPU_RESOURCES_OBSERVER(glad_glRenderbufferStorageMultisample, onRenderbufferStorageMultisample) \
+    GPU_RESOURCES_OBSERVER(GLExt::TexStorage2D, onTexStorage2D) \
+    GPU_RESOURCES_OBSERVER(GLExt::TexStorage3D, onTexStorage3D) \
+    GPU_RESOURCES_OBSERVER(GLExt::BufferStorage, onBufferStorage)
+
+    // call after gladLoadGLLoader and GLExt::load, before creating anything, on the GL thread
+    inline void install(){
+        State &s = state();
+        if(s.installed){
+            return;
+        }
+#define GPU_RESOURCES_KIND(kind, gen, remove) \
+        GLHooks::Hook<&glad_##gen>::addAfter(&onGen<kind>); \
+        GLHooks::Hook<&glad_##remove>::addBefore(&onDelete<kind>);
+        GPU_RESOURCES_GEN_DELETE
+#undef GPU_RESOURCES_KIND
+#define GPU_RESOURCES_OBSERVER(slot, observer) GLHooks::Hook<&slot>::addAfter(observer);
+        GPU_RESOURCES_SIZE_OBSERVERS
+#undef GPU_RESOURCES_OBSERVER
+        GLHooks::Hook<&glad_glCreateProgram>::addAfter(onCreateProgram);
+        GLHooks::Hook<&glad_glDeleteProgram>::addBefore(onDeleteProgram);
+        GLHooks::Hook<&glad_glCreateShader>::addAfter(onCreateShader);
+        GLHooks::Hook<&glad_glDeleteShader>::addBefore(onDeleteShader);
+        s.installed = true;
+    }
+
+    inline void uninstall(){
+#define GPU_RESOURCES_KIND(kind, gen, remove) \
+        GLHooks::Hook<&glad_##gen>::removeAfter(&onGen<kind>); \
+        GLHooks::Hook<&glad_##remove>::removeBefore(&onDelete<kind>);
+        GPU_RESOURCES_GEN_DELETE
+#undef GPU_RESOURCES_KIND
+#define GPU_RESOURCES_OBSERVER(slot, observer) GLHooks::Hook<&slot>::removeAfter(observer);
+        GPU_RESOURCES_SIZE_OBSERVERS
+#undef GPU_RESOURCES_OBSERVER
+        GLHooks::Hook<&glad_glCreateProgram>::removeAfter(onCreateProgram);
+        GLHooks::Hook<&glad_glDeleteProgram>::removeBefore(onDeleteProgram);
+        GLHooks::Hook<&glad_glCreateShader>::removeAfter(onCreateShader);
+        GLHooks::Hook<&glad_glDeleteShader>::removeBefore(onDeleteShader);
+        state().installed = false;
+    }
+
+    inline bool installed(){
+        return state().installed;
+    }
+
+    inline const KindStats& stats(Kind kind){
+        return state().kinds[kind];
+    }
+
+    inline size_t peakBytes(){
+        return state().peakBytes;
+    }
+
+    inline std::string describeSite(const Site &site){
+        if(site.file == NULL){
+            return "unknown site";
+        }
+        const char* file = site.file;
+        for(const char* c = site.file; *c != '\0'; c++){
+            if(*c == '/' || *c == '\\'){
+                file = c + 1;
+            }
+        }
+        return std::string(file) + ":" + std::to_string(site.line) + " (" + (site.function ? site.function : "?") + ")";
+    }
+
+    // live count and size per category plus the peak, e.g. to compare against a budget
+    inline void printBreakdown(std::ostream &out){
+        State &s = state();
+        out << "gpu memory: " << totalBytes() / 1024 << " KB live, " << s.peakBytes / 1024 << " KB peak" << std::endl;
+        for(int kind = 0; kind < KIND_COUNT; kind++){
+            const KindStats &stats = s.kinds[kind];
+            if(stats.created == 0){
+                continue;
+            }
+            out << "  " << kindName(static_cast<Kind>(kind)) << ": " << stats.live << " live, " << stats.bytes / 1024 << " KB (peak "
+                << stats.peakBytes / 1024 << " KB), " << stats.created << " created, " << stats.destroyed << " destroyed";
+            if(stats.destroyed > 0){
+                out << ", mean lifetime " << static_cast<double>(stats.lifetimeFrames) / stats.destroyed << " frames, " << stats.transient << " transient";
+            }
+            out << std::endl;
+        }
+    }
+
+    // every object still alive and every bad delete seen, returns the number of leaks
+    inline size_t leakReport(std::ostream &out){
+        State &s = state();
+        std::vector<const Resource*> leaks;
+        for(const std::pair<const uint64_t, Resource> &entry : s.live){
+            leaks.push_back(&entry.second);
+        }
+        std::sort(leaks.begin(), leaks.end(), [](const Resource* a, const Resource* b){
+            return a->kind != b->kind ? a->kind < b->kind : a->bytes > b->bytes;
+        });
+        if(leaks.empty()){
+            out << "gpu resources: no leaks" << std::endl;
+        }
+        else{
+            out << "gpu resources: " << leaks.size() << " leaked, " << totalBytes() / 1024 << " KB" << std::endl;
+        }
+        for(const Resource* resource : leaks){
+            out << "  " << kindName(resource->kind) << " " << resource->name;
+            if(!resource->label.empty()){
+                out << " \"" << resource->label << "\"";
+            }
+            out << ", " << resource->bytes << " bytes, created at " << describeSite(resource->site) << " in frame " << resource->createdFrame
+                << " (" << resource->createdSeconds << " s), alive " << s.frame - resource->createdFrame << " frames" << std::endl;
+        }
+        for(const std::string &text : s.problems){
+            out << "  bad delete: " << text << std::endl;
+        }
+        return leaks.size();
+    }
+}
+
+#define GPU_RESOURCE_CONCAT_INNER(a, b) a##b
+#define GPU_RESOURCE_CONCAT(a, b) GPU_RESOURCE_CONCAT_INNER(a, b)
+#define GPU_RESOURCE_SITE() GpuResources::SiteScope GPU_RESOURCE_CONCAT(gpuResourceSite, __LINE__)(__FILE__, __LINE__, __func__)
+
+#endif
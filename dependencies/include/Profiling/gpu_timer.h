@@ -0,0 +1,186 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+#include <Profiling/profiler.h>
+#include <Profiling/gpu_resources.h>
+
+#include <cstdint>
+#include <vector>
+
+// GPU side of the frame profiler. Each pass is bracketed by a GL_TIME_ELAPSED query for its
+// duration and a GL_TIMESTAMP query marking where it started, so it can be placed on the
+// same timeline as the CPU scopes.
+//
+//   gpuTimer.beginFrame();
+//   gpuTimer.beginPass("cubes"); ... draws ... gpuTimer.endPass();
+//   gpuTimer.endFrame();          // after SwapBuffers
+//
+// Queries live in a ring of FRAMES_IN_FLIGHT sets and a frame's results are read back
+// FRAMES_IN_FLIGHT - 1 frames later, only once GL_QUERY_RESULT_AVAILABLE says so, so the
+// profiler never stalls the pipeline. A frame whose results still aren't ready when its
+// set comes round again is skipped and counted in skippedFrames(). GL_TIME_ELAPSED
+// queries can't nest, so passes can't either. Needs a GL 3.3 context (ARB_timer_query is core).
+
+class GpuTimer {
+    public:
+        static const uint32_t FRAMES_IN_FLIGHT = 4;
+        static const uint32_t MAX_PASSES = 16;
+
+        struct Pass {
+            const char* name;
+            double milliseconds;
+        };
+
+        GpuTimer(){}
+
+        GpuTimer(const GpuTimer&) = delete;
+        GpuTimer& operator=(const GpuTimer&) = delete;
+
+        ~GpuTimer(){
+            destroy();
+        }
+
+        void beginFrame(){
+            if(!created){
+                create();
+            }
+            Frame &frame = frames[current];
+            if(frame.pending){
+                collect(frame);
+                if(frame.pending){
+                    skipped++;
+                    frame.pending = false;
+                }
+            }
+            frame.passCount = 0;
+            // re-anchor the GPU clock to the CPU clock every frame, drivers drift apart
+            GLint64 gpuNow = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+            frame.cpuOffsetNs = static_cast<int64_t>(Profiler::now()) - gpuNow;
+        }
+
+        void beginPass(const char* name){
+            Frame &frame = frames[current];
+            if(frame.passCount >= MAX_PASSES || open){
+                return;
+            }
+            PassQueries &pass = frame.passes[frame.passCount];
+            pass.name = name;
+            glQueryCounter(pass.start, GL_TIMESTAMP);
+            glBeginQuery(GL_TIME_ELAPSED, pass.elapsed);
+            open = true;
+        }
+
+        void endPass(){
+            if(!open){
+                return;
+            }
+            glEndQuery(GL_TIME_ELAPSED);
+            frames[current].passCount++;
+            open = false;
+        }
+
+        void endFrame(){
+            frames[current].pending = frames[current].passCount > 0;
+            current = (current + 1) % FRAMES_IN_FLIGHT;
+            // read back whatever older frames have finished, oldest first so lastFrame() ends up newest
+            for(uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++){
+                Frame &frame = frames[(current + i) % FRAMES_IN_FLIGHT];
+                if(frame.pending){
+                    collect(frame);
+                }
+            }
+        }
+
+        // passes of the most recent frame that was read back
+        const std::vector<Pass>& lastFrame() const{
+            return last;
+        }
+
+        // total GPU time of the most recent frame that was read back
+        double lastFrameMilliseconds() const{
+            double total = 0.0;
+            for(const Pass &pass : last){
+                total += pass.milliseconds;
+            }
+            return total;
+        }
+
+        uint64_t skippedFrames() const{
+            return skipped;
+        }
+
+        // frames read back so far, changes whenever lastFrame() has a new result
+        uint64_t resolvedFrames() const{
+            return resolved;
+        }
+
+        void destroy(){
+            if(!created){
+                return;
+            }
+            for(Frame &frame : frames){
+                for(PassQueries &pass : frame.passes){
+                    glDeleteQueries(1, &pass.start);
+                    glDeleteQueries(1, &pass.elapsed);
+                }
+            }
+            created = false;
+        }
+
+    private:
+        struct PassQueries {
+            const char* name = "";
+            GLuint start = 0;
+            GLuint elapsed = 0;
+        };
+
+        struct Frame {
+            PassQueries passes[MAX_PASSES];
+            uint32_t passCount = 0;
+            int64_t cpuOffsetNs = 0;
+            bool pending = false;
+        };
+
+        Frame frames[FRAMES_IN_FLIGHT];
+        uint32_t current = 0;
+        bool created = false;
+        bool open = false;
+        uint64_t skipped = 0;
+        uint64_t resolved = 0;
+        std::vector<Pass> last;
+
+        void create(){
+            GPU_RESOURCE_SITE();
+            for(Frame &frame : frames){
+                for(PassQueries &pass : frame.passes){
+                    glGenQueries(1, &pass.start);
+                    glGenQueries(1, &pass.elapsed);
+                }
+            }
+            created = true;
+        }
+
+        // results arrive in order, so checking the last query of the frame is enough
+        void collect(Frame &frame){
+            GLuint available = 0;
+            glGetQueryObjectuiv(frame.passes[frame.passCount - 1].elapsed, GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available){
+                return;
+            }
+            last.clear();
+            for(uint32_t i = 0; i < frame.passCount; i++){
+                GLuint64 start = 0, elapsed = 0;
+                glGetQueryObjectui64v(frame.passes[i].start, GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(frame.passes[i].elapsed, GL_QUERY_RESULT, &elapsed);
+                uint64_t cpuStart = static_cast<uint64_t>(static_cast<int64_t>(start) + frame.cpuOffsetNs);
+                Profiler::addGpuEvent(frame.passes[i].name, cpuStart, cpuStart + elapsed);
+                last.push_back(Pass{ frame.passes[i].name, elapsed / 1.0e6 });
+            }
+            frame.pending = false;
+            resolved++;
+        }
+};
+
+#endif
@@ -0,0 +1,296 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// CPU side of the frame profiler.
+//
+//   PROFILE_SCOPE("drawObjects");     // times the rest of the enclosing block
+//   PROFILE_FUNCTION();               // same, named after the function
+//
+// Scopes only record while a capture is running (Profiler::beginCapture), otherwise they
+// cost one relaxed atomic load. Each thread writes finished scopes into its own fixed size
+// buffer with no locks: the owning thread is the only writer and publishes with a release
+// store of the event count, the exporting thread reads up to that count. A buffer that
+// fills up drops further events for the rest of the capture (counted in dropped()) rather
+// than wrapping over events the exporter may be reading.
+//
+// Names must be string literals (or otherwise outlive the capture), only the pointer is
+// stored. GPU passes (see gpu_timer.h) are added through addGpuEvent and exported on their
+// own track. Define PROFILER_DISABLED to compile every scope out.
+
+namespace Profiler {
+
+    struct Event {
+        const char* name;
+        uint64_t startNs;
+        uint64_t endNs;
+        uint32_t depth;
+    };
+
+    // nanoseconds on the steady clock, shared by CPU scopes, GPU events and frame markers
+    inline uint64_t now(){
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    class ThreadBuffer {
+        public:
+            static const uint32_t CAPACITY = 1u << 16;
+
+            ThreadBuffer* next = NULL;
+            uint32_t threadIndex = 0;
+            std::string threadName;
+            std::atomic<uint32_t> generation{0};
+            std::atomic<uint32_t> count{0};
+            std::atomic<uint32_t> dropped{0};
+            uint32_t depth = 0;
+            std::vector<Event> events;
+
+            ThreadBuffer() : events(CAPACITY){}
+
+            // called by the owning thread only
+            void push(const Event &event, uint32_t currentGeneration){
+                if(generation.load(std::memory_order_relaxed) != currentGeneration){
+                    count.store(0, std::memory_order_relaxed);
+                    dropped.store(0, std::memory_order_relaxed);
+                    generation.store(currentGeneration, std::memory_order_release);
+                }
+                uint32_t index = count.load(std::memory_order_relaxed);
+                if(index >= CAPACITY){
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                events[index] = event;
+                count.store(index + 1, std::memory_order_release);
+            }
+    };
+
+    struct State {
+        std::atomic<bool> capturing{false};
+        std::atomic<uint32_t> generation{0};
+        std::atomic<ThreadBuffer*> buffers{NULL};
+        std::atomic<uint32_t> threadCount{0};
+        std::vector<Event> gpuEvents;           // main thread only
+        std::vector<Event> frames;              // main thread only
+        uint64_t frameStart = 0;
+        uint64_t frameIndex = 0;
+        uint64_t captureFirstFrame = 0;
+        uint64_t captureFrames = 0;             // 0 captures until endCapture
+        std::string capturePath;
+    };
+
+    inline State& state(){
+        static State instance;
+        return instance;
+    }
+
+    // buffers are pushed onto a lock free list once per thread and live until exit, so the
+    // exporter can still read threads that have finished
+    inline ThreadBuffer& threadBuffer(){
+        thread_local ThreadBuffer* buffer = NULL;
+        if(buffer == NULL){
+            State &s = state();
+            buffer = new ThreadBuffer();
+            buffer->threadIndex = s.threadCount.fetch_add(1, std::memory_order_relaxed);
+            ThreadBuffer* head = s.buffers.load(std::memory_order_relaxed);
+            do{
+                buffer->next = head;
+            }while(!s.buffers.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+        }
+        return *buffer;
+    }
+
+    // optional, shown as the track name in the trace viewer
+    inline void setThreadName(const std::string &name){
+        threadBuffer().threadName = name;
+    }
+
+    inline bool capturing(){
+        return state().capturing.load(std::memory_order_relaxed);
+    }
+
+    class Scope {
+        public:
+            explicit Scope(const char* name) : name(name){
+                if(!capturing()){
+                    return;
+                }
+                buffer = &threadBuffer();
+                depth = buffer->depth++;
+                startNs = now();
+            }
+
+            ~Scope(){
+                if(buffer == NULL){
+                    return;
+                }
+                uint64_t endNs = now();
+                buffer->depth--;
+                buffer->push(Event{ name, startNs, endNs, depth }, state().generation.load(std::memory_order_relaxed));
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            const char* name;
+            ThreadBuffer* buffer = NULL;
+            uint64_t startNs = 0;
+            uint32_t depth = 0;
+    };
+
+    // GPU work measured by GpuTimer, already converted to the CPU clock
+    inline void addGpuEvent(const char* name, uint64_t startNs, uint64_t endNs){
+        if(capturing()){
+            state().gpuEvents.push_back(Event{ name, startNs, endNs, 0 });
+        }
+    }
+
+    inline uint64_t frameIndex(){
+        return state().frameIndex;
+    }
+
+    inline uint32_t dropped();
+    inline bool writeChromeTrace(const std::string &path);
+
+    // starts recording; with frames > 0 the capture ends by itself after that many frames
+    // and is written to path, otherwise endCapture writes it
+    inline void beginCapture(const std::string &path, uint64_t frames = 0){
+        State &s = state();
+        if(s.capturing.load(std::memory_order_relaxed)){
+            return;
+        }
+        s.gpuEvents.clear();
+        s.frames.clear();
+        s.capturePath = path;
+        s.captureFirstFrame = s.frameIndex;
+        s.captureFrames = frames;
+        s.generation.fetch_add(1, std::memory_order_relaxed);
+        s.capturing.store(true, std::memory_order_release);
+    }
+
+    inline bool endCapture(){
+        State &s = state();
+        if(!s.capturing.load(std::memory_order_relaxed)){
+            return false;
+        }
+        s.capturing.store(false, std::memory_order_release);
+        return writeChromeTrace(s.capturePath);
+    }
+
+    // frame markers, call from the main thread at the start and end of every frame
+    inline void beginFrame(){
+        state().frameStart = now();
+    }
+
+    inline void endFrame(){
+        State &s = state();
+        if(s.capturing.load(std::memory_order_relaxed)){
+            s.frames.push_back(Event{ "frame", s.frameStart, now(), 0 });
+        }
+        s.frameIndex++;
+        if(s.capturing.load(std::memory_order_relaxed) && s.captureFrames > 0 && s.frameIndex - s.captureFirstFrame >= s.captureFrames){
+            endCapture();
+        }
+    }
+
+    inline uint32_t dropped(){
+        uint32_t total = 0;
+        uint32_t generation = state().generation.load(std::memory_order_relaxed);
+        for(ThreadBuffer* buffer = state().buffers.load(std::memory_order_acquire); buffer != NULL; buffer = buffer->next){
+            if(buffer->generation.load(std::memory_order_acquire) == generation){
+                total += buffer->dropped.load(std::memory_order_relaxed);
+            }
+        }
+        return total;
+    }
+
+    inline void writeEscaped(FILE* file, const char* text){
+        for(; *text != '\0'; text++){
+            if(*text == '"' || *text == '\\'){
+                fputc('\\', file);
+            }
+            fputc(*text, file);
+        }
+    }
+
+    // one complete ("X") event per scope, in microseconds relative to the first frame, in the
+    // Trace Event format read by chrome://tracing and ui.perfetto.dev
+    inline bool writeChromeTrace(const std::string &path){
+        State &s = state();
+        FILE* file = fopen(path.c_str(), "w");
+        if(file == NULL){
+            return false;
+        }
+        uint32_t generation = s.generation.load(std::memory_order_relaxed);
+        uint64_t origin = s.frames.empty() ? now() : s.frames.front().startNs;
+        for(ThreadBuffer* buffer = s.buffers.load(std::memory_order_acquire); buffer != NULL; buffer = buffer->next){
+            if(buffer->generation.load(std::memory_order_acquire) == generation && buffer->count.load(std::memory_order_acquire) > 0){
+                origin = std::min(origin, buffer->events[0].startNs);
+            }
+        }
+        for(const Event &event : s.gpuEvents){
+            origin = std::min(origin, event.startNs);
+        }
+
+        const uint32_t GPU_TRACK = 1000;
+        bool first = true;
+        auto writeEvent = [&](const Event &event, uint32_t track, const char* category){
+            fprintf(file, "%s\n{\"name\":\"", first ? "" : ",");
+            writeEscaped(file, event.name);
+            fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                category, track, (event.startNs - origin) / 1000.0, (event.endNs - event.startNs) / 1000.0);
+            first = false;
+        };
+        auto writeTrackName = [&](uint32_t track, const std::string &name){
+            fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",", track);
+            writeEscaped(file, name.c_str());
+            fprintf(file, "\"}}");
+            first = false;
+        };
+
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        for(ThreadBuffer* buffer = s.buffers.load(std::memory_order_acquire); buffer != NULL; buffer = buffer->next){
+            if(buffer->generation.load(std::memory_order_acquire) != generation){
+                continue;
+            }
+            uint32_t count = buffer->count.load(std::memory_order_acquire);
+            writeTrackName(buffer->threadIndex, buffer->threadName.empty() ? "thread " + std::to_string(buffer->threadIndex) : buffer->threadName);
+            for(uint32_t i = 0; i < count; i++){
+                writeEvent(buffer->events[i], buffer->threadIndex, "cpu");
+            }
+        }
+        if(!s.gpuEvents.empty()){
+            writeTrackName(GPU_TRACK, "GPU");
+            for(const Event &event : s.gpuEvents){
+                writeEvent(event, GPU_TRACK, "gpu");
+            }
+        }
+        if(!s.frames.empty()){
+            writeTrackName(GPU_TRACK + 1, "frames");
+            for(const Event &event : s.frames){
+                writeEvent(event, GPU_TRACK + 1, "frame");
+            }
+        }
+        fprintf(file, "\n]}\n");
+        return fclose(file) == 0;
+    }
+}
+
+#ifndef PROFILER_DISABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <Profiling/frame_stats.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Decides when frames start and measures when they were presented.
+//
+//   UNCAPPED        swap interval 0, frames start as soon as the previous one is submitted
+//   VSYNC           swap interval 1, SwapBuffers blocks until the vertical blank
+//   ADAPTIVE_VSYNC  swap interval -1 (EXT_swap_control_tear): waits for the blank when the
+//                   frame is on time and tears instead of waiting a whole extra refresh when
+//                   it is late; plain vsync where the extension is missing
+//   LOW_LATENCY     swap interval 0 and a limiter at targetHz. Instead of rendering right away
+//                   and waiting in the swap, the frame starts as late as it can and still be
+//                   presented by its deadline, so input sampled at the start is as fresh as
+//                   possible when it reaches the screen.
+//
+// The limiter keeps deadlines on a fixed cadence (one period apart) and predicts the frame's
+// cost from how long recent frames took from start to present, rising at once on a slow frame
+// and decaying slowly after. It sleeps until spinMilliseconds before the start, because
+// sleeps overshoot by the scheduler's granularity, then spins the rest. A frame that can't
+// make its deadline starts at once and the cadence restarts from it.
+//
+//   FramePacer::Clock::time_point start = pacer.waitForFrameStart();   // then poll input and build the view from it
+//   ... draw, SwapBuffers ...
+//   pacer.framePresented(start);
+//
+// In render thread mode waitForFrameStart() runs on the window thread and framePresented() on
+// the render thread, so both take a lock. With more than one frame in flight the window thread
+// starts the next frame before this one is presented, so the start travels with the frame
+// (FrameDescription) and each frame is costed from its own start, time queued included.
+
+class FramePacer {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        enum Mode { UNCAPPED, VSYNC, ADAPTIVE_VSYNC, LOW_LATENCY };
+
+        struct Jitter {
+            FrameStats::Summary interval;   // present to present, ms
+            FrameStats::Summary deviation;  // |interval - target| (the mean interval when uncapped), ms
+            double stddev = 0.0;            // of the intervals, ms
+            double targetMilliseconds = 0.0;
+            uint64_t missedDeadlines = 0;   // low latency: cadence restarts plus presents after the deadline
+            double waitMilliseconds = 0.0;  // mean time waitForFrameStart() held a frame back
+        };
+
+        double spinMilliseconds = 2.0;
+        double marginMilliseconds = 0.5;    // added to the predicted frame cost
+
+        static const char* modeName(Mode mode){
+            switch(mode){
+                case UNCAPPED: return "uncapped";
+                case VSYNC: return "vsync";
+                case ADAPTIVE_VSYNC: return "adaptive";
+                case LOW_LATENCY: return "low-latency";
+            }
+            return "?";
+        }
+
+        // accepts the names modeName() returns
+        static bool parseMode(const char* name, Mode &mode){
+            for(Mode candidate : { UNCAPPED, VSYNC, ADAPTIVE_VSYNC, LOW_LATENCY }){
+                if(strcmp(name, modeName(candidate)) == 0){
+                    mode = candidate;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // for glfwSwapInterval; tearControl when EXT_swap_control_tear is supported
+        static int swapInterval(Mode mode, bool tearControl){
+            switch(mode){
+                case VSYNC: return 1;
+                case ADAPTIVE_VSYNC: return tearControl ? -1 : 1;
+                default: return 0;
+            }
+        }
+
+        // targetHz is the limiter rate in low latency mode and what the other capped modes are
+        // expected to hold (the display's refresh rate) for the jitter report
+        void configure(Mode mode, double targetHz){
+            std::lock_guard<std::mutex> lock(this->guard);
+            this->mode_ = mode;
+            this->targetHz_ = targetHz;
+            this->period = targetHz > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetHz)) : Clock::duration::zero();
+            this->scheduled = false;
+        }
+
+        Mode mode() const{
+            return this->mode_;
+        }
+
+        double targetHz() const{
+            return this->targetHz_;
+        }
+
+        // low latency: blocks until the latest start that still meets the next deadline, other
+        // modes return at once. Returns when the frame started, for framePresented().
+        Clock::time_point waitForFrameStart(){
+            Clock::time_point now = Clock::now();
+            Clock::time_point start = now;
+            {
+                std::lock_guard<std::mutex> lock(this->guard);
+                if(this->mode_ != LOW_LATENCY || this->period == Clock::duration::zero()){
+                    return now;
+                }
+                Clock::duration cost = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(this->estimate + this->marginMilliseconds));
+                Clock::time_point deadline = this->scheduled ? this->deadline + this->period : now + this->period;
+                if(deadline - cost < now){
+                    // too late for this one, restart the cadence from here
+                    this->missed += this->scheduled ? 1 : 0;
+                    deadline = now + cost;
+                }
+                this->deadline = deadline;
+                this->scheduled = true;
+                start = deadline - cost;
+            }
+            Clock::duration spin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(this->spinMilliseconds));
+            if(start - spin > now){
+                std::this_thread::sleep_until(start - spin);
+            }
+            while(Clock::now() < start){
+                std::this_thread::yield();
+            }
+            Clock::time_point began = Clock::now();
+            double waited = std::chrono::duration<double, std::milli>(began - now).count();
+            std::lock_guard<std::mutex> lock(this->guard);
+            this->waited += waited;
+            this->waits++;
+            return began;
+        }
+
+        // right after SwapBuffers returns, with what waitForFrameStart() returned for this frame
+        void framePresented(Clock::time_point start){
+            Clock::time_point now = Clock::now();
+            std::lock_guard<std::mutex> lock(this->guard);
+            if(this->presented){
+                this->intervals.push_back(static_cast<float>(std::chrono::duration<double, std::milli>(now - this->lastPresent).count()));
+            }
+            this->presented = true;
+            this->lastPresent = now;
+            double cost = std::chrono::duration<double, std::milli>(now - start).count();
+            this->estimate = cost > this->estimate ? cost : this->estimate + (cost - this->estimate) * 0.05;
+            if(this->mode_ == LOW_LATENCY && this->scheduled && now > this->deadline){
+                this->missed++;
+            }
+        }
+
+        Jitter jitter() const{
+            std::lock_guard<std::mutex> lock(this->guard);
+            Jitter result;
+            result.interval = FrameStats::summarize(this->intervals);
+            result.targetMilliseconds = this->mode_ != UNCAPPED && this->targetHz_ > 0.0 ? 1000.0 / this->targetHz_ : result.interval.mean;
+            std::vector<float> deviations;
+            deviations.reserve(this->intervals.size());
+            double squares = 0.0;
+            for(float interval : this->intervals){
+                deviations.push_back(static_cast<float>(std::fabs(interval - result.targetMilliseconds)));
+                squares += (interval - result.interval.mean) * (interval - result.interval.mean);
+            }
+            result.deviation = FrameStats::summarize(deviations);
+            result.stddev = this->intervals.empty() ? 0.0 : std::sqrt(squares / this->intervals.size());
+            result.missedDeadlines = this->missed;
+            result.waitMilliseconds = this->waits > 0 ? this->waited / this->waits : 0.0;
+            return result;
+        }
+
+        // forgets the measurements (after a warmup), keeps the cadence
+        void reset(){
+            std::lock_guard<std::mutex> lock(this->guard);
+            this->intervals.clear();
+            this->presented = false;
+            this->missed = 0;
+            this->waited = 0.0;
+            this->waits = 0;
+        }
+
+    private:
+        mutable std::mutex guard;
+        Mode mode_ = UNCAPPED;
+        double targetHz_ = 0.0;
+        Clock::duration period = Clock::duration::zero();
+        bool scheduled = false;
+        Clock::time_point deadline;
+        double estimate = 0.0;              // predicted start to present, ms
+        bool presented = false;
+        Clock::time_point lastPresent;
+        std::vector<float> intervals;
+        uint64_t missed = 0;
+        double waited = 0.0;
+        uint64_t waits = 0;
+};
+
+#endif
@@ -0,0 +1,246 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <glad/glad.h>
+#include <Profiling/gpu_resources.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Bounds how far the CPU runs ahead of the GPU. Frames take turns in framesInFlight slots;
+// endFrame() puts a fence after the frame's commands and beginFrame() waits on the fence
+// the slot's previous frame left, so the CPU is never more than framesInFlight frames ahead,
+// and anything indexed by the slot is no longer being read by the GPU when a frame reuses it.
+//
+// The time beginFrame() spends in glClientWaitSync is kept per frame: frames that wait are
+// GPU bound, frames that never wait are CPU bound (or bound by the swap interval).
+//
+//   pipeline.beginFrame();        // before the first GL command that touches slot resources
+//   ... ring.write(...) for this frame's data, draws ...
+//   SwapBuffers; pipeline.endFrame();
+//
+// FrameRing is the per slot memory that goes with it: one buffer split into a region per
+// slot, bump allocated within the frame's region. Writes map the range unsynchronized,
+// which is safe because the fence already guarantees the GPU is done with the region.
+// A frame that needs more than a region grows the buffer (orphaning the old storage, so
+// frames in flight keep theirs); offsets handed out earlier in that frame then point into
+// the new storage, so only use an offset for commands issued before the next write.
+
+class FramePipeline {
+    public:
+        static const uint32_t MAX_FRAMES_IN_FLIGHT = 8;
+
+        struct Stats {
+            uint64_t frames = 0;
+            uint64_t framesWaited = 0;      // the fence wasn't signalled yet when the frame began
+            double waitMilliseconds = 0.0;  // summed over frames
+            double maxWaitMilliseconds = 0.0;
+        };
+
+        explicit FramePipeline(uint32_t framesInFlight = 2){
+            setFramesInFlight(framesInFlight);
+        }
+
+        FramePipeline(const FramePipeline&) = delete;
+        FramePipeline& operator=(const FramePipeline&) = delete;
+
+        ~FramePipeline(){
+            destroy();
+        }
+
+        // only before the first frame, FrameRings size themselves by it
+        void setFramesInFlight(uint32_t count){
+            if(this->frame == 0){
+                this->count = std::min(std::max<uint32_t>(count, 1), MAX_FRAMES_IN_FLIGHT);
+            }
+        }
+
+        uint32_t slots() const{
+            return this->count;
+        }
+
+        // the slot of the frame between beginFrame() and endFrame()
+        uint32_t slot() const{
+            return this->current;
+        }
+
+        // waits until the GPU is done with the frame that last used this slot
+        uint32_t beginFrame(){
+            this->current = static_cast<uint32_t>(this->frame % this->count);
+            this->lastWait = 0.0;
+            GLsync &fence = this->fences[this->current];
+            if(fence != NULL){
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                GLenum status = glClientWaitSync(fence, 0, 0);
+                if(status == GL_TIMEOUT_EXPIRED){
+                    this->stats_.framesWaited++;
+                    // the first real wait flushes, or the fence might never reach the GPU
+                    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+                    do{
+                        status = glClientWaitSync(fence, flags, WAIT_STEP_NS);
+                        flags = 0;
+                    } while(status == GL_TIMEOUT_EXPIRED);
+                }
+                this->lastWait = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                glDeleteSync(fence);
+                fence = NULL;
+            }
+            this->stats_.waitMilliseconds += this->lastWait;
+            this->stats_.maxWaitMilliseconds = std::max(this->stats_.maxWaitMilliseconds, this->lastWait);
+            return this->current;
+        }
+
+        // after the frame's last command, SwapBuffers included
+        void endFrame(){
+            this->fences[this->current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            this->frame++;
+            this->stats_.frames++;
+        }
+
+        // how long the last beginFrame() blocked
+        double lastWaitMilliseconds() const{
+            return this->lastWait;
+        }
+
+        const Stats &stats() const{
+            return this->stats_;
+        }
+
+        void destroy(){
+            for(GLsync &fence : this->fences){
+                if(fence != NULL){
+                    glDeleteSync(fence);
+                    fence = NULL;
+                }
+            }
+        }
+
+    private:
+        static const GLuint64 WAIT_STEP_NS = 1000000;
+
+        uint32_t count = 2;
+        uint32_t current = 0;
+        uint64_t frame = 0;
+        GLsync fences[MAX_FRAMES_IN_FLIGHT] = {};
+        double lastWait = 0.0;
+        Stats stats_;
+};
+
+class FrameRing {
+    public:
+        // bytesPerSlot grows on demand; alignment is raised to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+        // for uniform rings
+        FrameRing(GLenum target, size_t bytesPerSlot, const char* label, size_t alignment = 16)
+            : target(target), bytesPerSlot(bytesPerSlot), alignment(alignment), label(label){}
+
+        FrameRing(const FrameRing&) = delete;
+        FrameRing& operator=(const FrameRing&) = delete;
+
+        ~FrameRing(){
+            destroy();
+        }
+
+        // after pipeline.beginFrame(), starts this frame's region
+        void beginFrame(const FramePipeline &pipeline){
+            if(this->name == 0){
+                create(pipeline.slots());
+            }
+            this->slot = pipeline.slot();
+            this->used = 0;
+        }
+
+        // copies size bytes into this frame's region and leaves the buffer bound to the ring's
+        // target; returns the byte offset of the copy in buffer()
+        size_t write(const void* data, size_t size){
+            size_t offset = align(this->used);
+            if(offset + size > this->bytesPerSlot){
+                grow(std::max(this->bytesPerSlot * 2, align(size)));
+                offset = 0;
+            }
+            size_t start = this->slot * this->bytesPerSlot + offset;
+            glBindBuffer(this->target, this->name);
+            if(size > 0){
+                void* mapped = glMapBufferRange(this->target, start, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+                if(mapped != NULL){
+                    memcpy(mapped, data, size);
+                    glUnmapBuffer(this->target);
+                }
+                else{
+                    glBufferSubData(this->target, start, size, data);
+                }
+            }
+            this->used = offset + size;
+            this->peak = std::max(this->peak, this->used);
+            return start;
+        }
+
+        GLuint buffer() const{
+            return this->name;
+        }
+
+        size_t slotBytes() const{
+            return this->bytesPerSlot;
+        }
+
+        // most bytes a single frame used
+        size_t peakBytes() const{
+            return this->peak;
+        }
+
+        uint32_t growths() const{
+            return this->grown;
+        }
+
+        void destroy(){
+            if(this->name != 0){
+                glDeleteBuffers(1, &this->name);
+                this->name = 0;
+            }
+        }
+
+    private:
+        GLenum target;
+        size_t bytesPerSlot;
+        size_t alignment;
+        const char* label;
+        GLuint name = 0;
+        uint32_t slots = 0;
+        uint32_t slot = 0;
+        size_t used = 0;
+        size_t peak = 0;
+        uint32_t grown = 0;
+
+        size_t align(size_t offset) const{
+            return (offset + this->alignment - 1) / this->alignment * this->alignment;
+        }
+
+        void create(uint32_t slots){
+            this->slots = slots;
+            if(this->target == GL_UNIFORM_BUFFER){
+                GLint uniformAlignment = 0;
+                glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+                this->alignment = std::max(this->alignment, static_cast<size_t>(uniformAlignment));
+            }
+            this->bytesPerSlot = align(std::max<size_t>(this->bytesPerSlot, 1));
+            GPU_RESOURCE_SITE();
+            glGenBuffers(1, &this->name);
+            GpuResources::label(GpuResources::BUFFER, this->name, this->label);
+            allocate();
+        }
+
+        void grow(size_t bytes){
+            this->bytesPerSlot = align(bytes);
+            this->grown++;
+            allocate();
+        }
+
+        void allocate(){
+            glBindBuffer(this->target, this->name);
+            glBufferData(this->target, this->bytesPerSlot * this->slots, NULL, GL_STREAM_DRAW);
+        }
+};
+
+#endif
@@ -118,6 +118,11 @@ class Shader {
             glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
         }
 
+        // GLSL 330 has no layout(binding), uniform blocks get their binding point here
+        void setBlockBinding(const std::string &name, unsigned int binding){
+            glUniformBlockBinding(this->ID, glGetUniformBlockIndex(this->ID, name.c_str()), binding);
+        }
+
         void checkVShaderCompilation(unsigned int vertexShader){
             int success;
             char infoLog[512];
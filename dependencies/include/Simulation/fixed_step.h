@@ -0,0 +1,168 @@
+#ifndef FIXED_STEP_H
+#define FIXED_STEP_H
+
+#include <Profiling/profiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Fixed timestep simulation on its own thread. step(state, dt, tick) runs at a fixed rate
+// whatever the render rate is, and every finished tick is published as the newer of two
+// snapshots (previous and current). The renderer samples both along with how far the
+// present moment is between them and interpolates, which puts what it draws one tick
+// behind the simulation, but motion stays smooth at any frame rate and the simulation only
+// ever sees the same dt: the same input per tick gives the same states.
+//
+// Ticks are scheduled on an ideal timeline (tick n is due n * dt after start). A thread that
+// falls behind (a breakpoint, a long stall) runs at most maxCatchUp ticks back to back and
+// drops the rest of the backlog instead of spiralling.
+//
+//   FixedStepLoop<SimState> sim(60.0);
+//   sim.start(initial, [](SimState &state, double dt, uint64_t tick){ ... });
+//   FixedStepLoop<SimState>::Sample sample = sim.sample();    // every frame
+//   mix(sample.previous.x, sample.current.x, sample.alpha)
+
+template<typename State>
+class FixedStepLoop {
+    public:
+        typedef std::chrono::steady_clock Clock;
+        typedef std::function<void(State&, double, uint64_t)> Step;
+
+        struct Sample {
+            State previous;
+            State current;
+            float alpha = 0.0f;         // 0 draws previous, 1 draws current
+            uint64_t tick = 0;          // tick current was produced by
+        };
+
+        struct Stats {
+            uint64_t ticks = 0;
+            uint64_t droppedTicks = 0;
+            double stepSeconds = 0.0;   // summed over ticks
+            double maxStepSeconds = 0.0;
+        };
+
+        explicit FixedStepLoop(double hz = 60.0, uint32_t maxCatchUp = 5) : dt(1.0 / hz), maxCatchUp(std::max<uint32_t>(maxCatchUp, 1)){}
+
+        ~FixedStepLoop(){
+            stop();
+        }
+
+        FixedStepLoop(const FixedStepLoop&) = delete;
+        FixedStepLoop& operator=(const FixedStepLoop&) = delete;
+
+        // both snapshots start out as initial, the first tick is due dt from now
+        void start(const State &initial, Step step){
+            stop();
+            this->step = step;
+            this->working = initial;
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->previous = initial;
+                this->current = initial;
+                this->tick = 0;
+                this->startTime = Clock::now();
+                this->stats = Stats();
+            }
+            this->running.store(true);
+            this->thread = std::thread(&FixedStepLoop::run, this);
+        }
+
+        void stop(){
+            this->running.store(false);
+            if(this->thread.joinable()){
+                this->thread.join();
+            }
+        }
+
+        bool active() const{
+            return this->thread.joinable();
+        }
+
+        double stepSeconds() const{
+            return this->dt;
+        }
+
+        // the two newest snapshots, and the blend for rendering one tick behind right now
+        Sample sample() const{
+            Clock::time_point now = Clock::now();
+            Sample result;
+            std::lock_guard<std::mutex> lock(this->mutex);
+            result.previous = this->previous;
+            result.current = this->current;
+            result.tick = this->tick;
+            double ticksSinceStart = std::chrono::duration<double>(now - this->startTime).count() / this->dt;
+            result.alpha = static_cast<float>(std::min(std::max(ticksSinceStart - static_cast<double>(this->tick), 0.0), 1.0));
+            return result;
+        }
+
+        Stats statistics() const{
+            std::lock_guard<std::mutex> lock(this->mutex);
+            return this->stats;
+        }
+
+    private:
+        double dt;
+        uint32_t maxCatchUp;
+        Step step;
+        State working;                  // simulation thread only
+
+        mutable std::mutex mutex;       // guards everything below
+        State previous;
+        State current;
+        uint64_t tick = 0;
+        Clock::time_point startTime;
+        Stats stats;
+
+        std::atomic<bool> running{false};
+        std::thread thread;
+
+        Clock::duration ticks(double count) const{
+            return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(count * this->dt));
+        }
+
+        void advance(uint64_t next){
+            Clock::time_point begin = Clock::now();
+            {
+                PROFILE_SCOPE("simulation.step");
+                this->step(this->working, this->dt, next);
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->previous = this->current;
+            this->current = this->working;
+            this->tick = next;
+            this->stats.ticks++;
+            this->stats.stepSeconds += seconds;
+            this->stats.maxStepSeconds = std::max(this->stats.maxStepSeconds, seconds);
+        }
+
+        void run(){
+            Profiler::setThreadName("simulation");
+            uint64_t next = 1;
+            // only this thread moves startTime, so reading it without the lock is fine here
+            while(this->running.load()){
+                std::this_thread::sleep_until(this->startTime + ticks(static_cast<double>(next)));
+                double due = std::floor(std::chrono::duration<double>(Clock::now() - this->startTime).count() / this->dt);
+                uint32_t steps = 0;
+                while(static_cast<double>(next) <= due && steps < this->maxCatchUp && this->running.load()){
+                    advance(next++);
+                    steps++;
+                }
+                if(static_cast<double>(next) <= due && this->running.load()){
+                    uint64_t dropped = static_cast<uint64_t>(due) - next + 1;
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    this->startTime += ticks(static_cast<double>(dropped));
+                    this->stats.droppedTicks += dropped;
+                }
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef GOLDEN_IMAGE_H
+#define GOLDEN_IMAGE_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Golden image regression checks: the scene list with per scene budgets, and a perceptual
+// image comparison.
+//
+// Pixels are compared by their distance in YIQ space with luma weighted highest (the
+// pixelmatch metric), scaled so 1.0 is the largest possible difference. A pixel only counts
+// as different when it's over the threshold against every pixel in the 3x3 neighbourhood of
+// the other image, so a driver update that moves an edge by one pixel or changes how it's
+// antialiased doesn't fail the scene, while a change in lighting or a missing object does.
+//
+// Scene file, one scene per line, # starts a comment:
+//
+//   # name   x y z    yaw pitch  time  max_diff_%  max_cpu_ms  max_draws
+//   front    0 0 3    -90 0      0     0.5         50          4
+
+namespace Golden {
+
+    struct Scene {
+        std::string name;
+        glm::vec3 position = glm::vec3(0.0f);
+        float yaw = -90.0f;
+        float pitch = 0.0f;
+        double time = 0.0;              // scene clock, drives the animated cubes and light
+        double maxDiffPercent = 0.5;    // of all pixels
+        double maxCpuMs = 0.0;          // median CPU frame time, 0 for no budget
+        double maxDrawCalls = 0.0;      // per frame, 0 for no budget
+    };
+
+    // false with error set when the file is missing or a line doesn't parse
+    inline bool loadScenes(const std::string &path, std::vector<Scene> &scenes, std::string &error){
+        std::ifstream file(path);
+        if(!file){
+            error = "can't open " + path;
+            return false;
+        }
+        std::string line;
+        int number = 0;
+        while(std::getline(file, line)){
+            number++;
+            line = line.substr(0, line.find('#'));
+            std::istringstream stream(line);
+            Scene scene;
+            if(!(stream >> scene.name)){
+                continue;
+            }
+            if(!(stream >> scene.position.x >> scene.position.y >> scene.position.z >> scene.yaw >> scene.pitch >> scene.time
+                        >> scene.maxDiffPercent >> scene.maxCpuMs >> scene.maxDrawCalls)){
+                error = path + ":" + std::to_string(number) + ": expected name x y z yaw pitch time max_diff_% max_cpu_ms max_draws";
+                return false;
+            }
+            scenes.push_back(scene);
+        }
+        return true;
+    }
+
+    struct Comparison {
+        uint64_t differentPixels = 0;
+        double differentPercent = 0.0;
+        double maxDelta = 0.0;          // 0..1, before the neighbourhood check
+        std::vector<uint8_t> diff;      // RGB: faded expected image, differences in red
+    };
+
+    // squared YIQ distance normalised to 0..1
+    inline double yiqDelta(const uint8_t* a, const uint8_t* b){
+        double r1 = a[0], g1 = a[1], b1 = a[2];
+        double r2 = b[0], g2 = b[1], b2 = b[2];
+        double y = (r1 - r2) * 0.29889531 + (g1 - g2) * 0.58662247 + (b1 - b2) * 0.11448223;
+        double i = (r1 - r2) * 0.59597799 - (g1 - g2) * 0.27417610 - (b1 - b2) * 0.32180189;
+        double q = (r1 - r2) * 0.21147017 - (g1 - g2) * 0.52261711 + (b1 - b2) * 0.31114694;
+        return (0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q) / 35215.0;
+    }
+
+    // true when pixel (x, y) of image is within threshold of some pixel around (x, y) in other
+    inline bool matchesNearby(const uint8_t* image, const uint8_t* other, uint32_t width, uint32_t height, int channels, uint32_t x, uint32_t y, double threshold){
+        const uint8_t* pixel = image + (static_cast<size_t>(y) * width + x) * channels;
+        for(uint32_t ny = y > 0 ? y - 1 : 0; ny <= std::min(y + 1, height - 1); ny++){
+            for(uint32_t nx = x > 0 ? x - 1 : 0; nx <= std::min(x + 1, width - 1); nx++){
+                if(yiqDelta(pixel, other + (static_cast<size_t>(ny) * width + nx) * channels) <= threshold){
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // both images width x height with the same channel count (3 or 4, alpha is ignored)
+    inline Comparison compare(const uint8_t* expected, const uint8_t* actual, uint32_t width, uint32_t height, int channels, double threshold = 0.1){
+        Comparison result;
+        // pixelmatch compares the squared delta against threshold^2 of the maximum
+        double limit = threshold * threshold;
+        result.diff.resize(static_cast<size_t>(width) * height * 3);
+        for(uint32_t y = 0; y < height; y++){
+            for(uint32_t x = 0; x < width; x++){
+                size_t index = static_cast<size_t>(y) * width + x;
+                const uint8_t* a = expected + index * channels;
+                const uint8_t* b = actual + index * channels;
+                double delta = yiqDelta(a, b);
+                result.maxDelta = std::max(result.maxDelta, std::sqrt(delta));
+                bool different = delta > limit && !matchesNearby(actual, expected, width, height, channels, x, y, limit)
+                                                && !matchesNearby(expected, actual, width, height, channels, x, y, limit);
+                uint8_t* out = &result.diff[index * 3];
+                if(different){
+                    result.differentPixels++;
+                    out[0] = 255;
+                    out[1] = 0;
+                    out[2] = 0;
+                }
+                else{
+                    uint8_t grey = static_cast<uint8_t>(191 + (a[0] * 77 + a[1] * 150 + a[2] * 29) / 1024);
+                    out[0] = out[1] = out[2] = grey;
+                }
+            }
+        }
+        result.differentPercent = width * height > 0 ? 100.0 * result.differentPixels / (static_cast<double>(width) * height) : 0.0;
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,697 @@
+#ifndef BC_ENCODER_H
+#define BC_ENCODER_H
+
+#include <glad/glad.h>
+#include <GLExt/gl_ext.h>
+#include <Threading/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BC_ENCODER_SSE2
+#include <emmintrin.h>
+#endif
+
+// CPU block compression for the texture cooker. Everything here is plain CPU code (no GL
+// calls), so encode -> decode -> PSNR round trips run on machines without a GPU.
+//
+//   BC1  RGB, 4bpp            diffuse without alpha
+//   BC3  RGBA, 8bpp           diffuse with alpha (BC4 alpha block + BC1 colour block)
+//   BC4  one channel, 4bpp    greyscale specular, sampled through an RRR1 swizzle
+//   BC5  two channels, 8bpp   tangent space normals (xy, z rebuilt in the shader)
+//   BC7  RGBA, 8bpp           high quality, mode 6 only (one subset, 4 bit indices)
+
+namespace BC {
+
+    enum Format {
+        BC1,
+        BC3,
+        BC4,
+        BC5,
+        BC7
+    };
+
+    inline const char* name(Format format){
+        switch(format){
+            case BC1: return "BC1";
+            case BC3: return "BC3";
+            case BC4: return "BC4";
+            case BC5: return "BC5";
+            default: return "BC7";
+        }
+    }
+
+    inline size_t blockBytes(Format format){
+        return (format == BC1 || format == BC4) ? 8 : 16;
+    }
+
+    inline size_t compressedSize(Format format, uint32_t width, uint32_t height){
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+    }
+
+    inline GLenum glInternalFormat(Format format, bool srgb){
+        switch(format){
+            case BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case BC4: return GL_COMPRESSED_RED_RGTC1;
+            case BC5: return GL_COMPRESSED_RG_RGTC2;
+            default: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+        }
+    }
+
+    // which RGBA channels a format stores, for error metrics
+    inline unsigned int channelMask(Format format){
+        switch(format){
+            case BC1: return 0x7;
+            case BC4: return 0x1;
+            case BC5: return 0x3;
+            default: return 0xF;
+        }
+    }
+
+    // gathers a 4x4 RGBA block, clamping reads past the right / bottom edge
+    inline void fetchBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t block[64]){
+        for(uint32_t y = 0; y < 4; y++){
+            uint32_t sy = std::min(by * 4 + y, height - 1);
+            for(uint32_t x = 0; x < 4; x++){
+                uint32_t sx = std::min(bx * 4 + x, width - 1);
+                memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+            }
+        }
+    }
+
+    #pragma region BC1
+
+    inline uint16_t pack565(int r, int g, int b){
+        return static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+    }
+
+    inline void unpack565(uint16_t c, int rgb[3]){
+        int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // four colour palette of an opaque BC1 block, RGBA with alpha 0 so it drops out of distances
+    inline void bc1Palette(uint16_t c0, uint16_t c1, int palette[4][4]){
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        for(int c = 0; c < 3; c++){
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for(int i = 0; i < 4; i++){
+            palette[i][3] = 0;
+        }
+    }
+
+    // picks the nearest palette entry per pixel and returns the summed squared RGB error
+    inline int bc1Indices(const uint8_t block[64], const int palette[4][4], uint8_t indices[16]){
+#ifdef BC_ENCODER_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rgbMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        __m128i colors[4];
+        for(int i = 0; i < 4; i++){
+            colors[i] = _mm_set_epi16(0, palette[i][2], palette[i][1], palette[i][0], 0, palette[i][2], palette[i][1], palette[i][0]);
+        }
+        int error = 0;
+        for(int group = 0; group < 4; group++){
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + group * 16));
+            __m128i lo = _mm_and_si128(_mm_unpacklo_epi8(pixels, zero), rgbMask);
+            __m128i hi = _mm_and_si128(_mm_unpackhi_epi8(pixels, zero), rgbMask);
+            __m128i best = _mm_set1_epi32(0x7FFFFFFF);
+            __m128i bestIndex = zero;
+            for(int i = 0; i < 4; i++){
+                __m128i dlo = _mm_sub_epi16(lo, colors[i]);
+                __m128i dhi = _mm_sub_epi16(hi, colors[i]);
+                __m128 slo = _mm_castsi128_ps(_mm_madd_epi16(dlo, dlo));
+                __m128 shi = _mm_castsi128_ps(_mm_madd_epi16(dhi, dhi));
+                __m128i even = _mm_castps_si128(_mm_shuffle_ps(slo, shi, _MM_SHUFFLE(2, 0, 2, 0)));
+                __m128i odd = _mm_castps_si128(_mm_shuffle_ps(slo, shi, _MM_SHUFFLE(3, 1, 3, 1)));
+                __m128i distance = _mm_add_epi32(even, odd);
+                __m128i closer = _mm_cmplt_epi32(distance, best);
+                best = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, best));
+                bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(i)), _mm_andnot_si128(closer, bestIndex));
+            }
+            alignas(16) int distances[4];
+            alignas(16) int chosen[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(distances), best);
+            _mm_store_si128(reinterpret_cast<__m128i*>(chosen), bestIndex);
+            for(int p = 0; p < 4; p++){
+                indices[group * 4 + p] = static_cast<uint8_t>(chosen[p]);
+                error += distances[p];
+            }
+        }
+        return error;
+#else
+        int error = 0;
+        for(int p = 0; p < 16; p++){
+            int best = 0x7FFFFFFF;
+            for(int i = 0; i < 4; i++){
+                int dr = block[p * 4] - palette[i][0];
+                int dg = block[p * 4 + 1] - palette[i][1];
+                int db = block[p * 4 + 2] - palette[i][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if(distance < best){
+                    best = distance;
+                    indices[p] = static_cast<uint8_t>(i);
+                }
+            }
+            error += best;
+        }
+        return error;
+#endif
+    }
+
+    // principal axis of the block's colours (channels < count) by power iteration
+    inline void principalAxis(const float pixels[16][4], int count, float mean[4], float axis[4]){
+        for(int c = 0; c < 4; c++){
+            mean[c] = 0.0f;
+        }
+        for(int p = 0; p < 16; p++){
+            for(int c = 0; c < count; c++){
+                mean[c] += pixels[p][c] / 16.0f;
+            }
+        }
+        float cov[4][4] = {};
+        for(int p = 0; p < 16; p++){
+            float d[4] = {};
+            for(int c = 0; c < count; c++){
+                d[c] = pixels[p][c] - mean[c];
+            }
+            for(int i = 0; i < count; i++){
+                for(int j = 0; j < count; j++){
+                    cov[i][j] += d[i] * d[j];
+                }
+            }
+        }
+        float v[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for(int iteration = 0; iteration < 8; iteration++){
+            float next[4] = {};
+            for(int i = 0; i < count; i++){
+                for(int j = 0; j < count; j++){
+                    next[i] += cov[i][j] * v[j];
+                }
+            }
+            float length = 0.0f;
+            for(int c = 0; c < count; c++){
+                length = std::max(length, std::fabs(next[c]));
+            }
+            if(length < 1e-6f){
+                break;
+            }
+            for(int c = 0; c < count; c++){
+                v[c] = next[c] / length;
+            }
+        }
+        float length = 0.0f;
+        for(int c = 0; c < count; c++){
+            length += v[c] * v[c];
+        }
+        length = std::sqrt(length);
+        for(int c = 0; c < 4; c++){
+            axis[c] = c < count && length > 0.0f ? v[c] / length : 0.0f;
+        }
+    }
+
+    // endpoints at the extreme projections of the block onto its principal axis
+    inline void axisEndpoints(const float pixels[16][4], int count, float high[4], float low[4]){
+        float mean[4], axis[4];
+        principalAxis(pixels, count, mean, axis);
+        float minT = 1e30f, maxT = -1e30f;
+        for(int p = 0; p < 16; p++){
+            float t = 0.0f;
+            for(int c = 0; c < count; c++){
+                t += (pixels[p][c] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        for(int c = 0; c < 4; c++){
+            high[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+            low[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+        }
+    }
+
+    // least squares endpoints for fixed indices; weights[i] is the share of endpoint 0
+    inline bool refineEndpoints(const float pixels[16][4], int count, const uint8_t indices[16], const float* weights, float e0[4], float e1[4]){
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for(int p = 0; p < 16; p++){
+            float a = weights[indices[p]];
+            float b = 1.0f - a;
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            for(int c = 0; c < count; c++){
+                ax[c] += a * pixels[p][c];
+                bx[c] += b * pixels[p][c];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if(std::fabs(det) < 1e-6f){
+            return false;
+        }
+        for(int c = 0; c < count; c++){
+            e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / det, 0.0f, 255.0f);
+            e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / det, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    inline void encodeBC1(const uint8_t block[64], uint8_t out[8]){
+        float pixels[16][4];
+        for(int p = 0; p < 16; p++){
+            for(int c = 0; c < 4; c++){
+                pixels[p][c] = block[p * 4 + c];
+            }
+        }
+
+        float high[4], low[4];
+        axisEndpoints(pixels, 3, high, low);
+        uint16_t c0 = pack565(static_cast<int>(high[0] + 0.5f), static_cast<int>(high[1] + 0.5f), static_cast<int>(high[2] + 0.5f));
+        uint16_t c1 = pack565(static_cast<int>(low[0] + 0.5f), static_cast<int>(low[1] + 0.5f), static_cast<int>(low[2] + 0.5f));
+
+        int palette[4][4];
+        uint8_t indices[16];
+        bc1Palette(c0, c1, palette);
+        int error = bc1Indices(block, palette, indices);
+
+        // one least squares pass over the chosen indices usually recovers a few dB
+        const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        float e0[4], e1[4];
+        if(error > 0 && refineEndpoints(pixels, 3, indices, weights, e0, e1)){
+            uint16_t r0 = pack565(static_cast<int>(e0[0] + 0.5f), static_cast<int>(e0[1] + 0.5f), static_cast<int>(e0[2] + 0.5f));
+            uint16_t r1 = pack565(static_cast<int>(e1[0] + 0.5f), static_cast<int>(e1[1] + 0.5f), static_cast<int>(e1[2] + 0.5f));
+            int refinedPalette[4][4];
+            uint8_t refinedIndices[16];
+            bc1Palette(r0, r1, refinedPalette);
+            int refinedError = bc1Indices(block, refinedPalette, refinedIndices);
+            if(refinedError < error){
+                c0 = r0;
+                c1 = r1;
+                memcpy(indices, refinedIndices, 16);
+            }
+        }
+
+        // c0 > c1 selects the four colour mode, which BC3 colour blocks always use anyway
+        if(c0 < c1){
+            std::swap(c0, c1);
+            const uint8_t remap[4] = { 1, 0, 3, 2 };
+            for(int p = 0; p < 16; p++){
+                indices[p] = remap[indices[p]];
+            }
+        }
+        else if(c0 == c1){
+            memset(indices, 0, 16);
+        }
+
+        uint32_t bits = 0;
+        for(int p = 0; p < 16; p++){
+            bits |= static_cast<uint32_t>(indices[p]) << (p * 2);
+        }
+        out[0] = c0 & 0xFF;
+        out[1] = c0 >> 8;
+        out[2] = c1 & 0xFF;
+        out[3] = c1 >> 8;
+        out[4] = bits & 0xFF;
+        out[5] = (bits >> 8) & 0xFF;
+        out[6] = (bits >> 16) & 0xFF;
+        out[7] = bits >> 24;
+    }
+
+    inline void decodeBC1(const uint8_t in[8], uint8_t block[64]){
+        uint16_t c0 = in[0] | (in[1] << 8);
+        uint16_t c1 = in[2] | (in[3] << 8);
+        int palette[4][4];
+        bc1Palette(c0, c1, palette);
+        int alpha[4] = { 255, 255, 255, 255 };
+        if(c0 <= c1){
+            // three colour mode: 2 is the midpoint, 3 is transparent black
+            for(int c = 0; c < 3; c++){
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+            alpha[3] = 0;
+        }
+        uint32_t bits = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+        for(int p = 0; p < 16; p++){
+            int index = (bits >> (p * 2)) & 3;
+            block[p * 4] = static_cast<uint8_t>(palette[index][0]);
+            block[p * 4 + 1] = static_cast<uint8_t>(palette[index][1]);
+            block[p * 4 + 2] = static_cast<uint8_t>(palette[index][2]);
+            block[p * 4 + 3] = static_cast<uint8_t>(alpha[index]);
+        }
+    }
+
+    #pragma endregion
+
+    #pragma region BC4
+
+    inline void bc4Palette(int a0, int a1, int palette[8]){
+        palette[0] = a0;
+        palette[1] = a1;
+        if(a0 > a1){
+            for(int i = 1; i < 7; i++){
+                palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+            }
+        }
+        else{
+            for(int i = 1; i < 5; i++){
+                palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    // encodes one channel (stride 4 bytes apart, starting at block[channel]) into 8 bytes
+    inline void encodeBC4(const uint8_t block[64], int channel, uint8_t out[8]){
+        uint8_t values[16];
+        for(int p = 0; p < 16; p++){
+            values[p] = block[p * 4 + channel];
+        }
+#ifdef BC_ENCODER_SSE2
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+        __m128i lo = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+        __m128i hi = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+        lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+        hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+        lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 2));
+        hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 2));
+        lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 1));
+        hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 1));
+        int minValue = _mm_cvtsi128_si32(lo) & 0xFF;
+        int maxValue = _mm_cvtsi128_si32(hi) & 0xFF;
+#else
+        int minValue = 255, maxValue = 0;
+        for(int p = 0; p < 16; p++){
+            minValue = std::min<int>(minValue, values[p]);
+            maxValue = std::max<int>(maxValue, values[p]);
+        }
+#endif
+        out[0] = static_cast<uint8_t>(maxValue);
+        out[1] = static_cast<uint8_t>(minValue);
+        uint64_t bits = 0;
+        if(maxValue != minValue){
+            int palette[8];
+            bc4Palette(maxValue, minValue, palette);
+            for(int p = 0; p < 16; p++){
+                int best = 0x7FFFFFFF, index = 0;
+                for(int i = 0; i < 8; i++){
+                    int distance = std::abs(values[p] - palette[i]);
+                    if(distance < best){
+                        best = distance;
+                        index = i;
+                    }
+                }
+                bits |= static_cast<uint64_t>(index) << (p * 3);
+            }
+        }
+        for(int i = 0; i < 6; i++){
+            out[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+        }
+    }
+
+    inline void decodeBC4(const uint8_t in[8], int channel, uint8_t block[64]){
+        int palette[8];
+        bc4Palette(in[0], in[1], palette);
+        uint64_t bits = 0;
+        for(int i = 0; i < 6; i++){
+            bits |= static_cast<uint64_t>(in[2 + i]) << (i * 8);
+        }
+        for(int p = 0; p < 16; p++){
+            block[p * 4 + channel] = static_cast<uint8_t>(palette[(bits >> (p * 3)) & 7]);
+        }
+    }
+
+    #pragma endregion
+
+    #pragma region BC7
+
+    const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    inline int bc7Interpolate(int e0, int e1, int index){
+        return ((64 - BC7_WEIGHTS4[index]) * e0 + BC7_WEIGHTS4[index] * e1 + 32) >> 6;
+    }
+
+    // mode 6 endpoints are 7 bits per channel plus one shared p-bit per endpoint
+    inline void bc7Quantize(const float e[4], int pbit, int quantized[4]){
+        for(int c = 0; c < 4; c++){
+            int q = static_cast<int>(std::floor((e[c] - pbit) / 2.0f + 0.5f));
+            quantized[c] = std::clamp(q, 0, 127);
+        }
+    }
+
+    inline int bc7Indices(const uint8_t block[64], const int q0[4], const int q1[4], int p0, int p1, uint8_t indices[16]){
+        int palette[16][4];
+        for(int c = 0; c < 4; c++){
+            int e0 = (q0[c] << 1) | p0;
+            int e1 = (q1[c] << 1) | p1;
+            for(int i = 0; i < 16; i++){
+                palette[i][c] = bc7Interpolate(e0, e1, i);
+            }
+        }
+        int error = 0;
+        for(int p = 0; p < 16; p++){
+            int best = 0x7FFFFFFF;
+            for(int i = 0; i < 16; i++){
+                int distance = 0;
+                for(int c = 0; c < 4; c++){
+                    int d = block[p * 4 + c] - palette[i][c];
+                    distance += d * d;
+                }
+                if(distance < best){
+                    best = distance;
+                    indices[p] = static_cast<uint8_t>(i);
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+    struct BC7Mode6 {
+        int q0[4], q1[4];
+        int p0, p1;
+        uint8_t indices[16];
+        int error;
+    };
+
+    // tries all four p-bit combinations for a pair of float endpoints
+    inline BC7Mode6 bc7Fit(const uint8_t block[64], const float e0[4], const float e1[4]){
+        BC7Mode6 best;
+        best.error = 0x7FFFFFFF;
+        for(int p0 = 0; p0 < 2; p0++){
+            for(int p1 = 0; p1 < 2; p1++){
+                BC7Mode6 candidate;
+                candidate.p0 = p0;
+                candidate.p1 = p1;
+                bc7Quantize(e0, p0, candidate.q0);
+                bc7Quantize(e1, p1, candidate.q1);
+                candidate.error = bc7Indices(block, candidate.q0, candidate.q1, p0, p1, candidate.indices);
+                if(candidate.error < best.error){
+                    best = candidate;
+                }
+            }
+        }
+        return best;
+    }
+
+    struct BitWriter {
+        uint8_t* out;
+        int position = 0;
+
+        void put(uint32_t value, int count){
+            for(int i = 0; i < count; i++, position++){
+                if((value >> i) & 1){
+                    out[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+                }
+            }
+        }
+    };
+
+    struct BitReader {
+        const uint8_t* in;
+        int position = 0;
+
+        uint32_t get(int count){
+            uint32_t value = 0;
+            for(int i = 0; i < count; i++, position++){
+                value |= static_cast<uint32_t>((in[position >> 3] >> (position & 7)) & 1) << i;
+            }
+            return value;
+        }
+    };
+
+    inline void encodeBC7(const uint8_t block[64], uint8_t out[16]){
+        float pixels[16][4];
+        for(int p = 0; p < 16; p++){
+            for(int c = 0; c < 4; c++){
+                pixels[p][c] = block[p * 4 + c];
+            }
+        }
+        float e0[4], e1[4];
+        axisEndpoints(pixels, 4, e0, e1);
+        BC7Mode6 best = bc7Fit(block, e0, e1);
+
+        float weights[16];
+        for(int i = 0; i < 16; i++){
+            weights[i] = (64 - BC7_WEIGHTS4[i]) / 64.0f;
+        }
+        float r0[4], r1[4];
+        if(best.error > 0 && refineEndpoints(pixels, 4, best.indices, weights, r0, r1)){
+            BC7Mode6 refined = bc7Fit(block, r0, r1);
+            if(refined.error < best.error){
+                best = refined;
+            }
+        }
+
+        // the anchor (pixel 0) index is stored with its top bit implied zero
+        if(best.indices[0] & 8){
+            std::swap(best.q0, best.q1);
+            std::swap(best.p0, best.p1);
+            for(int p = 0; p < 16; p++){
+                best.indices[p] = static_cast<uint8_t>(15 - best.indices[p]);
+            }
+        }
+
+        memset(out, 0, 16);
+        BitWriter writer = { out };
+        writer.put(1 << 6, 7);
+        for(int c = 0; c < 4; c++){
+            writer.put(best.q0[c], 7);
+            writer.put(best.q1[c], 7);
+        }
+        writer.put(best.p0, 1);
+        writer.put(best.p1, 1);
+        writer.put(best.indices[0], 3);
+        for(int p = 1; p < 16; p++){
+            writer.put(best.indices[p], 4);
+        }
+    }
+
+    // decodes mode 6 blocks; other modes (never produced by encodeBC7) decode as magenta
+    inline void decodeBC7(const uint8_t in[16], uint8_t block[64]){
+        BitReader reader = { in };
+        if(reader.get(7) != (1 << 6)){
+            for(int p = 0; p < 16; p++){
+                block[p * 4] = 255;
+                block[p * 4 + 1] = 0;
+                block[p * 4 + 2] = 255;
+                block[p * 4 + 3] = 255;
+            }
+            return;
+        }
+        int q0[4], q1[4];
+        for(int c = 0; c < 4; c++){
+            q0[c] = reader.get(7);
+            q1[c] = reader.get(7);
+        }
+        int p0 = reader.get(1);
+        int p1 = reader.get(1);
+        for(int p = 0; p < 16; p++){
+            int index = reader.get(p == 0 ? 3 : 4);
+            for(int c = 0; c < 4; c++){
+                block[p * 4 + c] = static_cast<uint8_t>(bc7Interpolate((q0[c] << 1) | p0, (q1[c] << 1) | p1, index));
+            }
+        }
+    }
+
+    #pragma endregion
+
+    inline void encodeBlock(Format format, const uint8_t block[64], uint8_t* out){
+        switch(format){
+            case BC1: encodeBC1(block, out); break;
+            case BC3: encodeBC4(block, 3, out); encodeBC1(block, out + 8); break;
+            case BC4: encodeBC4(block, 0, out); break;
+            case BC5: encodeBC4(block, 0, out); encodeBC4(block, 1, out + 8); break;
+            case BC7: encodeBC7(block, out); break;
+        }
+    }
+
+    // decodes to RGBA the way GL samples it without swizzles (BC4 -> r001, BC5 -> rg01)
+    inline void decodeBlock(Format format, const uint8_t* in, uint8_t block[64]){
+        switch(format){
+            case BC1: decodeBC1(in, block); break;
+            case BC3: decodeBC1(in + 8, block); decodeBC4(in, 3, block); break;
+            case BC4:
+            case BC5:
+                for(int p = 0; p < 16; p++){
+                    block[p * 4 + 1] = 0;
+                    block[p * 4 + 2] = 0;
+                    block[p * 4 + 3] = 255;
+                }
+                decodeBC4(in, 0, block);
+                if(format == BC5){
+                    decodeBC4(in + 8, 1, block);
+                }
+                break;
+            case BC7: decodeBC7(in, block); break;
+        }
+    }
+
+    // compresses a tightly packed RGBA8 image, block rows are spread across threads
+    inline std::vector<uint8_t> encodeImage(const uint8_t* rgba, uint32_t width, uint32_t height, Format format){
+        uint32_t blocksX = (width + 3) / 4;
+        uint32_t blocksY = (height + 3) / 4;
+        size_t stride = blockBytes(format);
+        std::vector<uint8_t> out(static_cast<size_t>(blocksX) * blocksY * stride);
+        parallelFor(blocksY, [&](size_t begin, size_t end){
+            uint8_t block[64];
+            for(size_t by = begin; by < end; by++){
+                for(uint32_t bx = 0; bx < blocksX; bx++){
+                    fetchBlock(rgba, width, height, bx, static_cast<uint32_t>(by), block);
+                    encodeBlock(format, block, out.data() + (by * blocksX + bx) * stride);
+                }
+            }
+        }, 4);
+        return out;
+    }
+
+    inline std::vector<uint8_t> decodeImage(const uint8_t* data, uint32_t width, uint32_t height, Format format){
+        uint32_t blocksX = (width + 3) / 4;
+        uint32_t blocksY = (height + 3) / 4;
+        size_t stride = blockBytes(format);
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        uint8_t block[64];
+        for(uint32_t by = 0; by < blocksY; by++){
+            for(uint32_t bx = 0; bx < blocksX; bx++){
+                decodeBlock(format, data + (static_cast<size_t>(by) * blocksX + bx) * stride, block);
+                for(uint32_t y = 0; y < 4 && by * 4 + y < height; y++){
+                    for(uint32_t x = 0; x < 4 && bx * 4 + x < width; x++){
+                        memcpy(&rgba[((static_cast<size_t>(by) * 4 + y) * width + bx * 4 + x) * 4], block + (y * 4 + x) * 4, 4);
+                    }
+                }
+            }
+        }
+        return rgba;
+    }
+
+    // PSNR in dB over the channels in mask; 99 for a lossless match
+    inline double psnr(const uint8_t* a, const uint8_t* b, uint32_t width, uint32_t height, unsigned int mask){
+        double sum = 0.0;
+        size_t samples = 0;
+        for(size_t p = 0; p < static_cast<size_t>(width) * height; p++){
+            for(int c = 0; c < 4; c++){
+                if(mask & (1u << c)){
+                    double d = static_cast<double>(a[p * 4 + c]) - b[p * 4 + c];
+                    sum += d * d;
+                    samples++;
+                }
+            }
+        }
+        if(samples == 0 || sum == 0.0){
+            return 99.0;
+        }
+        double mse = sum / samples;
+        return 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Decoded 8 bit image shared by the decoders in image_decoder.h.
+
+namespace ImageDecode {
+
+    struct Image {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        int channels = 0;               // channels in pixels
+        int sourceChannels = 0;         // channels stored in the file
+        std::vector<uint8_t> pixels;    // tightly packed rows, top row first
+        const char* decoder = "";       // name of the decoder that produced it
+    };
+
+    // same weights stb_image uses, so both paths agree on greyscale output
+    inline uint8_t luminance(uint8_t r, uint8_t g, uint8_t b){
+        return static_cast<uint8_t>((r * 77 + g * 150 + b * 29) >> 8);
+    }
+
+    // converts count pixels between 1 (grey), 2 (grey alpha), 3 (RGB) and 4 (RGBA) channels
+    inline void convertChannels(const uint8_t* src, int srcChannels, uint8_t* dst, int dstChannels, size_t count){
+        for(size_t i = 0; i < count; i++, src += srcChannels, dst += dstChannels){
+            uint8_t r, g, b, a;
+            if(srcChannels <= 2){
+                r = g = b = src[0];
+                a = srcChannels == 2 ? src[1] : 255;
+            }
+            else{
+                r = src[0];
+                g = src[1];
+                b = src[2];
+                a = srcChannels == 4 ? src[3] : 255;
+            }
+            switch(dstChannels){
+                case 1:
+                    dst[0] = srcChannels <= 2 ? r : luminance(r, g, b);
+                    break;
+                case 2:
+                    dst[0] = srcChannels <= 2 ? r : luminance(r, g, b);
+                    dst[1] = a;
+                    break;
+                case 3:
+                    dst[0] = r;
+                    dst[1] = g;
+                    dst[2] = b;
+                    break;
+                default:
+                    dst[0] = r;
+                    dst[1] = g;
+                    dst[2] = b;
+                    dst[3] = a;
+                    break;
+            }
+        }
+    }
+}
+
+#endif
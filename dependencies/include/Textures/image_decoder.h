@@ -0,0 +1,128 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <FileIO/mapped_file.h>
+#include <StbImage/stb_image.h>
+#include <Textures/image.h>
+#include <Textures/jpeg_decoder.h>
+#include <Textures/png_decoder.h>
+#include <Threading/parallel_for.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Pluggable image decoding. Decoders are tried in registration order: the first one that
+// recognises the data and supports its variant wins, and stb_image sits at the end of the
+// list as the fallback for every format and variant the fast paths skip (progressive JPEG,
+// 16 bit or interlaced PNG, TGA, BMP, ...).
+//
+//   ImageDecode::Image image;
+//   if(ImageDecode::decodeFile(path, image, 4)){ ... image.pixels ... }
+
+namespace ImageDecode {
+
+    struct Options {
+        int desiredChannels = 0;        // 0 keeps the file's channel count
+        bool allowSimd = true;
+        bool parallel = true;           // split one image across threads where the format allows it
+        const char* only = NULL;        // restrict to one decoder by name, for benchmarks
+    };
+
+    typedef bool (*DecodeFunction)(const uint8_t* data, size_t size, const Options &options, Image &image);
+
+    struct Decoder {
+        const char* name;
+        DecodeFunction decode;
+    };
+
+    inline bool decodePng(const uint8_t* data, size_t size, const Options &options, Image &image){
+        return Png::decode(data, size, options.desiredChannels, image, options.allowSimd);
+    }
+
+    inline bool decodeJpeg(const uint8_t* data, size_t size, const Options &options, Image &image){
+        return Jpeg::decode(data, size, options.desiredChannels, image, options.allowSimd, options.parallel);
+    }
+
+    inline bool decodeStb(const uint8_t* data, size_t size, const Options &options, Image &image){
+        int width, height, channels;
+        unsigned char* pixels = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channels, options.desiredChannels);
+        if(pixels == NULL){
+            return false;
+        }
+        int stored = options.desiredChannels == 0 ? channels : options.desiredChannels;
+        image.width = width;
+        image.height = height;
+        image.channels = stored;
+        image.sourceChannels = channels;
+        image.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * stored);
+        image.decoder = "stb";
+        stbi_image_free(pixels);
+        return true;
+    }
+
+    inline std::vector<Decoder>& decoders(){
+        static std::vector<Decoder> list = {
+            { "png", decodePng },
+            { "jpeg", decodeJpeg },
+            { "stb", decodeStb }
+        };
+        return list;
+    }
+
+    // new decoders go ahead of the stb fallback
+    inline void registerDecoder(const Decoder &decoder){
+        std::vector<Decoder> &list = decoders();
+        list.insert(list.end() - 1, decoder);
+    }
+
+    inline bool decode(const uint8_t* data, size_t size, Image &image, const Options &options = Options()){
+        for(const Decoder &decoder : decoders()){
+            if(options.only != NULL && strcmp(options.only, decoder.name) != 0){
+                continue;
+            }
+            if(decoder.decode(data, size, options, image)){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline bool decodeFile(const std::string &path, Image &image, const Options &options = Options()){
+        MappedFile file;
+        if(!file.open(path)){
+            return false;
+        }
+        return decode(file.data(), file.size(), image, options);
+    }
+
+    inline bool decodeFile(const std::string &path, Image &image, int desiredChannels){
+        Options options;
+        options.desiredChannels = desiredChannels;
+        return decodeFile(path, image, options);
+    }
+
+    // decodes files on separate threads, each image single threaded; failed entries come
+    // back with no pixels
+    inline std::vector<Image> decodeFiles(const std::vector<std::string> &paths, const Options &options = Options()){
+        std::vector<Image> images(paths.size());
+        Options perImage = options;
+        perImage.parallel = false;
+        parallelFor(paths.size(), [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                if(!decodeFile(paths[i], images[i], perImage)){
+                    images[i] = Image();
+                }
+            }
+        });
+        return images;
+    }
+
+    // stb keeps the last error, the fast decoders only report through their return value
+    inline const char* failureReason(){
+        const char* reason = stbi_failure_reason();
+        return reason != NULL ? reason : "unsupported or corrupt image";
+    }
+}
+
+#endif
@@ -0,0 +1,808 @@
+#ifndef JPEG_DECODER_H
+#define JPEG_DECODER_H
+
+#include <Simd/cpu_features.h>
+#include <Textures/image.h>
+#include <Threading/parallel_for.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Baseline JPEG decoder (huffman, 8 bit, grey or YCbCr with 1x1, 2x1 or 2x2 luma sampling).
+// Progressive, arithmetic coded, 12 bit, CMYK and multi scan files return false and are left
+// to the stb fallback.
+//
+//  - entropy decoding splits at restart markers: each restart interval resets the DC
+//    predictors, so intervals decode on separate threads straight into the component planes
+//  - IDCT is the AAN float transform with the scale factors folded into the dequantisation
+//    table, run on four columns at a time with SSE2; DC only blocks skip it
+//  - chroma is upsampled with the same triangle filter stb uses and converted to RGB eight
+//    pixels at a time in 16 bit fixed point, rows split across threads
+
+namespace Jpeg {
+
+    // natural order index of each zigzag position, padded so a corrupt run can't index past it
+    const uint8_t ZIGZAG[64 + 16] = {
+        0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+        12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+        35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+        58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+        63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63
+    };
+
+    const int FAST_BITS = 9;
+
+    #pragma region Entropy decoding
+
+    struct Huffman {
+        uint8_t fast[1 << FAST_BITS];   // index into symbols, 255 when the code is longer than FAST_BITS
+        uint8_t symbols[256];
+        uint8_t sizes[257];
+        uint16_t codes[256];
+        uint32_t maxCode[18];           // one past the last code of each length, left aligned to 16 bits
+        int delta[17];                  // symbol index minus code for each length
+        int32_t fastAc[1 << FAST_BITS]; // AC code and magnitude in one lookup: value << 8 | run << 4 | bits, 0 if they don't fit
+
+        bool build(const uint8_t counts[16], const uint8_t* values){
+            int k = 0;
+            for(int i = 0; i < 16; i++){
+                for(int j = 0; j < counts[i]; j++){
+                    if(k >= 256){
+                        return false;
+                    }
+                    symbols[k] = values[k];
+                    sizes[k++] = static_cast<uint8_t>(i + 1);
+                }
+            }
+            sizes[k] = 0;
+
+            int code = 0;
+            k = 0;
+            for(int length = 1; length <= 16; length++){
+                delta[length] = k - code;
+                while(sizes[k] == length){
+                    codes[k++] = static_cast<uint16_t>(code++);
+                }
+                if(code - 1 >= (1 << length)){
+                    return false;
+                }
+                maxCode[length] = static_cast<uint32_t>(code) << (16 - length);
+                code <<= 1;
+            }
+            maxCode[17] = 0xFFFFFFFF;
+
+            memset(fast, 255, sizeof(fast));
+            for(int i = 0; i < k; i++){
+                int length = sizes[i];
+                if(length <= FAST_BITS){
+                    int first = codes[i] << (FAST_BITS - length);
+                    for(int j = 0; j < (1 << (FAST_BITS - length)); j++){
+                        fast[first + j] = static_cast<uint8_t>(i);
+                    }
+                }
+            }
+
+            // only meaningful for AC tables, cheap enough to build for all
+            for(int i = 0; i < (1 << FAST_BITS); i++){
+                fastAc[i] = 0;
+                if(fast[i] == 255){
+                    continue;
+                }
+                int rs = symbols[fast[i]];
+                int run = rs >> 4;
+                int size = rs & 15;
+                int length = sizes[fast[i]];
+                if(size == 0 || length + size > FAST_BITS){
+                    continue;
+                }
+                int value = ((i << length) & ((1 << FAST_BITS) - 1)) >> (FAST_BITS - size);
+                if(value < (1 << (size - 1))){
+                    value -= (1 << size) - 1;
+                }
+                fastAc[i] = static_cast<int32_t>(value * 256 + run * 16 + length + size);
+            }
+            return true;
+        }
+    };
+
+    inline uint64_t byteSwap(uint64_t value){
+#if defined(_MSC_VER) && !defined(__clang__)
+        return _byteswap_uint64(value);
+#else
+        return __builtin_bswap64(value);
+#endif
+    }
+
+    // JPEG packs bits MSB first and stuffs a zero after every 0xFF data byte
+    struct BitReader {
+        const uint8_t* p;
+        const uint8_t* end;
+        uint64_t bits = 0;
+        int count = 0;
+
+        BitReader(const uint8_t* begin, const uint8_t* end) : p(begin), end(end){}
+
+        void refill(){
+            if(end - p >= 8){
+                // eight bytes without a 0xFF can go in at once
+                uint64_t word;
+                memcpy(&word, p, 8);
+                uint64_t inverted = ~word;
+                if(((inverted - 0x0101010101010101ull) & ~inverted & 0x8080808080808080ull) == 0){
+                    int bytes = (64 - count) >> 3;
+                    bits |= byteSwap(word) >> count;
+                    p += bytes;
+                    count += bytes * 8;
+                    return;
+                }
+            }
+            while(count <= 56){
+                uint32_t byte = 0;
+                if(p < end){
+                    byte = *p++;
+                    if(byte == 0xFF){
+                        if(p < end && *p == 0){
+                            p++;
+                        }
+                        else{
+                            // a marker, pad with zeros from here on
+                            p = end;
+                            byte = 0;
+                        }
+                    }
+                }
+                bits |= static_cast<uint64_t>(byte) << (56 - count);
+                count += 8;
+            }
+        }
+
+        int decode(const Huffman &h){
+            if(count < 16){
+                refill();
+            }
+            int index = h.fast[bits >> (64 - FAST_BITS)];
+            if(index < 255){
+                int length = h.sizes[index];
+                bits <<= length;
+                count -= length;
+                return h.symbols[index];
+            }
+            uint32_t top = static_cast<uint32_t>(bits >> 48);
+            int length = FAST_BITS + 1;
+            while(top >= h.maxCode[length]){
+                length++;
+            }
+            if(length > 16){
+                return -1;
+            }
+            int symbol = static_cast<int>(bits >> (64 - length)) + h.delta[length];
+            if(symbol < 0 || symbol >= 256 || h.sizes[symbol] != length){
+                return -1;
+            }
+            bits <<= length;
+            count -= length;
+            return h.symbols[symbol];
+        }
+
+        // reads a magnitude category of size bits and sign extends it
+        int receiveExtend(int size){
+            if(size == 0){
+                return 0;
+            }
+            if(count < size){
+                refill();
+            }
+            int value = static_cast<int>(bits >> (64 - size));
+            bits <<= size;
+            count -= size;
+            return value < (1 << (size - 1)) ? value - (1 << size) + 1 : value;
+        }
+    };
+
+    // returns the zigzag position of the last non zero coefficient, or -1 on corrupt data
+    inline int decodeBlock(BitReader &reader, int16_t coefficients[64], const Huffman &dc, const Huffman &ac, int &predictor){
+        memset(coefficients, 0, 64 * sizeof(int16_t));
+        int category = reader.decode(dc);
+        if(category < 0 || category > 15){
+            return -1;
+        }
+        predictor += reader.receiveExtend(category);
+        coefficients[0] = static_cast<int16_t>(predictor);
+
+        int last = 0;
+        int k = 1;
+        while(k < 64){
+            if(reader.count < 16){
+                reader.refill();
+            }
+            int32_t fast = ac.fastAc[reader.bits >> (64 - FAST_BITS)];
+            if(fast != 0){
+                k += (fast >> 4) & 15;
+                if(k > 63){
+                    return -1;
+                }
+                int length = fast & 15;
+                reader.bits <<= length;
+                reader.count -= length;
+                coefficients[ZIGZAG[k]] = static_cast<int16_t>(fast >> 8);
+                last = k++;
+                continue;
+            }
+            int rs = reader.decode(ac);
+            if(rs < 0){
+                return -1;
+            }
+            int run = rs >> 4;
+            int size = rs & 15;
+            if(size == 0){
+                if(rs != 0xF0){
+                    break;
+                }
+                k += 16;
+                continue;
+            }
+            k += run;
+            if(k > 63){
+                return -1;
+            }
+            coefficients[ZIGZAG[k]] = static_cast<int16_t>(reader.receiveExtend(size));
+            last = k++;
+        }
+        return last;
+    }
+
+    #pragma endregion
+
+    #pragma region IDCT
+
+    // AAN scale factors, folded into the dequantisation table with the final divide by 8
+    inline void scaleQuantTable(const uint16_t natural[64], float scaled[64]){
+        double aan[8];
+        aan[0] = 1.0;
+        for(int k = 1; k < 8; k++){
+            aan[k] = std::cos(k * 3.14159265358979323846 / 16.0) * std::sqrt(2.0);
+        }
+        for(int v = 0; v < 8; v++){
+            for(int u = 0; u < 8; u++){
+                scaled[v * 8 + u] = static_cast<float>(natural[v * 8 + u] * aan[v] * aan[u] / 8.0);
+            }
+        }
+    }
+
+    inline float add(float a, float b){ return a + b; }
+    inline float sub(float a, float b){ return a - b; }
+    inline float mul(float a, float b){ return a * b; }
+#ifdef SIMD_SSE2
+    inline __m128 add(__m128 a, __m128 b){ return _mm_add_ps(a, b); }
+    inline __m128 sub(__m128 a, __m128 b){ return _mm_sub_ps(a, b); }
+    inline __m128 mul(__m128 a, __m128 b){ return _mm_mul_ps(a, b); }
+#endif
+
+    // one 8 point AAN pass (jidctflt), T is float or __m128
+    template<typename T>
+    inline void idct8(T &i0, T &i1, T &i2, T &i3, T &i4, T &i5, T &i6, T &i7,
+                      const T &sqrt2, const T &c1847, const T &c1082, const T &c2613){
+        T tmp10 = add(i0, i4);
+        T tmp11 = sub(i0, i4);
+        T tmp13 = add(i2, i6);
+        T tmp12 = sub(mul(sub(i2, i6), sqrt2), tmp13);
+        T tmp0 = add(tmp10, tmp13);
+        T tmp3 = sub(tmp10, tmp13);
+        T tmp1 = add(tmp11, tmp12);
+        T tmp2 = sub(tmp11, tmp12);
+
+        T z13 = add(i5, i3);
+        T z10 = sub(i5, i3);
+        T z11 = add(i1, i7);
+        T z12 = sub(i1, i7);
+        T tmp7 = add(z11, z13);
+        T tmp11b = mul(sub(z11, z13), sqrt2);
+        T z5 = mul(add(z10, z12), c1847);
+        T tmp10b = sub(mul(z12, c1082), z5);
+        T tmp12b = sub(z5, mul(z10, c2613));
+        T tmp6 = sub(tmp12b, tmp7);
+        T tmp5 = sub(tmp11b, tmp6);
+        T tmp4 = add(tmp10b, tmp5);
+
+        i0 = add(tmp0, tmp7);
+        i7 = sub(tmp0, tmp7);
+        i1 = add(tmp1, tmp6);
+        i6 = sub(tmp1, tmp6);
+        i2 = add(tmp2, tmp5);
+        i5 = sub(tmp2, tmp5);
+        i4 = add(tmp3, tmp4);
+        i3 = sub(tmp3, tmp4);
+    }
+
+    inline uint8_t clampByte(float value){
+        int rounded = static_cast<int>(std::lround(value));
+        return static_cast<uint8_t>(rounded < 0 ? 0 : rounded > 255 ? 255 : rounded);
+    }
+
+    inline void idctScalar(const int16_t coefficients[64], const float quant[64], uint8_t* out, size_t stride){
+        float block[64];
+        for(int i = 0; i < 64; i++){
+            block[i] = coefficients[i] * quant[i];
+        }
+        const float sqrt2 = 1.414213562f, c1847 = 1.847759065f, c1082 = 1.082392200f, c2613 = 2.613125930f;
+        for(int u = 0; u < 8; u++){
+            float* c = block + u;
+            idct8(c[0], c[8], c[16], c[24], c[32], c[40], c[48], c[56], sqrt2, c1847, c1082, c2613);
+        }
+        for(int y = 0; y < 8; y++){
+            float* r = block + y * 8;
+            idct8(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], sqrt2, c1847, c1082, c2613);
+            for(int x = 0; x < 8; x++){
+                out[y * stride + x] = clampByte(r[x] + 128.0f);
+            }
+        }
+    }
+
+#ifdef SIMD_SSE2
+    inline void transpose8x8(__m128 rows[8][2]){
+        _MM_TRANSPOSE4_PS(rows[0][0], rows[1][0], rows[2][0], rows[3][0]);
+        _MM_TRANSPOSE4_PS(rows[0][1], rows[1][1], rows[2][1], rows[3][1]);
+        _MM_TRANSPOSE4_PS(rows[4][0], rows[5][0], rows[6][0], rows[7][0]);
+        _MM_TRANSPOSE4_PS(rows[4][1], rows[5][1], rows[6][1], rows[7][1]);
+        for(int i = 0; i < 4; i++){
+            __m128 swap = rows[i][1];
+            rows[i][1] = rows[i + 4][0];
+            rows[i + 4][0] = swap;
+        }
+    }
+
+    // rows[y][half] holds columns half * 4 .. half * 4 + 3 of row y
+    inline void idctSse2(const int16_t coefficients[64], const float quant[64], uint8_t* out, size_t stride){
+        const __m128 sqrt2 = _mm_set1_ps(1.414213562f), c1847 = _mm_set1_ps(1.847759065f);
+        const __m128 c1082 = _mm_set1_ps(1.082392200f), c2613 = _mm_set1_ps(2.613125930f);
+        __m128 rows[8][2];
+        for(int y = 0; y < 8; y++){
+            __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients + y * 8));
+            __m128i sign = _mm_srai_epi16(packed, 15);
+            rows[y][0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, sign)), _mm_loadu_ps(quant + y * 8));
+            rows[y][1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(packed, sign)), _mm_loadu_ps(quant + y * 8 + 4));
+        }
+        // columns, then rows of the transposed block, then back
+        for(int half = 0; half < 2; half++){
+            idct8(rows[0][half], rows[1][half], rows[2][half], rows[3][half], rows[4][half], rows[5][half], rows[6][half], rows[7][half],
+                  sqrt2, c1847, c1082, c2613);
+        }
+        transpose8x8(rows);
+        for(int half = 0; half < 2; half++){
+            idct8(rows[0][half], rows[1][half], rows[2][half], rows[3][half], rows[4][half], rows[5][half], rows[6][half], rows[7][half],
+                  sqrt2, c1847, c1082, c2613);
+        }
+        transpose8x8(rows);
+
+        const __m128 bias = _mm_set1_ps(128.0f);
+        for(int y = 0; y < 8; y++){
+            __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(_mm_add_ps(rows[y][0], bias)), _mm_cvtps_epi32(_mm_add_ps(rows[y][1], bias)));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + y * stride), _mm_packus_epi16(words, words));
+        }
+    }
+#endif
+
+    inline void idct(const int16_t coefficients[64], int last, const float quant[64], uint8_t* out, size_t stride, bool allowSimd){
+        if(last == 0){
+            // DC only, the block is flat
+            uint8_t value = clampByte(coefficients[0] * quant[0] + 128.0f);
+            for(int y = 0; y < 8; y++){
+                memset(out + y * stride, value, 8);
+            }
+            return;
+        }
+#ifdef SIMD_SSE2
+        if(allowSimd){
+            idctSse2(coefficients, quant, out, stride);
+            return;
+        }
+#endif
+        (void)allowSimd;
+        idctScalar(coefficients, quant, out, stride);
+    }
+
+    #pragma endregion
+
+    #pragma region Colour
+
+    // fixed point YCbCr -> RGB, chroma is pre-shifted by 4 and the weights scaled by 4096 so
+    // both paths compute (c * 16 * weight) >> 16 and agree bit for bit
+    const int16_t CR_R = 5743;      // 1.402
+    const int16_t CB_G = 1410;      // 0.344136
+    const int16_t CR_G = 2925;      // 0.714136
+    const int16_t CB_B = 7258;      // 1.772
+
+    inline uint8_t clamp255(int value){
+        return static_cast<uint8_t>(value < 0 ? 0 : value > 255 ? 255 : value);
+    }
+
+    inline void ycbcrToRgbScalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, uint8_t* out, int channels, size_t count){
+        for(size_t i = 0; i < count; i++, out += channels){
+            int b16 = (cb[i] - 128) * 16;
+            int r16 = (cr[i] - 128) * 16;
+            out[0] = clamp255(y[i] + ((r16 * CR_R) >> 16));
+            out[1] = clamp255(y[i] - ((b16 * CB_G) >> 16) - ((r16 * CR_G) >> 16));
+            out[2] = clamp255(y[i] + ((b16 * CB_B) >> 16));
+            if(channels == 4){
+                out[3] = 255;
+            }
+        }
+    }
+
+#ifdef SIMD_SSE2
+    // eight pixels per step, written as RGBA; RGB rows go through the scalar path
+    inline void ycbcrToRgbaSse2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, uint8_t* out, size_t count){
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(128);
+        const __m128i crR = _mm_set1_epi16(CR_R), cbG = _mm_set1_epi16(CB_G), crG = _mm_set1_epi16(CR_G), cbB = _mm_set1_epi16(CB_B);
+        const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8){
+            __m128i yy = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + i)), zero);
+            __m128i bb = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cb + i)), zero), bias), 4);
+            __m128i rr = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cr + i)), zero), bias), 4);
+            __m128i r = _mm_add_epi16(yy, _mm_mulhi_epi16(rr, crR));
+            __m128i g = _mm_sub_epi16(_mm_sub_epi16(yy, _mm_mulhi_epi16(bb, cbG)), _mm_mulhi_epi16(rr, crG));
+            __m128i b = _mm_add_epi16(yy, _mm_mulhi_epi16(bb, cbB));
+            __m128i r8 = _mm_packus_epi16(r, r);
+            __m128i g8 = _mm_packus_epi16(g, g);
+            __m128i b8 = _mm_packus_epi16(b, b);
+            __m128i rg = _mm_unpacklo_epi8(r8, g8);
+            __m128i ba = _mm_unpacklo_epi8(b8, alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_unpacklo_epi16(rg, ba));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+        }
+        ycbcrToRgbScalar(y + i, cb + i, cr + i, out + i * 4, 4, count - i);
+    }
+#endif
+
+    // triangle filter upsampling, matches stb_image's h2v1 and h2v2 resamplers
+    inline void upsampleRow(const uint8_t* near, const uint8_t* far, uint8_t* out, uint32_t inputWidth, int horizontal, bool vertical){
+        if(horizontal == 1 && !vertical){
+            memcpy(out, near, inputWidth);
+            return;
+        }
+        if(inputWidth == 1){
+            out[0] = out[1] = vertical ? static_cast<uint8_t>((3 * near[0] + far[0] + 2) >> 2) : near[0];
+            return;
+        }
+        if(!vertical){
+            out[0] = near[0];
+            out[1] = static_cast<uint8_t>((near[0] * 3 + near[1] + 2) >> 2);
+            uint32_t i = 1;
+            for(; i < inputWidth - 1; i++){
+                int n = 3 * near[i] + 2;
+                out[i * 2] = static_cast<uint8_t>((n + near[i - 1]) >> 2);
+                out[i * 2 + 1] = static_cast<uint8_t>((n + near[i + 1]) >> 2);
+            }
+            out[i * 2] = static_cast<uint8_t>((near[inputWidth - 2] * 3 + near[inputWidth - 1] + 2) >> 2);
+            out[i * 2 + 1] = near[inputWidth - 1];
+            return;
+        }
+        int t1 = 3 * near[0] + far[0];
+        out[0] = static_cast<uint8_t>((t1 + 2) >> 2);
+        for(uint32_t i = 1; i < inputWidth; i++){
+            int t0 = t1;
+            t1 = 3 * near[i] + far[i];
+            out[i * 2 - 1] = static_cast<uint8_t>((3 * t0 + t1 + 8) >> 4);
+            out[i * 2] = static_cast<uint8_t>((3 * t1 + t0 + 8) >> 4);
+        }
+        out[inputWidth * 2 - 1] = static_cast<uint8_t>((t1 + 2) >> 2);
+    }
+
+    #pragma endregion
+
+    struct Component {
+        int id = 0;
+        int h = 1, v = 1;
+        int quant = 0;
+        int dc = 0, ac = 0;
+        uint32_t width = 0;         // samples actually covered by the image
+        uint32_t height = 0;
+        size_t stride = 0;          // plane size, padded to whole MCUs
+        std::vector<uint8_t> plane;
+    };
+
+    inline bool isJpeg(const uint8_t* data, size_t size){
+        return size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+    }
+
+    // desiredChannels 0 keeps the file's channel count
+    inline bool decode(const uint8_t* data, size_t size, int desiredChannels, ImageDecode::Image &image, bool allowSimd = true, bool parallel = true){
+        if(!isJpeg(data, size)){
+            return false;
+        }
+        Huffman dcTables[4], acTables[4];
+        uint16_t quantTables[4][64] = { { 0 } };
+        uint32_t width = 0, height = 0;
+        uint32_t restartInterval = 0;
+        std::vector<Component> components;
+        bool haveFrame = false;
+
+        // header segments up to the start of scan
+        size_t offset = 2;
+        const uint8_t* scan = NULL;
+        while(scan == NULL){
+            while(offset < size && data[offset] != 0xFF){
+                offset++;
+            }
+            while(offset < size && data[offset] == 0xFF){
+                offset++;
+            }
+            if(offset + 2 >= size){
+                return false;
+            }
+            int marker = data[offset++];
+            size_t length = (static_cast<size_t>(data[offset]) << 8) | data[offset + 1];
+            if(length < 2 || offset + length > size){
+                return false;
+            }
+            const uint8_t* body = data + offset + 2;
+            size_t bodyLength = length - 2;
+            offset += length;
+
+            if(marker == 0xC0 || marker == 0xC1){
+                if(bodyLength < 6 || body[0] != 8){
+                    return false;
+                }
+                height = (body[1] << 8) | body[2];
+                width = (body[3] << 8) | body[4];
+                int count = body[5];
+                if(width == 0 || height == 0 || (count != 1 && count != 3) || bodyLength < 6 + static_cast<size_t>(count) * 3){
+                    return false;
+                }
+                components.resize(count);
+                for(int i = 0; i < count; i++){
+                    components[i].id = body[6 + i * 3];
+                    components[i].h = body[7 + i * 3] >> 4;
+                    components[i].v = body[7 + i * 3] & 15;
+                    components[i].quant = body[8 + i * 3] & 3;
+                }
+                haveFrame = true;
+            }
+            else if((marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)){
+                return false;
+            }
+            else if(marker == 0xC4){
+                size_t p = 0;
+                while(p + 17 <= bodyLength){
+                    int tableClass = body[p] >> 4;
+                    int index = body[p] & 15;
+                    const uint8_t* counts = body + p + 1;
+                    int total = 0;
+                    for(int i = 0; i < 16; i++){
+                        total += counts[i];
+                    }
+                    if(index > 3 || tableClass > 1 || total > 256 || p + 17 + total > bodyLength){
+                        return false;
+                    }
+                    Huffman &table = tableClass == 0 ? dcTables[index] : acTables[index];
+                    if(!table.build(counts, body + p + 17)){
+                        return false;
+                    }
+                    p += 17 + total;
+                }
+            }
+            else if(marker == 0xDB){
+                size_t p = 0;
+                while(p < bodyLength){
+                    int precision = body[p] >> 4;
+                    int index = body[p] & 15;
+                    size_t tableBytes = precision ? 128 : 64;
+                    if(index > 3 || p + 1 + tableBytes > bodyLength){
+                        return false;
+                    }
+                    for(int k = 0; k < 64; k++){
+                        quantTables[index][ZIGZAG[k]] = precision ? static_cast<uint16_t>((body[p + 1 + k * 2] << 8) | body[p + 2 + k * 2]) : body[p + 1 + k];
+                    }
+                    p += 1 + tableBytes;
+                }
+            }
+            else if(marker == 0xDD){
+                if(bodyLength < 2){
+                    return false;
+                }
+                restartInterval = (body[0] << 8) | body[1];
+            }
+            else if(marker == 0xEE){
+                // Adobe APP14 with transform 0 means the channels are RGB, not YCbCr
+                if(bodyLength >= 12 && memcmp(body, "Adobe", 5) == 0 && body[11] == 0 && components.size() != 1){
+                    return false;
+                }
+            }
+            else if(marker == 0xDA){
+                if(!haveFrame || bodyLength < 1 || body[0] != components.size() || bodyLength < 4 + components.size() * 2){
+                    return false;
+                }
+                for(size_t i = 0; i < components.size(); i++){
+                    int id = body[1 + i * 2];
+                    int tables = body[2 + i * 2];
+                    Component* component = NULL;
+                    for(Component &c : components){
+                        component = c.id == id ? &c : component;
+                    }
+                    if(component == NULL || (tables >> 4) > 3 || (tables & 15) > 3){
+                        return false;
+                    }
+                    component->dc = tables >> 4;
+                    component->ac = tables & 15;
+                }
+                scan = data + offset;
+            }
+            else if(marker == 0xD9){
+                return false;
+            }
+        }
+
+        // grey images are coded non interleaved, one block per MCU whatever the sampling says
+        if(components.size() == 1){
+            components[0].h = components[0].v = 1;
+        }
+        int hMax = 1, vMax = 1;
+        for(const Component &c : components){
+            hMax = c.h > hMax ? c.h : hMax;
+            vMax = c.v > vMax ? c.v : vMax;
+        }
+        for(size_t i = 0; i < components.size(); i++){
+            const Component &c = components[i];
+            bool chroma = i > 0;
+            if(chroma ? (c.h != 1 || c.v != 1) : (c.h < 1 || c.h > 2 || c.v < 1 || c.v > c.h)){
+                return false;
+            }
+        }
+        uint32_t mcusX = (width + 8 * hMax - 1) / (8 * hMax);
+        uint32_t mcusY = (height + 8 * vMax - 1) / (8 * vMax);
+        uint32_t mcuCount = mcusX * mcusY;
+        for(Component &c : components){
+            c.width = (width * c.h + hMax - 1) / hMax;
+            c.height = (height * c.v + vMax - 1) / vMax;
+            c.stride = static_cast<size_t>(mcusX) * c.h * 8;
+            c.plane.resize(c.stride * mcusY * c.v * 8);
+        }
+
+        float scaledQuant[4][64];
+        for(int i = 0; i < 4; i++){
+            scaleQuantTable(quantTables[i], scaledQuant[i]);
+        }
+
+        // split the entropy coded data at restart markers
+        struct Segment {
+            const uint8_t* begin;
+            const uint8_t* end;
+        };
+        std::vector<Segment> segments;
+        const uint8_t* p = scan;
+        const uint8_t* segmentBegin = scan;
+        const uint8_t* dataEnd = data + size;
+        bool sawEnd = false;
+        while(p + 1 < dataEnd){
+            if(p[0] != 0xFF || p[1] == 0x00 || p[1] == 0xFF){
+                p += p[0] == 0xFF && p[1] == 0x00 ? 2 : 1;
+                continue;
+            }
+            segments.push_back({ segmentBegin, p });
+            if(p[1] >= 0xD0 && p[1] <= 0xD7){
+                p += 2;
+                segmentBegin = p;
+                continue;
+            }
+            // anything but EOI here would be a second scan
+            if(p[1] != 0xD9){
+                return false;
+            }
+            sawEnd = true;
+            break;
+        }
+        if(!sawEnd){
+            segments.push_back({ segmentBegin, dataEnd });
+        }
+        uint32_t interval = restartInterval != 0 ? restartInterval : mcuCount;
+        size_t expected = (mcuCount + interval - 1) / interval;
+        if(segments.size() < expected){
+            return false;
+        }
+        segments.resize(expected);
+
+        std::atomic<bool> failed(false);
+        auto decodeSegments = [&](size_t first, size_t last){
+            int16_t coefficients[64];
+            for(size_t s = first; s < last && !failed.load(std::memory_order_relaxed); s++){
+                BitReader reader(segments[s].begin, segments[s].end);
+                int predictors[3] = { 0, 0, 0 };
+                uint32_t mcuEnd = static_cast<uint32_t>(s + 1) * interval;
+                mcuEnd = mcuEnd < mcuCount ? mcuEnd : mcuCount;
+                for(uint32_t mcu = static_cast<uint32_t>(s) * interval; mcu < mcuEnd; mcu++){
+                    uint32_t mx = mcu % mcusX, my = mcu / mcusX;
+                    for(size_t c = 0; c < components.size(); c++){
+                        Component &component = components[c];
+                        for(int by = 0; by < component.v; by++){
+                            for(int bx = 0; bx < component.h; bx++){
+                                int last = decodeBlock(reader, coefficients, dcTables[component.dc], acTables[component.ac], predictors[c]);
+                                if(last < 0){
+                                    failed = true;
+                                    return;
+                                }
+                                size_t x = (static_cast<size_t>(mx) * component.h + bx) * 8;
+                                size_t y = (static_cast<size_t>(my) * component.v + by) * 8;
+                                idct(coefficients, last, scaledQuant[component.quant], component.plane.data() + y * component.stride + x,
+                                     component.stride, allowSimd);
+                            }
+                        }
+                    }
+                }
+            }
+        };
+        if(parallel){
+            parallelFor(segments.size(), decodeSegments, 8);
+        }
+        else{
+            decodeSegments(0, segments.size());
+        }
+        if(failed){
+            return false;
+        }
+
+        int sourceChannels = static_cast<int>(components.size());
+        int channels = desiredChannels == 0 ? sourceChannels : desiredChannels;
+        image.width = width;
+        image.height = height;
+        image.channels = channels;
+        image.sourceChannels = sourceChannels;
+        image.decoder = "jpeg";
+        image.pixels.resize(static_cast<size_t>(width) * height * channels);
+
+        auto convertRows = [&](size_t first, size_t last){
+            std::vector<uint8_t> cb(width + 1), cr(width + 1), rgba(static_cast<size_t>(width) * 4);
+            for(size_t y = first; y < last; y++){
+                uint8_t* out = image.pixels.data() + y * width * channels;
+                const uint8_t* luma = components[0].plane.data() + y * components[0].stride;
+                if(sourceChannels == 1){
+                    if(channels == 1){
+                        memcpy(out, luma, width);
+                    }
+                    else{
+                        ImageDecode::convertChannels(luma, 1, out, channels, width);
+                    }
+                    continue;
+                }
+                bool vertical = vMax == 2;
+                size_t chromaY = vertical ? y / 2 : y;
+                size_t farY = chromaY;
+                if(vertical){
+                    farY = (y & 1) ? chromaY + 1 : (chromaY > 0 ? chromaY - 1 : 0);
+                    farY = farY < components[1].height ? farY : components[1].height - 1;
+                }
+                for(int c = 1; c <= 2; c++){
+                    const Component &chroma = components[c];
+                    upsampleRow(chroma.plane.data() + chromaY * chroma.stride, chroma.plane.data() + farY * chroma.stride,
+                                c == 1 ? cb.data() : cr.data(), chroma.width, hMax, vertical);
+                }
+#ifdef SIMD_SSE2
+                if(allowSimd && channels == 4){
+                    ycbcrToRgbaSse2(luma, cb.data(), cr.data(), out, width);
+                    continue;
+                }
+#endif
+                if(channels >= 3){
+                    ycbcrToRgbScalar(luma, cb.data(), cr.data(), out, channels, width);
+                }
+                else{
+                    ycbcrToRgbScalar(luma, cb.data(), cr.data(), rgba.data(), 4, width);
+                    ImageDecode::convertChannels(rgba.data(), 4, out, channels, width);
+                }
+            }
+        };
+        if(parallel){
+            parallelFor(height, convertRows, 64);
+        }
+        else{
+            convertRows(0, height);
+        }
+        return true;
+    }
+}
+
+#endif
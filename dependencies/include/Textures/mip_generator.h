@@ -0,0 +1,377 @@
+#ifndef MIP_GENERATOR_H
+#define MIP_GENERATOR_H
+
+#include <Simd/cpu_features.h>
+#include <Textures/texture_container.h>
+#include <Threading/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// CPU mip chain generation for the cooker and the streaming path, replacing the driver's
+// glGenerateMipmap. Works on RGBA8 input:
+//
+//  - sRGB colour is decoded to linear float before filtering and re-encoded afterwards,
+//    alpha is always linear
+//  - box (2x2 average) or Kaiser windowed sinc (6 taps per axis, separable) filters
+//  - cutout textures can keep their alpha test coverage at every level, so foliage and
+//    fences don't thin out with distance
+//  - each level is split into row tiles across threads, the final quantisation runs
+//    across levels in parallel; AVX2 kernels are picked at runtime when available
+
+namespace Mips {
+
+    enum Filter {
+        FILTER_BOX,
+        FILTER_KAISER
+    };
+
+    struct Options {
+        Filter filter = FILTER_BOX;
+        bool srgb = false;
+        bool preserveAlphaCoverage = false;
+        float alphaCutoff = 0.5f;
+        bool allowSimd = true;
+    };
+
+    // RGBA float texels, colour in linear space
+    struct FloatImage {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<float> texels;
+
+        float* row(uint32_t y){
+            return texels.data() + static_cast<size_t>(y) * width * 4;
+        }
+
+        const float* row(uint32_t y) const{
+            return texels.data() + static_cast<size_t>(y) * width * 4;
+        }
+    };
+
+    const size_t ROWS_PER_TILE = 16;
+
+    #pragma region Colour conversion
+
+    inline const float* srgbToLinearTable(){
+        static const std::vector<float> table = [](){
+            std::vector<float> values(256);
+            for(int i = 0; i < 256; i++){
+                float c = i / 255.0f;
+                values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return values;
+        }();
+        return table.data();
+    }
+
+    // 12 bit linear -> 8 bit sRGB, fine enough that no output code is skipped
+    inline const uint8_t* linearToSrgbTable(){
+        static const std::vector<uint8_t> table = [](){
+            std::vector<uint8_t> values(4096);
+            for(int i = 0; i < 4096; i++){
+                float l = i / 4095.0f;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                values[i] = static_cast<uint8_t>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+            return values;
+        }();
+        return table.data();
+    }
+
+    inline FloatImage toFloat(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb){
+        FloatImage image;
+        image.width = width;
+        image.height = height;
+        image.texels.resize(static_cast<size_t>(width) * height * 4);
+        const float* decode = srgbToLinearTable();
+        parallelFor(height, [&](size_t begin, size_t end){
+            for(size_t i = begin * width * 4; i < end * width * 4; i++){
+                bool colour = srgb && (i & 3) != 3;
+                image.texels[i] = colour ? decode[rgba[i]] : rgba[i] / 255.0f;
+            }
+        }, ROWS_PER_TILE);
+        return image;
+    }
+
+    inline std::vector<uint8_t> toBytes(const FloatImage &image, bool srgb, float alphaScale){
+        std::vector<uint8_t> bytes(image.texels.size());
+        const uint8_t* encode = linearToSrgbTable();
+        for(size_t i = 0; i < image.texels.size(); i++){
+            float v = image.texels[i];
+            if((i & 3) == 3){
+                v *= alphaScale;
+            }
+            v = std::clamp(v, 0.0f, 1.0f);
+            bool colour = srgb && (i & 3) != 3;
+            bytes[i] = colour ? encode[static_cast<int>(v * 4095.0f + 0.5f)] : static_cast<uint8_t>(v * 255.0f + 0.5f);
+        }
+        return bytes;
+    }
+
+    #pragma endregion
+
+    #pragma region Box filter
+
+    inline void boxRowsScalar(const FloatImage &src, FloatImage &dst, size_t begin, size_t end, uint32_t firstX){
+        for(size_t y = begin; y < end; y++){
+            const float* r0 = src.row(std::min<uint32_t>(static_cast<uint32_t>(y) * 2, src.height - 1));
+            const float* r1 = src.row(std::min<uint32_t>(static_cast<uint32_t>(y) * 2 + 1, src.height - 1));
+            float* out = dst.row(static_cast<uint32_t>(y));
+            for(uint32_t x = firstX; x < dst.width; x++){
+                uint32_t x0 = std::min(x * 2, src.width - 1) * 4;
+                uint32_t x1 = std::min(x * 2 + 1, src.width - 1) * 4;
+                for(int c = 0; c < 4; c++){
+                    out[x * 4 + c] = (r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c]) * 0.25f;
+                }
+            }
+        }
+    }
+
+#ifdef SIMD_X86
+    // two destination texels (four source texels per row) per iteration
+    SIMD_TARGET_AVX2 inline void boxRowsAvx2(const FloatImage &src, FloatImage &dst, size_t begin, size_t end){
+        const __m256 quarter = _mm256_set1_ps(0.25f);
+        uint32_t pairs = src.width >= 2 ? dst.width / 2 : 0;
+        for(size_t y = begin; y < end; y++){
+            const float* r0 = src.row(std::min<uint32_t>(static_cast<uint32_t>(y) * 2, src.height - 1));
+            const float* r1 = src.row(std::min<uint32_t>(static_cast<uint32_t>(y) * 2 + 1, src.height - 1));
+            float* out = dst.row(static_cast<uint32_t>(y));
+            for(uint32_t pair = 0; pair < pairs; pair++){
+                size_t offset = static_cast<size_t>(pair) * 16;
+                __m256 a = _mm256_add_ps(_mm256_loadu_ps(r0 + offset), _mm256_loadu_ps(r1 + offset));
+                __m256 b = _mm256_add_ps(_mm256_loadu_ps(r0 + offset + 8), _mm256_loadu_ps(r1 + offset + 8));
+                __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+                __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+                _mm256_storeu_ps(out + pair * 8, _mm256_mul_ps(_mm256_add_ps(lo, hi), quarter));
+            }
+            boxRowsScalar(src, dst, y, y + 1, pairs * 2);
+        }
+    }
+#endif
+
+    #pragma endregion
+
+    #pragma region Kaiser filter
+
+    const int KAISER_TAPS = 6;
+
+    inline double besselI0(double x){
+        double sum = 1.0, term = 1.0;
+        for(int k = 1; k < 32; k++){
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // 2:1 decimation weights for source texels 2x-2 .. 2x+3, radius 3 source texels, alpha 4
+    inline const float* kaiserWeights(){
+        static const std::vector<float> weights = [](){
+            const double pi = 3.14159265358979323846;
+            const double alpha = 4.0, radius = 3.0;
+            std::vector<float> w(KAISER_TAPS);
+            double sum = 0.0;
+            for(int k = 0; k < KAISER_TAPS; k++){
+                double d = k - 2.5;
+                double t = d / 2.0;
+                double sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+                double x = d / radius;
+                double window = besselI0(alpha * std::sqrt(std::max(0.0, 1.0 - x * x))) / besselI0(alpha);
+                w[k] = static_cast<float>(sinc * window);
+                sum += w[k];
+            }
+            for(float &value : w){
+                value = static_cast<float>(value / sum);
+            }
+            return w;
+        }();
+        return weights.data();
+    }
+
+    inline void kaiserHorizontal(const FloatImage &src, FloatImage &dst, size_t begin, size_t end){
+        const float* w = kaiserWeights();
+        int last = static_cast<int>(src.width) - 1;
+        for(size_t y = begin; y < end; y++){
+            const float* in = src.row(static_cast<uint32_t>(y));
+            float* out = dst.row(static_cast<uint32_t>(y));
+            for(uint32_t x = 0; x < dst.width; x++){
+#ifdef SIMD_X86
+                __m128 sum = _mm_setzero_ps();
+                for(int k = 0; k < KAISER_TAPS; k++){
+                    int sx = std::clamp(static_cast<int>(x) * 2 - 2 + k, 0, last);
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(in + sx * 4)));
+                }
+                _mm_storeu_ps(out + x * 4, sum);
+#else
+                float sum[4] = {};
+                for(int k = 0; k < KAISER_TAPS; k++){
+                    int sx = std::clamp(static_cast<int>(x) * 2 - 2 + k, 0, last);
+                    for(int c = 0; c < 4; c++){
+                        sum[c] += w[k] * in[sx * 4 + c];
+                    }
+                }
+                for(int c = 0; c < 4; c++){
+                    out[x * 4 + c] = sum[c];
+                }
+#endif
+            }
+        }
+    }
+
+    inline void kaiserVerticalScalar(const FloatImage &src, FloatImage &dst, size_t begin, size_t end){
+        const float* w = kaiserWeights();
+        int last = static_cast<int>(src.height) - 1;
+        size_t floats = static_cast<size_t>(dst.width) * 4;
+        for(size_t y = begin; y < end; y++){
+            const float* rows[KAISER_TAPS];
+            for(int k = 0; k < KAISER_TAPS; k++){
+                rows[k] = src.row(std::clamp(static_cast<int>(y) * 2 - 2 + k, 0, last));
+            }
+            float* out = dst.row(static_cast<uint32_t>(y));
+            for(size_t i = 0; i < floats; i++){
+                float sum = 0.0f;
+                for(int k = 0; k < KAISER_TAPS; k++){
+                    sum += w[k] * rows[k][i];
+                }
+                out[i] = sum;
+            }
+        }
+    }
+
+#ifdef SIMD_X86
+    // whole rows are contiguous floats, so the vertical pass is a straight 8 wide FMA
+    SIMD_TARGET_AVX2 inline void kaiserVerticalAvx2(const FloatImage &src, FloatImage &dst, size_t begin, size_t end){
+        const float* w = kaiserWeights();
+        int last = static_cast<int>(src.height) - 1;
+        size_t floats = static_cast<size_t>(dst.width) * 4;
+        size_t vectorFloats = floats & ~static_cast<size_t>(7);
+        __m256 weights[KAISER_TAPS];
+        for(int k = 0; k < KAISER_TAPS; k++){
+            weights[k] = _mm256_set1_ps(w[k]);
+        }
+        for(size_t y = begin; y < end; y++){
+            const float* rows[KAISER_TAPS];
+            for(int k = 0; k < KAISER_TAPS; k++){
+                rows[k] = src.row(std::clamp(static_cast<int>(y) * 2 - 2 + k, 0, last));
+            }
+            float* out = dst.row(static_cast<uint32_t>(y));
+            for(size_t i = 0; i < vectorFloats; i += 8){
+                __m256 sum = _mm256_mul_ps(weights[0], _mm256_loadu_ps(rows[0] + i));
+                for(int k = 1; k < KAISER_TAPS; k++){
+                    sum = _mm256_fmadd_ps(weights[k], _mm256_loadu_ps(rows[k] + i), sum);
+                }
+                _mm256_storeu_ps(out + i, sum);
+            }
+            for(size_t i = vectorFloats; i < floats; i++){
+                float sum = 0.0f;
+                for(int k = 0; k < KAISER_TAPS; k++){
+                    sum += w[k] * rows[k][i];
+                }
+                out[i] = sum;
+            }
+        }
+    }
+#endif
+
+    #pragma endregion
+
+    inline FloatImage downsample(const FloatImage &src, const Options &options){
+        FloatImage dst;
+        dst.width = std::max<uint32_t>(1, src.width / 2);
+        dst.height = std::max<uint32_t>(1, src.height / 2);
+        dst.texels.resize(static_cast<size_t>(dst.width) * dst.height * 4);
+#ifdef SIMD_X86
+        bool avx2 = options.allowSimd && Simd::hasAvx2();
+#else
+        bool avx2 = false;
+#endif
+
+        if(options.filter == FILTER_BOX){
+            parallelFor(dst.height, [&](size_t begin, size_t end){
+#ifdef SIMD_X86
+                if(avx2){
+                    boxRowsAvx2(src, dst, begin, end);
+                    return;
+                }
+#endif
+                boxRowsScalar(src, dst, begin, end, 0);
+            }, ROWS_PER_TILE);
+            return dst;
+        }
+
+        FloatImage horizontal;
+        horizontal.width = dst.width;
+        horizontal.height = src.height;
+        horizontal.texels.resize(static_cast<size_t>(horizontal.width) * horizontal.height * 4);
+        parallelFor(horizontal.height, [&](size_t begin, size_t end){
+            kaiserHorizontal(src, horizontal, begin, end);
+        }, ROWS_PER_TILE);
+        parallelFor(dst.height, [&](size_t begin, size_t end){
+#ifdef SIMD_X86
+            if(avx2){
+                kaiserVerticalAvx2(horizontal, dst, begin, end);
+                return;
+            }
+#endif
+            kaiserVerticalScalar(horizontal, dst, begin, end);
+        }, ROWS_PER_TILE);
+        return dst;
+    }
+
+    // fraction of texels whose scaled alpha passes the cutoff
+    inline float alphaCoverage(const FloatImage &image, float cutoff, float scale){
+        size_t passed = 0;
+        size_t count = image.texels.size() / 4;
+        for(size_t i = 0; i < count; i++){
+            if(image.texels[i * 4 + 3] * scale >= cutoff){
+                passed++;
+            }
+        }
+        return count == 0 ? 0.0f : static_cast<float>(passed) / count;
+    }
+
+    // alpha scale that brings a filtered level back to the coverage of the top level
+    inline float coverageScale(const FloatImage &image, float cutoff, float targetCoverage){
+        float lo = 0.0f, hi = 4.0f;
+        for(int i = 0; i < 16; i++){
+            float mid = (lo + hi) * 0.5f;
+            if(alphaCoverage(image, cutoff, mid) < targetCoverage){
+                lo = mid;
+            }
+            else{
+                hi = mid;
+            }
+        }
+        return (lo + hi) * 0.5f;
+    }
+
+    // full chain for a tightly packed RGBA8 image, levels[0] is a copy of the input
+    inline std::vector<TextureContainer::Level> generate(const uint8_t* rgba, uint32_t width, uint32_t height, const Options &options = Options()){
+        uint32_t count = TextureContainer::mipCount(width, height);
+        std::vector<FloatImage> chain(count);
+        chain[0] = toFloat(rgba, width, height, options.srgb);
+        for(uint32_t i = 1; i < count; i++){
+            chain[i] = downsample(chain[i - 1], options);
+        }
+
+        float targetCoverage = options.preserveAlphaCoverage ? alphaCoverage(chain[0], options.alphaCutoff, 1.0f) : 0.0f;
+        std::vector<TextureContainer::Level> levels(count);
+        levels[0].width = width;
+        levels[0].height = height;
+        levels[0].bytes.assign(rgba, rgba + static_cast<size_t>(width) * height * 4);
+        parallelFor(count - 1, [&](size_t begin, size_t end){
+            for(size_t i = begin + 1; i < end + 1; i++){
+                float scale = options.preserveAlphaCoverage ? coverageScale(chain[i], options.alphaCutoff, targetCoverage) : 1.0f;
+                levels[i].width = chain[i].width;
+                levels[i].height = chain[i].height;
+                levels[i].bytes = toBytes(chain[i], options.srgb, scale);
+            }
+        });
+        return levels;
+    }
+}
+
+#endif
@@ -0,0 +1,657 @@
+#ifndef PNG_DECODER_H
+#define PNG_DECODER_H
+
+#include <Simd/cpu_features.h>
+#include <Textures/image.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// PNG decoder for the common texture case: 8 bit grey, grey alpha, RGB, RGBA or palette,
+// not interlaced. Anything else returns false and is left to the stb fallback.
+//
+// Faster than stb's path in two places:
+//  - inflate reads the stream through a 64 bit bit buffer refilled 8 bytes at a time,
+//    decodes most codes with one table lookup, and copies back references in 16 or 8 byte
+//    chunks instead of byte by byte
+//  - Sub, Avg and Paeth filters for 3 and 4 byte pixels are reversed one whole pixel per
+//    SSE2 operation (the libpng approach), Up runs 16 bytes at a time
+//
+// The inflate output buffer is sized from IHDR up front, so it never grows.
+
+namespace Png {
+
+    #pragma region Inflate
+
+    const int FAST_BITS = 10;
+    const size_t COPY_SLACK = 16;   // chunked match copies may write this far past the match
+
+    inline uint32_t reverseBits(uint32_t value, int bits){
+        uint32_t result = 0;
+        for(int i = 0; i < bits; i++){
+            result = (result << 1) | ((value >> i) & 1);
+        }
+        return result;
+    }
+
+    struct Huffman {
+        uint16_t fast[1 << FAST_BITS];  // (length << 9) | symbol, 0 when the code is longer than FAST_BITS
+        uint32_t maxCode[17];           // one past the last code of each length, left aligned to 16 bits
+        uint16_t firstCode[16];
+        uint16_t firstSymbol[16];
+        uint16_t symbols[288];
+        uint8_t lengths[288];           // code length of each entry in symbols, to reject invalid codes
+
+        bool build(const uint8_t* codeLengths, int count){
+            int sizes[17] = { 0 };
+            memset(fast, 0, sizeof(fast));
+            for(int i = 0; i < count; i++){
+                sizes[codeLengths[i]]++;
+            }
+            sizes[0] = 0;
+            uint16_t nextCode[16];
+            int code = 0, k = 0;
+            for(int i = 1; i < 16; i++){
+                if(sizes[i] > (1 << i)){
+                    return false;
+                }
+                nextCode[i] = static_cast<uint16_t>(code);
+                firstCode[i] = static_cast<uint16_t>(code);
+                firstSymbol[i] = static_cast<uint16_t>(k);
+                code += sizes[i];
+                if(sizes[i] != 0 && code > (1 << i)){
+                    return false;
+                }
+                maxCode[i] = static_cast<uint32_t>(code) << (16 - i);
+                code <<= 1;
+                k += sizes[i];
+            }
+            maxCode[16] = 0x10000;
+            for(int symbol = 0; symbol < count; symbol++){
+                int length = codeLengths[symbol];
+                if(length == 0){
+                    continue;
+                }
+                int index = nextCode[length] - firstCode[length] + firstSymbol[length];
+                symbols[index] = static_cast<uint16_t>(symbol);
+                lengths[index] = static_cast<uint8_t>(length);
+                if(length <= FAST_BITS){
+                    for(uint32_t j = reverseBits(nextCode[length], length); j < (1u << FAST_BITS); j += 1u << length){
+                        fast[j] = static_cast<uint16_t>((length << 9) | symbol);
+                    }
+                }
+                nextCode[length]++;
+            }
+            return true;
+        }
+    };
+
+    // deflate packs bits LSB first, so the buffer is filled from the low end
+    struct BitStream {
+        const uint8_t* p;
+        const uint8_t* end;
+        uint64_t bits = 0;
+        int count = 0;
+
+        BitStream(const uint8_t* data, size_t size) : p(data), end(data + size){}
+
+        void refill(){
+            if(end - p >= 8){
+                // bits above count may hold part of the next byte, the next refill ORs in the same bits
+                uint64_t word;
+                memcpy(&word, p, 8);
+                bits |= word << count;
+                p += (63 - count) >> 3;
+                count |= 56;
+                return;
+            }
+            while(count <= 56){
+                if(p < end){
+                    bits |= static_cast<uint64_t>(*p++) << count;
+                }
+                count += 8;
+            }
+        }
+
+        uint32_t read(int n){
+            if(n == 0){
+                return 0;
+            }
+            if(count < n){
+                refill();
+            }
+            uint32_t value = static_cast<uint32_t>(bits & ((1ull << n) - 1));
+            bits >>= n;
+            count -= n;
+            return value;
+        }
+
+        int decode(const Huffman &h){
+            if(count < 16){
+                refill();
+            }
+            uint32_t entry = h.fast[bits & ((1u << FAST_BITS) - 1)];
+            if(entry != 0){
+                int length = entry >> 9;
+                bits >>= length;
+                count -= length;
+                return entry & 511;
+            }
+            uint32_t code = reverseBits(static_cast<uint32_t>(bits & 0xFFFF), 16);
+            int length = FAST_BITS + 1;
+            while(code >= h.maxCode[length]){
+                length++;
+            }
+            if(length >= 16){
+                return -1;
+            }
+            int index = static_cast<int>(code >> (16 - length)) - h.firstCode[length] + h.firstSymbol[length];
+            if(index < 0 || index >= 288 || h.lengths[index] != length){
+                return -1;
+            }
+            bits >>= length;
+            count -= length;
+            return h.symbols[index];
+        }
+    };
+
+    const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+                                     2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    const uint8_t DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    // out has at least COPY_SLACK writable bytes past out + length
+    inline void copyMatch(uint8_t* out, size_t distance, size_t length){
+        const uint8_t* src = out - distance;
+        if(distance >= 16){
+            // each chunk ends before the bytes it writes begin
+            for(size_t i = 0; i < length; i += 16){
+#ifdef SIMD_SSE2
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+#else
+                memcpy(out + i, src + i, 16);
+#endif
+            }
+        }
+        else if(distance >= 8){
+            for(size_t i = 0; i < length; i += 8){
+                memcpy(out + i, src + i, 8);
+            }
+        }
+        else if(distance == 1){
+            memset(out, src[0], length);
+        }
+        else{
+            for(size_t i = 0; i < length; i++){
+                out[i] = src[i];
+            }
+        }
+    }
+
+    inline bool inflateBlock(BitStream &stream, const Huffman &literals, const Huffman &distances,
+                             uint8_t* begin, uint8_t* &out, uint8_t* end){
+        for(;;){
+            int symbol = stream.decode(literals);
+            if(symbol < 256){
+                if(symbol < 0 || out >= end){
+                    return false;
+                }
+                *out++ = static_cast<uint8_t>(symbol);
+                continue;
+            }
+            if(symbol == 256){
+                return true;
+            }
+            symbol -= 257;
+            if(symbol >= 29){
+                return false;
+            }
+            size_t length = LENGTH_BASE[symbol] + stream.read(LENGTH_EXTRA[symbol]);
+            int distanceCode = stream.decode(distances);
+            if(distanceCode < 0 || distanceCode >= 30){
+                return false;
+            }
+            size_t distance = DIST_BASE[distanceCode] + stream.read(DIST_EXTRA[distanceCode]);
+            if(distance > static_cast<size_t>(out - begin) || length > static_cast<size_t>(end - out)){
+                return false;
+            }
+            copyMatch(out, distance, length);
+            out += length;
+        }
+    }
+
+    inline bool readDynamicTables(BitStream &stream, Huffman &literals, Huffman &distances){
+        static const uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        int literalCount = stream.read(5) + 257;
+        int distanceCount = stream.read(5) + 1;
+        int codeLengthCount = stream.read(4) + 4;
+
+        uint8_t codeLengthLengths[19] = { 0 };
+        for(int i = 0; i < codeLengthCount; i++){
+            codeLengthLengths[ORDER[i]] = static_cast<uint8_t>(stream.read(3));
+        }
+        Huffman codeLengths;
+        if(!codeLengths.build(codeLengthLengths, 19)){
+            return false;
+        }
+
+        uint8_t lengths[286 + 32];
+        int total = literalCount + distanceCount;
+        int n = 0;
+        while(n < total){
+            int symbol = stream.decode(codeLengths);
+            if(symbol < 0 || symbol > 18){
+                return false;
+            }
+            if(symbol < 16){
+                lengths[n++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+            uint8_t fill = 0;
+            int repeat;
+            if(symbol == 16){
+                if(n == 0){
+                    return false;
+                }
+                fill = lengths[n - 1];
+                repeat = stream.read(2) + 3;
+            }
+            else if(symbol == 17){
+                repeat = stream.read(3) + 3;
+            }
+            else{
+                repeat = stream.read(7) + 11;
+            }
+            if(n + repeat > total){
+                return false;
+            }
+            memset(lengths + n, fill, repeat);
+            n += repeat;
+        }
+        return literals.build(lengths, literalCount) && distances.build(lengths + literalCount, distanceCount);
+    }
+
+    // block type 1 codes, built once
+    struct FixedTables {
+        Huffman literals;
+        Huffman distances;
+
+        FixedTables(){
+            uint8_t lengths[288];
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            literals.build(lengths, 288);
+            memset(lengths, 5, 32);
+            distances.build(lengths, 32);
+        }
+    };
+
+    inline const FixedTables& fixedTables(){
+        static const FixedTables tables;
+        return tables;
+    }
+
+    // inflates a zlib stream into exactly size bytes, out must have COPY_SLACK spare bytes past size
+    inline bool inflateZlib(const uint8_t* data, size_t dataSize, uint8_t* out, size_t size){
+        if(dataSize < 2){
+            return false;
+        }
+        uint8_t cmf = data[0], flg = data[1];
+        if((cmf * 256 + flg) % 31 != 0 || (cmf & 15) != 8 || (flg & 32) != 0){
+            return false;
+        }
+        BitStream stream(data + 2, dataSize - 2);
+        uint8_t* begin = out;
+        uint8_t* end = out + size;
+
+        const FixedTables &fixed = fixedTables();
+        Huffman literals, distances;
+        bool last = false;
+        while(!last){
+            last = stream.read(1) != 0;
+            uint32_t type = stream.read(2);
+            if(type == 0){
+                stream.read(stream.count & 7);
+                uint32_t length = stream.read(16);
+                uint32_t inverse = stream.read(16);
+                if(length != (~inverse & 0xFFFF) || length > static_cast<size_t>(end - out)){
+                    return false;
+                }
+                while(length > 0 && stream.count >= 8){
+                    *out++ = static_cast<uint8_t>(stream.read(8));
+                    length--;
+                }
+                if(length > 0){
+                    // the buffer is drained, copy the rest straight from the stream
+                    if(length > static_cast<size_t>(stream.end - stream.p)){
+                        return false;
+                    }
+                    memcpy(out, stream.p, length);
+                    out += length;
+                    stream.p += length;
+                    stream.bits = 0;
+                    stream.count = 0;
+                }
+            }
+            else if(type == 1){
+                if(!inflateBlock(stream, fixed.literals, fixed.distances, begin, out, end)){
+                    return false;
+                }
+            }
+            else if(type == 2){
+                if(!readDynamicTables(stream, literals, distances) || !inflateBlock(stream, literals, distances, begin, out, end)){
+                    return false;
+                }
+            }
+            else{
+                return false;
+            }
+        }
+        return out == end;
+    }
+
+    #pragma endregion
+
+    #pragma region Filters
+
+    enum FilterType {
+        FILTER_NONE = 0,
+        FILTER_SUB = 1,
+        FILTER_UP = 2,
+        FILTER_AVG = 3,
+        FILTER_PAETH = 4
+    };
+
+    inline uint8_t paeth(int a, int b, int c){
+        int pa = b - c < 0 ? c - b : b - c;
+        int pb = a - c < 0 ? c - a : a - c;
+        int pc = a + b - 2 * c < 0 ? 2 * c - a - b : a + b - 2 * c;
+        if(pa <= pb && pa <= pc){
+            return static_cast<uint8_t>(a);
+        }
+        return static_cast<uint8_t>(pb <= pc ? b : c);
+    }
+
+    inline void unfilterRowScalar(int filter, const uint8_t* cur, const uint8_t* prior, uint8_t* out, size_t length, int bpp){
+        switch(filter){
+            case FILTER_NONE:
+                // out overlaps cur when the rows are unfiltered in place
+                memmove(out, cur, length);
+                break;
+            case FILTER_SUB:
+                for(size_t i = 0; i < length; i++){
+                    out[i] = static_cast<uint8_t>(cur[i] + (i >= static_cast<size_t>(bpp) ? out[i - bpp] : 0));
+                }
+                break;
+            case FILTER_UP:
+                for(size_t i = 0; i < length; i++){
+                    out[i] = static_cast<uint8_t>(cur[i] + prior[i]);
+                }
+                break;
+            case FILTER_AVG:
+                for(size_t i = 0; i < length; i++){
+                    int a = i >= static_cast<size_t>(bpp) ? out[i - bpp] : 0;
+                    out[i] = static_cast<uint8_t>(cur[i] + ((a + prior[i]) >> 1));
+                }
+                break;
+            case FILTER_PAETH:
+                for(size_t i = 0; i < length; i++){
+                    bool first = i < static_cast<size_t>(bpp);
+                    out[i] = static_cast<uint8_t>(cur[i] + paeth(first ? 0 : out[i - bpp], prior[i], first ? 0 : prior[i - bpp]));
+                }
+                break;
+        }
+    }
+
+#ifdef SIMD_SSE2
+    // one pixel of 3 or 4 bytes widened to 16 bit lanes, BPP is a constant so the copies
+    // compile to plain loads and stores
+    template<int BPP>
+    inline __m128i loadPixel(const uint8_t* p){
+        uint32_t value = 0;
+        memcpy(&value, p, BPP);
+        return _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(value)), _mm_setzero_si128());
+    }
+
+    template<int BPP>
+    inline void storePixel(uint8_t* p, __m128i pixel){
+        uint32_t value = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(pixel, pixel)));
+        memcpy(p, &value, BPP);
+    }
+
+    inline __m128i abs16(__m128i x){
+        return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+    }
+
+    inline __m128i select(__m128i mask, __m128i a, __m128i b){
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    // Sub, Avg and Paeth carry a dependency from pixel to pixel, so the parallelism is
+    // across the channels of one pixel
+    template<int BPP>
+    inline void unfilterPixelsSse2(int filter, const uint8_t* cur, const uint8_t* prior, uint8_t* out, size_t length){
+        const __m128i low = _mm_set1_epi16(0xFF);
+        __m128i a = _mm_setzero_si128();
+        __m128i c = _mm_setzero_si128();
+        for(size_t i = 0; i < length; i += BPP){
+            __m128i x = loadPixel<BPP>(cur + i);
+            __m128i b = loadPixel<BPP>(prior + i);
+            __m128i predictor;
+            if(filter == FILTER_SUB){
+                predictor = a;
+            }
+            else if(filter == FILTER_AVG){
+                predictor = _mm_srli_epi16(_mm_add_epi16(a, b), 1);
+            }
+            else{
+                __m128i pa = _mm_sub_epi16(b, c);
+                __m128i pb = _mm_sub_epi16(a, c);
+                __m128i pc = abs16(_mm_add_epi16(pa, pb));
+                pa = abs16(pa);
+                pb = abs16(pb);
+                __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+                predictor = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+            }
+            a = _mm_and_si128(_mm_add_epi16(x, predictor), low);
+            c = b;
+            storePixel<BPP>(out + i, a);
+        }
+    }
+
+    inline void unfilterRowSse2(int filter, const uint8_t* cur, const uint8_t* prior, uint8_t* out, size_t length, int bpp){
+        if(filter == FILTER_UP){
+            size_t i = 0;
+            for(; i + 16 <= length; i += 16){
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi8(x, b));
+            }
+            for(; i < length; i++){
+                out[i] = static_cast<uint8_t>(cur[i] + prior[i]);
+            }
+            return;
+        }
+        if(filter == FILTER_NONE || (bpp != 3 && bpp != 4)){
+            unfilterRowScalar(filter, cur, prior, out, length, bpp);
+        }
+        else if(bpp == 4){
+            unfilterPixelsSse2<4>(filter, cur, prior, out, length);
+        }
+        else{
+            unfilterPixelsSse2<3>(filter, cur, prior, out, length);
+        }
+    }
+#endif
+
+    inline void unfilterRow(int filter, const uint8_t* cur, const uint8_t* prior, uint8_t* out, size_t length, int bpp, bool allowSimd){
+#ifdef SIMD_SSE2
+        if(allowSimd){
+            unfilterRowSse2(filter, cur, prior, out, length, bpp);
+            return;
+        }
+#endif
+        (void)allowSimd;
+        unfilterRowScalar(filter, cur, prior, out, length, bpp);
+    }
+
+    #pragma endregion
+
+    inline uint32_t readBigEndian(const uint8_t* p){
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    inline bool isPng(const uint8_t* data, size_t size){
+        static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        return size >= 8 && memcmp(data, SIGNATURE, 8) == 0;
+    }
+
+    // desiredChannels 0 keeps the file's channel count
+    inline bool decode(const uint8_t* data, size_t size, int desiredChannels, ImageDecode::Image &image, bool allowSimd = true){
+        if(!isPng(data, size)){
+            return false;
+        }
+        uint32_t width = 0, height = 0;
+        int colorType = -1;
+        uint8_t palette[256 * 4] = { 0 };
+        uint32_t paletteSize = 0;
+        bool paletteAlpha = false;
+        std::vector<const uint8_t*> idatData;
+        std::vector<size_t> idatSize;
+
+        size_t offset = 8;
+        bool ended = false;
+        while(!ended && offset + 12 <= size){
+            uint32_t length = readBigEndian(data + offset);
+            const uint8_t* type = data + offset + 4;
+            const uint8_t* body = data + offset + 8;
+            if(length > size - offset - 12){
+                return false;
+            }
+            if(memcmp(type, "IHDR", 4) == 0){
+                if(length != 13){
+                    return false;
+                }
+                width = readBigEndian(body);
+                height = readBigEndian(body + 4);
+                int depth = body[8];
+                colorType = body[9];
+                // compression and filter method 0 only, no interlacing, 8 bit samples
+                if(depth != 8 || body[10] != 0 || body[11] != 0 || body[12] != 0 || width == 0 || height == 0 ||
+                   (colorType != 0 && colorType != 2 && colorType != 3 && colorType != 4 && colorType != 6)){
+                    return false;
+                }
+            }
+            else if(memcmp(type, "PLTE", 4) == 0){
+                paletteSize = length / 3;
+                if(paletteSize > 256 || length % 3 != 0){
+                    return false;
+                }
+                for(uint32_t i = 0; i < paletteSize; i++){
+                    palette[i * 4 + 0] = body[i * 3 + 0];
+                    palette[i * 4 + 1] = body[i * 3 + 1];
+                    palette[i * 4 + 2] = body[i * 3 + 2];
+                    palette[i * 4 + 3] = 255;
+                }
+            }
+            else if(memcmp(type, "tRNS", 4) == 0){
+                // colour keyed transparency for non palette images is left to stb
+                if(colorType != 3 || length > paletteSize){
+                    return false;
+                }
+                for(uint32_t i = 0; i < length; i++){
+                    palette[i * 4 + 3] = body[i];
+                }
+                paletteAlpha = true;
+            }
+            else if(memcmp(type, "IDAT", 4) == 0){
+                idatData.push_back(body);
+                idatSize.push_back(length);
+            }
+            else if(memcmp(type, "IEND", 4) == 0){
+                ended = true;
+            }
+            else if(memcmp(type, "CgBI", 4) == 0){
+                return false;
+            }
+            offset += 12 + length;
+        }
+        if(colorType < 0 || idatData.empty() || (colorType == 3 && paletteSize == 0)){
+            return false;
+        }
+
+        // IDAT chunks form one zlib stream, only join them when there's more than one
+        std::vector<uint8_t> joined;
+        const uint8_t* stream = idatData[0];
+        size_t streamSize = idatSize[0];
+        if(idatData.size() > 1){
+            size_t total = 0;
+            for(size_t s : idatSize){
+                total += s;
+            }
+            joined.resize(total);
+            total = 0;
+            for(size_t i = 0; i < idatData.size(); i++){
+                memcpy(joined.data() + total, idatData[i], idatSize[i]);
+                total += idatSize[i];
+            }
+            stream = joined.data();
+            streamSize = joined.size();
+        }
+
+        static const int CHANNELS[7] = { 1, 0, 3, 1, 2, 0, 4 };
+        int bpp = CHANNELS[colorType];
+        size_t rowBytes = static_cast<size_t>(width) * bpp;
+        size_t filteredSize = (rowBytes + 1) * height;
+        std::vector<uint8_t> filtered(filteredSize + COPY_SLACK);
+        if(!inflateZlib(stream, streamSize, filtered.data(), filteredSize)){
+            return false;
+        }
+
+        // reversed in place: row y is written y + 1 bytes ahead of where it was read from, so
+        // every write lands on bytes that have already been consumed
+        std::vector<uint8_t> zeroRow(rowBytes, 0);
+        uint8_t* samples = filtered.data();
+        for(uint32_t y = 0; y < height; y++){
+            const uint8_t* row = filtered.data() + y * (rowBytes + 1);
+            int filter = row[0];
+            if(filter > FILTER_PAETH){
+                return false;
+            }
+            const uint8_t* prior = y == 0 ? zeroRow.data() : samples + (y - 1) * rowBytes;
+            unfilterRow(filter, row + 1, prior, samples + y * rowBytes, rowBytes, bpp, allowSimd);
+        }
+        filtered.resize(rowBytes * height);
+
+        int channels = bpp;
+        if(colorType == 3){
+            channels = paletteAlpha ? 4 : 3;
+            std::vector<uint8_t> expanded(static_cast<size_t>(width) * height * channels);
+            for(size_t i = 0, count = static_cast<size_t>(width) * height; i < count; i++){
+                memcpy(expanded.data() + i * channels, palette + filtered[i] * 4, channels);
+            }
+            filtered.swap(expanded);
+        }
+
+        image.width = width;
+        image.height = height;
+        image.sourceChannels = channels;
+        image.decoder = "png";
+        if(desiredChannels == 0 || desiredChannels == channels){
+            image.channels = channels;
+            image.pixels.swap(filtered);
+        }
+        else{
+            image.channels = desiredChannels;
+            image.pixels.resize(static_cast<size_t>(width) * height * desiredChannels);
+            ImageDecode::convertChannels(filtered.data(), channels, image.pixels.data(), desiredChannels, static_cast<size_t>(width) * height);
+        }
+        return true;
+    }
+}
+
+#endif
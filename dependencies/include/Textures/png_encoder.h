@@ -0,0 +1,278 @@
+#ifndef PNG_ENCODER_H
+#define PNG_ENCODER_H
+
+#include <Textures/png_decoder.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// PNG writer for screenshots and golden images: 8 bit grey, grey alpha, RGB or RGBA.
+//
+// Each row gets the filter with the smallest sum of absolute values (the usual libpng
+// heuristic), then the image is deflated with greedy LZ77 over a 32 KB window (hash chains
+// of 3 byte prefixes, capped search depth) and the fixed Huffman tables. Dynamic tables
+// would save another 10-20%, rendered frames with flat backgrounds already shrink a lot
+// from the matches alone.
+
+namespace Png {
+
+    #pragma region Deflate
+
+    struct BitWriter {
+        std::vector<uint8_t> &out;
+        uint64_t buffer = 0;
+        int count = 0;
+
+        explicit BitWriter(std::vector<uint8_t> &out) : out(out){}
+
+        // deflate packs bits LSB first
+        void write(uint32_t bits, int length){
+            buffer |= static_cast<uint64_t>(bits) << count;
+            count += length;
+            while(count >= 8){
+                out.push_back(static_cast<uint8_t>(buffer));
+                buffer >>= 8;
+                count -= 8;
+            }
+        }
+
+        // Huffman codes are stored MSB first
+        void writeCode(uint32_t code, int length){
+            uint32_t reversed = 0;
+            for(int i = 0; i < length; i++){
+                reversed |= ((code >> i) & 1) << (length - 1 - i);
+            }
+            write(reversed, length);
+        }
+
+        void flush(){
+            if(count > 0){
+                out.push_back(static_cast<uint8_t>(buffer));
+            }
+            buffer = 0;
+            count = 0;
+        }
+    };
+
+    inline void writeFixedLiteral(BitWriter &bits, uint32_t symbol){
+        if(symbol < 144){
+            bits.writeCode(0x30 + symbol, 8);
+        }
+        else if(symbol < 256){
+            bits.writeCode(0x190 + symbol - 144, 9);
+        }
+        else if(symbol < 280){
+            bits.writeCode(symbol - 256, 7);
+        }
+        else{
+            bits.writeCode(0xC0 + symbol - 280, 8);
+        }
+    }
+
+    inline void writeMatch(BitWriter &bits, uint32_t length, uint32_t distance){
+        static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const uint16_t distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const uint8_t distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        int code = 28;
+        while(lengthBase[code] > length){
+            code--;
+        }
+        writeFixedLiteral(bits, 257 + code);
+        bits.write(length - lengthBase[code], lengthExtra[code]);
+        int distanceCode = 29;
+        while(distanceBase[distanceCode] > distance){
+            distanceCode--;
+        }
+        bits.writeCode(distanceCode, 5);
+        bits.write(distance - distanceBase[distanceCode], distanceExtra[distanceCode]);
+    }
+
+    inline uint32_t adler32(const uint8_t* data, size_t size){
+        uint32_t a = 1, b = 0;
+        while(size > 0){
+            size_t block = size < 5552 ? size : 5552;
+            for(size_t i = 0; i < block; i++){
+                a += data[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+            data += block;
+            size -= block;
+        }
+        return (b << 16) | a;
+    }
+
+    // zlib stream of one fixed Huffman block
+    inline std::vector<uint8_t> deflateZlib(const uint8_t* data, size_t size, int maxChain = 32){
+        const uint32_t WINDOW = 32768;
+        const int HASH_BITS = 15;
+        const uint32_t MAX_MATCH = 258;
+        std::vector<uint8_t> out;
+        out.reserve(size / 2 + 64);
+        out.push_back(0x78);
+        out.push_back(0x01);
+        BitWriter bits(out);
+        bits.write(1, 1);           // final block
+        bits.write(1, 2);           // fixed Huffman
+
+        std::vector<int32_t> head(size_t(1) << HASH_BITS, -1);
+        std::vector<int32_t> previous(WINDOW, -1);
+        auto hash = [&](size_t i){
+            uint32_t value = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+            return (value * 2654435761u) >> (32 - HASH_BITS);
+        };
+        auto insert = [&](size_t i){
+            if(i + 2 < size){
+                uint32_t h = hash(i);
+                previous[i & (WINDOW - 1)] = head[h];
+                head[h] = static_cast<int32_t>(i);
+            }
+        };
+
+        size_t i = 0;
+        while(i < size){
+            uint32_t bestLength = 0, bestDistance = 0;
+            if(i + 2 < size){
+                int32_t candidate = head[hash(i)];
+                uint32_t limit = static_cast<uint32_t>(size - i < MAX_MATCH ? size - i : MAX_MATCH);
+                for(int chain = 0; candidate >= 0 && chain < maxChain && i - candidate <= WINDOW - 1; chain++){
+                    const uint8_t* a = data + candidate;
+                    const uint8_t* b = data + i;
+                    if(a[bestLength] == b[bestLength]){
+                        uint32_t length = 0;
+                        while(length < limit && a[length] == b[length]){
+                            length++;
+                        }
+                        if(length > bestLength){
+                            bestLength = length;
+                            bestDistance = static_cast<uint32_t>(i - candidate);
+                            if(length == limit){
+                                break;
+                            }
+                        }
+                    }
+                    int32_t next = previous[candidate & (WINDOW - 1)];
+                    if(next >= candidate){
+                        break;
+                    }
+                    candidate = next;
+                }
+            }
+            if(bestLength >= 3){
+                writeMatch(bits, bestLength, bestDistance);
+                for(uint32_t k = 0; k < bestLength; k++){
+                    insert(i + k);
+                }
+                i += bestLength;
+            }
+            else{
+                writeFixedLiteral(bits, data[i]);
+                insert(i);
+                i++;
+            }
+        }
+        writeFixedLiteral(bits, 256);
+        bits.flush();
+        uint32_t adler = adler32(data, size);
+        for(int shift = 24; shift >= 0; shift -= 8){
+            out.push_back(static_cast<uint8_t>(adler >> shift));
+        }
+        return out;
+    }
+    #pragma endregion
+
+    struct CrcTable {
+        uint32_t entries[256];
+
+        CrcTable(){
+            for(uint32_t n = 0; n < 256; n++){
+                uint32_t c = n;
+                for(int k = 0; k < 8; k++){
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                entries[n] = c;
+            }
+        }
+    };
+
+    inline uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0){
+        static const CrcTable table;
+        crc = ~crc;
+        for(size_t i = 0; i < size; i++){
+            crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    inline void writeChunk(std::vector<uint8_t> &out, const char* type, const uint8_t* data, size_t size){
+        for(int shift = 24; shift >= 0; shift -= 8){
+            out.push_back(static_cast<uint8_t>(size >> shift));
+        }
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data, data + size);
+        uint32_t crc = crc32(out.data() + start, size + 4);
+        for(int shift = 24; shift >= 0; shift -= 8){
+            out.push_back(static_cast<uint8_t>(crc >> shift));
+        }
+    }
+
+    // pixels are tightly packed rows, top row first
+    inline std::vector<uint8_t> encode(const uint8_t* pixels, uint32_t width, uint32_t height, int channels){
+        static const uint8_t colorTypes[5] = { 0, 0, 4, 2, 6 };
+        size_t stride = static_cast<size_t>(width) * channels;
+        std::vector<uint8_t> filtered((stride + 1) * height);
+        std::vector<uint8_t> candidate(stride);
+        for(uint32_t y = 0; y < height; y++){
+            const uint8_t* row = pixels + y * stride;
+            const uint8_t* above = y > 0 ? row - stride : NULL;
+            uint8_t* target = &filtered[y * (stride + 1)];
+            uint64_t bestScore = UINT64_MAX;
+            for(uint8_t filter = FILTER_NONE; filter <= FILTER_PAETH; filter++){
+                uint64_t score = 0;
+                for(size_t x = 0; x < stride; x++){
+                    int left = x >= static_cast<size_t>(channels) ? row[x - channels] : 0;
+                    int up = above ? above[x] : 0;
+                    int upLeft = above && x >= static_cast<size_t>(channels) ? above[x - channels] : 0;
+                    int predicted = filter == FILTER_SUB ? left : filter == FILTER_UP ? up : filter == FILTER_AVG ? (left + up) / 2 : filter == FILTER_PAETH ? paeth(left, up, upLeft) : 0;
+                    candidate[x] = static_cast<uint8_t>(row[x] - predicted);
+                    score += candidate[x] < 128 ? candidate[x] : 256 - candidate[x];
+                }
+                if(score < bestScore){
+                    bestScore = score;
+                    target[0] = filter;
+                    memcpy(target + 1, candidate.data(), stride);
+                }
+            }
+        }
+
+        std::vector<uint8_t> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        uint8_t header[13] = {
+            static_cast<uint8_t>(width >> 24), static_cast<uint8_t>(width >> 16), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width),
+            static_cast<uint8_t>(height >> 24), static_cast<uint8_t>(height >> 16), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+            8, colorTypes[channels], 0, 0, 0
+        };
+        writeChunk(out, "IHDR", header, sizeof(header));
+        std::vector<uint8_t> compressed = deflateZlib(filtered.data(), filtered.size());
+        writeChunk(out, "IDAT", compressed.data(), compressed.size());
+        writeChunk(out, "IEND", NULL, 0);
+        return out;
+    }
+
+    inline bool writeFile(const std::string &path, const uint8_t* pixels, uint32_t width, uint32_t height, int channels){
+        std::vector<uint8_t> png = encode(pixels, width, height, channels);
+        FILE* file = fopen(path.c_str(), "wb");
+        if(file == NULL){
+            return false;
+        }
+        bool written = fwrite(png.data(), 1, png.size(), file) == png.size();
+        return fclose(file) == 0 && written;
+    }
+}
+
+#endif
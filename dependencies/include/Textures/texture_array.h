@@ -0,0 +1,338 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <glad/glad.h>
+#include <GLExt/gl_ext.h>
+#include <Profiling/gpu_resources.h>
+#include <Textures/texture_container.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Packs textures that share format, size and mip count into the layers of
+// GL_TEXTURE_2D_ARRAY objects. Materials then refer to (array, layer) pairs instead of
+// texture objects: the layer travels with the instance data, and any instances whose
+// textures live in the same arrays can be drawn with one call and one set of binds.
+//
+// GL arrays can't grow in place, so every array is created with a fixed layer capacity
+// and a new array is opened when all layers of a matching one are taken.
+//
+// Streamable allocators skip immutable storage so the finest mips of an array can be
+// released and reallocated later (see setBaseLevel and TextureResidency).
+
+struct TextureArrayKey {
+    GLenum internalFormat = GL_RGBA8;
+    GLenum format = GL_RGBA;          // 0 for block compressed formats
+    GLenum type = GL_UNSIGNED_BYTE;   // 0 for block compressed formats
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levels = 1;
+    uint32_t flags = 0;               // TextureContainer::Flags, swizzles are per texture object
+
+    bool compressed() const{
+        return (flags & TextureContainer::FLAG_COMPRESSED) != 0;
+    }
+
+    bool operator==(const TextureArrayKey &other) const{
+        return internalFormat == other.internalFormat && format == other.format && type == other.type &&
+               width == other.width && height == other.height && levels == other.levels && flags == other.flags;
+    }
+
+    static TextureArrayKey fromFile(const TextureFile &file){
+        const TextureContainer::Header &header = file.header();
+        TextureArrayKey key;
+        key.internalFormat = header.glInternalFormat;
+        key.format = header.glFormat;
+        key.type = header.glType;
+        key.width = header.width;
+        key.height = header.height;
+        key.levels = header.levelCount;
+        key.flags = header.flags & (TextureContainer::FLAG_COMPRESSED | TextureContainer::FLAG_SWIZZLE_RRR1);
+        return key;
+    }
+};
+
+struct TextureSlot {
+    int array = -1;
+    uint32_t layer = 0;
+
+    bool valid() const{
+        return array >= 0;
+    }
+};
+
+class TextureArrayAllocator {
+    public:
+        struct Stats {
+            uint32_t arrays = 0;
+            uint32_t layersUsed = 0;
+            uint32_t layersCapacity = 0;
+            float fragmentation = 0.0f;     // share of reserved layers that are free
+            size_t bytesReserved = 0;       // VRAM held by all arrays
+            size_t bytesUsed = 0;           // part of it backing live layers
+            uint64_t bindsRequested = 0;
+            uint64_t bindsIssued = 0;
+            uint64_t rebindsAvoided = 0;    // skipped redundant binds + per material binds merged into batches
+        };
+
+        static const int MAX_UNITS = 16;
+
+        explicit TextureArrayAllocator(uint32_t layersPerArray = 8, bool streamable = false) : layersPerArray(layersPerArray), streamable(streamable){
+            for(int i = 0; i < MAX_UNITS; i++){
+                boundArrays[i] = -1;
+            }
+        }
+
+        TextureSlot allocate(const TextureArrayKey &key){
+            for(size_t i = 0; i < arrays.size(); i++){
+                TextureArray &array = arrays[i];
+                if(!(array.key == key) || array.usedCount == array.used.size()){
+                    continue;
+                }
+                for(uint32_t layer = 0; layer < array.used.size(); layer++){
+                    if(!array.used[layer]){
+                        array.used[layer] = true;
+                        array.usedCount++;
+                        return TextureSlot{ static_cast<int>(i), layer };
+                    }
+                }
+            }
+            arrays.push_back(createArray(key));
+            arrays.back().used[0] = true;
+            arrays.back().usedCount = 1;
+            return TextureSlot{ static_cast<int>(arrays.size() - 1), 0 };
+        }
+
+        // the layer keeps its old texels until it's reused
+        void release(const TextureSlot &slot){
+            if(!slot.valid() || slot.array >= static_cast<int>(arrays.size())){
+                return;
+            }
+            TextureArray &array = arrays[slot.array];
+            if(array.used[slot.layer]){
+                array.used[slot.layer] = false;
+                array.usedCount--;
+            }
+        }
+
+        // size is only read for compressed formats
+        void uploadLevel(const TextureSlot &slot, uint32_t level, uint32_t width, uint32_t height, const void* data, size_t size){
+            const TextureArray &array = arrays[slot.array];
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            if(array.key.compressed()){
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, slot.layer, width, height, 1,
+                    array.key.internalFormat, static_cast<GLsizei>(size), data);
+            }
+            else{
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, slot.layer, width, height, 1,
+                    array.key.format, array.key.type, data);
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            forgetBindings();
+        }
+
+        // copies every level of a cooked texture into the slot's layer, straight from the mapping
+        bool uploadFile(const TextureSlot &slot, const TextureFile &file){
+            if(!slot.valid() || !(arrays[slot.array].key == TextureArrayKey::fromFile(file))){
+                return false;
+            }
+            for(uint32_t level = 0; level < file.levelCount(); level++){
+                const TextureContainer::LevelIndex &index = file.level(level);
+                uploadLevel(slot, level, index.width, index.height, file.levelData(level), file.levelSize(level));
+            }
+            return true;
+        }
+
+        GLuint texture(int array) const{
+            return arrays[array].texture;
+        }
+
+        const TextureArrayKey& key(int array) const{
+            return arrays[array].key;
+        }
+
+        size_t arrayCount() const{
+            return arrays.size();
+        }
+
+        uint32_t layerCount() const{
+            return layersPerArray;
+        }
+
+        bool isStreamable() const{
+            return streamable;
+        }
+
+        // finest level with storage, always 0 unless the allocator is streamable
+        uint32_t baseLevel(int array) const{
+            return arrays[array].baseLevel;
+        }
+
+        // streamable allocators only: releases the storage of every level finer than base and
+        // allocates any missing level from base on. Newly allocated levels are undefined until
+        // each live layer is uploaded again.
+        void setBaseLevel(int array, uint32_t base){
+            TextureArray &target = arrays[array];
+            base = base < target.key.levels ? base : target.key.levels - 1;
+            if(!streamable || base == target.baseLevel){
+                return;
+            }
+            glBindTexture(GL_TEXTURE_2D_ARRAY, target.texture);
+            for(uint32_t level = 0; level < target.key.levels; level++){
+                bool wanted = level >= base;
+                bool allocated = level >= target.baseLevel;
+                if(wanted != allocated){
+                    specifyLevel(target.key, level, wanted);
+                }
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, base);
+            target.baseLevel = base;
+            forgetBindings();
+        }
+
+        // binds an array to a texture unit unless it is already bound there
+        void bind(int unit, int array){
+            stats_.bindsRequested++;
+            if(unit < MAX_UNITS && boundArrays[unit] == array){
+                stats_.rebindsAvoided++;
+                return;
+            }
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array >= 0 ? arrays[array].texture : 0);
+            if(unit < MAX_UNITS){
+                boundArrays[unit] = array;
+            }
+            stats_.bindsIssued++;
+        }
+
+        // a batch drawing distinctMaterials materials with one set of binds saves the binds
+        // a texture-per-material path would have issued on every material switch
+        void recordBatch(uint32_t distinctMaterials, uint32_t texturesPerMaterial){
+            if(distinctMaterials > 1){
+                stats_.rebindsAvoided += static_cast<uint64_t>(distinctMaterials - 1) * texturesPerMaterial;
+            }
+        }
+
+        // call when texture units were changed behind the allocator's back
+        void forgetBindings(){
+            for(int i = 0; i < MAX_UNITS; i++){
+                boundArrays[i] = -1;
+            }
+        }
+
+        Stats stats() const{
+            Stats result = stats_;
+            result.arrays = static_cast<uint32_t>(arrays.size());
+            for(const TextureArray &array : arrays){
+                size_t layerBytes = bytesPerLayer(array.key, array.baseLevel);
+                result.layersUsed += array.usedCount;
+                result.layersCapacity += static_cast<uint32_t>(array.used.size());
+                result.bytesReserved += layerBytes * array.used.size();
+                result.bytesUsed += layerBytes * array.usedCount;
+            }
+            if(result.layersCapacity > 0){
+                result.fragmentation = 1.0f - static_cast<float>(result.layersUsed) / result.layersCapacity;
+            }
+            return result;
+        }
+
+        void destroy(){
+            for(TextureArray &array : arrays){
+                glDeleteTextures(1, &array.texture);
+            }
+            arrays.clear();
+            forgetBindings();
+        }
+
+        // bytes of one layer including its mips, from firstLevel down to 1x1
+        static size_t bytesPerLayer(const TextureArrayKey &key, uint32_t firstLevel = 0){
+            size_t total = 0;
+            for(uint32_t level = firstLevel; level < key.levels; level++){
+                total += levelBytes(key, levelWidth(key, level), levelHeight(key, level));
+            }
+            return total;
+        }
+
+        static uint32_t levelWidth(const TextureArrayKey &key, uint32_t level){
+            uint32_t width = key.width >> level;
+            return width > 0 ? width : 1;
+        }
+
+        static uint32_t levelHeight(const TextureArrayKey &key, uint32_t level){
+            uint32_t height = key.height >> level;
+            return height > 0 ? height : 1;
+        }
+
+        static size_t levelBytes(const TextureArrayKey &key, uint32_t width, uint32_t height){
+            return static_cast<size_t>(TextureContainer::levelBytes(key.internalFormat, key.format, key.type, key.flags, width, height));
+        }
+
+    private:
+        struct TextureArray {
+            TextureArrayKey key;
+            GLuint texture = 0;
+            std::vector<bool> used;
+            uint32_t usedCount = 0;
+            uint32_t baseLevel = 0;
+        };
+
+        uint32_t layersPerArray;
+        bool streamable;
+        std::vector<TextureArray> arrays;
+        int boundArrays[MAX_UNITS];
+        Stats stats_;
+
+        TextureArray createArray(const TextureArrayKey &key){
+            TextureArray array;
+            array.key = key;
+            array.used.assign(layersPerArray, false);
+            GPU_RESOURCE_SITE();
+            glGenTextures(1, &array.texture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+            GpuResources::label(GpuResources::TEXTURE, array.texture, "texture array " + std::to_string(key.width) + "x" + std::to_string(key.height) + " " + std::to_string(arrays.size()));
+            if(streamable){
+                // only the 1x1 level to start with, the residency manager moves the base level from there
+                array.baseLevel = key.levels - 1;
+                specifyLevel(key, array.baseLevel, true);
+            }
+            else if(GLExt::hasTextureStorage){
+                GLExt::TexStorage3D(GL_TEXTURE_2D_ARRAY, key.levels, key.internalFormat, key.width, key.height, layersPerArray);
+            }
+            else{
+                for(uint32_t level = 0; level < key.levels; level++){
+                    specifyLevel(key, level, true);
+                }
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, array.baseLevel);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, key.levels - 1);
+            if(key.flags & TextureContainer::FLAG_SWIZZLE_RRR1){
+                const GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+                glTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+            }
+            forgetBindings();
+            return array;
+        }
+
+        // (re)defines one level of the bound array, a released level is resized to 0x0x0
+        void specifyLevel(const TextureArrayKey &key, uint32_t level, bool allocate){
+            GLsizei width = allocate ? levelWidth(key, level) : 0;
+            GLsizei height = allocate ? levelHeight(key, level) : 0;
+            GLsizei depth = allocate ? layersPerArray : 0;
+            if(key.compressed()){
+                // contents are undefined until each layer is uploaded
+                glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, key.internalFormat, width, height, depth, 0,
+                    static_cast<GLsizei>(levelBytes(key, width, height) * depth), NULL);
+            }
+            else{
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, level, key.internalFormat, width, height, depth, 0, key.format, key.type, NULL);
+            }
+        }
+};
+
+#endif
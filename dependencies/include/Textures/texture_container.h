@@ -0,0 +1,266 @@
+#ifndef TEXTURE_CONTAINER_H
+#define TEXTURE_CONTAINER_H
+
+#include <glad/glad.h>
+#include <FileIO/mapped_file.h>
+#include <GLExt/gl_ext.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Cooked texture container (.gtex). Laid out like a stripped down KTX2 file:
+//
+//   Header                    fixed size, little endian
+//   LevelIndex[levelCount]    one entry per mip, level 0 (largest) first
+//   level data                smallest mip first so a partial read streams coarse mips,
+//                             each level aligned to LEVEL_ALIGNMENT
+//
+// Level data is already in the layout glTexSubImage2D / glCompressedTexSubImage2D expect
+// (tightly packed rows or 4x4 blocks, GL_UNPACK_ALIGNMENT 1), so a loader can hand pointers into the mapped file straight to GL.
+
+namespace TextureContainer {
+
+    const uint8_t IDENTIFIER[12] = { 0xAB, 'G', 'T', 'E', 'X', ' ', '1', '0', 0xBB, '\r', '\n', 0x1A };
+    const uint32_t VERSION = 1;
+    const uint32_t LEVEL_ALIGNMENT = 16;
+
+    enum Flags : uint32_t {
+        FLAG_SRGB = 1u << 0,
+        FLAG_COMPRESSED = 1u << 1,       // glInternalFormat is a block format, glFormat / glType are 0
+        FLAG_SWIZZLE_RRR1 = 1u << 2      // single channel data that should sample as greyscale
+    };
+
+    struct Header {
+        uint8_t identifier[12];
+        uint32_t version;
+        uint32_t glInternalFormat;   // sized internal format, e.g. GL_RGBA8
+        uint32_t glFormat;           // pixel transfer format, e.g. GL_RGBA (0 when compressed)
+        uint32_t glType;             // pixel transfer type, e.g. GL_UNSIGNED_BYTE (0 when compressed)
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+        uint32_t flags;
+        uint32_t reserved[5];
+    };
+
+    struct LevelIndex {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    static_assert(sizeof(Header) == 64, "Header layout is part of the file format");
+    static_assert(sizeof(LevelIndex) == 24, "LevelIndex layout is part of the file format");
+
+    // one mip level in memory, as produced by the cooker
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct Desc {
+        uint32_t glInternalFormat;
+        uint32_t glFormat;
+        uint32_t glType;
+        uint32_t flags;
+    };
+
+    inline uint32_t mipCount(uint32_t width, uint32_t height){
+        uint32_t levels = 1;
+        while(width > 1 || height > 1){
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+            levels++;
+        }
+        return levels;
+    }
+
+    // sized internal / transfer formats for 8 bit images with 1-4 channels
+    inline Desc descForChannels(int channels, bool srgb){
+        Desc desc = { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, srgb ? FLAG_SRGB : 0u };
+        switch(channels){
+            case 1: desc.glInternalFormat = GL_R8; desc.glFormat = GL_RED; break;
+            case 2: desc.glInternalFormat = GL_RG8; desc.glFormat = GL_RG; break;
+            case 3: desc.glInternalFormat = srgb ? GL_SRGB8 : GL_RGB8; desc.glFormat = GL_RGB; break;
+            default: desc.glInternalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8; desc.glFormat = GL_RGBA; break;
+        }
+        return desc;
+    }
+
+    // bytes of one width x height level as the cooker lays it out, 0 for a format it never writes
+    inline uint64_t levelBytes(uint32_t glInternalFormat, uint32_t glFormat, uint32_t glType, uint32_t flags, uint32_t width, uint32_t height){
+        if(flags & FLAG_COMPRESSED){
+            uint64_t blockBytes = 0;
+            switch(glInternalFormat){
+                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+                case GL_COMPRESSED_RED_RGTC1:
+                    blockBytes = 8;
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+                case GL_COMPRESSED_RG_RGTC2:
+                case GL_COMPRESSED_RGBA_BPTC_UNORM:
+                case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+                    blockBytes = 16;
+                    break;
+            }
+            return static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+        }
+        uint64_t channels = 0;
+        switch(glInternalFormat){
+            case GL_R8: channels = glFormat == GL_RED ? 1 : 0; break;
+            case GL_RG8: channels = glFormat == GL_RG ? 2 : 0; break;
+            case GL_RGB8: case GL_SRGB8: channels = glFormat == GL_RGB ? 3 : 0; break;
+            case GL_RGBA8: case GL_SRGB8_ALPHA8: channels = glFormat == GL_RGBA ? 4 : 0; break;
+        }
+        return glType == GL_UNSIGNED_BYTE ? static_cast<uint64_t>(width) * height * channels : 0;
+    }
+
+    inline uint64_t alignUp(uint64_t value, uint64_t alignment){
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // levels[0] is the full resolution image
+    inline bool write(const std::string &path, const Desc &desc, const std::vector<Level> &levels){
+        if(levels.empty()){
+            return false;
+        }
+
+        Header header = {};
+        memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+        header.version = VERSION;
+        header.glInternalFormat = desc.glInternalFormat;
+        header.glFormat = desc.glFormat;
+        header.glType = desc.glType;
+        header.width = levels[0].width;
+        header.height = levels[0].height;
+        header.levelCount = static_cast<uint32_t>(levels.size());
+        header.flags = desc.flags;
+
+        std::vector<LevelIndex> index(levels.size());
+        uint64_t offset = alignUp(sizeof(Header) + sizeof(LevelIndex) * levels.size(), LEVEL_ALIGNMENT);
+        for(size_t i = levels.size(); i-- > 0;){
+            index[i].byteOffset = offset;
+            index[i].byteLength = levels[i].bytes.size();
+            index[i].width = levels[i].width;
+            index[i].height = levels[i].height;
+            offset = alignUp(offset + levels[i].bytes.size(), LEVEL_ALIGNMENT);
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if(!out){
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(index.data()), sizeof(LevelIndex) * index.size());
+
+        const char padding[LEVEL_ALIGNMENT] = {};
+        uint64_t written = sizeof(Header) + sizeof(LevelIndex) * index.size();
+        for(size_t i = levels.size(); i-- > 0;){
+            out.write(padding, static_cast<std::streamsize>(index[i].byteOffset - written));
+            out.write(reinterpret_cast<const char*>(levels[i].bytes.data()), static_cast<std::streamsize>(levels[i].bytes.size()));
+            written = index[i].byteOffset + index[i].byteLength;
+        }
+        return static_cast<bool>(out);
+    }
+}
+
+// Read side of the container. The file stays mapped for the lifetime of the object and
+// levelData() points straight into the mapping.
+class TextureFile {
+    public:
+        bool open(const std::string &path){
+            if(!file.open(path)){
+                return false;
+            }
+            if(!validate()){
+                file.close();
+                return false;
+            }
+            return true;
+        }
+
+        void close(){
+            file.close();
+        }
+
+        bool isOpen() const{
+            return file.isOpen();
+        }
+
+        const TextureContainer::Header& header() const{
+            return *reinterpret_cast<const TextureContainer::Header*>(file.data());
+        }
+
+        uint32_t levelCount() const{
+            return header().levelCount;
+        }
+
+        const TextureContainer::LevelIndex& level(uint32_t i) const{
+            return index()[i];
+        }
+
+        const uint8_t* levelData(uint32_t i) const{
+            return file.data() + index()[i].byteOffset;
+        }
+
+        size_t levelSize(uint32_t i) const{
+            return static_cast<size_t>(index()[i].byteLength);
+        }
+
+        // bytes of level data for levels [baseLevel, levelCount)
+        size_t byteSize(uint32_t baseLevel = 0) const{
+            size_t total = 0;
+            for(uint32_t i = baseLevel; i < levelCount(); i++){
+                total += levelSize(i);
+            }
+            return total;
+        }
+
+        const MappedFile& mapping() const{
+            return file;
+        }
+
+    private:
+        MappedFile file;
+
+        const TextureContainer::LevelIndex* index() const{
+            return reinterpret_cast<const TextureContainer::LevelIndex*>(file.data() + sizeof(TextureContainer::Header));
+        }
+
+        bool validate() const{
+            if(file.size() < sizeof(TextureContainer::Header)){
+                return false;
+            }
+            const TextureContainer::Header &h = header();
+            if(memcmp(h.identifier, TextureContainer::IDENTIFIER, sizeof(TextureContainer::IDENTIFIER)) != 0 ||
+               h.version != TextureContainer::VERSION || h.width == 0 || h.height == 0 ||
+               h.levelCount == 0 || h.levelCount > TextureContainer::mipCount(h.width, h.height)){
+                return false;
+            }
+            if(file.size() < sizeof(TextureContainer::Header) + sizeof(TextureContainer::LevelIndex) * h.levelCount){
+                return false;
+            }
+            // the loaders hand levelData() to GL with the index dims, so every level has to hold
+            // exactly the bytes its mip size needs in a format the cooker writes
+            for(uint32_t i = 0; i < h.levelCount; i++){
+                const TextureContainer::LevelIndex &l = index()[i];
+                uint32_t width = h.width >> i > 0 ? h.width >> i : 1;
+                uint32_t height = h.height >> i > 0 ? h.height >> i : 1;
+                uint64_t bytes = TextureContainer::levelBytes(h.glInternalFormat, h.glFormat, h.glType, h.flags, width, height);
+                if(l.width != width || l.height != height || bytes == 0 || l.byteLength != bytes ||
+                   l.byteOffset > file.size() || l.byteLength > file.size() - l.byteOffset){
+                    return false;
+                }
+            }
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <GLExt/gl_ext.h>
+#include <Textures/texture_container.h>
+
+// Uploads levels [baseLevel, levelCount) of a cooked texture into the texture currently
+// bound to target, reading straight out of the file mapping. Uses immutable storage
+// (glTexStorage2D) when the context has it and falls back to one glTexImage2D per level.
+// Block compressed containers go through the glCompressedTex* variants.
+inline bool uploadTextureFile(const TextureFile &file, GLenum target = GL_TEXTURE_2D, uint32_t baseLevel = 0){
+    if(!file.isOpen() || baseLevel >= file.levelCount()){
+        return false;
+    }
+    const TextureContainer::Header &header = file.header();
+    GLsizei levels = static_cast<GLsizei>(file.levelCount() - baseLevel);
+    bool compressed = (header.flags & TextureContainer::FLAG_COMPRESSED) != 0;
+
+    GLint previousAlignment = 4;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    const TextureContainer::LevelIndex &top = file.level(baseLevel);
+    if(GLExt::hasTextureStorage){
+        GLExt::TexStorage2D(target, levels, header.glInternalFormat, top.width, top.height);
+    }
+    for(GLsizei i = 0; i < levels; i++){
+        uint32_t source = baseLevel + static_cast<uint32_t>(i);
+        const TextureContainer::LevelIndex &level = file.level(source);
+        GLsizei size = static_cast<GLsizei>(file.levelSize(source));
+        if(compressed && GLExt::hasTextureStorage){
+            glCompressedTexSubImage2D(target, i, 0, 0, level.width, level.height, header.glInternalFormat, size, file.levelData(source));
+        }
+        else if(compressed){
+            glCompressedTexImage2D(target, i, header.glInternalFormat, level.width, level.height, 0, size, file.levelData(source));
+        }
+        else if(GLExt::hasTextureStorage){
+            glTexSubImage2D(target, i, 0, 0, level.width, level.height, header.glFormat, header.glType, file.levelData(source));
+        }
+        else{
+            glTexImage2D(target, i, header.glInternalFormat, level.width, level.height, 0, header.glFormat, header.glType, file.levelData(source));
+        }
+    }
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    if(header.flags & TextureContainer::FLAG_SWIZZLE_RRR1){
+        const GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+    return true;
+}
+
+#endif
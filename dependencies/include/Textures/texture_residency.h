@@ -0,0 +1,344 @@
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include <Rendering/frame_pipeline.h>
+#include <Textures/texture_array.h>
+#include <Textures/texture_container.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Keeps texture memory under a budget by streaming mips in and out of a streamable
+// TextureArrayAllocator.
+//
+// Every frame the renderer reports which textures it drew and the finest mip it needs
+// for each (estimateLevel gives a CPU estimate from the on-screen texel density). update()
+// then moves each array's GL_TEXTURE_BASE_LEVEL towards the finest level any of its layers
+// asked for, dropping finer mips of the least recently used arrays while the total is over
+// budget. The base level is a property of the texture object, so residency is decided per
+// array; a texture's resident bytes are its layer's share of that.
+//
+// Mips no larger than MIN_RESIDENT_SIZE are never evicted, so every texture can always be
+// sampled. Streaming in is capped at uploadBytesPerFrame (at least one level per frame) so a
+// fast camera move can't stall a single frame on uploads. With a staging ring set, streamed
+// levels are copied into the frame's slot of a pixel unpack buffer and uploaded from there,
+// so the driver doesn't have to copy them out of client memory before returning.
+
+class TextureResidency {
+    public:
+        struct Stats {
+            size_t budgetBytes = 0;
+            size_t residentBytes = 0;
+            uint32_t textures = 0;
+            uint64_t levelsStreamedIn = 0;
+            uint64_t levelsStreamedOut = 0;
+            uint64_t bytesStreamedIn = 0;
+            uint64_t evictions = 0;          // levels dropped because of the budget rather than distance
+        };
+
+        static const uint32_t MIN_RESIDENT_SIZE = 64;
+
+        explicit TextureResidency(TextureArrayAllocator &arrays, size_t budgetBytes = 64u << 20, size_t uploadBytesPerFrame = 4u << 20)
+            : arrays(arrays), budgetBytes(budgetBytes), uploadBytesPerFrame(uploadBytesPerFrame){}
+
+        void setBudget(size_t bytes){
+            budgetBytes = bytes;
+        }
+
+        size_t budget() const{
+            return budgetBytes;
+        }
+
+        // a GL_PIXEL_UNPACK_BUFFER ring, begun for the frame before update(); NULL uploads from client memory
+        void setStaging(FrameRing* ring){
+            staging = ring;
+        }
+
+        // the cooked file stays mapped so evicted levels can be streamed back from it
+        void track(const TextureSlot &slot, TextureFile &&file){
+            Texture texture;
+            texture.slot = slot;
+            texture.file = std::move(file);
+            add(std::move(texture));
+        }
+
+        // CPU side levels (level 0 first) for textures that only exist as source images
+        void track(const TextureSlot &slot, std::vector<TextureContainer::Level> &&levels){
+            Texture texture;
+            texture.slot = slot;
+            texture.levels = std::move(levels);
+            add(std::move(texture));
+        }
+
+        void untrack(const TextureSlot &slot){
+            for(size_t i = 0; i < textures.size(); i++){
+                if(sameSlot(textures[i].slot, slot)){
+                    textures.erase(textures.begin() + i);
+                    return;
+                }
+            }
+        }
+
+        // marks the texture as used this frame and needing at least the given mip
+        void request(const TextureSlot &slot, uint32_t level){
+            Texture* texture = find(slot);
+            if(texture == NULL){
+                return;
+            }
+            if(texture->lastUsed != frame){
+                texture->lastUsed = frame;
+                texture->requested = level;
+            }
+            else{
+                texture->requested = std::min(texture->requested, level);
+            }
+        }
+
+        // mip whose texels come out about pixel sized for a surface at distance, with the
+        // texture stretched over worldSize units and a perspective camera of the given fovY
+        uint32_t estimateLevel(const TextureSlot &slot, float worldSize, float distance, float fovY, float viewportHeight) const{
+            if(!slot.valid()){
+                return 0;
+            }
+            const TextureArrayKey &key = arrays.key(slot.array);
+            float pixelsPerUnit = viewportHeight / (2.0f * std::max(distance, 1e-3f) * std::tan(fovY * 0.5f));
+            float texelsPerPixel = static_cast<float>(std::max(key.width, key.height)) / (worldSize * pixelsPerUnit);
+            if(texelsPerPixel <= 1.0f){
+                return 0;
+            }
+            uint32_t level = static_cast<uint32_t>(std::floor(std::log2(texelsPerPixel)));
+            return std::min(level, key.levels - 1);
+        }
+
+        // call once per frame after the frame's requests and before drawing
+        void update(){
+            if(!arrays.isStreamable()){
+                frame++;
+                return;
+            }
+            std::vector<ArrayState> states(arrays.arrayCount());
+            for(size_t i = 0; i < states.size(); i++){
+                states[i].tail = tailLevel(arrays.key(static_cast<int>(i)));
+                states[i].target = states[i].tail;
+            }
+            for(Texture &texture : textures){
+                ArrayState &state = states[texture.slot.array];
+                state.tracked = true;
+                state.target = std::min(state.target, texture.requested);
+                state.lastUsed = std::max(state.lastUsed, texture.lastUsed);
+            }
+
+            // over budget: coarsen the least recently used arrays first, finest mips first within a tie
+            size_t total = 0;
+            for(size_t i = 0; i < states.size(); i++){
+                total += arrayBytes(static_cast<int>(i), states[i].tracked ? states[i].target : arrays.baseLevel(static_cast<int>(i)));
+            }
+            while(total > budgetBytes){
+                int victim = -1;
+                for(size_t i = 0; i < states.size(); i++){
+                    const ArrayState &state = states[i];
+                    if(!state.tracked || state.target >= state.tail){
+                        continue;
+                    }
+                    if(victim < 0 || state.lastUsed < states[victim].lastUsed ||
+                       (state.lastUsed == states[victim].lastUsed && state.target < states[victim].target)){
+                        victim = static_cast<int>(i);
+                    }
+                }
+                if(victim < 0){
+                    break;
+                }
+                total -= arrayBytes(victim, states[victim].target) - arrayBytes(victim, states[victim].target + 1);
+                states[victim].target++;
+                stats_.evictions++;
+            }
+
+            // dropping levels is free, do it first so the new uploads fit
+            for(size_t i = 0; i < states.size(); i++){
+                int array = static_cast<int>(i);
+                uint32_t base = arrays.baseLevel(array);
+                if(states[i].tracked && states[i].target > base){
+                    arrays.setBaseLevel(array, states[i].target);
+                    stats_.levelsStreamedOut += states[i].target - base;
+                }
+            }
+
+            size_t uploaded = 0;
+            bool progress = true;
+            while(progress){
+                progress = false;
+                for(size_t i = 0; i < states.size(); i++){
+                    int array = static_cast<int>(i);
+                    uint32_t base = arrays.baseLevel(array);
+                    if(!states[i].tracked || states[i].target >= base){
+                        continue;
+                    }
+                    size_t levelBytes = layerLevelBytes(array, base - 1) * layersTracked(array);
+                    if(uploaded > 0 && uploaded + levelBytes > uploadBytesPerFrame){
+                        continue;
+                    }
+                    streamIn(array, base - 1);
+                    uploaded += levelBytes;
+                    progress = true;
+                }
+            }
+
+            frame++;
+        }
+
+        // bytes this texture keeps in video memory, its layer's share of its array
+        size_t residentBytes(const TextureSlot &slot) const{
+            if(!slot.valid()){
+                return 0;
+            }
+            return TextureArrayAllocator::bytesPerLayer(arrays.key(slot.array), arrays.baseLevel(slot.array));
+        }
+
+        // bytes held by every array, including layers that are allocated but unused
+        size_t residentBytes() const{
+            size_t total = 0;
+            for(size_t i = 0; i < arrays.arrayCount(); i++){
+                total += arrayBytes(static_cast<int>(i), arrays.baseLevel(static_cast<int>(i)));
+            }
+            return total;
+        }
+
+        uint32_t residentLevel(const TextureSlot &slot) const{
+            return slot.valid() ? arrays.baseLevel(slot.array) : 0;
+        }
+
+        Stats stats() const{
+            Stats result = stats_;
+            result.budgetBytes = budgetBytes;
+            result.residentBytes = residentBytes();
+            result.textures = static_cast<uint32_t>(textures.size());
+            return result;
+        }
+
+    private:
+        struct Texture {
+            TextureSlot slot;
+            TextureFile file;                                  // cooked source, or
+            std::vector<TextureContainer::Level> levels;       // decoded source
+            uint32_t requested = 0;
+            uint64_t lastUsed = 0;
+
+            const void* levelData(uint32_t level) const{
+                return file.isOpen() ? static_cast<const void*>(file.levelData(level)) : static_cast<const void*>(levels[level].bytes.data());
+            }
+
+            size_t levelSize(uint32_t level) const{
+                return file.isOpen() ? file.levelSize(level) : levels[level].bytes.size();
+            }
+        };
+
+        struct ArrayState {
+            uint32_t target = 0;
+            uint32_t tail = 0;
+            uint64_t lastUsed = 0;
+            bool tracked = false;
+        };
+
+        TextureArrayAllocator &arrays;
+        size_t budgetBytes;
+        size_t uploadBytesPerFrame;
+        std::vector<Texture> textures;
+        uint64_t frame = 1;
+        Stats stats_;
+        FrameRing* staging = NULL;
+
+        static bool sameSlot(const TextureSlot &a, const TextureSlot &b){
+            return a.array == b.array && a.layer == b.layer;
+        }
+
+        Texture* find(const TextureSlot &slot){
+            for(Texture &texture : textures){
+                if(sameSlot(texture.slot, slot)){
+                    return &texture;
+                }
+            }
+            return NULL;
+        }
+
+        void add(Texture &&texture){
+            if(!texture.slot.valid()){
+                return;
+            }
+            untrack(texture.slot);
+            const TextureArrayKey &key = arrays.key(texture.slot.array);
+            texture.requested = tailLevel(key);
+            texture.lastUsed = frame;
+            if(arrays.baseLevel(texture.slot.array) > texture.requested){
+                // a fresh array, bring in the mips that always stay resident for every layer
+                // tracked so far, the new one is uploaded below
+                uint32_t base = arrays.baseLevel(texture.slot.array);
+                arrays.setBaseLevel(texture.slot.array, texture.requested);
+                for(uint32_t level = texture.requested; level < base; level++){
+                    uploadLevel(texture.slot.array, level);
+                }
+            }
+            for(uint32_t level = arrays.baseLevel(texture.slot.array); level < key.levels; level++){
+                arrays.uploadLevel(texture.slot, level, TextureArrayAllocator::levelWidth(key, level), TextureArrayAllocator::levelHeight(key, level),
+                    texture.levelData(level), texture.levelSize(level));
+            }
+            textures.push_back(std::move(texture));
+        }
+
+        void streamIn(int array, uint32_t level){
+            arrays.setBaseLevel(array, level);
+            uploadLevel(array, level);
+            stats_.levelsStreamedIn++;
+            stats_.bytesStreamedIn += layerLevelBytes(array, level) * layersTracked(array);
+        }
+
+        // uploads one level of every tracked layer in the array
+        void uploadLevel(int array, uint32_t level){
+            const TextureArrayKey &key = arrays.key(array);
+            for(const Texture &texture : textures){
+                if(texture.slot.array != array){
+                    continue;
+                }
+                const void* data = texture.levelData(level);
+                if(staging != NULL){
+                    // with the unpack buffer bound the data pointer is an offset into it
+                    data = reinterpret_cast<const void*>(staging->write(data, texture.levelSize(level)));
+                }
+                arrays.uploadLevel(texture.slot, level, TextureArrayAllocator::levelWidth(key, level), TextureArrayAllocator::levelHeight(key, level),
+                    data, texture.levelSize(level));
+                if(staging != NULL){
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                }
+            }
+        }
+
+        uint32_t layersTracked(int array) const{
+            uint32_t count = 0;
+            for(const Texture &texture : textures){
+                count += texture.slot.array == array ? 1 : 0;
+            }
+            return count;
+        }
+
+        size_t layerLevelBytes(int array, uint32_t level) const{
+            const TextureArrayKey &key = arrays.key(array);
+            return TextureArrayAllocator::levelBytes(key, TextureArrayAllocator::levelWidth(key, level), TextureArrayAllocator::levelHeight(key, level));
+        }
+
+        size_t arrayBytes(int array, uint32_t base) const{
+            return TextureArrayAllocator::bytesPerLayer(arrays.key(array), base) * arrays.layerCount();
+        }
+
+        // first level small enough to stay resident regardless of budget
+        static uint32_t tailLevel(const TextureArrayKey &key){
+            uint32_t level = 0;
+            while(level + 1 < key.levels && std::max(TextureArrayAllocator::levelWidth(key, level), TextureArrayAllocator::levelHeight(key, level)) > MIN_RESIDENT_SIZE){
+                level++;
+            }
+            return level;
+        }
+};
+
+#endif
@@ -0,0 +1,522 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <Profiling/profiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Work stealing job system. Every worker owns a Chase-Lev deque: it pushes and pops jobs at
+// the bottom without locks while idle workers steal from the top of a random victim, so
+// work spawned inside a job stays on the worker that made it (and in its cache) until
+// someone is out of work. Threads that aren't workers submit through a shared queue.
+//
+// Completion is tracked with JobCounters: run() adds one to the job's counter and the job
+// takes one off when it finishes, and a job can be held back until another counter reaches
+// zero, which is how dependencies are expressed. wait() doesn't block while there is work,
+// it runs jobs until the counter is done, so waiting inside a job can't deadlock the pool.
+//
+// GL calls must come from the thread that owns the context: runOnMainThread() queues work
+// for it and that thread runs it from drainMainThread() (once a frame) or while it waits.
+//
+//   JobCounter done;
+//   jobs.run([&]{ cull(); }, &done);
+//   jobs.run([&]{ upload(); }, NULL, &done);      // runs once cull() is finished
+//   jobs.parallelFor(count, [&](size_t begin, size_t end){ ... }, 64);
+//   jobs.wait(done);
+//
+// Workers are pinned to hardware threads 1..N when there are enough of them, leaving
+// hardware thread 0 to the main thread.
+
+class JobSystem;
+
+class JobCounter {
+    public:
+        JobCounter(){}
+
+        // the job that finished last may still be inside the lock when a waiter sees done()
+        ~JobCounter(){
+            std::lock_guard<std::mutex> lock(this->mutex);
+        }
+
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        bool done() const{
+            return this->pending.load(std::memory_order_acquire) == 0;
+        }
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<int64_t> pending{0};
+        std::mutex mutex;                   // guards waiting and the decrements of pending
+        std::vector<void*> waiting;         // jobs held back until pending is 0
+};
+
+// the lock free deque from Lê, Pop, Cohen and Zappa Nardelli, "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (PPoPP 2013); grows when full, retired arrays are
+// kept until the deque is destroyed because a thief may still be reading one
+template<typename T>
+class WorkStealingDeque {
+    public:
+        explicit WorkStealingDeque(int64_t capacity = 256){
+            this->arrays.emplace_back(new Array(capacity));
+            this->array.store(this->arrays.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        // owner only
+        void push(T item){
+            int64_t b = this->bottom.load(std::memory_order_relaxed);
+            int64_t t = this->top.load(std::memory_order_acquire);
+            Array* a = this->array.load(std::memory_order_relaxed);
+            if(b - t > a->capacity - 1){
+                a = grow(a, b, t);
+            }
+            a->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        // owner only, newest first
+        bool pop(T &item){
+            int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+            Array* a = this->array.load(std::memory_order_relaxed);
+            this->bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = this->top.load(std::memory_order_relaxed);
+            if(t > b){
+                this->bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            item = a->get(b);
+            if(t == b){
+                // the last item, a thief may be taking it at the same time
+                bool won = this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                this->bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        // any thread, oldest first; false when empty or another thread got there first
+        bool steal(T &item){
+            int64_t t = this->top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = this->bottom.load(std::memory_order_acquire);
+            if(t >= b){
+                return false;
+            }
+            Array* a = this->array.load(std::memory_order_acquire);
+            item = a->get(t);
+            return this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        bool empty() const{
+            return this->bottom.load(std::memory_order_relaxed) <= this->top.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Array {
+            int64_t capacity;
+            std::unique_ptr<std::atomic<T>[]> items;
+
+            explicit Array(int64_t capacity) : capacity(capacity), items(new std::atomic<T>[capacity]){}
+
+            T get(int64_t index) const{
+                return this->items[index & (this->capacity - 1)].load(std::memory_order_relaxed);
+            }
+
+            void put(int64_t index, T item){
+                this->items[index & (this->capacity - 1)].store(item, std::memory_order_relaxed);
+            }
+        };
+
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        std::atomic<Array*> array;
+        std::vector<std::unique_ptr<Array>> arrays;     // owner only
+
+        Array* grow(Array* old, int64_t b, int64_t t){
+            this->arrays.emplace_back(new Array(old->capacity * 2));
+            Array* bigger = this->arrays.back().get();
+            for(int64_t i = t; i < b; i++){
+                bigger->put(i, old->get(i));
+            }
+            this->array.store(bigger, std::memory_order_release);
+            return bigger;
+        }
+};
+
+class JobSystem {
+    public:
+        struct Stats {
+            uint64_t executed = 0;
+            uint64_t stolen = 0;            // taken from another worker's deque
+            uint64_t mainThreadJobs = 0;
+        };
+
+        // one worker fewer than hardware threads, the thread that waits runs jobs too
+        static uint32_t defaultWorkers(){
+            uint32_t hardware = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+            return hardware - 1;
+        }
+
+        // the process wide pool parallelFor() and the engine use
+        static JobSystem &instance(){
+            static JobSystem jobs;
+            return jobs;
+        }
+
+        explicit JobSystem(uint32_t workers = defaultWorkers(), bool pin = true){
+            this->mainThread = std::this_thread::get_id();
+            for(uint32_t i = 0; i < workers; i++){
+                this->workers.emplace_back(new Worker());
+            }
+            uint32_t hardware = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+            for(uint32_t i = 0; i < workers; i++){
+                this->workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+                if(pin && workers < hardware){
+                    pinToHardwareThread(this->workers[i]->thread, i + 1);
+                }
+            }
+        }
+
+        ~JobSystem(){
+            {
+                std::lock_guard<std::mutex> lock(this->sleepMutex);
+                this->running.store(false);
+            }
+            this->wake.notify_all();
+            for(std::unique_ptr<Worker> &worker : this->workers){
+                worker->thread.join();
+            }
+            // whatever never ran (a dependency that never finished) is dropped
+            Job* job;
+            for(std::unique_ptr<Worker> &worker : this->workers){
+                while(worker->deque.pop(job)){
+                    delete job;
+                }
+            }
+            for(Job* queued : this->injected){
+                delete queued;
+            }
+            for(Job* queued : this->mainQueue){
+                delete queued;
+            }
+        }
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        uint32_t workerCount() const{
+            return static_cast<uint32_t>(this->workers.size());
+        }
+
+        // work runs on any worker (or a waiting thread); counter, if any, is done when it has
+        // run, and it doesn't start before after, if any, is done
+        void run(std::function<void()> work, JobCounter* counter = NULL, JobCounter* after = NULL){
+            Job* job = new Job{ std::move(work), counter, false };
+            if(counter != NULL){
+                counter->pending.fetch_add(1, std::memory_order_relaxed);
+            }
+            if(after != NULL && hold(job, *after)){
+                return;
+            }
+            schedule(job);
+        }
+
+        // work runs on the main thread, from drainMainThread() or while it waits
+        void runOnMainThread(std::function<void()> work, JobCounter* counter = NULL){
+            Job* job = new Job{ std::move(work), counter, true };
+            if(counter != NULL){
+                counter->pending.fetch_add(1, std::memory_order_relaxed);
+            }
+            std::lock_guard<std::mutex> lock(this->mainMutex);
+            this->mainQueue.push_back(job);
+        }
+
+        // the calling thread becomes the one runOnMainThread() jobs run on (the GL thread)
+        void setMainThread(){
+            std::lock_guard<std::mutex> lock(this->mainMutex);
+            this->mainThread = std::this_thread::get_id();
+        }
+
+        bool onMainThread() const{
+            std::lock_guard<std::mutex> lock(this->mainMutex);
+            return this->mainThread == std::this_thread::get_id();
+        }
+
+        // main thread only, runs every main thread job queued so far; returns how many ran
+        size_t drainMainThread(){
+            std::deque<Job*> jobs;
+            {
+                std::lock_guard<std::mutex> lock(this->mainMutex);
+                jobs.swap(this->mainQueue);
+            }
+            for(Job* job : jobs){
+                execute(job);
+            }
+            return jobs.size();
+        }
+
+        // runs jobs on this thread until counter is done
+        void wait(JobCounter &counter){
+            int worker = currentWorker();
+            bool main = worker < 0 && onMainThread();
+            uint32_t idle = 0;
+            while(!counter.done()){
+                Job* job = NULL;
+                if(main){
+                    std::lock_guard<std::mutex> lock(this->mainMutex);
+                    if(!this->mainQueue.empty()){
+                        job = this->mainQueue.front();
+                        this->mainQueue.pop_front();
+                    }
+                }
+                if(job == NULL){
+                    job = find(worker);
+                }
+                if(job != NULL){
+                    execute(job);
+                    idle = 0;
+                }
+                else if(++idle > 64){
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        // splits [0, count) into ranges of at least grain and runs body(begin, end) on each,
+        // a few ranges per thread so stealing can even out uneven ranges; returns when all ran
+        void parallelFor(size_t count, const std::function<void(size_t, size_t)> &body, size_t grain = 1){
+            if(count == 0){
+                return;
+            }
+            grain = std::max<size_t>(grain, 1);
+            size_t threads = this->workers.size() + 1;
+            size_t ranges = std::min((count + grain - 1) / grain, threads * RANGES_PER_THREAD);
+            if(ranges <= 1 || this->workers.empty()){
+                body(0, count);
+                return;
+            }
+            size_t chunk = (count + ranges - 1) / ranges;
+            JobCounter done;
+            for(size_t begin = chunk; begin < count; begin += chunk){
+                size_t end = std::min(count, begin + chunk);
+                run([&body, begin, end](){ body(begin, end); }, &done);
+            }
+            body(0, std::min(count, chunk));
+            wait(done);
+        }
+
+        Stats stats() const{
+            Stats result;
+            result.executed = this->executed.load(std::memory_order_relaxed);
+            result.stolen = this->stolen.load(std::memory_order_relaxed);
+            result.mainThreadJobs = this->mainThreadJobs.load(std::memory_order_relaxed);
+            return result;
+        }
+
+    private:
+        static const size_t RANGES_PER_THREAD = 4;
+
+        struct Job {
+            std::function<void()> work;
+            JobCounter* counter;
+            bool mainThread;
+        };
+
+        struct Worker {
+            WorkStealingDeque<Job*> deque;
+            std::thread thread;
+        };
+
+        // the worker the calling thread is in this system, if any
+        struct ThreadSlot {
+            const JobSystem* system = NULL;
+            int index = -1;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<bool> running{true};
+        std::atomic<int64_t> queued{0};     // jobs in deques and the injection queue
+
+        std::mutex injectMutex;
+        std::deque<Job*> injected;          // from threads that aren't workers
+
+        mutable std::mutex mainMutex;
+        std::deque<Job*> mainQueue;
+        std::thread::id mainThread;
+
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        uint32_t sleepers = 0;
+
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> mainThreadJobs{0};
+
+        static ThreadSlot &threadSlot(){
+            static thread_local ThreadSlot slot;
+            return slot;
+        }
+
+        int currentWorker() const{
+            const ThreadSlot &slot = threadSlot();
+            return slot.system == this ? slot.index : -1;
+        }
+
+        static void pinToHardwareThread(std::thread &thread, uint32_t cpu){
+#if defined(_WIN32)
+            if(cpu < 64){
+                SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu);
+            }
+#elif defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+            (void)thread;
+            (void)cpu;
+#endif
+        }
+
+        // true when after isn't done yet and job now waits on it
+        bool hold(Job* job, JobCounter &after){
+            std::lock_guard<std::mutex> lock(after.mutex);
+            if(after.pending.load(std::memory_order_acquire) == 0){
+                return false;
+            }
+            after.waiting.push_back(job);
+            return true;
+        }
+
+        void schedule(Job* job){
+            if(job->mainThread){
+                std::lock_guard<std::mutex> lock(this->mainMutex);
+                this->mainQueue.push_back(job);
+                return;
+            }
+            int worker = currentWorker();
+            if(worker >= 0){
+                this->workers[worker]->deque.push(job);
+            }
+            else{
+                std::lock_guard<std::mutex> lock(this->injectMutex);
+                this->injected.push_back(job);
+            }
+            this->queued.fetch_add(1, std::memory_order_release);
+            // the lock orders this against a worker deciding to sleep
+            std::lock_guard<std::mutex> lock(this->sleepMutex);
+            if(this->sleepers > 0){
+                this->wake.notify_one();
+            }
+        }
+
+        Job* take(Job* job){
+            this->queued.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+
+        // own deque first, then the injection queue, then steal starting at a random worker
+        Job* find(int worker){
+            Job* job;
+            if(worker >= 0 && this->workers[worker]->deque.pop(job)){
+                return take(job);
+            }
+            if(this->queued.load(std::memory_order_acquire) <= 0){
+                return NULL;
+            }
+            {
+                std::lock_guard<std::mutex> lock(this->injectMutex);
+                if(!this->injected.empty()){
+                    job = this->injected.front();
+                    this->injected.pop_front();
+                    return take(job);
+                }
+            }
+            size_t count = this->workers.size();
+            static thread_local uint32_t seed = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1u;
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            for(size_t i = 0; i < count; i++){
+                size_t victim = (seed + i) % count;
+                if(static_cast<int>(victim) != worker && this->workers[victim]->deque.steal(job)){
+                    this->stolen.fetch_add(1, std::memory_order_relaxed);
+                    return take(job);
+                }
+            }
+            return NULL;
+        }
+
+        void execute(Job* job){
+            job->work();
+            if(job->mainThread){
+                this->mainThreadJobs.fetch_add(1, std::memory_order_relaxed);
+            }
+            this->executed.fetch_add(1, std::memory_order_relaxed);
+            JobCounter* counter = job->counter;
+            delete job;
+            if(counter == NULL){
+                return;
+            }
+            // decremented under the lock so a held job can't slip in between the last decrement
+            // and taking the held list, and the counter can't be destroyed while this is in there
+            std::vector<void*> released;
+            {
+                std::lock_guard<std::mutex> lock(counter->mutex);
+                if(counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                    released.swap(counter->waiting);
+                }
+            }
+            for(void* waiting : released){
+                schedule(static_cast<Job*>(waiting));
+            }
+        }
+
+        void workerLoop(uint32_t index){
+            threadSlot().system = this;
+            threadSlot().index = static_cast<int>(index);
+            Profiler::setThreadName("job worker " + std::to_string(index));
+            while(this->running.load(std::memory_order_acquire)){
+                Job* job = find(static_cast<int>(index));
+                if(job != NULL){
+                    execute(job);
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(this->sleepMutex);
+                this->sleepers++;
+                this->wake.wait(lock, [this](){
+                    return !this->running.load(std::memory_order_relaxed) || this->queued.load(std::memory_order_acquire) > 0;
+                });
+                this->sleepers--;
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <Threading/job_system.h>
+
+#include <cstddef>
+#include <functional>
+
+// Splits [0, count) into contiguous ranges of at least minPerThread items and runs
+// body(begin, end) on each range on the shared job system (JobSystem::instance()). The
+// calling thread takes the first range and runs other jobs until all are done, so this
+// can be called from inside a job.
+inline void parallelFor(size_t count, const std::function<void(size_t, size_t)> &body, size_t minPerThread = 1){
+    JobSystem::instance().parallelFor(count, body, minPerThread);
+}
+
+#endif
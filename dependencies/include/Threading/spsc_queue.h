@@ -0,0 +1,107 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread, a ring
+// of capacity slots indexed by two counters. The producer only writes tail and the consumer
+// only writes head, so each side needs one acquire load of the other's counter and one
+// release store of its own, no compare-and-swap. The counters sit on their own cache lines
+// so the two threads don't bounce a line between them on every call.
+//
+// tryPush/tryPop never block. push/pop spin briefly, then yield, then sleep in short steps
+// until there is room or an item, or until cancel() is called (for shutdown).
+
+template<typename T>
+class SpscQueue {
+    public:
+        explicit SpscQueue(size_t capacity) : slots(capacity > 0 ? capacity : 1){}
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        size_t capacity() const{
+            return this->slots.size();
+        }
+
+        // approximate from any other thread
+        size_t size() const{
+            return this->tail.load(std::memory_order_acquire) - this->head.load(std::memory_order_acquire);
+        }
+
+        // producer only
+        bool tryPush(const T &item){
+            size_t back = this->tail.load(std::memory_order_relaxed);
+            if(back - this->head.load(std::memory_order_acquire) == this->slots.size()){
+                return false;
+            }
+            this->slots[back % this->slots.size()] = item;
+            this->tail.store(back + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer only
+        bool tryPop(T &item){
+            size_t front = this->head.load(std::memory_order_relaxed);
+            if(front == this->tail.load(std::memory_order_acquire)){
+                return false;
+            }
+            item = this->slots[front % this->slots.size()];
+            this->head.store(front + 1, std::memory_order_release);
+            return true;
+        }
+
+        // false when cancelled before there was room
+        bool push(const T &item){
+            for(unsigned int attempt = 0; !this->tryPush(item); attempt++){
+                if(this->cancelled.load(std::memory_order_acquire)){
+                    return false;
+                }
+                backoff(attempt);
+            }
+            return true;
+        }
+
+        // false when cancelled while empty
+        bool pop(T &item){
+            for(unsigned int attempt = 0; !this->tryPop(item); attempt++){
+                if(this->cancelled.load(std::memory_order_acquire)){
+                    return false;
+                }
+                backoff(attempt);
+            }
+            return true;
+        }
+
+        // wakes both sides out of push/pop, items already queued can still be popped
+        void cancel(){
+            this->cancelled.store(true, std::memory_order_release);
+        }
+
+        void reset(){
+            this->cancelled.store(false, std::memory_order_release);
+        }
+
+    private:
+        std::vector<T> slots;
+        alignas(64) std::atomic<size_t> head{0};   // next slot to pop, written by the consumer
+        alignas(64) std::atomic<size_t> tail{0};   // next slot to push, written by the producer
+        alignas(64) std::atomic<bool> cancelled{false};
+
+        static void backoff(unsigned int attempt){
+            if(attempt < 64){
+                return;
+            }
+            if(attempt < 128){
+                std::this_thread::yield();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+};
+
+#endif
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Compares two microbenchmark JSON reports (bench --benchmark_out=...) and flags regressions.
+
+    python3 scripts/compare_bench.py baseline.json contender.json [--threshold 5] [--metric cpu_time]
+
+Runs are matched by name. When a report has repetitions the median aggregate is compared,
+otherwise the mean of the iteration runs. A benchmark regresses when the contender is slower
+than the baseline by more than --threshold percent; the exit code is 1 if any did, so the
+script can gate CI. Benchmarks present in only one report are listed but never fail the run.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path, metric):
+    with open(path) as file:
+        report = json.load(file)
+    medians = {}
+    iterations = {}
+    errors = set()
+    for run in report.get("benchmarks", []):
+        name = run.get("run_name", run["name"])
+        if run.get("error_occurred"):
+            errors.add(name)
+            continue
+        # Google Benchmark reports may use other units, compare everything in ns
+        scale = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}[run.get("time_unit", "ns")]
+        value = run[metric] * scale
+        if run.get("run_type") == "aggregate":
+            if run.get("aggregate_name") == "median":
+                medians[name] = value
+        else:
+            iterations.setdefault(name, []).append(value)
+    times = {name: sum(values) / len(values) for name, values in iterations.items()}
+    times.update(medians)
+    return times, errors
+
+
+def format_ns(value):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if value >= scale:
+            return "%.2f %s" % (value / scale, unit)
+    return "%.1f ns" % value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=5.0, help="percent slowdown that counts as a regression (default 5)")
+    parser.add_argument("--metric", choices=("cpu_time", "real_time"), default="cpu_time")
+    parser.add_argument("--filter", default="", help="only compare benchmarks whose name contains this")
+    args = parser.parse_args()
+
+    baseline, baseline_errors = load(args.baseline, args.metric)
+    contender, contender_errors = load(args.contender, args.metric)
+    names = [name for name in baseline if name in contender and args.filter in name]
+    regressions = []
+
+    width = max([len(name) for name in names] + [9])
+    print("%-*s %14s %14s %9s" % (width, "Benchmark", "Baseline", "Contender", "Change"))
+    for name in names:
+        before, after = baseline[name], contender[name]
+        change = (after - before) / before * 100.0 if before > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions.append((name, change))
+        elif change < -args.threshold:
+            flag = "  improved"
+        print("%-*s %14s %14s %+8.1f%%%s" % (width, name, format_ns(before), format_ns(after), change, flag))
+
+    for name in sorted(set(baseline) - set(contender)):
+        print("only in baseline: %s" % name)
+    for name in sorted(set(contender) - set(baseline)):
+        print("only in contender: %s" % name)
+    for name in sorted(contender_errors - baseline_errors):
+        print("error in contender: %s" % name)
+
+    if regressions:
+        print("\n%d regression(s) over %.1f%%:" % (len(regressions), args.threshold))
+        for name, change in regressions:
+            print("  %s %+.1f%%" % (name, change))
+        return 1
+    print("\nno regressions over %.1f%%" % args.threshold)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,461 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <Benchmark/microbench.h>
+#include <Camera/camera.h>
+#include <Culling/frustum.h>
+#include <FileIO/mapped_file.h>
+#include <Shaders/shader.h>
+#include <Textures/image_decoder.h>
+#include <Threading/job_system.h>
+
+using namespace std;
+
+// Microbenchmarks for the per frame hot paths. No window or GL context: the glad entry
+// points the Shader class calls are pointed at stubs that only record their arguments,
+// so the uniform benchmarks measure our side of the call (string building, the
+// glGetUniformLocation round trip per setter) and not a driver.
+//
+//   bench --benchmark_out=before.json
+//   bench --benchmark_out=after.json
+//   python3 scripts/compare_bench.py before.json after.json
+
+string projectPath = filesystem::current_path().parent_path().string();
+
+#pragma region GL Stubs
+namespace Stub {
+    volatile GLint lastLocation;
+    float lastValues[16];
+
+    // a driver hashes the name into the program's uniform table, this is about as cheap
+    GLint APIENTRY getUniformLocation(GLuint, const GLchar* name){
+        uint32_t hash = 2166136261u;
+        for(const GLchar* c = name; *c != '\0'; c++){
+            hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+        }
+        return static_cast<GLint>(hash & 0xFF);
+    }
+
+    void APIENTRY uniform1i(GLint location, GLint value){
+        lastLocation = location;
+        lastValues[0] = static_cast<float>(value);
+    }
+
+    void APIENTRY uniform1f(GLint location, GLfloat value){
+        lastLocation = location;
+        lastValues[0] = value;
+    }
+
+    void APIENTRY uniform3fv(GLint location, GLsizei, const GLfloat* value){
+        lastLocation = location;
+        memcpy(lastValues, value, 3 * sizeof(float));
+    }
+
+    void APIENTRY uniform4fv(GLint location, GLsizei, const GLfloat* value){
+        lastLocation = location;
+        memcpy(lastValues, value, 4 * sizeof(float));
+    }
+
+    void APIENTRY uniformMatrix4fv(GLint location, GLsizei, GLboolean, const GLfloat* value){
+        lastLocation = location;
+        memcpy(lastValues, value, 16 * sizeof(float));
+    }
+
+    GLuint APIENTRY createShader(GLenum){
+        return 1;
+    }
+
+    GLuint APIENTRY createProgram(){
+        return 1;
+    }
+
+    void APIENTRY shaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*){}
+    void APIENTRY compileShader(GLuint){}
+    void APIENTRY attachShader(GLuint, GLuint){}
+    void APIENTRY linkProgram(GLuint){}
+    void APIENTRY deleteShader(GLuint){}
+    void APIENTRY deleteProgram(GLuint){}
+    void APIENTRY useProgram(GLuint){}
+
+    void APIENTRY getShaderiv(GLuint, GLenum, GLint* value){
+        *value = GL_TRUE;
+    }
+
+    void APIENTRY getProgramiv(GLuint, GLenum, GLint* value){
+        *value = GL_TRUE;
+    }
+
+    void install(){
+        glad_glGetUniformLocation = getUniformLocation;
+        glad_glUniform1i = uniform1i;
+        glad_glUniform1f = uniform1f;
+        glad_glUniform3fv = uniform3fv;
+        glad_glUniform4fv = uniform4fv;
+        glad_glUniformMatrix4fv = uniformMatrix4fv;
+        glad_glCreateShader = createShader;
+        glad_glCreateProgram = createProgram;
+        glad_glShaderSource = shaderSource;
+        glad_glCompileShader = compileShader;
+        glad_glAttachShader = attachShader;
+        glad_glLinkProgram = linkProgram;
+        glad_glDeleteShader = deleteShader;
+        glad_glDeleteProgram = deleteProgram;
+        glad_glUseProgram = useProgram;
+        glad_glGetShaderiv = getShaderiv;
+        glad_glGetProgramiv = getProgramiv;
+    }
+}
+
+Shader& stubShader(){
+    static Shader* shader = NULL;
+    if(shader == NULL){
+        Stub::install();
+        string vertexPath = projectPath + "/src/shader.vert";
+        string fragmentPath = projectPath + "/src/shader.frag";
+        shader = new Shader(vertexPath.c_str(), fragmentPath.c_str());
+    }
+    return *shader;
+}
+#pragma endregion
+
+#pragma region Camera
+static void BM_CameraGetViewMatrix(Microbench::State &state){
+    Camera camera(FREE, 1.0f, glm::vec3(0.0f, 0.0f, 3.0f));
+    for(auto _ : state){
+        Microbench::doNotOptimize(camera.GetViewMatrix());
+    }
+}
+MICROBENCH(BM_CameraGetViewMatrix);
+
+static void BM_CameraProcessMouseMovement(Microbench::State &state){
+    Camera camera(FREE, 1.0f, glm::vec3(0.0f, 0.0f, 3.0f));
+    float direction = 1.0f;
+    for(auto _ : state){
+        camera.ProcessMouseMovement(3.0f * direction, -2.0f * direction);
+        direction = -direction;
+        Microbench::doNotOptimize(camera.Front);
+    }
+}
+MICROBENCH(BM_CameraProcessMouseMovement);
+
+// what a frame does with the camera: one mouse event, then the view matrix
+static void BM_CameraMouseThenView(Microbench::State &state){
+    Camera camera(FREE, 1.0f, glm::vec3(0.0f, 0.0f, 3.0f));
+    float direction = 1.0f;
+    for(auto _ : state){
+        camera.ProcessMouseMovement(3.0f * direction, -2.0f * direction);
+        direction = -direction;
+        Microbench::doNotOptimize(camera.GetViewMatrix());
+    }
+}
+MICROBENCH(BM_CameraMouseThenView);
+
+// everything a frame reads from a camera that moved: view, projection, their product and the frustum
+static void BM_CameraMoveThenMatrices(Microbench::State &state){
+    Camera camera(FREE, 1.0f, glm::vec3(0.0f, 0.0f, 3.0f));
+    float direction = 1.0f;
+    for(auto _ : state){
+        camera.ProcessMouseMovement(3.0f * direction, -2.0f * direction);
+        direction = -direction;
+        Microbench::doNotOptimize(camera.GetViewProjectionMatrix());
+        Microbench::doNotOptimize(camera.GetFrustum());
+    }
+}
+MICROBENCH(BM_CameraMoveThenMatrices);
+
+// the same reads from a camera that didn't move, only the cache check
+static void BM_CameraCachedMatrices(Microbench::State &state){
+    Camera camera(FREE, 1.0f, glm::vec3(0.0f, 0.0f, 3.0f));
+    for(auto _ : state){
+        Microbench::doNotOptimize(camera.GetViewProjectionMatrix());
+        Microbench::doNotOptimize(camera.GetFrustum());
+    }
+}
+MICROBENCH(BM_CameraCachedMatrices);
+#pragma endregion
+
+#pragma region GLM
+static const glm::vec3 POSITIONS[] = {
+    glm::vec3( 0.0f, 0.0f, 0.0f), glm::vec3( 2.0f, 5.0f, -15.0f), glm::vec3(-1.5f, -2.2f, -2.5f), glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f), glm::vec3(-1.7f, 3.0f, -7.5f), glm::vec3( 1.3f, -2.0f, -2.5f), glm::vec3( 1.5f, 2.0f, -2.5f)
+};
+
+// the model matrix of a cube in drawObjects: translate, then two rotations
+static void BM_GlmModelMatrix(Microbench::State &state){
+    size_t i = 0;
+    for(auto _ : state){
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), POSITIONS[i & 7]);
+        model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+        model = glm::rotate(model, glm::radians(300.0f), glm::vec3(1.0f, 0.3f, 0.5f));
+        Microbench::doNotOptimize(model);
+        i++;
+    }
+}
+MICROBENCH(BM_GlmModelMatrix);
+
+static void BM_GlmModelViewProjection(Microbench::State &state){
+    Camera camera(FREE, 1.0f, glm::vec3(0.0f, 0.0f, 3.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    glm::mat4 view = camera.GetViewMatrix();
+    size_t i = 0;
+    for(auto _ : state){
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), POSITIONS[i & 7]);
+        Microbench::doNotOptimize(projection * view * model);
+        i++;
+    }
+}
+MICROBENCH(BM_GlmModelViewProjection);
+
+static void BM_GlmInverse(Microbench::State &state){
+    glm::mat4 matrix = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f) * glm::translate(glm::mat4(1.0f), POSITIONS[1]);
+    for(auto _ : state){
+        Microbench::doNotOptimize(matrix);
+        Microbench::doNotOptimize(glm::inverse(matrix));
+    }
+}
+MICROBENCH(BM_GlmInverse);
+#pragma endregion
+
+#pragma region Uniforms
+static void BM_ShaderSetMat4(Microbench::State &state){
+    Shader &shader = stubShader();
+    glm::mat4 value = glm::mat4(1.0f);
+    for(auto _ : state){
+        shader.setMat4("projection", value);
+    }
+}
+MICROBENCH(BM_ShaderSetMat4);
+
+static void BM_ShaderSetVec3(Microbench::State &state){
+    Shader &shader = stubShader();
+    glm::vec3 value = glm::vec3(1.0f);
+    for(auto _ : state){
+        shader.setVec3("light.ambient", value);
+    }
+}
+MICROBENCH(BM_ShaderSetVec3);
+
+static void BM_ShaderSetFloat(Microbench::State &state){
+    Shader &shader = stubShader();
+    for(auto _ : state){
+        shader.setFloat("material.shininess", 32.0f);
+    }
+}
+MICROBENCH(BM_ShaderSetFloat);
+
+// every uniform drawObjects sets on the cube shader in one frame
+static void BM_ShaderFrameUniforms(Microbench::State &state){
+    Shader &shader = stubShader();
+    glm::mat4 matrix = glm::mat4(1.0f);
+    glm::vec3 vector = glm::vec3(1.0f);
+    for(auto _ : state){
+        shader.setInt("material.emission", 2);
+        shader.setInt("material.diffuse", 0);
+        shader.setInt("material.specular", 1);
+        shader.setFloat("material.shininess", 32.0f);
+        shader.setVec3("light.ambient", vector);
+        shader.setVec3("light.diffuse", vector);
+        shader.setVec3("light.specular", vector);
+        shader.setFloat("light.constant", 1.0f);
+        shader.setFloat("light.linear", 0.09f);
+        shader.setFloat("light.quadratic", 0.032f);
+        shader.setVec3("light.position", vector);
+        shader.setVec3("light.direction", vector);
+        shader.setFloat("light.innerCutOff", 0.976f);
+        shader.setFloat("light.outerCutOff", 0.953f);
+        shader.setMat4("projection", matrix);
+        shader.setMat4("view", matrix);
+    }
+    state.setItemsProcessed(static_cast<int64_t>(state.iterations()) * 16);
+}
+MICROBENCH(BM_ShaderFrameUniforms);
+#pragma endregion
+
+#pragma region Image Decode
+static void decodeBenchmark(Microbench::State &state, const char* name, const char* only){
+    MappedFile file;
+    if(!file.open(projectPath + "/textures/" + name)){
+        state.skipWithError(string("missing textures/") + name);
+        return;
+    }
+    ImageDecode::Options options;
+    options.desiredChannels = 4;
+    options.only = only;
+    options.parallel = false;
+    ImageDecode::Image image;
+    for(auto _ : state){
+        ImageDecode::decode(file.data(), file.size(), image, options);
+        Microbench::doNotOptimize(image.pixels.data());
+    }
+    state.setBytesProcessed(static_cast<int64_t>(state.iterations() * file.size()));
+    state.setLabel(image.decoder != NULL ? image.decoder : "failed");
+}
+
+static void BM_DecodePng(Microbench::State &state){
+    decodeBenchmark(state, "container2.png", NULL);
+}
+MICROBENCH(BM_DecodePng);
+
+static void BM_DecodePngStb(Microbench::State &state){
+    decodeBenchmark(state, "container2.png", "stb");
+}
+MICROBENCH(BM_DecodePngStb);
+
+static void BM_DecodeJpeg(Microbench::State &state){
+    decodeBenchmark(state, "matrix.jpg", NULL);
+}
+MICROBENCH(BM_DecodeJpeg);
+
+static void BM_DecodeJpegStb(Microbench::State &state){
+    decodeBenchmark(state, "matrix.jpg", "stb");
+}
+MICROBENCH(BM_DecodeJpegStb);
+#pragma endregion
+
+#pragma region Culling
+// count spheres spread over a 200 unit box around a camera looking down -z, about a sixth visible
+static Culling::SphereSoA sceneSpheres(size_t count){
+    Culling::SphereSoA spheres;
+    uint32_t seed = 12345;
+    auto next = [&seed](){
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / 16777216.0f;
+    };
+    for(size_t i = 0; i < count; i++){
+        spheres.add(glm::vec3(next() * 200.0f - 100.0f, next() * 200.0f - 100.0f, next() * 200.0f - 100.0f), 0.5f + next() * 2.0f);
+    }
+    return spheres;
+}
+
+static Culling::Frustum sceneFrustum(){
+    Camera camera(FREE, 1.0f, glm::vec3(0.0f, 0.0f, 3.0f));
+    return Culling::Frustum::fromMatrix(glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f) * camera.GetViewMatrix());
+}
+
+static void BM_CullSpheresScalar(Microbench::State &state){
+    Culling::SphereSoA spheres = sceneSpheres(state.range(0));
+    Culling::Frustum frustum = sceneFrustum();
+    vector<uint8_t> visible(spheres.size());
+    for(auto _ : state){
+        Microbench::doNotOptimize(Culling::cullSpheresScalar(frustum, spheres, 0, spheres.size(), visible.data()));
+    }
+    state.setItemsProcessed(static_cast<int64_t>(state.iterations() * spheres.size()));
+}
+MICROBENCH(BM_CullSpheresScalar)->arg(1024)->arg(65536);
+
+static void BM_CullSpheres(Microbench::State &state){
+    Culling::SphereSoA spheres = sceneSpheres(state.range(0));
+    Culling::Frustum frustum = sceneFrustum();
+    vector<uint8_t> visible(spheres.size());
+    for(auto _ : state){
+        Microbench::doNotOptimize(Culling::cullSpheres(frustum, spheres, visible.data()));
+    }
+    state.setItemsProcessed(static_cast<int64_t>(state.iterations() * spheres.size()));
+    state.setLabel(Simd::hasAvx2() ? "avx2" : "sse2");
+}
+MICROBENCH(BM_CullSpheres)->arg(1024)->arg(65536);
+
+static void BM_CullAabbs(Microbench::State &state){
+    Culling::SphereSoA spheres = sceneSpheres(state.range(0));
+    vector<glm::vec3> mins(spheres.size()), maxs(spheres.size());
+    for(size_t i = 0; i < spheres.size(); i++){
+        glm::vec3 center = glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]);
+        mins[i] = center - glm::vec3(spheres.radius[i]);
+        maxs[i] = center + glm::vec3(spheres.radius[i]);
+    }
+    Culling::Frustum frustum = sceneFrustum();
+    vector<uint8_t> visible(spheres.size());
+    for(auto _ : state){
+        Microbench::doNotOptimize(Culling::cullAabbs(frustum, mins.data(), maxs.data(), mins.size(), visible.data()));
+    }
+    state.setItemsProcessed(static_cast<int64_t>(state.iterations() * spheres.size()));
+}
+MICROBENCH(BM_CullAabbs)->arg(1024)->arg(65536);
+#pragma endregion
+
+#pragma region Jobs
+// scaling runs take the total thread count (workers + the calling thread) as the argument
+// and rate against wall time, CPU time is only the calling thread's share
+
+// spawn and wait overhead: 1024 empty jobs per iteration
+static void BM_JobsEmpty(Microbench::State &state){
+    JobSystem jobs(static_cast<uint32_t>(state.range(0) - 1));
+    for(auto _ : state){
+        JobCounter done;
+        for(int i = 0; i < 1024; i++){
+            jobs.run([](){}, &done);
+        }
+        jobs.wait(done);
+    }
+    state.setItemsProcessed(static_cast<int64_t>(state.iterations()) * 1024);
+}
+MICROBENCH(BM_JobsEmpty)->arg(1)->arg(2)->arg(4)->arg(8)->useRealTime();
+
+// nested spawning, where the per worker deques matter: 16 jobs that each spawn 64
+static void BM_JobsNested(Microbench::State &state){
+    JobSystem jobs(static_cast<uint32_t>(state.range(0) - 1));
+    for(auto _ : state){
+        JobCounter done;
+        for(int i = 0; i < 16; i++){
+            jobs.run([&jobs, &done](){
+                for(int j = 0; j < 64; j++){
+                    jobs.run([](){ Microbench::clobberMemory(); }, &done);
+                }
+            }, &done);
+        }
+        jobs.wait(done);
+    }
+    state.setItemsProcessed(static_cast<int64_t>(state.iterations()) * 16 * 65);
+}
+MICROBENCH(BM_JobsNested)->arg(1)->arg(2)->arg(4)->arg(8)->useRealTime();
+
+// culling 1M spheres in parallel for ranges of 16K
+static void BM_JobsParallelCull(Microbench::State &state){
+    JobSystem jobs(static_cast<uint32_t>(state.range(0) - 1));
+    Culling::SphereSoA spheres = sceneSpheres(1 << 20);
+    Culling::Frustum frustum = sceneFrustum();
+    vector<uint8_t> visible(spheres.size());
+    for(auto _ : state){
+        jobs.parallelFor(spheres.size(), [&](size_t begin, size_t end){
+            Culling::cullSpheresScalar(frustum, spheres, begin, end - begin, visible.data());
+        }, 16384);
+        Microbench::clobberMemory();
+    }
+    state.setItemsProcessed(static_cast<int64_t>(state.iterations() * spheres.size()));
+}
+MICROBENCH(BM_JobsParallelCull)->arg(1)->arg(2)->arg(4)->arg(8)->useRealTime();
+
+// the same split over threads started for every call, what parallelFor used to do
+static void BM_ThreadsParallelCull(Microbench::State &state){
+    size_t threads = static_cast<size_t>(state.range(0));
+    Culling::SphereSoA spheres = sceneSpheres(1 << 20);
+    Culling::Frustum frustum = sceneFrustum();
+    vector<uint8_t> visible(spheres.size());
+    for(auto _ : state){
+        size_t chunk = (spheres.size() + threads - 1) / threads;
+        vector<thread> workers;
+        for(size_t begin = chunk; begin < spheres.size(); begin += chunk){
+            workers.emplace_back([&, begin](){
+                Culling::cullSpheresScalar(frustum, spheres, begin, std::min(spheres.size() - begin, chunk), visible.data());
+            });
+        }
+        Culling::cullSpheresScalar(frustum, spheres, 0, std::min(spheres.size(), chunk), visible.data());
+        for(thread &worker : workers){
+            worker.join();
+        }
+        Microbench::clobberMemory();
+    }
+    state.setItemsProcessed(static_cast<int64_t>(state.iterations() * spheres.size()));
+}
+MICROBENCH(BM_ThreadsParallelCull)->arg(1)->arg(2)->arg(4)->arg(8)->useRealTime();
+#pragma endregion
+
+int main(int argc, char** argv){
+    return Microbench::run(argc, argv);
+}
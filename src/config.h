@@ -13,4 +13,29 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <Camera/camera.h>
-#include <glm/gtx/string_cast.hpp>
\ No newline at end of file
+#include <glm/gtx/string_cast.hpp>
+#include <GLExt/gl_ext.h>
+#include <Textures/texture_loader.h>
+#include <Textures/image_decoder.h>
+#include <Textures/mip_generator.h>
+#include <Textures/texture_array.h>
+#include <Textures/texture_residency.h>
+#include <Profiling/profiler.h>
+#include <Profiling/gpu_timer.h>
+#include <Profiling/frame_stats.h>
+#include <GLExt/gl_call_stats.h>
+#include <Profiling/gpu_resources.h>
+#include <Culling/frustum.h>
+#include <Textures/png_encoder.h>
+#include <Testing/golden_image.h>
+#include <GLExt/gl_capture.h>
+#include <Simulation/fixed_step.h>
+#include <Threading/spsc_queue.h>
+#include <Rendering/frame_pipeline.h>
+#include <Threading/job_system.h>
+#include <Rendering/frame_pacer.h>
+#include <Camera/look_latch.h>
+#include <Camera/camera_path.h>
+#include <Meshes/mesh_container.h>
+#include <Meshes/mesh_loader.h>
+#include <Meshes/mesh_import.h>
\ No newline at end of file
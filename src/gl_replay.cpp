@@ -0,0 +1,619 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <FileIO/mapped_file.h>
+#include <GLExt/gl_capture.h>
+#include <Profiling/frame_stats.h>
+
+using namespace std;
+
+// Headless replayer for GL command captures (OpenGL_Test --capture, GLExt/gl_capture.h).
+// Opens a hidden window with the same 3.3 core context as the app, maps the capture and
+// re-executes it call by call: object names, uniform locations and sync objects are
+// remapped to what this driver hands out, payloads are passed straight from the mapping.
+//
+// The first frame holds everything the app did at startup (shaders, buffers, textures) and
+// is reported on its own; the frames after it can be looped to get stable numbers. Every
+// call is timed, so the report shows which entry points the driver spends its time in,
+// independent of the app's own CPU work.
+//
+//   GL_Replay capture.glcs [--loops 10] [--finish] [--top 25] [--out replay.json]
+
+typedef chrono::steady_clock Clock;
+
+struct Replayer;
+
+struct ReplayEntry {
+    string name;
+    void (*execute)(Replayer&, ReplayEntry&) = NULL;
+    const GLCapture::EntrySpec* spec = NULL;
+    bool useProgram = false;
+    uint64_t calls = 0;
+    uint64_t skipped = 0;           // the entry point isn't available on this driver
+    double seconds = 0.0;
+    double maxSeconds = 0.0;
+};
+
+struct Payload {
+    const uint8_t* data = NULL;
+    uint64_t size = 0;
+};
+
+struct PendingNames {
+    GpuResources::Kind kind;
+    const GLuint* captured;
+    const GLuint* replayed;
+    uint64_t count;
+};
+
+struct Replayer {
+    MappedFile file;
+    GLCapture::Header header;
+    size_t cursor = 0;
+    bool truncated = false;
+    string error;
+    bool finishEachCall = false;
+
+    unordered_map<string, void (*)(Replayer&, ReplayEntry&)> executors;
+    vector<ReplayEntry> entries;                // by id in the capture
+    unordered_map<uint64_t, Payload> payloads;
+
+    unordered_map<GLuint, GLuint> names[GpuResources::KIND_COUNT];
+    unordered_map<uint64_t, GLint> locations;   // captured program << 32 | captured location
+    unordered_map<uint64_t, GLsync> syncs;
+    unordered_map<GLenum, uint8_t*> mapped;
+    GLuint program = 0;                         // current program, captured name
+
+    uint64_t values[16] = {};                   // captured scalar arguments of the current call
+    deque<vector<uint8_t>> scratch;             // output and unknown pointers of the current call
+    vector<PendingNames> pendingNames;
+    double frameCallSeconds = 0.0;
+    uint64_t unknownPointers = 0;
+
+    bool open(const string &path){
+        if(!file.open(path) || file.size() < sizeof(GLCapture::Header)){
+            error = "can't read " + path;
+            return false;
+        }
+        memcpy(&header, file.data(), sizeof(GLCapture::Header));
+        if(header.magic != GLCapture::MAGIC || header.version != GLCapture::VERSION){
+            error = path + " isn't a version " + to_string(GLCapture::VERSION) + " GL capture";
+            return false;
+        }
+        cursor = sizeof(GLCapture::Header);
+        return true;
+    }
+
+    template<typename T>
+    T read(){
+        T value{};
+        if(cursor + sizeof(T) > file.size()){
+            truncated = true;
+            return value;
+        }
+        memcpy(&value, file.data() + cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    uint8_t* allocate(uint64_t size){
+        scratch.emplace_back(static_cast<size_t>(std::max<uint64_t>(size, 1)), 0);
+        return scratch.back().data();
+    }
+
+    GLuint mapName(GpuResources::Kind kind, GLuint captured) const{
+        auto found = names[kind].find(captured);
+        return found != names[kind].end() ? found->second : captured;
+    }
+
+    GLint mapLocation(GLint captured) const{
+        if(captured < 0){
+            return captured;
+        }
+        auto found = locations.find(static_cast<uint64_t>(program) << 32 | static_cast<uint32_t>(captured));
+        return found != locations.end() ? found->second : captured;
+    }
+
+    uint64_t mapScalar(const GLCapture::ArgSpec &arg, uint64_t value) const{
+        switch(arg.kind){
+            case GLCapture::ARG_NAME:
+                return mapName(arg.object, static_cast<GLuint>(value));
+            case GLCapture::ARG_LOCATION:
+                return static_cast<uint64_t>(static_cast<int64_t>(mapLocation(static_cast<GLint>(value))));
+            case GLCapture::ARG_LABEL_NAME:
+                for(int kind = 0; kind < GpuResources::KIND_COUNT; kind++){
+                    if(GpuResources::labelIdentifier(static_cast<GpuResources::Kind>(kind)) == static_cast<GLenum>(values[arg.a])){
+                        return mapName(static_cast<GpuResources::Kind>(kind), static_cast<GLuint>(value));
+                    }
+                }
+                return value;
+            default:
+                return value;
+        }
+    }
+
+    const void* decodePointer(const GLCapture::ArgSpec &arg){
+        uint8_t tag = read<uint8_t>();
+        switch(tag){
+            case GLCapture::TAG_NULL:
+                return NULL;
+            case GLCapture::TAG_OFFSET:
+                return reinterpret_cast<const void*>(static_cast<uintptr_t>(read<uint64_t>()));
+            case GLCapture::TAG_OUTPUT:
+                return allocate(read<uint64_t>());
+            case GLCapture::TAG_PAYLOAD:
+                break;
+            default:
+                unknownPointers++;
+                return allocate(1 << 16);
+        }
+        uint64_t hash = read<uint64_t>();
+        auto found = payloads.find(hash);
+        if(found == payloads.end()){
+            truncated = true;
+            error = "payload referenced before it was defined";
+            return NULL;
+        }
+        const Payload &payload = found->second;
+        if(arg.kind == GLCapture::ARG_NAMES || arg.kind == GLCapture::ARG_NAMES_OUT){
+            uint64_t count = payload.size / sizeof(GLuint);
+            GLuint* replayed = reinterpret_cast<GLuint*>(allocate(payload.size));
+            const GLuint* captured = reinterpret_cast<const GLuint*>(payload.data);
+            if(arg.kind == GLCapture::ARG_NAMES_OUT){
+                pendingNames.push_back(PendingNames{ arg.object, captured, replayed, count });
+            }
+            else{
+                for(uint64_t i = 0; i < count; i++){
+                    replayed[i] = mapName(arg.object, captured[i]);
+                }
+            }
+            return replayed;
+        }
+        if(arg.kind == GLCapture::ARG_STRINGS){
+            // NUL separated in the capture, glShaderSource gets one pointer per string
+            const char** strings = reinterpret_cast<const char**>(allocate(values[arg.a] * sizeof(const char*)));
+            const char* text = reinterpret_cast<const char*>(payload.data);
+            for(uint64_t i = 0; i < values[arg.a] && text < reinterpret_cast<const char*>(payload.data + payload.size); i++){
+                strings[i] = text;
+                text += strlen(text) + 1;
+            }
+            return strings;
+        }
+        return payload.data;
+    }
+
+    void forgetSync(GLsync sync){
+        for(auto it = syncs.begin(); it != syncs.end();){
+            it = it->second == sync ? syncs.erase(it) : next(it);
+        }
+    }
+
+    template<typename T>
+    T decode(const GLCapture::ArgSpec &arg, size_t index){
+        if constexpr(is_same<T, GLsync>::value){
+            uint64_t id = read<uint64_t>();
+            auto found = syncs.find(id);
+            return found != syncs.end() ? found->second : NULL;
+        }
+        else if constexpr(is_pointer<T>::value){
+            return static_cast<T>(const_cast<void*>(decodePointer(arg)));
+        }
+        else{
+            T value = read<T>();
+            if constexpr(is_integral<T>::value){
+                if(index < 16){
+                    values[index] = GLCapture::toValue(value);
+                }
+                return static_cast<T>(mapScalar(arg, GLCapture::toValue(value)));
+            }
+            return value;
+        }
+    }
+
+    void timeCall(ReplayEntry &entry, Clock::time_point start){
+        if(finishEachCall){
+            glFinish();
+        }
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+        entry.calls++;
+        entry.seconds += seconds;
+        entry.maxSeconds = std::max(entry.maxSeconds, seconds);
+        frameCallSeconds += seconds;
+    }
+
+    void mapResult(ReplayEntry &entry, uint64_t captured, uint64_t result){
+        switch(entry.spec->result){
+            case GLCapture::RESULT_NAME:
+                names[entry.spec->object][static_cast<GLuint>(captured)] = static_cast<GLuint>(result);
+                break;
+            case GLCapture::RESULT_LOCATION:
+                locations[values[0] << 32 | static_cast<uint32_t>(captured)] = static_cast<GLint>(result);
+                break;
+            case GLCapture::RESULT_MAPPED:
+                mapped[static_cast<GLenum>(values[0])] = reinterpret_cast<uint8_t*>(static_cast<uintptr_t>(result));
+                break;
+            default:
+                break;
+        }
+    }
+
+    void endCall(ReplayEntry &entry){
+        for(const PendingNames &pending : pendingNames){
+            for(uint64_t i = 0; i < pending.count; i++){
+                names[pending.kind][pending.captured[i]] = pending.replayed[i];
+            }
+        }
+        pendingNames.clear();
+        if(entry.useProgram){
+            program = static_cast<GLuint>(values[0]);
+        }
+        scratch.clear();
+    }
+
+    void defineEntry(){
+        uint16_t id = read<uint16_t>();
+        uint8_t length = read<uint8_t>();
+        if(cursor + length > file.size()){
+            truncated = true;
+            return;
+        }
+        string name(reinterpret_cast<const char*>(file.data() + cursor), length);
+        cursor += length;
+        if(id >= entries.size()){
+            entries.resize(id + 1);
+        }
+        ReplayEntry &entry = entries[id];
+        entry.name = name;
+        entry.spec = &GLCapture::findSpec(name.c_str());
+        entry.useProgram = name == "glUseProgram";
+        auto executor = executors.find(name);
+        entry.execute = executor != executors.end() ? executor->second : NULL;
+    }
+
+    void definePayload(){
+        uint64_t hash = read<uint64_t>();
+        uint64_t size = read<uint64_t>();
+        cursor = (cursor + 7) / 8 * 8;
+        if(cursor + size > file.size()){
+            truncated = true;
+            return;
+        }
+        payloads[hash] = Payload{ file.data() + cursor, size };
+        cursor += size;
+    }
+
+    void writeMapped(){
+        GLenum target = read<uint32_t>();
+        uint64_t offset = read<uint64_t>();
+        auto payload = payloads.find(read<uint64_t>());
+        auto pointer = mapped.find(target);
+        if(payload != payloads.end() && pointer != mapped.end() && pointer->second != NULL){
+            memcpy(pointer->second + offset, payload->second.data, payload->second.size);
+        }
+    }
+
+    // executes records up to the end of the next frame, false at the end of the capture or on an error
+    bool runFrame(){
+        frameCallSeconds = 0.0;
+        while(!truncated){
+            uint16_t record = read<uint16_t>();
+            if(truncated){
+                break;
+            }
+            switch(record){
+                case GLCapture::RECORD_FRAME:
+                    return true;
+                case GLCapture::RECORD_END:
+                    return false;
+                case GLCapture::RECORD_ENTRY:
+                    defineEntry();
+                    break;
+                case GLCapture::RECORD_PAYLOAD:
+                    definePayload();
+                    break;
+                case GLCapture::RECORD_MAPPED:
+                    writeMapped();
+                    break;
+                default:
+                    if(record >= entries.size() || entries[record].execute == NULL){
+                        error = "call to " + (record < entries.size() ? entries[record].name : "entry " + to_string(record)) + ", which this build can't replay";
+                        return false;
+                    }
+                    entries[record].execute(*this, entries[record]);
+            }
+        }
+        if(error.empty()){
+            error = "capture is truncated";
+        }
+        return false;
+    }
+};
+
+template<typename T>
+bool missingSync(const T &value){
+    if constexpr(is_same<T, GLsync>::value){
+        return value == NULL;
+    }
+    else{
+        return false;
+    }
+}
+
+// decodes the arguments of one call to the entry point at Slot, runs and times it
+template<auto* Slot, typename Function = remove_pointer_t<decltype(Slot)>>
+struct Call;
+
+template<auto* Slot, typename R, typename... A>
+struct Call<Slot, R (APIENTRYP)(A...)> {
+    template<size_t... I>
+    static tuple<A...> decodeArgs(Replayer &replayer, ReplayEntry &entry, index_sequence<I...>){
+        // braced initialisation evaluates left to right, the order the arguments were written in
+        return tuple<A...>{ replayer.template decode<A>(entry.spec->arg(I), I)... };
+    }
+
+    static void execute(Replayer &replayer, ReplayEntry &entry){
+        tuple<A...> args = decodeArgs(replayer, entry, index_sequence_for<A...>{});
+        // a fence from before the replayed frames (a later loop waiting on one the first loop
+        // deleted) has no object here, waiting on it would only raise GL_INVALID_VALUE
+        bool missing = apply([](const A&... values){ return (missingSync(values) || ... || false); }, args);
+        if constexpr(is_void<R>::value){
+            if(*Slot != NULL && !missing){
+                Clock::time_point start = Clock::now();
+                apply(*Slot, args);
+                replayer.timeCall(entry, start);
+                // glDeleteSync, the only void call taking just a sync
+                if constexpr(is_same<tuple<A...>, tuple<GLsync>>::value){
+                    replayer.forgetSync(get<0>(args));
+                }
+            }
+            else if(*Slot == NULL){
+                entry.skipped++;
+            }
+        }
+        else{
+            uint64_t captured = is_pointer<R>::value ? replayer.read<uint64_t>() : GLCapture::toValue(replayer.read<R>());
+            R result{};
+            if(*Slot != NULL && !missing){
+                Clock::time_point start = Clock::now();
+                result = apply(*Slot, args);
+                replayer.timeCall(entry, start);
+            }
+            else if(*Slot == NULL){
+                entry.skipped++;
+            }
+            if constexpr(is_same<R, GLsync>::value){
+                replayer.syncs[captured] = result;
+            }
+            else if constexpr(is_pointer<R>::value){
+                replayer.mapResult(entry, captured, reinterpret_cast<uintptr_t>(result));
+            }
+            else{
+                replayer.mapResult(entry, captured, GLCapture::toValue(result));
+            }
+        }
+        replayer.endCall(entry);
+    }
+};
+
+unordered_map<string, void (*)(Replayer&, ReplayEntry&)> executors(){
+    unordered_map<string, void (*)(Replayer&, ReplayEntry&)> table;
+#define GL_ENTRY_POINT(name) table[#name] = &Call<&glad_##name>::execute;
+    GL_ENTRY_POINTS
+#undef GL_ENTRY_POINT
+#define GL_CAPTURE_EXT_ENTRY_POINT(name) table["gl" #name] = &Call<&GLExt::name>::execute;
+    GL_CAPTURE_EXT_ENTRY_POINTS
+#undef GL_CAPTURE_EXT_ENTRY_POINT
+    return table;
+}
+
+GLFWwindow* createWindow(int width, int height){
+#if defined(__linux__)
+    // no display server: GLFW's null platform with an OSMesa context (Mesa llvmpipe)
+    if(getenv("DISPLAY") == NULL && getenv("WAYLAND_DISPLAY") == NULL){
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    }
+#endif
+    if(!glfwInit()){
+        return NULL;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = glfwCreateWindow(width, height, "GL Replay", NULL, NULL);
+    if(window == NULL){
+        glfwTerminate();
+        return NULL;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    return window;
+}
+
+void writeSummary(FILE* file, const char* name, const FrameStats::Summary &summary){
+    fprintf(file, "  \"%s\": {\"frames\": %llu, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n", name,
+            static_cast<unsigned long long>(summary.frames), summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+}
+
+bool writeReport(const string &path, const string &capture, const Replayer &replayer, const vector<const ReplayEntry*> &sorted,
+                 double setupMs, uint64_t loops, const FrameStats &frames, double callMs, uint64_t glErrors){
+    FILE* file = fopen(path.c_str(), "w");
+    if(file == NULL){
+        return false;
+    }
+    fprintf(file, "{\n  \"capture\": \"%s\",\n  \"width\": %u,\n  \"height\": %u,\n  \"captured_frames\": %llu,\n  \"loops\": %llu,\n",
+            capture.c_str(), replayer.header.width, replayer.header.height, static_cast<unsigned long long>(replayer.header.frames), static_cast<unsigned long long>(loops));
+    fprintf(file, "  \"finish_each_call\": %s,\n  \"setup_ms\": %.4f,\n  \"gl_call_ms_per_frame\": %.4f,\n  \"gl_errors\": %llu,\n",
+            replayer.finishEachCall ? "true" : "false", setupMs, callMs, static_cast<unsigned long long>(glErrors));
+    writeSummary(file, "cpu_ms", frames.cpuRun());
+    writeSummary(file, "gpu_ms", frames.gpuRun());
+    fprintf(file, "  \"calls\": [\n");
+    for(size_t i = 0; i < sorted.size(); i++){
+        const ReplayEntry &entry = *sorted[i];
+        fprintf(file, "    {\"name\": \"%s\", \"calls\": %llu, \"total_ms\": %.4f, \"mean_us\": %.4f, \"max_us\": %.4f}%s\n", entry.name.c_str(),
+                static_cast<unsigned long long>(entry.calls), entry.seconds * 1e3, entry.calls > 0 ? entry.seconds * 1e6 / entry.calls : 0.0,
+                entry.maxSeconds * 1e6, i + 1 < sorted.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+void printUsage(){
+    cout << "usage: GL_Replay <capture.glcs> [--loops N] [--finish] [--top N] [--out report.json]" << endl;
+    cout << "  --loops N    replay the frames after setup N times (default 1)" << endl;
+    cout << "  --finish     glFinish after every call, so call times include the GPU work they cause" << endl;
+    cout << "  --top N      entry points in the printed table (default 25)" << endl;
+    cout << "  --out file   JSON report with frame times and every entry point" << endl;
+}
+
+int main(int argc, char** argv){
+    vector<string> args(argv + 1, argv + argc);
+    if(args.empty() || args[0][0] == '-'){
+        printUsage();
+        return -1;
+    }
+    string capture = args[0];
+    uint64_t loops = 1;
+    size_t top = 25;
+    string out;
+    Replayer replayer;
+    for(size_t i = 1; i < args.size(); i++){
+        if(args[i] == "--loops" && i + 1 < args.size()){
+            loops = std::max(1, atoi(args[++i].c_str()));
+        }
+        else if(args[i] == "--finish"){
+            replayer.finishEachCall = true;
+        }
+        else if(args[i] == "--top" && i + 1 < args.size()){
+            top = static_cast<size_t>(std::max(1, atoi(args[++i].c_str())));
+        }
+        else if(args[i] == "--out" && i + 1 < args.size()){
+            out = args[++i];
+        }
+        else{
+            printUsage();
+            return -1;
+        }
+    }
+
+    if(!replayer.open(capture)){
+        cout << replayer.error << endl;
+        return -1;
+    }
+    // contexts without a default framebuffer report a 0x0 viewport, the app's window size then
+    int width = replayer.header.width > 0 ? static_cast<int>(replayer.header.width) : 800;
+    int height = replayer.header.height > 0 ? static_cast<int>(replayer.header.height) : 600;
+    GLFWwindow* window = createWindow(width, height);
+    if(window == NULL || !gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)){
+        cout << "can't create a GL 3.3 core context" << endl;
+        return -1;
+    }
+    GLExt::load((GLADloadproc)glfwGetProcAddress);
+    replayer.executors = executors();
+    cout << capture << ": " << replayer.header.frames << " frames, " << replayer.header.calls << " calls, "
+         << replayer.header.width << "x" << replayer.header.height << ", " << glGetString(GL_RENDERER) << endl;
+
+    // timestamps around each frame; TIME_ELAPSED would clash with the app's own GPU timer queries
+    GLuint timestamps[2];
+    glGenQueries(2, timestamps);
+
+    Clock::time_point start = Clock::now();
+    bool more = replayer.runFrame();
+    glFinish();
+    double setupMs = chrono::duration<double, milli>(Clock::now() - start).count();
+    size_t firstFrame = replayer.cursor;
+    vector<ReplayEntry> setupEntries = replayer.entries;
+    for(ReplayEntry &entry : replayer.entries){
+        entry.calls = 0;
+        entry.seconds = 0.0;
+        entry.maxSeconds = 0.0;
+    }
+
+    FrameStats frames;
+    double callSeconds = 0.0;
+    uint64_t glErrors = 0;
+    for(uint64_t loop = 0; more && loop < loops; loop++){
+        replayer.cursor = firstFrame;
+        while(true){
+            glQueryCounter(timestamps[0], GL_TIMESTAMP);
+            Clock::time_point frameStart = Clock::now();
+            if(!replayer.runFrame()){
+                more = replayer.error.empty();
+                break;
+            }
+            Clock::time_point submitted = Clock::now();
+            glQueryCounter(timestamps[1], GL_TIMESTAMP);
+            glFinish();
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(timestamps[0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(timestamps[1], GL_QUERY_RESULT, &end);
+            frames.addFrame(chrono::duration<double, milli>(submitted - frameStart).count());
+            frames.addGpuFrame((end - begin) / 1e6);
+            callSeconds += replayer.frameCallSeconds;
+            while(glGetError() != GL_NO_ERROR){
+                glErrors++;
+            }
+        }
+    }
+    if(!replayer.error.empty()){
+        cout << "replay stopped: " << replayer.error << endl;
+    }
+
+    FrameStats::Summary cpu = frames.cpuRun();
+    FrameStats::Summary gpu = frames.gpuRun();
+    double callMs = cpu.frames > 0 ? callSeconds * 1e3 / cpu.frames : 0.0;
+    printf("setup frame %.2f ms, then %llu frames x %llu loops\n", setupMs, static_cast<unsigned long long>(replayer.header.frames > 0 ? replayer.header.frames - 1 : 0),
+           static_cast<unsigned long long>(loops));
+    printf("  cpu submit  mean %.3f  p50 %.3f  p95 %.3f  max %.3f ms (%.3f ms in GL calls)\n", cpu.mean, cpu.p50, cpu.p95, cpu.max, callMs);
+    printf("  gpu         mean %.3f  p50 %.3f  p95 %.3f  max %.3f ms\n", gpu.mean, gpu.p50, gpu.p95, gpu.max);
+    if(glErrors > 0 || replayer.unknownPointers > 0){
+        printf("  %llu GL errors, %llu pointers replayed with scratch memory\n", static_cast<unsigned long long>(glErrors), static_cast<unsigned long long>(replayer.unknownPointers));
+    }
+
+    vector<const ReplayEntry*> sorted;
+    double total = 0.0;
+    for(const ReplayEntry &entry : replayer.entries){
+        if(entry.calls > 0){
+            sorted.push_back(&entry);
+            total += entry.seconds;
+        }
+        if(entry.skipped > 0){
+            printf("  %s isn't available, %llu calls skipped\n", entry.name.c_str(), static_cast<unsigned long long>(entry.skipped));
+        }
+    }
+    sort(sorted.begin(), sorted.end(), [](const ReplayEntry* a, const ReplayEntry* b){ return a->seconds > b->seconds; });
+    printf("\n%-36s %10s %12s %10s %10s %7s\n", "entry point", "calls", "total ms", "mean us", "max us", "share");
+    for(size_t i = 0; i < std::min(top, sorted.size()); i++){
+        const ReplayEntry &entry = *sorted[i];
+        printf("%-36s %10llu %12.3f %10.3f %10.3f %6.1f%%\n", entry.name.c_str(), static_cast<unsigned long long>(entry.calls), entry.seconds * 1e3,
+               entry.seconds * 1e6 / entry.calls, entry.maxSeconds * 1e6, total > 0.0 ? 100.0 * entry.seconds / total : 0.0);
+    }
+    double setupCalls = 0.0;
+    for(const ReplayEntry &entry : setupEntries){
+        setupCalls += entry.seconds;
+    }
+    printf("setup frame: %.2f ms in GL calls\n", setupCalls * 1e3);
+
+    if(!out.empty()){
+        if(writeReport(out, capture, replayer, sorted, setupMs, loops, frames, callMs, glErrors)){
+            cout << "report written to " << out << endl;
+        }
+        else{
+            cout << "can't write " << out << endl;
+        }
+    }
+    glDeleteQueries(2, timestamps);
+    glfwTerminate();
+    return replayer.error.empty() ? 0 : 1;
+}
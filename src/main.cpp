@@ -82,6 +82,9 @@ unsigned int indices[] = { // note that we start from 0!
 3,5,7,
 };
 
+// bounding sphere of a unit cube
+const float CUBE_RADIUS = 0.87f;
+
 vec3 cubePositions[] = {
     vec3( 0.0f, 0.0f, 0.0f),
     vec3( 2.0f, 5.0f, -15.0f),
@@ -95,6 +98,64 @@ vec3 cubePositions[] = {
     vec3(-1.3f, 1.0f, -1.5f)
 };
 
+// per instance vertex data, matches the aModel / aLayers attributes in shader.vert
+struct InstanceData {
+    mat4 model;
+    ivec4 layers;   // texture array layers: x diffuse, y specular, z emission
+};
+
+// extra spin in degrees of every third cube at scene time t, the rest only have their fixed tilt
+void animateCubes(double time, float spin[10]){
+    float scalar = abs(static_cast<float>(time));
+    for(unsigned int i = 0; i < 10; i++){
+        spin[i] = (i + 1) % 3 == 0 ? scalar * 300 : 0.0f;
+    }
+}
+
+// what the simulation thread publishes every tick: the camera after input and the cube animation
+struct SimState {
+    Camera camera;
+    double time = 0.0;
+    float spin[10] = {};
+    uint64_t inputSerial = 0;   // ticks so far that consumed mouse input
+    double inputTime = 0.0;     // glfwGetTime of the oldest mouse event the newest of those consumed
+    LookLatch::Totals look;     // mouse look applied to camera so far
+};
+
+// everything a frame draws from, built on the window thread and rendered on the render thread
+// (or right away when rendering stays on the window thread)
+struct FrameDescription {
+    Camera camera;
+    double sceneTime = 0.0;
+    float cubeSpin[10] = {};
+    double inputTime = 0.0;     // mouse event this frame first shows, 0 for none
+    LookLatch::Totals look;     // mouse look already in camera's orientation
+    FramePacer::Clock::time_point start;    // from framePacer.waitForFrameStart(), costs the frame
+};
+
+// the camera uniform block of shader.vert and lightShader.vert (std140), one per frame
+struct CameraBlock {
+    mat4 view;
+    mat4 projection;
+};
+
+// input the window thread hands to the simulation thread: held movement keys (a bit per
+// Camera_Movement), the mouse look totals (also latched by the renderer) and the zoom
+// accumulated since the last tick
+struct SimInput {
+    atomic<uint32_t> held{0};
+    LookLatch look;
+    mutex guard;       // guards scroll
+    float scroll = 0.0f;
+};
+
+// a material is one layer per texture role; materials whose textures share arrays batch together
+struct Material {
+    TextureSlot diffuse;
+    TextureSlot specular;
+    TextureSlot emission;
+};
+
 string projectPath = filesystem::current_path().parent_path().string();
 string vLocal = "/src/shader.vert";
 string fLocal = "/src/shader.frag";
@@ -116,7 +177,13 @@ class OpenGLTest{
     public:
         GLFWwindow* window;
 
-        OpenGLTest() : vertices(VERTICIES), verticesNum(sizeof(VERTICIES)), texCoords(TEX_COORDS){
+        // headless renders into an offscreen framebuffer behind a hidden window (see runBench)
+        // glCallStats counts every GL call per frame (GLCallStats), always on for headless runs
+        // reverseZ uses a float depth buffer with depth reversed and no far plane, when the
+        // context has clip control
+        // cookedTextures loads textures/cooked/ when it's there; off decodes the sources and
+        // builds the mips at runtime, the same on every checkout (golden runs)
+        explicit OpenGLTest(bool headless = false, bool glCallStats = false, bool reverseZ = true, bool cookedTextures = true) : headless(headless), cookedTextures(cookedTextures), glCallStats(glCallStats || headless), vertices(VERTICIES), verticesNum(sizeof(VERTICIES)), texCoords(TEX_COORDS){
             glfwInitialize();
             int glfwWindow = this->glfwWindow();
             if(glfwWindow == -1){
@@ -131,24 +198,32 @@ class OpenGLTest{
 
             this->setupShaders();
 
+            this->reverseZ = reverseZ && GLExt::ClipControl != NULL;
+            if(reverseZ && !this->reverseZ){
+                cout << "no clip control (GL 4.5 or ARB_clip_control), using standard depth" << endl;
+            }
             this->camera = Camera(FREE, (static_cast<float>(SCREEN_WIDTH)/static_cast<float>(SCREEN_HEIGHT)), vec3(0.0f, 0.0f, 3.0f));
-            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+            this->camera.ReverseZ = this->reverseZ;
+            // the window's own depth buffer is fixed point, reverse-Z renders offscreen and blits
+            if(this->headless || this->reverseZ){
+                this->setupOffscreenTarget();
+            }
+            if(!this->headless){
+                glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+            }
             glfwSetWindowUserPointer(window, this);
             glfwSetCursorPosCallback(window, mouse_callback);
             glfwSetScrollCallback(window, scroll_callback);
 
             this->setupObjects();
             
-            this->loadText(&texture1, "container2.png", GL_RGBA, GL_TEXTURE0);
-            this->loadText(&specular1, "container2_specular.png", GL_RGBA, GL_TEXTURE1);
-            this->loadText(&emission1, "matrix.jpg", GL_RGB, GL_TEXTURE2);
-
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, texture1);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, specular1);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, emission1);
+            this->loadText(&texture1, "container2.png");
+            this->loadText(&specular1, "container2_specular.png");
+            this->loadText(&emission1, "matrix.jpg");
+            this->materials.push_back(Material{ texture1, specular1, emission1 });
+            // from here on levels stream in during frames, through the frame's staging slot
+            this->textureResidency.setStaging(&this->stagingRing);
+
             glBindVertexArray(VAO);
 
             // activate shader
@@ -158,34 +233,574 @@ class OpenGLTest{
             (*ourShader).setInt("emission", 2);
 
             glEnable(GL_DEPTH_TEST);
+            if(this->reverseZ){
+                // clip z 0..w straight into depth, cleared to the far end (0) and nearer is greater
+                GLExt::ClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+                glClearDepth(0.0);
+                glDepthFunc(GL_GREATER);
+            }
             return;
         }
 
         int update(){
-            // get deltaTime:
-            this->updateDeltaTime();
+            if(this->renderThread.joinable()){
+                // render thread mode: this thread only handles events and queues frames
+                if(this->frameQueue->size() < this->frameQueue->capacity()){
+                    FramePacer::Clock::time_point start = this->framePacer.waitForFrameStart();
+                    glfwPollEvents();
+                    this->processInput(this->window);
+                    FrameDescription frame = this->describeFrame();
+                    frame.start = start;
+                    this->frameQueue->push(frame);
+                }
+                else{
+                    glfwPollEvents();
+                    this->processInput(this->window);
+                    this_thread::sleep_for(chrono::microseconds(250));
+                }
+                return 0;
+            }
+            // the low latency limiter holds the frame back, so poll right before using the input
+            // instead of after the previous swap
+            FramePacer::Clock::time_point start = this->framePacer.waitForFrameStart();
+            bool lateInput = this->framePacer.mode() == FramePacer::LOW_LATENCY;
+            // input, scripted instead in headless runs:
+            if(!this->headless){
+                if(lateInput){
+                    glfwPollEvents();
+                }
+                this->processInput(this->window);
+            }
+            FrameDescription frame = this->describeFrame();
+            frame.start = start;
+            this->renderFrame(frame, !lateInput);
+            return 0;
+        }
 
-            // input:
-            this->processInput(this->window);
-    
-            // rendering commands:
-            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            this->model = mat4(1.0);
-            this->view = this->camera.GetViewMatrix();
-            this->projection = perspective(radians(this->camera.Zoom), static_cast<float>(SCREEN_WIDTH)/static_cast<float>(SCREEN_HEIGHT), 0.1f, 100.0f);
-
-            this->drawObjects();
-            
-            // check and call events, swap buffers:
-            glfwSwapBuffers(this->window);
-            glfwPollEvents();
+        // moves the GL context to a thread that renders the frames update() queues, at most
+        // framesInFlight ahead; 0 keeps everything on the window thread
+        void startRenderThread(uint32_t framesInFlight){
+            if(framesInFlight == 0){
+                return;
+            }
+            this->frameQueue.reset(new SpscQueue<FrameDescription>(framesInFlight));
+            glfwMakeContextCurrent(NULL);
+            this->renderThread = thread([this](){
+                Profiler::setThreadName("render");
+                glfwMakeContextCurrent(this->window);
+                JobSystem::instance().setMainThread();
+                FrameDescription frame;
+                while(this->frameQueue->pop(frame)){
+                    this->renderFrame(frame, false);
+                }
+                glfwMakeContextCurrent(NULL);
+            });
+        }
+
+        void stopRenderThread(){
+            if(!this->renderThread.joinable()){
+                return;
+            }
+            this->frameQueue->cancel();
+            this->renderThread.join();
+            glfwMakeContextCurrent(this->window);
+            JobSystem::instance().setMainThread();
+        }
+
+        // draws and presents one frame; pollEvents when this is also the window thread
+        void renderFrame(const FrameDescription &frame, bool pollEvents){
+            Profiler::beginFrame();
+            {
+                // GL work jobs queued for the context's thread since the last frame
+                PROFILE_SCOPE("mainThreadJobs");
+                JobSystem::instance().drainMainThread();
+            }
+            {
+                // blocks while the GPU still has this slot's previous frame
+                PROFILE_SCOPE("fenceWait");
+                this->framePipeline.beginFrame();
+            }
+            this->instanceRing.beginFrame(this->framePipeline);
+            this->cameraRing.beginFrame(this->framePipeline);
+            this->stagingRing.beginFrame(this->framePipeline);
+            this->gpuTimer.beginFrame();
+            {
+                PROFILE_SCOPE("update");
+                // get deltaTime:
+                this->updateDeltaTime();
+                this->camera = frame.camera;
+                this->frameLook = frame.look;
+                this->frameInputTime = frame.inputTime;
+                this->sceneTime = frame.sceneTime;
+                copy(begin(frame.cubeSpin), end(frame.cubeSpin), this->cubeSpin);
+
+                // rendering commands:
+                this->gpuTimer.beginPass("clear");
+                glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                this->gpuTimer.endPass();
+                this->model = mat4(1.0);
+                this->view = this->camera.GetViewMatrix();
+                this->projection = this->camera.GetProjectionMatrix();
+
+                this->drawObjects();
+                if(this->recordingPath){
+                    // after the late latch, so it's the pose this frame was drawn with
+                    this->recordedPath.record(this->camera);
+                }
+                if(!this->headless && this->offscreenFBO != 0){
+                    this->presentOffscreenTarget();
+                }
+
+                // check and call events, swap buffers:
+                {
+                    PROFILE_SCOPE("glfwSwapBuffers");
+                    glfwSwapBuffers(this->window);
+                }
+                this->framePacer.framePresented(frame.start);
+                this->framePipeline.endFrame();
+                this->fenceWaits.push_back(static_cast<float>(this->framePipeline.lastWaitMilliseconds()));
+                // swap returning is as close to the photons as we can see without present timing
+                if(this->frameInputTime > 0.0){
+                    this->inputLatencies.push_back(static_cast<float>((glfwGetTime() - this->frameInputTime) * 1000.0));
+                }
+                if(pollEvents){
+                    PROFILE_SCOPE("glfwPollEvents");
+                    glfwPollEvents();
+                }
+            }
+            if(this->memoryReportRequested.exchange(false)){
+                GpuResources::printBreakdown(cout);
+            }
+            this->gpuTimer.endFrame();
+            if(GLCallStats::installed()){
+                GLCallStats::endFrame();
+            }
+            GpuResources::endFrame();
+            GLCapture::endFrame();
+            if(this->gpuTimer.resolvedFrames() != this->gpuFramesSeen){
+                this->gpuFramesSeen = this->gpuTimer.resolvedFrames();
+                this->frameStats.addGpuFrame(this->gpuTimer.lastFrameMilliseconds());
+            }
+            Profiler::endFrame();
+        }
+
+        // renders warmup + frames frames along path (by frame index, looping) with a fixed scene
+        // clock, so runs are comparable, and writes a JSON report to reportPath
+        int runBench(uint64_t frames, uint64_t warmup, const CameraPath &path, const string &pathName, const string &reportPath){
+            for(uint64_t frame = 0; frame < warmup + frames; frame++){
+                if(frame == warmup){
+                    this->frameStats.reset();
+                    this->fenceWaits.clear();
+                    this->framePacer.reset();
+                    GLCallStats::resetTotals();
+                }
+                path.apply(frame, this->camera);
+                this->sceneTime = frame / 60.0;
+
+                if(this->update() == -1){
+                    return -1;
+                }
+            }
+            glFinish();
+
+            FrameStats::Summary cpu = this->frameStats.cpuRun();
+            FrameStats::Summary gpu = this->frameStats.gpuRun();
+            FrameStats::Summary fenceWait = FrameStats::summarize(this->fenceWaits);
+            FramePacer::Jitter pacing = this->framePacer.jitter();
+            const GLCallStats::Counters &gl = GLCallStats::totals();
+            double perFrame = 1.0 / std::max<uint64_t>(GLCallStats::frames(), 1);
+            const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+            cout << "bench: " << frames << " frames along " << pathName << " on " << (renderer ? renderer : "?") << ", cpu mean " << cpu.mean << " ms p99 " << cpu.p99
+                 << " ms, gpu mean " << gpu.mean << " ms, " << gl.drawCalls * perFrame << " draws/frame, " << gl.primitives * perFrame << " triangles/frame" << endl;
+            this->printGLCallStats();
+
+            FILE* file = fopen(reportPath.c_str(), "w");
+            if(file == NULL){
+                cout << "Failed to write " << reportPath << endl;
+                return -1;
+            }
+            fprintf(file, "{\n  \"frames\": %llu,\n  \"warmup\": %llu,\n  \"width\": %u,\n  \"height\": %u,\n  \"renderer\": \"",
+                static_cast<unsigned long long>(frames), static_cast<unsigned long long>(warmup), SCREEN_WIDTH, SCREEN_HEIGHT);
+            Profiler::writeEscaped(file, renderer ? renderer : "");
+            fprintf(file, "\",\n  \"camera_path\": \"");
+            Profiler::writeEscaped(file, pathName.c_str());
+            fprintf(file, "\",\n  \"seconds\": %.4f,\n", this->frameStats.elapsedSeconds());
+            FrameStats::writeSummary(file, "cpu", cpu);
+            FrameStats::writeSummary(file, "gpu", gpu);
+            FrameStats::writeSummary(file, "fence_wait", fenceWait);
+            fprintf(file, "  \"frames_in_flight\": %u,\n", this->framePipeline.slots());
+            fprintf(file, "  \"pacing\": \"%s\",\n  \"pacing_target_hz\": %.2f,\n", FramePacer::modeName(this->framePacer.mode()), this->framePacer.targetHz());
+            FrameStats::writeSummary(file, "present_interval", pacing.interval);
+            FrameStats::writeSummary(file, "pacing_deviation", pacing.deviation);
+            fprintf(file, "  \"pacing_jitter_ms\": %.4f,\n  \"missed_deadlines\": %llu,\n", pacing.stddev, static_cast<unsigned long long>(pacing.missedDeadlines));
+            fprintf(file, "  \"draw_calls_per_frame\": %.2f,\n  \"triangles_per_frame\": %.2f,\n  \"gpu_frames_skipped\": %llu,\n  \"stutters\": %llu,\n",
+                gl.drawCalls * perFrame, gl.primitives * perFrame, static_cast<unsigned long long>(this->gpuTimer.skippedFrames()), static_cast<unsigned long long>(this->frameStats.stutterCount()));
+            fprintf(file, "  \"gl_per_frame\": {\"calls\": %.2f, \"draw_calls\": %.2f, \"instances\": %.2f, \"vertices\": %.2f, \"primitives\": %.2f, \"binds\": %.2f, "
+                "\"uniform_calls\": %.2f, \"uniform_bytes\": %.2f, \"buffer_bytes\": %.2f, \"texture_bytes\": %.2f},\n",
+                gl.calls * perFrame, gl.drawCalls * perFrame, gl.instances * perFrame, gl.vertices * perFrame, gl.primitives * perFrame, gl.binds * perFrame,
+                gl.uniformCalls * perFrame, gl.uniformBytes * perFrame, gl.bufferBytes * perFrame, gl.textureBytes * perFrame);
+            fprintf(file, "  \"gpu_memory_bytes\": {\"live\": %zu, \"peak\": %zu", GpuResources::totalBytes(), GpuResources::peakBytes());
+            for(int kind = 0; kind < GpuResources::KIND_COUNT; kind++){
+                if(GpuResources::stats(static_cast<GpuResources::Kind>(kind)).bytes > 0){
+                    fprintf(file, ", \"%s\": %zu", GpuResources::kindName(static_cast<GpuResources::Kind>(kind)), GpuResources::stats(static_cast<GpuResources::Kind>(kind)).bytes);
+                }
+            }
+            fprintf(file, "},\n");
+            fprintf(file, "  \"gl_calls_per_frame\": {");
+            vector<pair<const char*, uint64_t>> entries = GLCallStats::topEntryPoints(SIZE_MAX);
+            for(size_t i = 0; i < entries.size(); i++){
+                fprintf(file, "%s\"%s\": %.2f", i == 0 ? "" : ", ", entries[i].first, entries[i].second * perFrame);
+            }
+            fprintf(file, "}\n}\n");
+            fclose(file);
             return 0;
         }
 
+        // per frame averages since the last reset and the most called entry points
+        void printGLCallStats(){
+            if(!GLCallStats::installed()){
+                return;
+            }
+            const GLCallStats::Counters &gl = GLCallStats::totals();
+            double perFrame = 1.0 / std::max<uint64_t>(GLCallStats::frames(), 1);
+            cout << "gl per frame: " << gl.calls * perFrame << " calls, " << gl.drawCalls * perFrame << " draws, " << gl.primitives * perFrame << " primitives, "
+                 << gl.binds * perFrame << " binds, " << gl.uniformCalls * perFrame << " uniform calls (" << gl.uniformBytes * perFrame << " B), "
+                 << gl.bufferBytes * perFrame << " B buffers, " << gl.textureBytes * perFrame << " B textures" << endl;
+            for(const pair<const char*, uint64_t> &entry : GLCallStats::topEntryPoints(10)){
+                cout << "  " << entry.first << " " << entry.second * perFrame << endl;
+            }
+        }
+
+        // renders every scene in scenesPath at its fixed pose and scene time and compares the
+        // last frame with tests/golden/<name>.png, also checking the frame time and draw call
+        // budgets; update rewrites the golden images instead. Returns the number of failures.
+        int runGolden(const string &scenesPath, bool update){
+            vector<Golden::Scene> scenes;
+            string error;
+            if(!Golden::loadScenes(scenesPath, scenes, error)){
+                cout << "golden: " << error << endl;
+                return 1;
+            }
+            string goldenDir = projectPath + "/tests/golden/";
+            string outDir = projectPath + "/golden_out/";
+            int failures = 0;
+            vector<uint8_t> rgba(SCREEN_WIDTH * SCREEN_HEIGHT * 4);
+            vector<uint8_t> rgb(SCREEN_WIDTH * SCREEN_HEIGHT * 3);
+            for(const Golden::Scene &scene : scenes){
+                this->camera.SetPose(scene.position, scene.yaw, scene.pitch);
+                this->sceneTime = scene.time;
+                // warm up until texture streaming settles, then measure
+                for(uint64_t frame = 0; frame < 60 + 30; frame++){
+                    if(frame == 60){
+                        this->frameStats.reset();
+                        GLCallStats::resetTotals();
+                    }
+                    if(this->update() == -1){
+                        return -1;
+                    }
+                }
+                glFinish();
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, this->offscreenFBO);
+                glReadPixels(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+                // GL rows start at the bottom
+                for(unsigned int y = 0; y < SCREEN_HEIGHT; y++){
+                    ImageDecode::convertChannels(&rgba[(SCREEN_HEIGHT - 1 - y) * SCREEN_WIDTH * 4], 4, &rgb[y * SCREEN_WIDTH * 3], 3, SCREEN_WIDTH);
+                }
+
+                string goldenPath = goldenDir + scene.name + ".png";
+                if(update){
+                    filesystem::create_directories(goldenDir);
+                    bool written = Png::writeFile(goldenPath, rgb.data(), SCREEN_WIDTH, SCREEN_HEIGHT, 3);
+                    cout << "golden: " << (written ? "wrote " : "failed to write ") << goldenPath << endl;
+                    failures += written ? 0 : 1;
+                    continue;
+                }
+
+                vector<string> problems;
+                ImageDecode::Image golden;
+                Golden::Comparison comparison;
+                if(!ImageDecode::decodeFile(goldenPath, golden, 3)){
+                    problems.push_back("no golden image at " + goldenPath + " (run with --update-golden)");
+                }
+                else if(golden.width != SCREEN_WIDTH || golden.height != SCREEN_HEIGHT){
+                    problems.push_back("golden image is " + to_string(golden.width) + "x" + to_string(golden.height));
+                }
+                else{
+                    comparison = Golden::compare(golden.pixels.data(), rgb.data(), SCREEN_WIDTH, SCREEN_HEIGHT, 3);
+                    if(comparison.differentPercent > scene.maxDiffPercent){
+                        problems.push_back(to_string(comparison.differentPercent) + "% of pixels differ (budget " + to_string(scene.maxDiffPercent) + "%)");
+                    }
+                }
+                double cpuMs = this->frameStats.cpuRun().p50;
+                double drawCalls = static_cast<double>(GLCallStats::totals().drawCalls) / std::max<uint64_t>(GLCallStats::frames(), 1);
+                if(scene.maxCpuMs > 0.0 && cpuMs > scene.maxCpuMs){
+                    problems.push_back("median frame " + to_string(cpuMs) + " ms (budget " + to_string(scene.maxCpuMs) + " ms)");
+                }
+                if(scene.maxDrawCalls > 0.0 && drawCalls > scene.maxDrawCalls){
+                    problems.push_back(to_string(drawCalls) + " draw calls per frame (budget " + to_string(scene.maxDrawCalls) + ")");
+                }
+
+                cout << "golden: " << scene.name << (problems.empty() ? " PASS" : " FAIL") << ", " << comparison.differentPercent << "% different (max delta "
+                     << comparison.maxDelta << "), " << cpuMs << " ms, " << drawCalls << " draws" << endl;
+                for(const string &problem : problems){
+                    cout << "  " << problem << endl;
+                }
+                if(!problems.empty()){
+                    failures++;
+                    filesystem::create_directories(outDir);
+                    Png::writeFile(outDir + scene.name + ".png", rgb.data(), SCREEN_WIDTH, SCREEN_HEIGHT, 3);
+                    if(!comparison.diff.empty()){
+                        Png::writeFile(outDir + scene.name + "_diff.png", comparison.diff.data(), SCREEN_WIDTH, SCREEN_HEIGHT, 3);
+                    }
+                }
+            }
+            if(!update){
+                cout << "golden: " << scenes.size() - failures << "/" << scenes.size() << " scenes passed" << (failures ? ", output in " + outDir : "") << endl;
+            }
+            return failures;
+        }
+
+        // headless, with the simulation running: a thread moves the mouse right by a pixel per
+        // event through the cursor callback at about 1 kHz while frames render, once with late
+        // latching off and once on. After each frame the yaw it drew says how far along the
+        // scripted path it was, and the time the mouse got there gives the motion to present
+        // latency, interpolation lag included.
+        int runInputBench(uint64_t frames, uint64_t warmup, double simHz){
+            Camera start = this->camera;
+            for(bool latch : { false, true }){
+                this->camera = start;
+                this->lateLatch = latch;
+                this->startSimulation(simHz);
+                vector<pair<double, double>> path;      // glfwGetTime and x of every event
+                path.reserve((warmup + frames) * 100);
+                mutex pathGuard;
+                atomic<bool> moving{true};
+                thread mouse([&](){
+                    Profiler::setThreadName("scripted mouse");
+                    for(double x = 100.0; moving.load(); x += 1.0){
+                        {
+                            lock_guard<mutex> lock(pathGuard);
+                            path.push_back(make_pair(glfwGetTime(), x));
+                        }
+                        this->handle_mouse_callback(x, 300.0);
+                        this_thread::sleep_for(chrono::milliseconds(1));
+                    }
+                });
+                vector<float> latencies;
+                for(uint64_t frame = 0; frame < warmup + frames; frame++){
+                    if(frame == warmup && !latch){
+                        this->frameStats.reset();
+                    }
+                    if(this->update() == -1){
+                        moving.store(false);
+                        mouse.join();
+                        return -1;
+                    }
+                    double presented = glfwGetTime();
+                    lock_guard<mutex> lock(pathGuard);
+                    if(frame < warmup || path.size() < 2){
+                        continue;
+                    }
+                    // the first event only sets the cursor's starting point
+                    double shown = path[0].second + (this->camera.Yaw - start.Yaw) / this->camera.MouseSensitivity;
+                    vector<pair<double, double>>::const_iterator reached = lower_bound(path.begin(), path.end(), shown - 0.01, [](const pair<double, double> &event, double x){
+                        return event.second < x;
+                    });
+                    if(reached != path.end() && reached != path.begin()){
+                        latencies.push_back(static_cast<float>((presented - reached->first) * 1000.0));
+                    }
+                }
+                moving.store(false);
+                mouse.join();
+                this->simulation->stop();
+                this->simulation.reset();
+                this->firstMouse = true;
+
+                FrameStats::Summary latency = FrameStats::summarize(latencies);
+                cout << "input bench, late latching " << (latch ? "on" : "off") << " (" << simHz << " Hz simulation): motion to present ms, " << latency.frames
+                     << " frames, mean " << latency.mean << ", p50 " << latency.p50 << ", p95 " << latency.p95 << ", p99 " << latency.p99 << ", max " << latency.max << endl;
+            }
+            this->camera = start;
+            this->lateLatch = true;
+            return 0;
+        }
+
+        // camera movement and animation move to a fixed rate thread, frames draw its interpolated
+        // snapshots (see Simulation/fixed_step.h); headless runs keep driving both directly
+        void startSimulation(double hz){
+            SimState initial;
+            initial.camera = this->camera;
+            initial.look = this->simInput.look.totals();
+            animateCubes(initial.time, initial.spin);
+            this->simulation.reset(new FixedStepLoop<SimState>(hz));
+            this->simulation->start(initial, [this](SimState &state, double dt, uint64_t){
+                this->stepSimulation(state, dt);
+            });
+        }
+
+        // off draws the orientation the simulation interpolated, like everything else in the frame
+        void setLateLatch(bool enabled){
+            this->lateLatch = enabled;
+        }
+
+        // sets the swap interval for mode, so on the context's thread before startRenderThread;
+        // targetHz 0 uses the primary monitor's refresh rate
+        void setPacing(FramePacer::Mode mode, double targetHz){
+            if(targetHz <= 0.0){
+                GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+                const GLFWvidmode* videoMode = monitor != NULL ? glfwGetVideoMode(monitor) : NULL;
+                targetHz = videoMode != NULL && videoMode->refreshRate > 0 ? videoMode->refreshRate : 60.0;
+            }
+            bool tearControl = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+            if(mode == FramePacer::ADAPTIVE_VSYNC && !tearControl){
+                cout << "pacing: no swap tear control, adaptive falls back to vsync" << endl;
+            }
+            glfwSwapInterval(FramePacer::swapInterval(mode, tearControl));
+            this->framePacer.configure(mode, targetHz);
+        }
+
+        // before the first frame
+        void setGpuFramesInFlight(uint32_t frames){
+            this->framePipeline.setFramesInFlight(frames);
+        }
+
+        // draws the cubes with a cooked mesh (.gmesh from Mesh_Cooker) instead of the built in
+        // vertices, its most detailed LOD; OBJ and glTF files are imported on the spot. Before
+        // the first frame, on the window thread
+        bool loadMesh(const string &path){
+            if(MeshImport::supported(path)){
+                return importMesh(path);
+            }
+            MeshFile file;
+            if(!file.open(path)){
+                cout << "Failed to open mesh " << path << endl;
+                return false;
+            }
+            GPU_RESOURCE_SITE();
+            // the cube vao's vertex attributes now read the mesh, the instance ones are untouched
+            createMeshBuffers();
+            glBindVertexArray(this->VAO);
+            uploadMeshFile(file, this->meshVBO, this->meshEBO);
+            glBindVertexArray(0);
+
+            const MeshContainer::Header &header = file.header();
+            const MeshContainer::Lod &lod = file.lod(0);
+            this->meshSubmeshes.clear();
+            for(uint32_t i = lod.firstSubmesh; i < lod.firstSubmesh + lod.submeshCount; i++){
+                this->meshSubmeshes.push_back(file.submesh(i));
+            }
+            this->meshIndexType = header.indexType;
+            this->meshIndexSize = file.indexSize();
+            // culling tests a sphere around each cube's position, the mesh's origin
+            this->cubeRadius = length(make_vec3(header.sphereCenter)) + header.sphereRadius;
+            cout << "mesh: " << path << ", " << header.vertexCount << " vertices, " << lod.submeshCount << " submeshes, "
+                 << header.lodCount << " LODs, " << (file.vertexDataSize() + file.indexDataSize()) / 1024 << " KB uploaded from the mapping" << endl;
+            return true;
+        }
+
+        bool importMesh(const string &path){
+            MeshContainer::Mesh mesh;
+            vector<string> materials;
+            string error;
+            auto start = chrono::steady_clock::now();
+            if(!MeshImport::load(path, mesh, materials, error)){
+                cout << "Failed to import mesh " << error << endl;
+                return false;
+            }
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            GPU_RESOURCE_SITE();
+            createMeshBuffers();
+            glBindVertexArray(this->VAO);
+            uploadMesh(mesh, this->meshVBO, this->meshEBO);
+            glBindVertexArray(0);
+
+            const MeshContainer::Lod &lod = mesh.lods[0];
+            this->meshSubmeshes.assign(mesh.submeshes.begin() + lod.firstSubmesh, mesh.submeshes.begin() + lod.firstSubmesh + lod.submeshCount);
+            this->meshIndexType = GL_UNSIGNED_INT;
+            this->meshIndexSize = sizeof(uint32_t);
+            float radius = 0.0f;
+            for(uint32_t vertex = 0; vertex < mesh.vertexCount; vertex++){
+                float p[3];
+                MeshContainer::position(mesh, *MeshContainer::findAttribute(mesh, MeshContainer::LOCATION_POSITION), vertex, p);
+                radius = std::max(radius, length(make_vec3(p)));
+            }
+            this->cubeRadius = radius;
+            cout << "mesh: " << path << ", " << mesh.vertexCount << " vertices, " << lod.submeshCount << " submeshes, imported in "
+                 << ms << " ms (cook it with Mesh_Cooker to skip this)" << endl;
+            return true;
+        }
+
+        void createMeshBuffers(){
+            glGenBuffers(1, &this->meshVBO);
+            glGenBuffers(1, &this->meshEBO);
+            GpuResources::label(GpuResources::BUFFER, this->meshVBO, "mesh vertices");
+            GpuResources::label(GpuResources::BUFFER, this->meshEBO, "mesh indices");
+        }
+
+        // records the next frames into a Chrome trace (chrome://tracing, ui.perfetto.dev)
+        void captureTrace(const string &path, uint64_t frames){
+            Profiler::beginCapture(path, frames);
+            cout << "capturing " << frames << " frames to " << path << endl;
+        }
+
+        // records the camera of every frame drawn from here on, written to path by stop()
+        void recordCameraPath(const string &path){
+            this->recordingPath = true;
+            this->recordedPathFile = path;
+        }
+
         int stop(){
+            if(Profiler::capturing()){
+                Profiler::endCapture();
+            }
+            this->stopRenderThread();
+            GLCapture::end();
+            if(this->recordingPath){
+                if(this->recordedPath.save(this->recordedPathFile)){
+                    cout << "camera path: " << this->recordedPath.frames() << " frames to " << this->recordedPathFile << endl;
+                }
+                else{
+                    cout << "Failed to write " << this->recordedPathFile << endl;
+                }
+            }
+            if(this->simulation){
+                this->simulation->stop();
+                FixedStepLoop<SimState>::Stats sim = this->simulation->statistics();
+                cout << "simulation: " << sim.ticks << " ticks at " << 1.0 / this->simulation->stepSeconds() << " Hz, " << sim.droppedTicks << " dropped, step mean "
+                     << (sim.ticks > 0 ? sim.stepSeconds * 1e6 / sim.ticks : 0.0) << " us max " << sim.maxStepSeconds * 1e6 << " us" << endl;
+            }
+            this->gpuTimer.destroy();
+            this->reportFrameStats();
+            this->reportFenceWaits();
+            this->reportPacing();
+            if(!this->headless){
+                FrameStats::Summary latency = FrameStats::summarize(this->inputLatencies);
+                cout << "input to present ms (" << (this->frameQueue ? "render thread, " + to_string(this->frameQueue->capacity()) + " frames in flight" : string("single thread"))
+                     << "): " << latency.frames << " frames, mean " << latency.mean << ", p50 " << latency.p50 << ", p95 " << latency.p95
+                     << ", p99 " << latency.p99 << ", max " << latency.max << endl;
+            }
+            if(!this->headless){
+                this->printGLCallStats();
+            }
+            TextureArrayAllocator::Stats arrayStats = this->textureArrays.stats();
+            cout << "texture arrays: " << arrayStats.arrays << " arrays, " << arrayStats.layersUsed << "/" << arrayStats.layersCapacity
+                 << " layers used, fragmentation " << arrayStats.fragmentation * 100.0f << "%, "
+                 << arrayStats.bytesUsed / 1024 << "/" << arrayStats.bytesReserved / 1024 << " KB, "
+                 << arrayStats.bindsIssued << " binds issued, " << arrayStats.rebindsAvoided << " rebinds avoided" << endl;
+            TextureResidency::Stats residencyStats = this->textureResidency.stats();
+            cout << "texture residency: " << residencyStats.residentBytes / 1024 << "/" << residencyStats.budgetBytes / 1024 << " KB resident, "
+                 << residencyStats.levelsStreamedIn << " levels in (" << residencyStats.bytesStreamedIn / 1024 << " KB), "
+                 << residencyStats.levelsStreamedOut << " out, " << residencyStats.evictions << " evicted for budget" << endl;
+            for(const TextureSlot* slot : { &this->texture1, &this->specular1, &this->emission1 }){
+                cout << "  array " << slot->array << " layer " << slot->layer << ": base level " << this->textureResidency.residentLevel(*slot)
+                     << ", " << this->textureResidency.residentBytes(*slot) / 1024 << " KB" << endl;
+            }
+            GpuResources::printBreakdown(cout);
             this->unbindObjects();
             this->deleteObjects();
+            // everything this class created is gone now, what is left leaked
+            GpuResources::leakReport(cout);
             glfwTerminate();
             return 0;
         }
@@ -193,13 +808,57 @@ class OpenGLTest{
     private:
         #pragma region Private Class Variables
         unsigned int VBO, VAO, EBO;
-        unsigned int texture1;
-        unsigned int specular1;
-        unsigned int emission1;
+        unsigned int meshVBO = 0, meshEBO = 0;
+        vector<MeshContainer::Submesh> meshSubmeshes;  // empty draws the built in cube
+        GLenum meshIndexType = GL_UNSIGNED_SHORT;
+        size_t meshIndexSize = sizeof(uint16_t);
+        float cubeRadius = CUBE_RADIUS;
+        FramePipeline framePipeline;
+        FrameRing instanceRing{GL_ARRAY_BUFFER, 16 * sizeof(InstanceData), "cube instances"};
+        FrameRing stagingRing{GL_PIXEL_UNPACK_BUFFER, 256u << 10, "texture staging"};
+        FrameRing cameraRing{GL_UNIFORM_BUFFER, sizeof(CameraBlock), "camera block"};
+        bool lateLatch = true;
+        LookLatch::Totals frameLook;    // mouse look in this frame's camera before latching
+        double frameInputTime = 0.0;    // oldest mouse event this frame shows, 0 for none
+        bool recordingPath = false;
+        CameraPath recordedPath;        // only touched by the thread that renders, until stop()
+        string recordedPathFile;
+        vector<float> fenceWaits;       // ms per frame in framePipeline.beginFrame()
+        FramePacer framePacer;
+        TextureArrayAllocator textureArrays{8, true};
+        TextureResidency textureResidency{textureArrays, TEXTURE_BUDGET};
+        GpuTimer gpuTimer;
+        bool headless = false;
+        bool cookedTextures = true;
+        unsigned int offscreenFBO = 0, offscreenColor = 0, offscreenDepth = 0;
+        bool reverseZ = false;
+        double sceneTime = 0.0;
+        float cubeSpin[10] = {};
+        unique_ptr<FixedStepLoop<SimState>> simulation;
+        SimInput simInput;
+        uint64_t inputSerialSeen = 0;
+        unique_ptr<SpscQueue<FrameDescription>> frameQueue;
+        thread renderThread;
+        vector<float> inputLatencies;   // ms, render thread (or the window thread without one)
+        atomic<bool> memoryReportRequested{false};
+        bool glCallStats = false;
+        uint64_t gpuFramesSeen = 0;
+        FrameStats frameStats;
+        bool traceKeyDown = false;
+        bool memoryKeyDown = false;
+        TextureSlot texture1;
+        TextureSlot specular1;
+        TextureSlot emission1;
+        vector<Material> materials;
+        vector<InstanceData> instances;
+        vector<unsigned int> visibleCubes;  // culled and sorted, for the camera at visibleVersion
+        uint64_t visibleVersion = 0;
         Shader* ourShader;
         Shader* ourLightShader;
         const unsigned int SCREEN_WIDTH = 800;
         const unsigned int SCREEN_HEIGHT = 600;
+        static const size_t TEXTURE_BUDGET = 32u << 20;
+        static const GLuint CAMERA_BINDING = 0;
         mat4 model;
         mat4 view;
         mat4 projection;
@@ -207,7 +866,6 @@ class OpenGLTest{
         // Camera 
         Camera camera;
         float deltaTime = 0.0f;
-        float lastFrame = 0.0f;
         float lastX, lastY;
         bool firstMouse = true;
 
@@ -241,35 +899,139 @@ class OpenGLTest{
             float yOffset = lastY - ypos;
             lastX = xpos;
             lastY = ypos;
-            camera.ProcessMouseMovement(xOffset, yOffset, true);
+            if(this->simulation){
+                this->simInput.look.add(xOffset, yOffset, glfwGetTime());
+            }
+            else{
+                camera.ProcessMouseMovement(xOffset, yOffset, true);
+            }
         };
 
         void handle_scroll_callback(double yoffset){
-            this->camera.ProcessMouseScroll(yoffset);
+            if(this->simulation){
+                lock_guard<mutex> lock(this->simInput.guard);
+                this->simInput.scroll += static_cast<float>(yoffset);
+            }
+            else{
+                this->camera.ProcessMouseScroll(yoffset);
+            }
+        }
+
+        // one tick on the simulation thread: input gathered since the last tick, then the animation
+        void stepSimulation(SimState &state, double dt){
+            float scroll;
+            {
+                lock_guard<mutex> lock(this->simInput.guard);
+                scroll = this->simInput.scroll;
+                this->simInput.scroll = 0.0f;
+            }
+            LookLatch::Totals look = this->simInput.look.totals();
+            if(look.events != state.look.events){
+                state.camera.ProcessMouseMovement(LookLatch::deltaX(state.look, look), LookLatch::deltaY(state.look, look), true);
+                state.look = look;
+                // with late latching the renderer shows these first and measures them instead
+                double oldest = this->lateLatch ? 0.0 : this->simInput.look.takeOldestEvent();
+                if(oldest > 0.0){
+                    state.inputSerial++;
+                    state.inputTime = oldest;
+                }
+            }
+            if(scroll != 0.0f){
+                state.camera.ProcessMouseScroll(scroll);
+            }
+            uint32_t held = this->simInput.held.load(memory_order_relaxed);
+            for(Camera_Movement direction : { FORWARD, BACKWARD, LEFT, RIGHT }){
+                if(held & (1u << direction)){
+                    state.camera.ProcessKeyboard(direction, static_cast<float>(dt));
+                }
+            }
+            state.time += dt;
+            animateCubes(state.time, state.spin);
+        }
+
+        // the next frame: blended between the two newest simulation ticks, or straight from the
+        // scripted camera and scene clock when there is no simulation
+        FrameDescription describeFrame(){
+            FrameDescription frame;
+            if(!this->simulation){
+                frame.camera = this->camera;
+                frame.sceneTime = this->sceneTime;
+                animateCubes(frame.sceneTime, frame.cubeSpin);
+                return frame;
+            }
+            FixedStepLoop<SimState>::Sample sample = this->simulation->sample();
+            const SimState &from = sample.previous;
+            const SimState &to = sample.current;
+            float alpha = sample.alpha;
+            frame.camera = to.camera;
+            if(this->lateLatch){
+                // orientation isn't interpolated: the newest tick's, plus whatever the renderer
+                // latches on top of it
+                frame.camera.SetPose(mix(from.camera.Position, to.camera.Position, alpha), to.camera.Yaw, to.camera.Pitch);
+                frame.look = to.look;
+            }
+            else{
+                frame.camera.SetPose(mix(from.camera.Position, to.camera.Position, alpha), mix(from.camera.Yaw, to.camera.Yaw, alpha), mix(from.camera.Pitch, to.camera.Pitch, alpha));
+            }
+            frame.camera.Zoom = mix(from.camera.Zoom, to.camera.Zoom, alpha);
+            frame.sceneTime = mix(from.time, to.time, static_cast<double>(alpha));
+            for(unsigned int i = 0; i < 10; i++){
+                frame.cubeSpin[i] = mix(from.spin[i], to.spin[i], alpha);
+            }
+            if(to.inputSerial != this->inputSerialSeen){
+                this->inputSerialSeen = to.inputSerial;
+                frame.inputTime = to.inputTime;
+            }
+            return frame;
         }
 
         void processInput(GLFWwindow *window){
             if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
                 glfwSetWindowShouldClose(this->window, true);
             }
-
-            vec3 restriction = vec3(1.0f, 0.0f, 1.0f);
-            if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS){
-                this->camera.ProcessKeyboard(FORWARD, this->deltaTime);
-            }
-            if(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS){
-                this->camera.ProcessKeyboard(BACKWARD, this->deltaTime);
+            // F9 traces the next 120 frames
+            bool traceKey = glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS;
+            if(traceKey && !this->traceKeyDown && !Profiler::capturing()){
+                this->captureTrace(projectPath + "/trace_" + to_string(Profiler::frameIndex()) + ".json", 120);
             }
-            if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS){
-                this->camera.ProcessKeyboard(LEFT, this->deltaTime);
+            this->traceKeyDown = traceKey;
+            // F10 prints the live GPU memory breakdown
+            bool memoryKey = glfwGetKey(window, GLFW_KEY_F10) == GLFW_PRESS;
+            if(memoryKey && !this->memoryKeyDown){
+                // printed after the next frame, on the thread that owns the GL objects
+                this->memoryReportRequested.store(true);
             }
-            if(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS){
-                this->camera.ProcessKeyboard(RIGHT, this->deltaTime); 
+            this->memoryKeyDown = memoryKey;
+
+            vec3 restriction = vec3(1.0f, 0.0f, 1.0f);
+            // the simulation thread moves the camera from the held keys on its own ticks
+            const pair<int, Camera_Movement> keys[] = { { GLFW_KEY_W, FORWARD }, { GLFW_KEY_S, BACKWARD }, { GLFW_KEY_A, LEFT }, { GLFW_KEY_D, RIGHT } };
+            uint32_t held = 0;
+            for(const pair<int, Camera_Movement> &key : keys){
+                if(glfwGetKey(window, key.first) == GLFW_PRESS){
+                    if(this->simulation){
+                        held |= 1u << key.second;
+                    }
+                    else{
+                        this->camera.ProcessKeyboard(key.second, this->deltaTime);
+                    }
+                }
             }
+            this->simInput.held.store(held, memory_order_relaxed);
         }
 
         void glfwInitialize(){
+#if defined(__linux__)
+            // no display server: GLFW's null platform with an OSMesa context (Mesa llvmpipe)
+            if(this->headless && getenv("DISPLAY") == NULL && getenv("WAYLAND_DISPLAY") == NULL){
+                glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+                glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+            }
+#endif
             glfwInit();
+            if(this->headless){
+                glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            }
             glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
             glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
             glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -292,27 +1054,48 @@ class OpenGLTest{
                 cout << "Failed to initialize GLAD" << endl;
                 return -1;
             }
+            GLExt::load((GLADloadproc)glfwGetProcAddress);
+            // before anything is created, so every object is accounted for
+            GpuResources::install();
+#ifdef GL_CALL_STATS
+            this->glCallStats = true;
+#endif
+            if(this->glCallStats){
+                GLCallStats::install();
+            }
+            // starts a capture requested with --capture, so it sees every object being created
+            GLCapture::install();
     
             framebuffer_size_callback(this->window, SCREEN_WIDTH, SCREEN_HEIGHT);
             return 0;
         }
     
         void setupShaders(){
+            GPU_RESOURCE_SITE();
             this->ourShader = new Shader(vShaderPath,fShaderPath);
+            GpuResources::label(GpuResources::PROGRAM, this->ourShader->ID, "cube shader");
 
             string vLightFullPath = (projectPath+vLightLocal);
             string fLightFullPath = (projectPath+fLightLocal);
             const char* vLightShaderPath = vLightFullPath.c_str();
             const char* fLightShaderPath = fLightFullPath.c_str();
             this->ourLightShader = new Shader(vLightShaderPath,fLightShaderPath);
+            GpuResources::label(GpuResources::PROGRAM, this->ourLightShader->ID, "light shader");
+            this->ourShader->setBlockBinding("Camera", CAMERA_BINDING);
+            this->ourLightShader->setBlockBinding("Camera", CAMERA_BINDING);
         }
 
         void setupObjects(){
             // Generate buffers
+            GPU_RESOURCE_SITE();
             glGenBuffers(1, &this->EBO);
             glGenVertexArrays(1, &this->VAO);
             glGenBuffers(1, &this->VBO);
             glGenVertexArrays(1, &this->lightVAO);
+            GpuResources::label(GpuResources::BUFFER, this->EBO, "cube indices");
+            GpuResources::label(GpuResources::VERTEX_ARRAY, this->VAO, "cube vao");
+            GpuResources::label(GpuResources::BUFFER, this->VBO, "cube vertices");
+            GpuResources::label(GpuResources::VERTEX_ARRAY, this->lightVAO, "light vao");
 
             // bind and fill VBO with data
             glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
@@ -329,6 +1112,13 @@ class OpenGLTest{
             glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6* sizeof(float)));
             glEnableVertexAttribArray(2);
 
+            // per instance model matrix (4 vec4 columns) and texture layers, pointed into the
+            // frame's slot of instanceRing before each draw
+            for(unsigned int i = 3; i <= 7; i++){
+                glEnableVertexAttribArray(i);
+                glVertexAttribDivisor(i, 1);
+            }
+
             // bind and apply data from EBO to lightVAO
             // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
             // glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
@@ -343,64 +1133,178 @@ class OpenGLTest{
             // glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
         }
 
+        // color + depth renderbuffers the size of the scene, left bound for every frame
+        void setupOffscreenTarget(){
+            GPU_RESOURCE_SITE();
+            glGenFramebuffers(1, &this->offscreenFBO);
+            glGenRenderbuffers(1, &this->offscreenColor);
+            glGenRenderbuffers(1, &this->offscreenDepth);
+            GpuResources::label(GpuResources::FRAMEBUFFER, this->offscreenFBO, "offscreen target");
+            GpuResources::label(GpuResources::RENDERBUFFER, this->offscreenColor, "offscreen color");
+            GpuResources::label(GpuResources::RENDERBUFFER, this->offscreenDepth, "offscreen depth");
+            glBindRenderbuffer(GL_RENDERBUFFER, this->offscreenColor);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SCREEN_WIDTH, SCREEN_HEIGHT);
+            glBindRenderbuffer(GL_RENDERBUFFER, this->offscreenDepth);
+            // reverse-Z needs float depth, fixed point has its precision where reversed depth has none
+            glRenderbufferStorage(GL_RENDERBUFFER, this->reverseZ ? GL_DEPTH_COMPONENT32F : GL_DEPTH24_STENCIL8, SCREEN_WIDTH, SCREEN_HEIGHT);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, this->offscreenFBO);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->offscreenColor);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, this->reverseZ ? GL_DEPTH_ATTACHMENT : GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->offscreenDepth);
+            if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+                cout << "Offscreen framebuffer is incomplete" << endl;
+            }
+            glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+        }
+
+        // copies the frame from the offscreen target to the window's framebuffer, where the
+        // viewport used to put it
+        void presentOffscreenTarget(){
+            PROFILE_FUNCTION();
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, this->offscreenFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, this->offscreenFBO);
+            // the resize callback sets the viewport to the window's size
+            glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+        }
+
         void unbindObjects(){
             glBindBuffer(GL_ARRAY_BUFFER, 0);
             glBindVertexArray(0);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
         }
 
-        void loadText(unsigned int* texture, string textName, unsigned int dataType, unsigned int textNum){
-            // loading texture
-            glGenTextures(1, texture);
-            glBindTexture(GL_TEXTURE_2D, *texture);
-
-            // set texture parameters (wrapping, filtering, mipmaps)
-            // set per coordinate s,t,r = x,y,z
-            // set texture option on currently bound textures
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR_MIPMAP_LINEAR);
+        void loadText(TextureSlot* slot, string textName){
+            // prefer the cooked container (run Texture_Cooker --all), it already has every mip
+            TextureFile cooked;
+            string cookedPath = (projectPath+"/textures/cooked/" + filesystem::path(textName).stem().string() + ".gtex");
+            if(this->cookedTextures && cooked.open(cookedPath)){
+                *slot = this->textureArrays.allocate(TextureArrayKey::fromFile(cooked));
+                this->textureResidency.track(*slot, std::move(cooked));
+                return;
+            }
+            if(this->cookedTextures && filesystem::exists(cookedPath)){
+                cout << "Ignoring " << cookedPath << ", it isn't a valid cooked texture (cook it again)" << endl;
+            }
 
-            int width, height, nrChannels;
             string fullTexPath = (projectPath+"/textures/" + textName);
-            unsigned char *data = stbi_load(fullTexPath.c_str(), &width, &height, &nrChannels, 0);
-
-            if(data){
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, 
-                    dataType, GL_UNSIGNED_BYTE, data);
-                glGenerateMipmap(GL_TEXTURE_2D);
+            ImageDecode::Image image;
+
+            if(ImageDecode::decodeFile(fullTexPath, image, 4)){
+                // build the mips on the CPU instead of glGenerateMipmap so both paths filter the same way
+                vector<TextureContainer::Level> levels = Mips::generate(image.pixels.data(), image.width, image.height);
+                TextureArrayKey key;
+                key.width = image.width;
+                key.height = image.height;
+                key.levels = static_cast<uint32_t>(levels.size());
+                *slot = this->textureArrays.allocate(key);
+                this->textureResidency.track(*slot, std::move(levels));
             }
             else{
-                cout << "Failed to load texture because " << stbi_failure_reason() << endl;
+                cout << "Failed to load texture because " << ImageDecode::failureReason() << endl;
             }
-
-            stbi_image_free(data);
         }
 
         void updateDeltaTime(){
-            float currentFrame = glfwGetTime();
-            this->deltaTime = currentFrame-this->lastFrame;
-            this->lastFrame = currentFrame;
+            // steady clock in double precision, glfwGetTime as a float loses precision over long runs
+            this->deltaTime = static_cast<float>(this->frameStats.tick());
+        }
+
+        // frames that waited on a fence were GPU bound, the rest CPU bound (or waiting on vsync)
+        void reportFenceWaits(){
+            FrameStats::Summary wait = FrameStats::summarize(this->fenceWaits);
+            const FramePipeline::Stats &stats = this->framePipeline.stats();
+            cout << "fence wait ms (" << this->framePipeline.slots() << " frames in flight): " << wait.frames << " frames, mean " << wait.mean << ", p95 " << wait.p95
+                 << ", max " << wait.max << ", " << stats.framesWaited << " frames GPU bound" << endl;
+            cout << "frame rings: instances " << this->instanceRing.peakBytes() << "/" << this->instanceRing.slotBytes() << " B per slot, staging "
+                 << this->stagingRing.peakBytes() / 1024 << "/" << this->stagingRing.slotBytes() / 1024 << " KB per slot, "
+                 << this->instanceRing.growths() + this->stagingRing.growths() << " growths" << endl;
+        }
+
+        // present to present intervals against the rate the mode should hold
+        void reportPacing(){
+            FramePacer::Jitter pacing = this->framePacer.jitter();
+            cout << "pacing (" << FramePacer::modeName(this->framePacer.mode());
+            if(this->framePacer.mode() != FramePacer::UNCAPPED){
+                cout << ", " << this->framePacer.targetHz() << " Hz target";
+            }
+            cout << "): " << pacing.interval.frames
+                 << " presents, interval mean " << pacing.interval.mean << " ms, jitter " << pacing.stddev << " ms, |interval - " << pacing.targetMilliseconds
+                 << "| p50 " << pacing.deviation.p50 << " p99 " << pacing.deviation.p99 << " max " << pacing.deviation.max << " ms";
+            if(this->framePacer.mode() == FramePacer::LOW_LATENCY){
+                cout << ", " << pacing.missedDeadlines << " missed deadlines, mean hold " << pacing.waitMilliseconds << " ms";
+            }
+            cout << endl;
+        }
+
+        // prints run percentiles and writes frame_stats.csv / frame_stats.json next to src/
+        void reportFrameStats(){
+            const char* names[] = { "cpu", "gpu" };
+            FrameStats::Summary summaries[] = { this->frameStats.cpuRun(), this->frameStats.gpuRun() };
+            for(int i = 0; i < 2; i++){
+                cout << names[i] << " frame ms: " << summaries[i].frames << " frames, mean " << summaries[i].mean << ", p50 " << summaries[i].p50
+                     << ", p95 " << summaries[i].p95 << ", p99 " << summaries[i].p99 << ", max " << summaries[i].max << endl;
+            }
+            cout << "hitches:";
+            for(size_t i = 0; i < this->frameStats.settings().hitchThresholds.size(); i++){
+                cout << " >" << this->frameStats.settings().hitchThresholds[i] << "ms " << this->frameStats.hitchCount(i);
+            }
+            cout << ", stutters (>" << this->frameStats.settings().stutterFactor << "x median) " << this->frameStats.stutterCount() << endl;
+            this->frameStats.writeCsv(projectPath + "/frame_stats.csv");
+            this->frameStats.writeJson(projectPath + "/frame_stats.json");
         }
 
         void deleteObjects(){
             glDeleteVertexArrays(1, &this->VAO);
             glDeleteBuffers(1, &this->VBO);
             glDeleteBuffers(1, &this->EBO);
-            glDeleteBuffers(1, &this->lightVAO);
+            if(this->meshVBO != 0){
+                glDeleteBuffers(1, &this->meshVBO);
+                glDeleteBuffers(1, &this->meshEBO);
+            }
+            this->instanceRing.destroy();
+            this->stagingRing.destroy();
+            this->cameraRing.destroy();
+            this->framePipeline.destroy();
+            this->textureArrays.destroy();
+            glDeleteVertexArrays(1, &this->lightVAO);
             (*ourShader).close();
+            (*ourLightShader).close();
+            delete this->ourShader;
+            delete this->ourLightShader;
+            this->ourShader = NULL;
+            this->ourLightShader = NULL;
+            if(this->offscreenFBO != 0){
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glDeleteFramebuffers(1, &this->offscreenFBO);
+                glDeleteRenderbuffers(1, &this->offscreenColor);
+                glDeleteRenderbuffers(1, &this->offscreenDepth);
+            }
+        }
+
+        // binds the arrays backing a material, already bound arrays are skipped
+        void bindTextures(const Material &material){
+            this->textureArrays.bind(0, material.diffuse.array);
+            this->textureArrays.bind(1, material.specular.array);
+            this->textureArrays.bind(2, material.emission.array);
+        }
+
+        // instance attributes start at byte offset base of the bound array buffer, GL 3.3 has no
+        // base instance for draws
+        void pointInstanceAttributes(size_t base){
+            for(unsigned int column = 0; column < 4; column++){
+                glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(base + column * sizeof(vec4)));
+            }
+            glVertexAttribIPointer(7, 4, GL_INT, sizeof(InstanceData), (void*)(base + offsetof(InstanceData, layers)));
+        }
+
+        static bool sameArrays(const Material &a, const Material &b){
+            return a.diffuse.array == b.diffuse.array && a.specular.array == b.specular.array && a.emission.array == b.emission.array;
         }
 
-        void bindTextures(){
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, this->texture1);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, this->specular1);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, this->emission1);
+        static bool sameLayers(const Material &a, const Material &b){
+            return a.diffuse.layer == b.diffuse.layer && a.specular.layer == b.specular.layer && a.emission.layer == b.emission.layer;
         }
 
         void moveLight(float scalar){
@@ -410,17 +1314,37 @@ class OpenGLTest{
             // lightPos.x += factor * cos(scalar) * this->deltaTime;
         }
 
+        // with late latching, turns the camera by the mouse motion that arrived after the tick
+        // the frame was described from, then writes the frame's camera block. Called right
+        // before the first draw, after the CPU work of the frame.
+        void latchCamera(){
+            PROFILE_FUNCTION();
+            if(this->lateLatch && this->simulation){
+                LookLatch::Totals look = this->simInput.look.totals();
+                if(look.events != this->frameLook.events){
+                    this->camera.ProcessMouseMovement(LookLatch::deltaX(this->frameLook, look), LookLatch::deltaY(this->frameLook, look), true);
+                    this->view = this->camera.GetViewMatrix();
+                }
+                double oldest = this->simInput.look.takeOldestEvent();
+                if(oldest > 0.0){
+                    this->frameInputTime = oldest;
+                }
+            }
+            CameraBlock block = { this->view, this->projection };
+            size_t offset = this->cameraRing.write(&block, sizeof(block));
+            glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BINDING, this->cameraRing.buffer(), offset, sizeof(block));
+        }
+
         void drawObjects(){
+            PROFILE_FUNCTION();
 
-            float scalar = abs(glfwGetTime());
+            float scalar = abs(static_cast<float>(this->sceneTime));
             vec3 lightColor = vec3(1.0f);
             vec3 diffuseColor = lightColor;
             vec4 lightDir = vec4(-0.2f, -1.0f, -0.3f, 0.0);
             moveLight(scalar);
             (*ourShader).use();
 
-            bindTextures();
-
             // Emission
             (*ourShader).setInt("material.emission", 2);
 
@@ -450,31 +1374,97 @@ class OpenGLTest{
             (*ourShader).setFloat("light.outerCutOff", cos(radians(17.5f)));
             // cout << cos(radians(1.5f)) << endl;
             
-            // Model View Projection
-            (*ourShader).setMat4("projection", this->projection);
-            (*ourShader).setMat4("view", this->view);
-            this->model = mat4(1.0);
-            (*ourShader).setMat4("model", this->model);
-
             // ******************************//
 
             // Objects
 
-            glBindVertexArray(this->VAO);
-
-
+            // instances sorted so cubes whose materials live in the same arrays are contiguous
+            vector<size_t> materialOf(10);
             for(unsigned int i = 0; i < 10; i++){
+                materialOf[i] = i % this->materials.size();
+            }
+            // the cubes and their materials don't move, so the visible list only changes with the camera
+            if(this->visibleVersion != this->camera.Version()){
+                this->visibleVersion = this->camera.Version();
+                vector<unsigned int> &order = this->visibleCubes;
+                order.resize(10);
+                for(unsigned int i = 0; i < 10; i++){
+                    order[i] = i;
+                }
+                stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b){
+                    const Material &ma = this->materials[materialOf[a]];
+                    const Material &mb = this->materials[materialOf[b]];
+                    return tie(ma.diffuse.array, ma.specular.array, ma.emission.array) < tie(mb.diffuse.array, mb.specular.array, mb.emission.array);
+                });
+                // cubes outside the view frustum are neither drawn nor streamed in
+                const Culling::Frustum &frustum = this->camera.GetFrustum();
+                order.erase(remove_if(order.begin(), order.end(), [&](unsigned int i){
+                    return !frustum.testSphere(cubePositions[i], this->cubeRadius);
+                }), order.end());
+            }
+            const vector<unsigned int> &order = this->visibleCubes;
+
+            this->instances.clear();
+            for(unsigned int i : order){
                 this->model = mat4(1.0f);
                 this->model = translate(this->model, cubePositions[i]);
                 float angle = 20.0f * i;
                 this->model = rotate(this->model, radians(angle), vec3(1.0f, 0.3f, 0.5f));
                 if((i+1)%3==0){
-                   this->model = rotate(this->model, radians(scalar*300), vec3(1.0f, 0.3f, 0.5f)); 
+                   this->model = rotate(this->model, radians(this->cubeSpin[i]), vec3(1.0f, 0.3f, 0.5f)); 
                 }
-                (*ourShader).setMat4("model", this->model);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
+                const Material &material = this->materials[materialOf[i]];
+                this->instances.push_back({ this->model, ivec4(material.diffuse.layer, material.specular.layer, material.emission.layer, 0) });
+
+                // nearest point of the cube decides the mip, a unit cube has the texture stretched over 1 unit
+                float distance = std::max(length(cubePositions[i] - this->camera.Position) - this->cubeRadius, 0.1f);
+                float fovY = radians(this->camera.Zoom);
+                this->textureResidency.request(material.diffuse, this->textureResidency.estimateLevel(material.diffuse, 1.0f, distance, fovY, SCREEN_HEIGHT));
+                this->textureResidency.request(material.specular, this->textureResidency.estimateLevel(material.specular, 1.0f, distance, fovY, SCREEN_HEIGHT));
+            }
+            {
+                PROFILE_SCOPE("textureResidency.update");
+                this->textureResidency.update();
+            }
+            vector<size_t> sortedMaterials(order.size());
+            for(size_t i = 0; i < order.size(); i++){
+                sortedMaterials[i] = materialOf[order[i]];
             }
 
+            glBindVertexArray(this->VAO);
+            size_t instanceOffset = this->instanceRing.write(this->instances.data(), this->instances.size() * sizeof(InstanceData));
+            // culling and streaming above used the view from the start of the frame, the draws
+            // use the latched one
+            this->latchCamera();
+
+            // one draw per run of instances sharing arrays, however many materials are in it
+            this->gpuTimer.beginPass("cubes");
+            size_t first = 0;
+            while(first < this->instances.size()){
+                const Material &material = this->materials[sortedMaterials[first]];
+                size_t count = 1;
+                uint32_t distinctMaterials = 1;
+                while(first + count < this->instances.size() && sameArrays(this->materials[sortedMaterials[first + count]], material)){
+                    bool seen = false;
+                    for(size_t j = first; j < first + count && !seen; j++){
+                        seen = sameLayers(this->materials[sortedMaterials[j]], this->materials[sortedMaterials[first + count]]);
+                    }
+                    distinctMaterials += seen ? 0 : 1;
+                    count++;
+                }
+                bindTextures(material);
+                this->textureArrays.recordBatch(distinctMaterials, 3);
+                this->pointInstanceAttributes(instanceOffset + first * sizeof(InstanceData));
+                if(this->meshSubmeshes.empty()){
+                    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(count));
+                }
+                for(const MeshContainer::Submesh &submesh : this->meshSubmeshes){
+                    glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(submesh.indexCount), this->meshIndexType,
+                        reinterpret_cast<const void*>(static_cast<uintptr_t>(submesh.firstIndex * this->meshIndexSize)), static_cast<GLsizei>(count));
+                }
+                first += count;
+            }
+            this->gpuTimer.endPass();
 
             // glDrawArrays(GL_TRIANGLES, 0, 36);
             // glDrawElements(GL_TRIANGLES, sizeof(indices) / sizeof(float), GL_UNSIGNED_INT, 0);
@@ -486,22 +1476,206 @@ class OpenGLTest{
             (*ourLightShader).use();
 
             (*ourLightShader).setVec3("lightColor", lightColor);
-            (*ourLightShader).setMat4("projection", this->projection);
-            (*ourLightShader).setMat4("view", this->view);
             this->model = mat4(1.0f);
             this->model = translate(this->model, vec3(lightPos));
             // this->model = scale(this->model, vec3(0.2f));
             (*ourLightShader).setMat4("model", this->model);
             
             glBindVertexArray(this->lightVAO);
+            this->gpuTimer.beginPass("light");
             glDrawArrays(GL_TRIANGLES, 0, 36);
+            this->gpuTimer.endPass();
             // glDrawElements(GL_TRIANGLES, sizeof(indices) / sizeof(float), GL_UNSIGNED_INT, 0);
             glBindVertexArray(0);
         }
 };
 
-int main(){
-    OpenGLTest app;
+// true and the count when argv[index] exists and is a number
+static bool numberArg(int argc, char** argv, int index, uint64_t &value){
+    if(index >= argc || !isdigit(static_cast<unsigned char>(argv[index][0]))){
+        return false;
+    }
+    value = std::max(1, atoi(argv[index]));
+    return true;
+}
+
+// the bench's camera paths: the procedural ones are laid out around this scene's cubes and
+// take frames poses (one lap per measured run), anything else is a recorded .cpath file
+static bool loadBenchPath(const string &name, uint64_t frames, CameraPath &path, string &error){
+    if(name == "orbit"){
+        // around the cubes, bobbing up and down twice
+        path = CameraPath::orbit(vec3(0.0f, 0.0f, -6.0f), 9.0f, 2.0f, frames);
+    }
+    else if(name == "flythrough"){
+        // in between the cubes, out to the far ones and back
+        path = CameraPath::flyThrough({ vec3(0.0f, 0.5f, 4.0f), vec3(3.5f, 1.0f, -4.0f), vec3(4.0f, 3.5f, -13.0f),
+            vec3(-1.0f, 1.0f, -17.0f), vec3(-5.5f, -1.0f, -9.0f), vec3(-3.0f, 0.5f, -1.0f) }, frames);
+    }
+    else if(name == "strafe"){
+        // side to side in front of the cubes, looking down the row
+        path = CameraPath::strafe(vec3(0.0f, 0.0f, 4.0f), 4.0f, -90.0f, 0.0f, frames);
+    }
+    else{
+        return path.load(name, error);
+    }
+    return true;
+}
+
+// --trace <file.json> [frames]   captures a Chrome trace of the first frames (default 120)
+// --bench [frames]               headless run along a fixed camera path (default 600 frames)
+// --bench-out <file.json>        where the bench report goes (default bench_report.json)
+// --bench-path <path>            the bench camera: orbit (default), flythrough, strafe or a
+//                                recorded .cpath file, played back one pose per frame
+// --mesh <file>                  draws the cubes with a mesh cooked by Mesh_Cooker (.gmesh), or
+//                                imports an .obj, .gltf or .glb at startup
+// --record-path <file.cpath>     records the camera of every frame drawn, for --bench-path
+// --gl-stats                     count GL calls per frame (always on with --bench)
+// --sim-hz <rate>                fixed simulation rate for camera movement and animation (default 60)
+// --frames-in-flight <n>         frames the window thread may queue ahead of the render thread,
+//                                0 renders on the window thread (default 1)
+// --gpu-frames-in-flight <n>     frames the CPU may submit before waiting on the GPU's fence (default 2)
+// --no-late-latch                draw the camera orientation of the frame's simulation snapshot
+//                                instead of latching newer mouse input right before the draws
+// --input-bench [frames]         headless scripted mouse input, event to present latency with
+//                                late latching off and on (default 600 frames each)
+// --no-reverse-z                 standard depth (24 bit, -1..1, far plane at 100) instead of
+//                                reverse-Z with a float depth buffer and no far plane
+// --pacing <mode>                uncapped, vsync, adaptive or low-latency (default vsync, uncapped headless)
+// --fps <rate>                   low latency limiter rate (default the monitor's refresh rate)
+// --capture <file.glcs> [frames] records the GL commands of the first frames (default 60) for GL_Replay
+int main(int argc, char** argv){
+    bool bench = false;
+    uint64_t benchFrames = 600;
+    string benchOut = projectPath + "/bench_report.json";
+    string benchPath = "orbit";
+    string recordPath;
+    string meshPath;
+    bool glStats = false;
+    string goldenScenes;
+    bool updateGolden = false;
+    string tracePath;
+    uint64_t traceFrames = 120;
+    string glCapturePath;
+    uint64_t glCaptureFrames = 60;
+    uint64_t simHz = 60;
+    uint64_t framesInFlight = 1;
+    uint64_t gpuFramesInFlight = 2;
+    string pacing;
+    uint64_t fps = 0;
+    bool lateLatch = true;
+    bool reverseZ = true;
+    bool inputBench = false;
+    uint64_t inputBenchFrames = 600;
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if(arg == "--trace" && i + 1 < argc){
+            tracePath = argv[++i];
+            i += numberArg(argc, argv, i + 1, traceFrames) ? 1 : 0;
+        }
+        else if(arg == "--capture" && i + 1 < argc){
+            glCapturePath = argv[++i];
+            i += numberArg(argc, argv, i + 1, glCaptureFrames) ? 1 : 0;
+        }
+        else if(arg == "--bench"){
+            bench = true;
+            i += numberArg(argc, argv, i + 1, benchFrames) ? 1 : 0;
+        }
+        else if(arg == "--bench-out" && i + 1 < argc){
+            benchOut = argv[++i];
+        }
+        else if(arg == "--bench-path" && i + 1 < argc){
+            benchPath = argv[++i];
+        }
+        else if(arg == "--mesh" && i + 1 < argc){
+            meshPath = argv[++i];
+        }
+        else if(arg == "--record-path" && i + 1 < argc){
+            recordPath = argv[++i];
+        }
+        else if(arg == "--sim-hz"){
+            i += numberArg(argc, argv, i + 1, simHz) ? 1 : 0;
+        }
+        else if(arg == "--frames-in-flight" && i + 1 < argc){
+            framesInFlight = strtoull(argv[++i], NULL, 10);
+        }
+        else if(arg == "--gpu-frames-in-flight"){
+            i += numberArg(argc, argv, i + 1, gpuFramesInFlight) ? 1 : 0;
+        }
+        else if(arg == "--pacing" && i + 1 < argc){
+            pacing = argv[++i];
+        }
+        else if(arg == "--fps"){
+            i += numberArg(argc, argv, i + 1, fps) ? 1 : 0;
+        }
+        else if(arg == "--no-reverse-z"){
+            reverseZ = false;
+        }
+        else if(arg == "--no-late-latch"){
+            lateLatch = false;
+        }
+        else if(arg == "--input-bench"){
+            inputBench = true;
+            i += numberArg(argc, argv, i + 1, inputBenchFrames) ? 1 : 0;
+        }
+        else if(arg == "--gl-stats"){
+            glStats = true;
+        }
+        else if(arg == "--golden" && i + 1 < argc){
+            goldenScenes = argv[++i];
+        }
+        else if(arg == "--update-golden"){
+            updateGolden = true;
+        }
+    }
+
+    if(!glCapturePath.empty()){
+        GLCapture::begin(glCapturePath, glCaptureFrames);
+    }
+    bool headless = bench || inputBench || !goldenScenes.empty();
+    // golden images are rendered from the source textures, textures/cooked/ isn't checked in
+    OpenGLTest app(headless, glStats, reverseZ, goldenScenes.empty());
+    app.setGpuFramesInFlight(static_cast<uint32_t>(gpuFramesInFlight));
+    app.setLateLatch(lateLatch);
+    if(!meshPath.empty() && !app.loadMesh(meshPath)){
+        app.stop();
+        return -1;
+    }
+    FramePacer::Mode pacingMode = headless ? FramePacer::UNCAPPED : FramePacer::VSYNC;
+    if(!pacing.empty() && !FramePacer::parseMode(pacing.c_str(), pacingMode)){
+        cout << "unknown pacing mode " << pacing << ", using " << FramePacer::modeName(pacingMode) << endl;
+    }
+    app.setPacing(pacingMode, static_cast<double>(fps));
+    Profiler::setThreadName("main");
+    if(!tracePath.empty()){
+        app.captureTrace(tracePath, traceFrames);
+    }
+    if(!recordPath.empty()){
+        app.recordCameraPath(recordPath);
+    }
+    if(bench){
+        CameraPath path;
+        string error;
+        if(!loadBenchPath(benchPath, benchFrames, path, error)){
+            cout << error << endl;
+            app.stop();
+            return -1;
+        }
+        int result = app.runBench(benchFrames, 60, path, benchPath, benchOut);
+        app.stop();
+        return result;
+    }
+    if(inputBench){
+        int result = app.runInputBench(inputBenchFrames, 60, static_cast<double>(simHz));
+        app.stop();
+        return result;
+    }
+    if(!goldenScenes.empty()){
+        int result = app.runGolden(goldenScenes, updateGolden);
+        app.stop();
+        return result;
+    }
+    app.startSimulation(static_cast<double>(simHz));
+    app.startRenderThread(static_cast<uint32_t>(framesInFlight));
     while(!glfwWindowShouldClose(app.window)){
         if(app.update() == -1) return -1;
     }
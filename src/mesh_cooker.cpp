@@ -0,0 +1,359 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <FileIO/mapped_file.h>
+#include <Meshes/mesh_container.h>
+#include <Meshes/mesh_import.h>
+#include <Meshes/mesh_lod.h>
+
+#if defined(_WIN32)
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+// Offline cooker for the meshes/ folder. Imports OBJ or glTF once (Meshes/mesh_import.h),
+// builds coarser LODs (Meshes/mesh_lod.h) and writes a .gmesh container the app can mmap and
+// upload directly (OpenGL_Test --mesh meshes/cooked/cube.gmesh).
+
+string projectPath = filesystem::current_path().parent_path().string();
+string meshesPath = projectPath + "/meshes/";
+string cookedPath = meshesPath + "cooked/";
+string generatedPath = meshesPath + "generated/";
+
+struct CookOptions {
+    uint32_t lods = 4;        // the original included
+};
+
+int cook(const string &input, const string &output, const CookOptions &options){
+    MeshContainer::Mesh mesh;
+    vector<string> materials;
+    string error;
+    if(!MeshImport::load(input, mesh, materials, error)){
+        cout << "Failed to import " << error << endl;
+        return -1;
+    }
+    size_t triangles = mesh.indices.size() / 3;
+    MeshLod::generate(mesh, options.lods);
+    if(!MeshContainer::write(output, mesh)){
+        cout << "Failed to write " << output << endl;
+        return -1;
+    }
+    cout << input << " -> " << output << " (" << mesh.vertexCount << " vertices, " << triangles << " triangles, "
+         << mesh.lods[0].submeshCount << " materials, " << mesh.lods.size() << " LODs";
+    for(size_t i = 1; i < mesh.lods.size(); i++){
+        uint32_t indices = 0;
+        for(uint32_t s = mesh.lods[i].firstSubmesh; s < mesh.lods[i].firstSubmesh + mesh.lods[i].submeshCount; s++){
+            indices += mesh.submeshes[s].indexCount;
+        }
+        cout << (i == 1 ? ": " : ", ") << indices / 3 << " triangles at error " << mesh.lods[i].error;
+    }
+    cout << ", " << filesystem::file_size(output) / 1024 << " KB)" << endl;
+    return 0;
+}
+
+int cookAll(const CookOptions &options){
+    filesystem::create_directories(cookedPath);
+    int result = 0;
+    for(const filesystem::directory_entry &entry : filesystem::directory_iterator(meshesPath)){
+        if(entry.is_regular_file() && MeshImport::supported(entry.path().string())){
+            result = cook(entry.path().string(), cookedPath + entry.path().stem().string() + ".gmesh", options) != 0 ? -1 : result;
+        }
+    }
+    return result;
+}
+
+// A wavy 200 unit grid of about the given number of triangles, written as
+// meshes/generated/large.obj and large.glb for the importer benchmark: every vertex with a
+// texture coordinate and a normal, quads in the OBJ (two triangles each), and the two halves
+// of the grid in two materials. The size gives numbers of mixed width and sign, like exported
+// scenes. Nothing in meshes/generated/ is checked in.
+int generate(uint64_t triangles){
+    uint32_t side = static_cast<uint32_t>(max(2.0, sqrt(static_cast<double>(triangles) / 2.0)));
+    uint64_t vertexCount = static_cast<uint64_t>(side + 1) * (side + 1);
+    if(vertexCount > 0xFFFFFFFFull){
+        cout << "Too many triangles" << endl;
+        return -1;
+    }
+    filesystem::create_directories(generatedPath);
+    vector<float> positions, normals, texcoords;
+    positions.reserve(vertexCount * 3);
+    normals.reserve(vertexCount * 3);
+    texcoords.reserve(vertexCount * 2);
+    for(uint32_t z = 0; z <= side; z++){
+        for(uint32_t x = 0; x <= side; x++){
+            float u = static_cast<float>(x) / side, v = static_cast<float>(z) / side;
+            float height = 5.0f * sin(u * 40.0f) * cos(v * 30.0f);
+            float dx = 5.0f * 40.0f / 200.0f * cos(u * 40.0f) * cos(v * 30.0f);
+            float dz = -5.0f * 30.0f / 200.0f * sin(u * 40.0f) * sin(v * 30.0f);
+            float length = sqrt(dx * dx + 1.0f + dz * dz);
+            positions.insert(positions.end(), { u * 200.0f - 100.0f, height, v * 200.0f - 100.0f });
+            normals.insert(normals.end(), { -dx / length, 1.0f / length, -dz / length });
+            texcoords.insert(texcoords.end(), { u, v });
+        }
+    }
+    vector<uint32_t> indices;
+    indices.reserve(static_cast<size_t>(side) * side * 6);
+    for(uint32_t z = 0; z < side; z++){
+        for(uint32_t x = 0; x < side; x++){
+            uint32_t a = z * (side + 1) + x, b = a + 1, c = a + side + 1, d = c + 1;
+            indices.insert(indices.end(), { a, c, d, a, d, b });
+        }
+    }
+    size_t half = static_cast<size_t>(side / 2) * side * 6;
+
+    string objPath = generatedPath + "large.obj";
+    FILE* obj = fopen(objPath.c_str(), "wb");
+    if(obj == NULL){
+        cout << "Failed to write " << objPath << endl;
+        return -1;
+    }
+    fprintf(obj, "# %u x %u grid from Mesh_Cooker --generate\n", side, side);
+    for(uint64_t i = 0; i < vertexCount; i++){
+        fprintf(obj, "v %.6f %.6f %.6f\n", positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+    }
+    for(uint64_t i = 0; i < vertexCount; i++){
+        fprintf(obj, "vt %.6f %.6f\n", texcoords[i * 2], texcoords[i * 2 + 1]);
+    }
+    for(uint64_t i = 0; i < vertexCount; i++){
+        fprintf(obj, "vn %.6f %.6f %.6f\n", normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+    }
+    for(size_t i = 0; i < indices.size(); i += 6){
+        if(i == 0 || i == half){
+            fprintf(obj, "usemtl %s\n", i == 0 ? "near" : "far");
+        }
+        uint32_t a = indices[i] + 1, c = indices[i + 1] + 1, d = indices[i + 2] + 1, b = indices[i + 5] + 1;
+        fprintf(obj, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, c, c, c, d, d, d, b, b, b);
+    }
+    fclose(obj);
+
+    // one buffer: positions, normals, texcoords, then the indices of both primitives
+    size_t positionBytes = positions.size() * sizeof(float), normalBytes = normals.size() * sizeof(float);
+    size_t texcoordBytes = texcoords.size() * sizeof(float), indexBytes = indices.size() * sizeof(uint32_t);
+    size_t binaryBytes = positionBytes + normalBytes + texcoordBytes + indexBytes;
+    string views = "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" + to_string(positionBytes) + "},"
+                   "{\"buffer\":0,\"byteOffset\":" + to_string(positionBytes) + ",\"byteLength\":" + to_string(normalBytes) + "},"
+                   "{\"buffer\":0,\"byteOffset\":" + to_string(positionBytes + normalBytes) + ",\"byteLength\":" + to_string(texcoordBytes) + "},"
+                   "{\"buffer\":0,\"byteOffset\":" + to_string(positionBytes + normalBytes + texcoordBytes) + ",\"byteLength\":" + to_string(indexBytes) + "}";
+    string accessors = "{\"bufferView\":0,\"componentType\":5126,\"count\":" + to_string(vertexCount) + ",\"type\":\"VEC3\","
+                       "\"min\":[-100,-5,-100],\"max\":[100,5,100]},"
+                       "{\"bufferView\":1,\"componentType\":5126,\"count\":" + to_string(vertexCount) + ",\"type\":\"VEC3\"},"
+                       "{\"bufferView\":2,\"componentType\":5126,\"count\":" + to_string(vertexCount) + ",\"type\":\"VEC2\"},"
+                       "{\"bufferView\":3,\"componentType\":5125,\"count\":" + to_string(half) + ",\"type\":\"SCALAR\"},"
+                       "{\"bufferView\":3,\"byteOffset\":" + to_string(half * sizeof(uint32_t)) + ",\"componentType\":5125,\"count\":" + to_string(indices.size() - half) + ",\"type\":\"SCALAR\"}";
+    string attributes = "\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2}";
+    string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"Mesh_Cooker --generate\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+                  "\"meshes\":[{\"primitives\":[{" + attributes + ",\"indices\":3,\"material\":0},{" + attributes + ",\"indices\":4,\"material\":1}]}],"
+                  "\"materials\":[{\"name\":\"near\"},{\"name\":\"far\"}],"
+                  "\"buffers\":[{\"byteLength\":" + to_string(binaryBytes) + "}],\"bufferViews\":[" + views + "],\"accessors\":[" + accessors + "]}";
+    json.resize(MeshContainer::alignUp(json.size(), 4), ' ');
+    uint32_t binaryChunk = static_cast<uint32_t>(MeshContainer::alignUp(binaryBytes, 4));
+    uint32_t header[3] = { GltfImport::GLB_MAGIC, 2, static_cast<uint32_t>(12 + 8 + json.size() + 8 + binaryChunk) };
+    uint32_t jsonHeader[2] = { static_cast<uint32_t>(json.size()), GltfImport::GLB_CHUNK_JSON };
+    uint32_t binaryHeader[2] = { binaryChunk, GltfImport::GLB_CHUNK_BIN };
+    string glbPath = generatedPath + "large.glb";
+    ofstream glb(glbPath, ios::binary);
+    glb.write(reinterpret_cast<const char*>(header), sizeof(header));
+    glb.write(reinterpret_cast<const char*>(jsonHeader), sizeof(jsonHeader));
+    glb.write(json.data(), static_cast<streamsize>(json.size()));
+    glb.write(reinterpret_cast<const char*>(binaryHeader), sizeof(binaryHeader));
+    glb.write(reinterpret_cast<const char*>(positions.data()), static_cast<streamsize>(positionBytes));
+    glb.write(reinterpret_cast<const char*>(normals.data()), static_cast<streamsize>(normalBytes));
+    glb.write(reinterpret_cast<const char*>(texcoords.data()), static_cast<streamsize>(texcoordBytes));
+    glb.write(reinterpret_cast<const char*>(indices.data()), static_cast<streamsize>(indexBytes));
+    glb.write("\0\0\0", static_cast<streamsize>(binaryChunk - binaryBytes));
+    if(!glb){
+        cout << "Failed to write " << glbPath << endl;
+        return -1;
+    }
+    glb.close();
+    cout << "generated " << indices.size() / 3 << " triangles, " << vertexCount << " vertices: " << objPath << " ("
+         << filesystem::file_size(objPath) / (1024 * 1024) << " MB), " << glbPath << " (" << filesystem::file_size(glbPath) / (1024 * 1024) << " MB)" << endl;
+    return 0;
+}
+
+long peakResidentKb(){
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+    #else
+    return usage.ru_maxrss;
+    #endif
+#endif
+}
+
+// Loads the named meshes through one path and reports wall time and peak RSS, like
+// Texture_Cooker --bench. Run once per mode: peak RSS is per process.
+int bench(const string &mode, const vector<string> &names, int iterations){
+    uint64_t checksum = 0;
+    size_t bytes = 0;
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < iterations; i++){
+        for(const string &name : names){
+            string stem = filesystem::path(name).stem().string();
+            if(mode == "obj"){
+                MeshContainer::Mesh mesh;
+                vector<string> materials;
+                string error;
+                if(!MeshImport::load(meshesPath + stem + ".obj", mesh, materials, error)){
+                    cout << "Failed to import " << error << endl;
+                    return -1;
+                }
+                checksum += mesh.streams[0].bytes.back() + mesh.indices.back();
+                bytes += mesh.streams[0].bytes.size() + mesh.indices.size() * sizeof(uint32_t);
+            }
+            else{
+                MeshFile file;
+                if(!file.open(cookedPath + stem + ".gmesh")){
+                    cout << "Failed to open cooked " << stem << ", run --all first" << endl;
+                    return -1;
+                }
+                // touch every page of vertex and index data like an upload would
+                for(size_t b = 0; b < file.vertexDataSize(); b += 64){
+                    checksum += file.vertexData()[b];
+                }
+                for(size_t b = 0; b < file.indexDataSize(); b += 64){
+                    checksum += file.indexData()[b];
+                }
+                bytes += file.vertexDataSize() + file.indexDataSize();
+            }
+        }
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "mode=" << mode << " loads=" << names.size() * iterations
+         << " total_ms=" << ms << " ms_per_load=" << ms / (names.size() * iterations)
+         << " MB=" << bytes / (1024.0 * 1024.0) << " peak_rss_kb=" << peakResidentKb()
+         << " checksum=" << checksum << endl;
+    return 0;
+}
+
+// Imports one OBJ or glTF file through MeshImport and reports parsing throughput against the
+// source size, and peak RSS (mapping and result included) against it. Run serial and parallel
+// in separate processes: peak RSS is per process.
+int benchImport(const string &mode, const string &path, int iterations){
+    MeshImport::Options options;
+    options.parallel = mode == "parallel";
+    long baselineKb = peakResidentKb();
+    uint64_t checksum = 0;
+    uint32_t vertices = 0;
+    size_t triangles = 0, submeshes = 0;
+    double bestMs = 0.0, totalMs = 0.0;
+    for(int i = 0; i < iterations; i++){
+        MeshContainer::Mesh mesh;
+        vector<string> materials;
+        string error;
+        auto start = chrono::steady_clock::now();
+        if(!MeshImport::load(path, mesh, materials, error, options)){
+            cout << "Failed to import " << error << endl;
+            return -1;
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        bestMs = i == 0 ? ms : min(bestMs, ms);
+        totalMs += ms;
+        vertices = mesh.vertexCount;
+        triangles = mesh.indices.size() / 3;
+        submeshes = mesh.submeshes.size();
+        checksum += mesh.streams[0].bytes[mesh.streams[0].bytes.size() / 2] + mesh.indices[mesh.indices.size() / 2];
+    }
+    double sourceMb = filesystem::file_size(path) / (1024.0 * 1024.0);
+    long peakKb = peakResidentKb();
+    cout << "mode=" << mode << " threads=" << (options.parallel ? JobSystem::instance().workerCount() + 1 : 1)
+         << " file=" << filesystem::path(path).filename().string() << " source_MB=" << sourceMb << " loads=" << iterations
+         << " best_ms=" << bestMs << " ms_per_load=" << totalMs / iterations << " MB_per_s=" << sourceMb / (bestMs / 1000.0)
+         << " vertices=" << vertices << " triangles=" << triangles << " submeshes=" << submeshes
+         << " peak_rss_kb=" << peakKb << " baseline_rss_kb=" << baselineKb << " peak_over_source=" << (peakKb - baselineKb) / (sourceMb * 1024.0)
+         << " checksum=" << checksum << endl;
+    return 0;
+}
+
+void printUsage(){
+    cout << "usage:" << endl;
+    cout << "  Mesh_Cooker [options] --all               cook meshes/*.obj, *.gltf and *.glb into meshes/cooked/" << endl;
+    cout << "  Mesh_Cooker [options] <input> <output>    cook a single OBJ or glTF file" << endl;
+    cout << "  Mesh_Cooker --bench <obj|cooked> [-n N] <name>..." << endl;
+    cout << "  Mesh_Cooker --generate <triangles>        write meshes/generated/large.obj and large.glb" << endl;
+    cout << "  Mesh_Cooker --bench-import <serial|parallel> [-n N] <file>" << endl;
+    cout << "options:" << endl;
+    cout << "  --lods <n>                                LODs to write, the original included (default 4, 1 keeps only it)" << endl;
+}
+
+int main(int argc, char** argv){
+    vector<string> args(argv + 1, argv + argc);
+    if(args.empty()){
+        printUsage();
+        return -1;
+    }
+    if(args[0] == "--bench" && args.size() >= 3){
+        string mode = args[1];
+        int iterations = 20;
+        size_t first = 2;
+        if(args.size() >= 5 && args[2] == "-n"){
+            iterations = max(1, atoi(args[3].c_str()));
+            first = 4;
+        }
+        if(mode != "obj" && mode != "cooked"){
+            printUsage();
+            return -1;
+        }
+        return bench(mode, vector<string>(args.begin() + first, args.end()), iterations);
+    }
+    if(args[0] == "--generate" && args.size() == 2){
+        return generate(strtoull(args[1].c_str(), NULL, 10));
+    }
+    if(args[0] == "--bench-import" && args.size() >= 3){
+        string mode = args[1];
+        int iterations = 5;
+        string path;
+        for(size_t i = 2; i < args.size(); i++){
+            if(args[i] == "-n" && i + 1 < args.size()){
+                iterations = max(1, atoi(args[++i].c_str()));
+            }
+            else{
+                path = args[i];
+            }
+        }
+        if((mode != "serial" && mode != "parallel") || path.empty()){
+            printUsage();
+            return -1;
+        }
+        return benchImport(mode, path, iterations);
+    }
+
+    CookOptions options;
+    bool all = false;
+    vector<string> paths;
+    for(size_t i = 0; i < args.size(); i++){
+        if(args[i] == "--all"){
+            all = true;
+        }
+        else if(args[i] == "--lods" && i + 1 < args.size()){
+            options.lods = static_cast<uint32_t>(max(1, atoi(args[++i].c_str())));
+        }
+        else{
+            paths.push_back(args[i]);
+        }
+    }
+    if(all){
+        return cookAll(options);
+    }
+    if(paths.size() != 2){
+        printUsage();
+        return -1;
+    }
+    return cook(paths[0], paths[1], options);
+}
@@ -2,9 +2,9 @@
 out vec4 FragColor;
 
 struct Material{
-    sampler2D diffuse;
-    sampler2D specular;
-    sampler2D emission;
+    sampler2DArray diffuse;
+    sampler2DArray specular;
+    sampler2DArray emission;
     float shininess;
 };
 
@@ -26,6 +26,7 @@ struct Light{
 in vec3 normal;
 in vec2 textCoord;
 in vec3 FragPos;
+flat in ivec4 layers;
 
 uniform Material material;
 uniform Light light;
@@ -39,7 +40,7 @@ void main()
 
 
     // Ambient
-    vec3 ambient = light.ambient * texture(material.diffuse, textCoord).rgb;
+    vec3 ambient = light.ambient * texture(material.diffuse, vec3(textCoord, layers.x)).rgb;
 
     // Attenuation
     float distance = length(light.position - FragPos);
@@ -52,13 +53,13 @@ void main()
         // Diffuse
         vec3 norm = normalize(normal);
         float diff = max(dot(norm, lightDir), 0.0);
-        vec3 diffuse = diff * light.diffuse * texture(material.diffuse, textCoord).rgb;
+        vec3 diffuse = diff * light.diffuse * texture(material.diffuse, vec3(textCoord, layers.x)).rgb;
 
         // Specular
         vec3 viewDir = normalize(-FragPos);
         vec3 reflectDir = reflect(-lightDir, norm);
         float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-        vec3 specular = spec * light.specular * texture(material.specular, textCoord).rgb;
+        vec3 specular = spec * light.specular * texture(material.specular, vec3(textCoord, layers.y)).rgb;
 
         // ambient *= attenuation;
         diffuse *= attenuation;
@@ -2,19 +2,25 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTextCoord;
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in ivec4 aLayers;
 
 out vec3 normal;
 out vec2 textCoord;
 out vec3 FragPos;
+flat out ivec4 layers;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+};
 
 void main()
 {
-	normal = mat3(transpose(inverse(view * model))) * aNormal;
+	normal = mat3(transpose(inverse(view * aModel))) * aNormal;
 	textCoord = aTextCoord;
-	FragPos = vec3(view * model * vec4(aPos, 1.0));
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	layers = aLayers;
+	FragPos = vec3(view * aModel * vec4(aPos, 1.0));
+	gl_Position = projection * view * aModel * vec4(aPos, 1.0);
 }
\ No newline at end of file
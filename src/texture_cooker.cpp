@@ -0,0 +1,468 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <FileIO/mapped_file.h>
+#include <Textures/image_decoder.h>
+#include <Textures/texture_container.h>
+#include <Textures/bc_encoder.h>
+#include <Textures/mip_generator.h>
+#include <Threading/job_system.h>
+
+#if defined(_WIN32)
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+// Offline cooker for the textures/ folder. Decodes PNG/JPEG once, builds the full mip
+// chain on the CPU (Textures/mip_generator.h), optionally block compresses it and writes a .gtex container the app
+// can mmap and upload directly.
+
+string projectPath = filesystem::current_path().parent_path().string();
+string texturesPath = projectPath + "/textures/";
+string cookedPath = texturesPath + "cooked/";
+
+// drops RGBA8 texels down to the first channels components
+vector<uint8_t> packChannels(const vector<uint8_t> &rgba, int channels){
+    if(channels == 4){
+        return rgba;
+    }
+    vector<uint8_t> packed(rgba.size() / 4 * channels);
+    for(size_t i = 0; i < rgba.size() / 4; i++){
+        for(int c = 0; c < channels; c++){
+            packed[i * channels + c] = rgba[i * 4 + c];
+        }
+    }
+    return packed;
+}
+
+enum TextureRole {
+    ROLE_DIFFUSE,
+    ROLE_SPECULAR,
+    ROLE_NORMAL,
+    ROLE_HIGH_QUALITY
+};
+
+struct CookOptions {
+    bool srgb = false;
+    bool compress = true;
+    bool hasFormat = false;   // format overrides the role based choice
+    BC::Format format = BC::BC1;
+    bool hasRole = false;     // otherwise --all guesses the role from the file name
+    TextureRole role = ROLE_DIFFUSE;
+    Mips::Filter filter = Mips::FILTER_BOX;
+    bool cutout = false;      // keep alpha test coverage through the mip chain
+};
+
+TextureRole roleFromName(const string &stem){
+    if(stem.find("normal") != string::npos) return ROLE_NORMAL;
+    if(stem.find("specular") != string::npos) return ROLE_SPECULAR;
+    return ROLE_DIFFUSE;
+}
+
+bool isOpaque(const TextureContainer::Level &level){
+    for(size_t i = 3; i < level.bytes.size(); i += 4){
+        if(level.bytes[i] != 255) return false;
+    }
+    return true;
+}
+
+bool isGreyscale(const TextureContainer::Level &level){
+    for(size_t i = 0; i < level.bytes.size(); i += 4){
+        if(level.bytes[i] != level.bytes[i + 1] || level.bytes[i] != level.bytes[i + 2]) return false;
+    }
+    return true;
+}
+
+BC::Format formatForRole(TextureRole role, const TextureContainer::Level &level){
+    switch(role){
+        case ROLE_SPECULAR: return isGreyscale(level) ? BC::BC4 : BC::BC1;
+        case ROLE_NORMAL: return BC::BC5;
+        case ROLE_HIGH_QUALITY: return BC::BC7;
+        default: return isOpaque(level) ? BC::BC1 : BC::BC3;
+    }
+}
+
+int cook(const string &input, const string &output, const CookOptions &options, ostream &log = cout){
+    // mips and block compression always work from RGBA, raw output is packed back down
+    ImageDecode::Image image;
+    if(!ImageDecode::decodeFile(input, image, 4)){
+        log << "Failed to load " << input << " because " << ImageDecode::failureReason() << endl;
+        return -1;
+    }
+    int width = image.width, height = image.height, channels = image.sourceChannels;
+    if(options.compress){
+        channels = 4;
+    }
+
+    Mips::Options mipOptions;
+    mipOptions.filter = options.filter;
+    mipOptions.srgb = options.srgb;
+    mipOptions.preserveAlphaCoverage = options.cutout;
+    vector<TextureContainer::Level> levels = Mips::generate(image.pixels.data(), width, height, mipOptions);
+    uint32_t count = static_cast<uint32_t>(levels.size());
+    for(TextureContainer::Level &level : levels){
+        level.bytes = packChannels(level.bytes, channels);
+    }
+
+    TextureContainer::Desc desc = TextureContainer::descForChannels(channels, options.srgb);
+    size_t rawBytes = 0;
+    for(const TextureContainer::Level &level : levels){
+        rawBytes += level.bytes.size();
+    }
+
+    if(!options.compress){
+        if(!TextureContainer::write(output, desc, levels)){
+            log << "Failed to write " << output << endl;
+            return -1;
+        }
+        log << input << " -> " << output << " (" << width << "x" << height << ", " << channels << " channels, " << count << " levels)" << endl;
+        return 0;
+    }
+
+    BC::Format format = options.hasFormat ? options.format : formatForRole(options.role, levels[0]);
+    vector<uint8_t> original = levels[0].bytes;
+    size_t compressedBytes = 0;
+    for(TextureContainer::Level &level : levels){
+        level.bytes = BC::encodeImage(level.bytes.data(), level.width, level.height, format);
+        compressedBytes += level.bytes.size();
+    }
+
+    // quality of the top level, decoded the way the sampler will see it
+    vector<uint8_t> decoded = BC::decodeImage(levels[0].bytes.data(), width, height, format);
+    double psnr = BC::psnr(original.data(), decoded.data(), width, height, BC::channelMask(format));
+
+    desc.glInternalFormat = BC::glInternalFormat(format, options.srgb && format != BC::BC4 && format != BC::BC5);
+    desc.glFormat = 0;
+    desc.glType = 0;
+    desc.flags |= TextureContainer::FLAG_COMPRESSED;
+    if(format == BC::BC4){
+        desc.flags |= TextureContainer::FLAG_SWIZZLE_RRR1;
+    }
+    if(!TextureContainer::write(output, desc, levels)){
+        log << "Failed to write " << output << endl;
+        return -1;
+    }
+    log << input << " -> " << output << " (" << width << "x" << height << ", " << BC::name(format) << ", " << count << " levels)"
+         << " rgba8 " << rawBytes / 1024 << " KB -> " << compressedBytes / 1024 << " KB"
+         << " (" << static_cast<double>(rawBytes) / compressedBytes << "x smaller), PSNR " << psnr << " dB" << endl;
+    return 0;
+}
+
+// every image is a job on the shared job system; their own mips and blocks are parallel for
+// loops, which run in between on the same workers
+int cookAll(CookOptions options){
+    filesystem::create_directories(cookedPath);
+    vector<filesystem::path> inputs;
+    for(const filesystem::directory_entry &entry : filesystem::directory_iterator(texturesPath)){
+        string extension = entry.path().extension().string();
+        if(entry.is_regular_file() && (extension == ".png" || extension == ".jpg" || extension == ".jpeg")){
+            inputs.push_back(entry.path());
+        }
+    }
+    vector<int> results(inputs.size());
+    vector<ostringstream> logs(inputs.size());
+    JobSystem &jobs = JobSystem::instance();
+    JobCounter done;
+    for(size_t i = 0; i < inputs.size(); i++){
+        jobs.run([&, i](){
+            CookOptions fileOptions = options;
+            if(!fileOptions.hasRole){
+                fileOptions.role = roleFromName(inputs[i].stem().string());
+            }
+            results[i] = cook(inputs[i].string(), cookedPath + inputs[i].stem().string() + ".gtex", fileOptions, logs[i]);
+        }, &done);
+    }
+    jobs.wait(done);
+    int result = 0;
+    for(size_t i = 0; i < inputs.size(); i++){
+        cout << logs[i].str();
+        result = results[i] != 0 ? -1 : result;
+    }
+    return result;
+}
+
+long peakResidentKb(){
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+    #else
+    return usage.ru_maxrss;
+    #endif
+#endif
+}
+
+// Loads the named textures through one path and reports wall time and peak RSS.
+// Run once per mode: peak RSS is per process, so mixing modes in one run hides the difference.
+int bench(const string &mode, const vector<string> &names, int iterations){
+    uint64_t checksum = 0;
+    size_t bytes = 0;
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < iterations; i++){
+        for(const string &name : names){
+            string stem = filesystem::path(name).stem().string();
+            if(mode == "stb"){
+                int width, height, channels;
+                unsigned char* data = stbi_load((texturesPath + name).c_str(), &width, &height, &channels, 0);
+                if(!data){
+                    cout << "Failed to load " << name << " because " << stbi_failure_reason() << endl;
+                    return -1;
+                }
+                size_t size = static_cast<size_t>(width) * height * channels;
+                checksum += data[size - 1];
+                bytes += size;
+                stbi_image_free(data);
+            }
+            else{
+                TextureFile file;
+                if(!file.open(cookedPath + stem + ".gtex")){
+                    cout << "Failed to open cooked " << stem << ", run --all first" << endl;
+                    return -1;
+                }
+                // touch every level like an upload would
+                for(uint32_t level = 0; level < file.levelCount(); level++){
+                    const uint8_t* data = file.levelData(level);
+                    for(size_t b = 0; b < file.levelSize(level); b += 64){
+                        checksum += data[b];
+                    }
+                    bytes += file.levelSize(level);
+                }
+            }
+        }
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "mode=" << mode << " loads=" << names.size() * iterations
+         << " total_ms=" << ms << " ms_per_load=" << ms / (names.size() * iterations)
+         << " MB=" << bytes / (1024.0 * 1024.0) << " peak_rss_kb=" << peakResidentKb()
+         << " checksum=" << checksum << endl;
+    return 0;
+}
+
+// Times the CPU mip chain over every image in textures/, scalar vs the SIMD kernels
+int benchMips(Mips::Filter filter, int iterations){
+    for(const filesystem::directory_entry &entry : filesystem::directory_iterator(texturesPath)){
+        string extension = entry.path().extension().string();
+        if(!entry.is_regular_file() || (extension != ".png" && extension != ".jpg" && extension != ".jpeg")){
+            continue;
+        }
+        ImageDecode::Image image;
+        if(!ImageDecode::decodeFile(entry.path().string(), image, 4)){
+            continue;
+        }
+        const uint8_t* data = image.pixels.data();
+        int width = image.width, height = image.height;
+        double megapixels = width * height / 1.0e6;
+        for(int simd = 0; simd < 2; simd++){
+            Mips::Options options;
+            options.filter = filter;
+            options.srgb = true;
+            options.allowSimd = simd == 1;
+            auto start = chrono::steady_clock::now();
+            size_t levels = 0;
+            for(int i = 0; i < iterations; i++){
+                levels += Mips::generate(data, width, height, options).size();
+            }
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / iterations;
+            cout << entry.path().filename().string() << " filter=" << (filter == Mips::FILTER_BOX ? "box" : "kaiser")
+                 << " simd=" << (simd == 1 && Simd::hasAvx2() ? "avx2" : "off") << " levels=" << levels / iterations
+                 << " ms=" << ms << " MP/s=" << megapixels / (ms / 1000.0) << endl;
+        }
+    }
+    return 0;
+}
+
+// Times every image in textures/ through stb and through the fast decoders (scalar, SIMD,
+// SIMD with threads), checks the fast output against stb and sums MB/s of compressed input per format
+int benchDecode(int iterations){
+    struct Config {
+        const char* label;
+        const char* only;
+        bool simd;
+        bool parallel;
+    };
+    const Config configs[] = {
+        { "stb", "stb", true, false },
+        { "fast-scalar", NULL, false, false },
+        { "fast-simd", NULL, true, false },
+        { "fast-simd-mt", NULL, true, true }
+    };
+    const size_t CONFIGS = sizeof(configs) / sizeof(configs[0]);
+    struct Totals {
+        double megabytes[CONFIGS] = { 0 };
+        double seconds[CONFIGS] = { 0 };
+    };
+    Totals png, jpeg;
+    vector<string> paths;
+
+    for(const filesystem::directory_entry &entry : filesystem::directory_iterator(texturesPath)){
+        string extension = entry.path().extension().string();
+        if(!entry.is_regular_file() || (extension != ".png" && extension != ".jpg" && extension != ".jpeg")){
+            continue;
+        }
+        paths.push_back(entry.path().string());
+        MappedFile file;
+        if(!file.open(entry.path().string())){
+            continue;
+        }
+        double megabytes = file.size() / (1024.0 * 1024.0);
+        Totals &totals = extension == ".png" ? png : jpeg;
+
+        ImageDecode::Image reference;
+        ImageDecode::Options referenceOptions;
+        referenceOptions.desiredChannels = 4;
+        referenceOptions.only = "stb";
+        ImageDecode::decode(file.data(), file.size(), reference, referenceOptions);
+
+        for(size_t c = 0; c < CONFIGS; c++){
+            ImageDecode::Options options;
+            options.desiredChannels = 4;
+            options.only = configs[c].only;
+            options.allowSimd = configs[c].simd;
+            options.parallel = configs[c].parallel;
+            ImageDecode::Image image;
+            auto start = chrono::steady_clock::now();
+            for(int i = 0; i < iterations; i++){
+                ImageDecode::decode(file.data(), file.size(), image, options);
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / iterations;
+            totals.megabytes[c] += megabytes;
+            totals.seconds[c] += seconds;
+
+            int maxError = 0;
+            for(size_t i = 0; i < image.pixels.size() && i < reference.pixels.size(); i++){
+                maxError = max(maxError, abs(static_cast<int>(image.pixels[i]) - reference.pixels[i]));
+            }
+            cout << entry.path().filename().string() << " " << configs[c].label << " decoder=" << image.decoder
+                 << " ms=" << seconds * 1000.0 << " MB/s=" << megabytes / seconds
+                 << " MP/s=" << image.width * image.height / 1.0e6 / seconds << " max_error_vs_stb=" << maxError << endl;
+        }
+    }
+
+    for(int format = 0; format < 2; format++){
+        const Totals &totals = format == 0 ? png : jpeg;
+        for(size_t c = 0; c < CONFIGS; c++){
+            if(totals.seconds[c] > 0.0){
+                cout << (format == 0 ? "png" : "jpeg") << " " << configs[c].label << " MB/s=" << totals.megabytes[c] / totals.seconds[c] << endl;
+            }
+        }
+    }
+
+    // whole folder, one image per thread
+    ImageDecode::Options options;
+    options.desiredChannels = 4;
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < iterations; i++){
+        ImageDecode::decodeFiles(paths, options);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / iterations;
+    double megabytes = 0.0;
+    for(const string &path : paths){
+        megabytes += filesystem::file_size(path) / (1024.0 * 1024.0);
+    }
+    cout << "batch files=" << paths.size() << " threads=" << JobSystem::instance().workerCount() + 1
+         << " ms=" << seconds * 1000.0 << " MB/s=" << megabytes / seconds << endl;
+    return 0;
+}
+
+void printUsage(){
+    cout << "usage:" << endl;
+    cout << "  Texture_Cooker [options] --all               cook textures/ into textures/cooked/, role picked from the file name" << endl;
+    cout << "  Texture_Cooker [options] <input> <output>    cook a single image" << endl;
+    cout << "  Texture_Cooker --bench <stb|cooked> [-n N] <name>..." << endl;
+    cout << "  Texture_Cooker --bench-mips <box|kaiser> [-n N]" << endl;
+    cout << "  Texture_Cooker --bench-decode [-n N]" << endl;
+    cout << "options:" << endl;
+    cout << "  --srgb                                        colour data is sRGB encoded" << endl;
+    cout << "  --raw                                         keep uncompressed 8 bit texels" << endl;
+    cout << "  --role <diffuse|specular|normal|hq>           pick BC1/BC3, BC4/BC1, BC5 or BC7" << endl;
+    cout << "  --format <bc1|bc3|bc4|bc5|bc7>                force a block format" << endl;
+    cout << "  --filter <box|kaiser>                         mip filter, box by default" << endl;
+    cout << "  --cutout                                      preserve alpha test coverage in the mips" << endl;
+}
+
+int main(int argc, char** argv){
+    vector<string> args(argv + 1, argv + argc);
+    if(args.empty()){
+        printUsage();
+        return -1;
+    }
+    if(args[0] == "--bench" && args.size() >= 3){
+        string mode = args[1];
+        int iterations = 20;
+        size_t first = 2;
+        if(args.size() >= 5 && args[2] == "-n"){
+            iterations = max(1, atoi(args[3].c_str()));
+            first = 4;
+        }
+        if(mode != "stb" && mode != "cooked"){
+            printUsage();
+            return -1;
+        }
+        return bench(mode, vector<string>(args.begin() + first, args.end()), iterations);
+    }
+    if(args[0] == "--bench-decode"){
+        int iterations = args.size() >= 3 && args[1] == "-n" ? max(1, atoi(args[2].c_str())) : 20;
+        return benchDecode(iterations);
+    }
+    if(args[0] == "--bench-mips" && args.size() >= 2){
+        int iterations = args.size() >= 4 && args[2] == "-n" ? max(1, atoi(args[3].c_str())) : 10;
+        return benchMips(args[1] == "kaiser" ? Mips::FILTER_KAISER : Mips::FILTER_BOX, iterations);
+    }
+
+    CookOptions options;
+    bool all = false;
+    vector<string> paths;
+    for(size_t i = 0; i < args.size(); i++){
+        if(args[i] == "--all"){
+            all = true;
+        }
+        else if(args[i] == "--srgb"){
+            options.srgb = true;
+        }
+        else if(args[i] == "--filter" && i + 1 < args.size()){
+            options.filter = args[++i] == "kaiser" ? Mips::FILTER_KAISER : Mips::FILTER_BOX;
+        }
+        else if(args[i] == "--cutout"){
+            options.cutout = true;
+        }
+        else if(args[i] == "--raw"){
+            options.compress = false;
+        }
+        else if(args[i] == "--role" && i + 1 < args.size()){
+            string role = args[++i];
+            options.hasRole = true;
+            options.role = role == "specular" ? ROLE_SPECULAR : role == "normal" ? ROLE_NORMAL : role == "hq" ? ROLE_HIGH_QUALITY : ROLE_DIFFUSE;
+        }
+        else if(args[i] == "--format" && i + 1 < args.size()){
+            string format = args[++i];
+            options.hasFormat = true;
+            options.format = format == "bc3" ? BC::BC3 : format == "bc4" ? BC::BC4 : format == "bc5" ? BC::BC5 : format == "bc7" ? BC::BC7 : BC::BC1;
+        }
+        else{
+            paths.push_back(args[i]);
+        }
+    }
+    if(all){
+        return cookAll(options);
+    }
+    if(paths.size() != 2){
+        printUsage();
+        return -1;
+    }
+    return cook(paths[0], paths[1], options);
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <FileIO/mapped_file.h>
+#include <Meshes/mesh_container.h>
+#include <Meshes/obj_importer.h>
+#include <Textures/bc_encoder.h>
+#include <Textures/image_decoder.h>
+
+using namespace std;
+
+// CPU only checks of the asset pipeline, run by ctest as asset_checks. Each check prints one
+// PASS / FAIL line; the exit code is the number of failures. Run from a build folder directly
+// inside the project, the texture checks read textures/ from there.
+
+string projectPath = filesystem::current_path().parent_path().string();
+string texturesPath = projectPath + "/textures/";
+
+#pragma region Mesh Import
+// an OBJ over several import chunks with what exporters mix in: quads and triangles, faces
+// with and without texcoords or normals, negative indices, material switches back to earlier
+// materials and faces with fewer than three corners
+string syntheticObj(){
+    const int GRID = 160;
+    const char* materials[3] = { "stone", "wood", "metal" };
+    string text = "# asset_checks\n";
+    for(int y = 0; y <= GRID; y++){
+        for(int x = 0; x <= GRID; x++){
+            text += "v " + to_string(x * 0.25f) + " " + to_string(((x * 7 + y * 3) % 11) * 0.05f) + " " + to_string(y * -0.25f) + "\n";
+            text += "vt " + to_string(static_cast<float>(x) / GRID) + " " + to_string(static_cast<float>(y) / GRID) + "\n";
+        }
+    }
+    text += "vn 0 1 0\nvn 0.6 0.8 0\n";
+    for(int y = 0; y < GRID; y++){
+        if(y % 16 == 0){
+            text += "usemtl " + string(materials[(y / 16) % 3]) + "\ng row" + to_string(y) + "\n";
+        }
+        for(int x = 0; x < GRID; x++){
+            int a = y * (GRID + 1) + x + 1, b = a + 1, c = a + GRID + 2, d = a + GRID + 1;
+            string A = to_string(a), B = to_string(b), C = to_string(c), D = to_string(d);
+            switch((x + y) % 5){
+                case 0: text += "f " + A + "/" + A + "/1 " + B + "/" + B + "/1 " + C + "/" + C + "/2 " + D + "/" + D + "/2\n"; break;
+                case 1: text += "f " + A + "//1 " + B + "//1 " + C + "//2\nf " + A + "//1 " + C + "//2 " + D + "//2\n"; break;
+                case 2: text += "f " + A + " " + B + " " + C + " " + D + "\n"; break;
+                case 3: text += "f " + A + "/" + A + " " + B + "/" + B + " " + C + "/" + C + "\n"; break;
+                default: text += "f -1/-1/-1 " + B + "/" + B + "/-2 " + C + "/" + C + "/-1\n"; break;
+            }
+            if((x * 13 + y) % 97 == 0){
+                text += "f " + A + "/" + A + "\nf " + B + " " + C + "\n";
+            }
+        }
+    }
+    return text;
+}
+
+bool sameMesh(const MeshContainer::Mesh &a, const MeshContainer::Mesh &b){
+    if(a.vertexCount != b.vertexCount || a.streams.size() != b.streams.size() || a.indices != b.indices ||
+       a.lods.size() != b.lods.size() || a.submeshes.size() != b.submeshes.size()){
+        return false;
+    }
+    for(size_t i = 0; i < a.streams.size(); i++){
+        if(a.streams[i].stride != b.streams[i].stride || a.streams[i].bytes != b.streams[i].bytes){
+            return false;
+        }
+    }
+    return memcmp(a.lods.data(), b.lods.data(), sizeof(MeshContainer::Lod) * a.lods.size()) == 0 &&
+           memcmp(a.submeshes.data(), b.submeshes.data(), sizeof(MeshContainer::Submesh) * a.submeshes.size()) == 0;
+}
+
+// the parallel OBJ path has to give exactly the serial path's mesh
+bool checkObjParallelMatchesSerial(){
+    string text = syntheticObj();
+    MeshContainer::Mesh serial, parallel;
+    vector<string> serialMaterials, parallelMaterials;
+    string error;
+    if(!ObjImport::parse(text.data(), text.size(), serial, serialMaterials, error, false) ||
+       !ObjImport::parse(text.data(), text.size(), parallel, parallelMaterials, error, true)){
+        cout << "obj_parallel FAIL, " << error << endl;
+        return false;
+    }
+    bool pass = text.size() > 4 * ObjImport::MIN_CHUNK_BYTES && sameMesh(serial, parallel) && serialMaterials == parallelMaterials;
+    cout << "obj_parallel " << (pass ? "PASS" : "FAIL") << ", " << text.size() / 1024 << " KB, " << serial.vertexCount << " / "
+         << parallel.vertexCount << " vertices, " << serial.indices.size() / 3 << " / " << parallel.indices.size() / 3 << " triangles" << endl;
+    return pass;
+}
+#pragma endregion
+
+#pragma region Textures
+vector<string> sourceTextures(){
+    vector<string> paths;
+    for(const filesystem::directory_entry &entry : filesystem::directory_iterator(texturesPath)){
+        string extension = entry.path().extension().string();
+        if(entry.is_regular_file() && (extension == ".png" || extension == ".jpg" || extension == ".jpeg")){
+            paths.push_back(entry.path().string());
+        }
+    }
+    sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// the fast decoders against stb on every source texture, scalar, SIMD and threaded: PNG has to
+// match exactly, JPEG within the rounding of a float IDCT against stb's integer one
+const int JPEG_MAX_ERROR = 8;
+
+int checkDecodersMatchStb(){
+    struct Config {
+        const char* label;
+        bool simd;
+        bool parallel;
+    };
+    const Config configs[] = { { "scalar", false, false }, { "simd", true, false }, { "simd-mt", true, true } };
+    int failures = 0;
+    for(const string &path : sourceTextures()){
+        string name = filesystem::path(path).filename().string();
+        MappedFile file;
+        ImageDecode::Image reference;
+        ImageDecode::Options referenceOptions;
+        referenceOptions.desiredChannels = 4;
+        referenceOptions.only = "stb";
+        if(!file.open(path) || !ImageDecode::decode(file.data(), file.size(), reference, referenceOptions)){
+            cout << "decode " << name << " FAIL, stb can't read it" << endl;
+            failures++;
+            continue;
+        }
+        bool png = filesystem::path(path).extension() == ".png";
+        for(const Config &config : configs){
+            ImageDecode::Options options;
+            options.desiredChannels = 4;
+            options.only = png ? "png" : "jpeg";
+            options.allowSimd = config.simd;
+            options.parallel = config.parallel;
+            ImageDecode::Image image;
+            int maxError = -1;
+            if(ImageDecode::decode(file.data(), file.size(), image, options) && image.width == reference.width &&
+               image.height == reference.height && image.pixels.size() == reference.pixels.size()){
+                maxError = 0;
+                for(size_t i = 0; i < image.pixels.size(); i++){
+                    maxError = max(maxError, abs(static_cast<int>(image.pixels[i]) - reference.pixels[i]));
+                }
+            }
+            bool pass = maxError >= 0 && maxError <= (png ? 0 : JPEG_MAX_ERROR);
+            cout << "decode " << name << " " << config.label << (pass ? " PASS" : " FAIL") << ", max error vs stb " << maxError << endl;
+            failures += pass ? 0 : 1;
+        }
+    }
+    return failures;
+}
+
+// encode -> decode round trip of every block format over every source texture, on the channels
+// the format keeps. Floors are per BC::Format, a couple of dB under the worst source texture.
+const double MIN_PSNR[] = { 30.0, 31.0, 39.0, 38.0, 33.0 };
+
+int checkBlockCompressionPsnr(){
+    const BC::Format formats[] = { BC::BC1, BC::BC3, BC::BC4, BC::BC5, BC::BC7 };
+    int failures = 0;
+    for(const string &path : sourceTextures()){
+        string name = filesystem::path(path).filename().string();
+        ImageDecode::Image image;
+        if(!ImageDecode::decodeFile(path, image, 4)){
+            cout << "bc " << name << " FAIL, can't decode it" << endl;
+            failures++;
+            continue;
+        }
+        for(BC::Format format : formats){
+            vector<uint8_t> blocks = BC::encodeImage(image.pixels.data(), image.width, image.height, format);
+            vector<uint8_t> decoded = BC::decodeImage(blocks.data(), image.width, image.height, format);
+            double psnr = BC::psnr(image.pixels.data(), decoded.data(), image.width, image.height, BC::channelMask(format));
+            bool pass = blocks.size() == BC::compressedSize(format, image.width, image.height) && psnr >= MIN_PSNR[format];
+            cout << "bc " << name << " " << BC::name(format) << (pass ? " PASS" : " FAIL") << ", PSNR " << psnr << " dB (min " << MIN_PSNR[format] << ")" << endl;
+            failures += pass ? 0 : 1;
+        }
+    }
+    return failures;
+}
+#pragma endregion
+
+int main(){
+    int failures = 0;
+    failures += checkObjParallelMatchesSerial() ? 0 : 1;
+    failures += checkDecodersMatchStb();
+    failures += checkBlockCompressionPsnr();
+    cout << "asset_checks: " << failures << " failed" << endl;
+    return failures;
+}